@@ -0,0 +1,260 @@
+/*****************************************************************************
+FILE: l2qa_perf.c
+  
+PURPOSE: Contains functions for counting the hardware events of the QA
+kernels with the Linux perf_event_open interface.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. Each event is opened as its own counter rather than as a group, so an
+   event the processor doesn't support (or a PMU with fewer counters than
+   events) doesn't stop the others from being counted.  When the kernel
+   multiplexes the counters, the counts are scaled by the fraction of the
+   interval each counter was running.
+2. Without perf_event_open (i.e. not Linux, in most virtual machines, or with
+   a perf_event_paranoid setting of 3 or more) no counter can be opened and
+   l2qa_perf_enable returns 0 with the reason in l2qa_perf_error.
+*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "l2qa_perf.h"
+
+#ifdef __linux__
+/* perf_event_open configuration of each event, in the order of
+   L2qa_perf_event_t */
+static const uint64_t event_configs[L2QA_PERF_NUM_EVENTS] =
+{
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES
+};
+#endif
+
+static int event_fds[L2QA_PERF_NUM_EVENTS]; /* file descriptor of each
+                                               counter; -1 if not open */
+static bool perf_enabled = false;   /* is at least one counter open? */
+static char perf_error[256] = "";   /* reason the counters are unavailable */
+
+/******************************************************************************
+MODULE:  l2qa_perf_enable
+
+PURPOSE: Opens a counter for each hardware event and turns on the counting.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+0               No counter could be opened; l2qa_perf_error has the reason
+n               Number of events which will be counted
+
+NOTES:
+1. The counters are opened disabled, and are only running between
+   l2qa_perf_start and l2qa_perf_stop.
+******************************************************************************/
+int l2qa_perf_enable (void)
+{
+    int nopened = 0;       /* number of counters opened */
+    int i;                 /* looping variable */
+#ifdef __linux__
+    int first_errno = 0;   /* errno of the first counter not opened */
+    struct perf_event_attr attr; /* settings of the counter */
+
+    for (i = 0; i < L2QA_PERF_NUM_EVENTS; i++)
+    {
+        memset (&attr, 0, sizeof (attr));
+        attr.size = sizeof (attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = event_configs[i];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+            PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        /* Count this process and the threads it creates, on any CPU */
+        event_fds[i] = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (event_fds[i] >= 0)
+            nopened++;
+        else if (first_errno == 0)
+            first_errno = errno;
+    }
+
+    if (nopened == 0)
+        snprintf (perf_error, sizeof (perf_error), "perf_event_open: %s "
+            "(check /proc/sys/kernel/perf_event_paranoid)",
+            strerror (first_errno));
+#else
+    for (i = 0; i < L2QA_PERF_NUM_EVENTS; i++)
+        event_fds[i] = -1;
+    snprintf (perf_error, sizeof (perf_error), "perf_event_open is only "
+        "available on Linux");
+#endif
+
+    perf_enabled = (nopened > 0);
+    return (nopened);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_perf_error
+
+PURPOSE: Returns the reason no counter could be opened.
+
+RETURN VALUE:
+Type = const char *
+Value           Description
+-----           -----------
+string          Reason from the last l2qa_perf_enable ("" if none)
+
+NOTES:
+******************************************************************************/
+const char *l2qa_perf_error (void)
+{
+    return (perf_error);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_perf_is_enabled
+
+PURPOSE: Returns whether the hardware events are being counted.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            At least one counter is open
+false           Counting is off or unavailable
+
+NOTES:
+******************************************************************************/
+bool l2qa_perf_is_enabled (void)
+{
+    return (perf_enabled);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_perf_start
+
+PURPOSE: Resets and starts the counters.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void l2qa_perf_start (void)
+{
+#ifdef __linux__
+    int i;                 /* looping variable */
+
+    if (!perf_enabled)
+        return;
+
+    for (i = 0; i < L2QA_PERF_NUM_EVENTS; i++)
+    {
+        if (event_fds[i] < 0)
+            continue;
+        ioctl (event_fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl (event_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_perf_stop
+
+PURPOSE: Stops the counters and returns the counts of the events since
+l2qa_perf_start.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. An event which isn't open, couldn't be read, or never got a counter while
+   running is L2QA_PERF_NOT_COUNTED.
+******************************************************************************/
+void l2qa_perf_stop
+(
+    L2qa_perf_counts_t *counts  /* O: counts of the events since
+                                      l2qa_perf_start */
+)
+{
+    int i;                 /* looping variable */
+#ifdef __linux__
+    uint64_t values[3];    /* count, time enabled, and time running */
+#endif
+
+    for (i = 0; i < L2QA_PERF_NUM_EVENTS; i++)
+        counts->count[i] = L2QA_PERF_NOT_COUNTED;
+
+#ifdef __linux__
+    if (!perf_enabled)
+        return;
+
+    for (i = 0; i < L2QA_PERF_NUM_EVENTS; i++)
+    {
+        if (event_fds[i] >= 0)
+            ioctl (event_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (i = 0; i < L2QA_PERF_NUM_EVENTS; i++)
+    {
+        if (event_fds[i] < 0 ||
+            read (event_fds[i], values, sizeof (values)) != sizeof (values) ||
+            values[2] == 0)
+            continue;
+
+        /* Scale a multiplexed counter to the whole interval */
+        if (values[2] < values[1])
+            counts->count[i] = (long long) ((double) values[0] *
+                values[1] / values[2]);
+        else
+            counts->count[i] = (long long) values[0];
+    }
+#endif
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_perf_disable
+
+PURPOSE: Closes the counters and turns off the counting.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void l2qa_perf_disable (void)
+{
+    int i;                 /* looping variable */
+
+    if (!perf_enabled)
+        return;
+
+    for (i = 0; i < L2QA_PERF_NUM_EVENTS; i++)
+    {
+#ifdef __linux__
+        if (event_fds[i] >= 0)
+            close (event_fds[i]);
+#endif
+        event_fds[i] = -1;
+    }
+    perf_enabled = false;
+}
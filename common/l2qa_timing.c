@@ -0,0 +1,241 @@
+/*****************************************************************************
+FILE: l2qa_timing.c
+  
+PURPOSE: Contains functions for timing the phases of the QA tools and
+reporting the times as JSON.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The times are wall times from the monotonic clock, so they include the
+   time spent waiting on the disk.
+*****************************************************************************/
+#include <sys/stat.h>
+#include "l2qa_common.h"
+#include "l2qa_timing.h"
+
+/* Names of the phases in the report, in the order of L2qa_phase_t */
+static const char *phase_names[L2QA_NUM_PHASES] =
+{
+    "validate_xml", "parse_metadata", "read", "translate", "water", "dilate",
+    "write", "append_metadata"
+};
+
+/* Totals for each phase */
+static struct
+{
+    long calls;            /* number of times the phase was timed */
+    double seconds;        /* total wall time of the phase */
+    long long bytes;       /* total bytes read or written */
+    long long pixels;      /* total pixels processed */
+} phase_totals[L2QA_NUM_PHASES];
+
+static bool timing_enabled = false; /* is timing on? */
+static L2qa_timer_t timing_start;   /* time timing was turned on */
+
+/******************************************************************************
+MODULE:  elapsed_seconds
+
+PURPOSE: Returns the seconds since the start time.
+
+RETURN VALUE:
+Type = double
+Value           Description
+-----           -----------
+n               Elapsed seconds
+
+NOTES:
+******************************************************************************/
+static double elapsed_seconds
+(
+    L2qa_timer_t *start    /* I: start time */
+)
+{
+    struct timespec now;   /* current time */
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return ((now.tv_sec - start->tv_sec) +
+        (now.tv_nsec - start->tv_nsec) * 1e-9);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_timing_enable
+
+PURPOSE: Turns on the timing of the phases and starts the total wall time.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void l2qa_timing_enable (void)
+{
+    timing_enabled = true;
+    clock_gettime (CLOCK_MONOTONIC, &timing_start);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_timing_is_enabled
+
+PURPOSE: Returns whether the timing of the phases is on.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            Timing is on
+false           Timing is off
+
+NOTES:
+******************************************************************************/
+bool l2qa_timing_is_enabled (void)
+{
+    return (timing_enabled);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_timer_start
+
+PURPOSE: Starts timing a phase.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void l2qa_timer_start
+(
+    L2qa_timer_t *timer    /* O: start time of the phase */
+)
+{
+    if (timing_enabled)
+        clock_gettime (CLOCK_MONOTONIC, timer);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_timer_stop
+
+PURPOSE: Stops timing a phase and adds its time, bytes, and pixels to the
+totals of the phase.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void l2qa_timer_stop
+(
+    L2qa_timer_t *timer,   /* I: start time from l2qa_timer_start */
+    L2qa_phase_t phase,    /* I: phase being timed */
+    long long bytes,       /* I: bytes read or written by the phase */
+    long long pixels       /* I: pixels processed by the phase */
+)
+{
+    if (!timing_enabled || phase < 0 || phase >= L2QA_NUM_PHASES)
+        return;
+
+    phase_totals[phase].calls++;
+    phase_totals[phase].seconds += elapsed_seconds (timer);
+    phase_totals[phase].bytes += bytes;
+    phase_totals[phase].pixels += pixels;
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_timing_file_size
+
+PURPOSE: Returns the size of a file for the bytes of a phase (i.e. the XML
+file for validate_xml and parse_metadata).
+
+RETURN VALUE:
+Type = long long
+Value           Description
+-----           -----------
+0               Timing is off or the file can't be found
+n               Size of the file in bytes
+
+NOTES:
+******************************************************************************/
+long long l2qa_timing_file_size
+(
+    char *filename         /* I: file read or written by a phase */
+)
+{
+    struct stat statbuf;   /* status of the file */
+
+    if (!timing_enabled || stat (filename, &statbuf) != 0)
+        return (0);
+
+    return ((long long) statbuf.st_size);
+}
+
+
+/******************************************************************************
+MODULE:  l2qa_timing_report
+
+PURPOSE: Writes the times of the phases as JSON.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Only the phases which were timed are reported.  unaccounted_seconds is the
+   wall time outside of the timed phases (i.e. argument parsing and memory
+   allocation).
+2. The phases can't add up to more than the wall time unless one is timed
+   inside another, so that is reported as a warning on stderr (the report
+   itself may be on stdout).
+******************************************************************************/
+void l2qa_timing_report
+(
+    FILE *fp,              /* I: open file for the report */
+    char *tool_name        /* I: name of the tool */
+)
+{
+    int i;                     /* looping variable for the phases */
+    bool first = true;         /* is this the first phase reported? */
+    double wall_seconds;       /* total wall time since timing was on */
+    double phase_seconds = 0.0; /* total wall time of the phases */
+    double seconds;            /* wall time of the current phase */
+
+    if (!timing_enabled)
+        return;
+
+    wall_seconds = elapsed_seconds (&timing_start);
+    fprintf (fp, "{\n  \"tool\": \"%s\",\n  \"version\": \"%s\",\n"
+        "  \"phases\": [", tool_name, L2QA_COMMON_VERSION);
+    for (i = 0; i < L2QA_NUM_PHASES; i++)
+    {
+        if (phase_totals[i].calls == 0)
+            continue;
+
+        seconds = phase_totals[i].seconds;
+        phase_seconds += seconds;
+        fprintf (fp, "%s\n    {\"phase\": \"%s\", \"calls\": %ld, "
+            "\"seconds\": %.6f, \"bytes\": %lld, \"pixels\": %lld, "
+            "\"bytes_per_second\": %.1f, \"pixels_per_second\": %.1f}",
+            first ? "" : ",", phase_names[i], phase_totals[i].calls, seconds,
+            phase_totals[i].bytes, phase_totals[i].pixels,
+            (seconds > 0.0) ? phase_totals[i].bytes / seconds : 0.0,
+            (seconds > 0.0) ? phase_totals[i].pixels / seconds : 0.0);
+        first = false;
+    }
+    fprintf (fp, "\n  ],\n  \"wall_seconds\": %.6f,\n"
+        "  \"unaccounted_seconds\": %.6f\n}\n", wall_seconds,
+        wall_seconds - phase_seconds);
+    fflush (fp);
+
+    if (phase_seconds > wall_seconds)
+    {
+        fprintf (stderr, "Warning: l2qa_timing_report: The phases add up to "
+            "%.6f seconds, more than the %.6f seconds of wall time, so some "
+            "were timed twice\n", phase_seconds, wall_seconds);
+    }
+}
@@ -0,0 +1,78 @@
+/*****************************************************************************
+FILE: l2qa_timing.h
+  
+PURPOSE: Contains defines and function prototypes for timing the phases of
+the QA tools (XML validation and parsing, reading, translation, dilation,
+writing, and appending to the XML file).
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. Timing is off until l2qa_timing_enable is called (i.e. for the --timing
+   option of the tools).  While it's off, l2qa_timer_start and l2qa_timer_stop
+   return without reading the clock, so the instrumented functions cost a
+   function call per phase.
+2. The totals are global and aren't protected by a lock, so the timed
+   functions must be called from one thread while timing is on.
+3. The phases must not be nested (i.e. a phase must not call a function
+   which times its own phase), or their time is counted twice.
+*****************************************************************************/
+
+#ifndef L2QA_TIMING_H
+#define L2QA_TIMING_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+
+/* Phases of the QA tools */
+typedef enum
+{
+    L2QA_PHASE_VALIDATE_XML,     /* validate_xml_file */
+    L2QA_PHASE_PARSE_METADATA,   /* parse_metadata */
+    L2QA_PHASE_READ,             /* reading the QA bands and streams */
+    L2QA_PHASE_TRANSLATE,        /* Level-1 QA to pixel QA translation */
+    L2QA_PHASE_WATER,            /* setting the water bit from the Level-2
+                                    QA (its read is a READ) */
+    L2QA_PHASE_DILATE,           /* dilation of the pixel QA */
+    L2QA_PHASE_WRITE,            /* writing the QA bands and streams */
+    L2QA_PHASE_APPEND_METADATA,  /* ENVI header and XML append */
+    L2QA_NUM_PHASES
+} L2qa_phase_t;
+
+/* Start time of a timed phase */
+typedef struct timespec L2qa_timer_t;
+
+/* Function prototypes */
+void l2qa_timing_enable (void);
+
+bool l2qa_timing_is_enabled (void);
+
+void l2qa_timer_start
+(
+    L2qa_timer_t *timer    /* O: start time of the phase */
+);
+
+void l2qa_timer_stop
+(
+    L2qa_timer_t *timer,   /* I: start time from l2qa_timer_start */
+    L2qa_phase_t phase,    /* I: phase being timed */
+    long long bytes,       /* I: bytes read or written by the phase */
+    long long pixels       /* I: pixels processed by the phase */
+);
+
+long long l2qa_timing_file_size
+(
+    char *filename         /* I: file read or written by a phase */
+);
+
+void l2qa_timing_report
+(
+    FILE *fp,              /* I: open file for the report */
+    char *tool_name        /* I: name of the tool */
+);
+
+#endif
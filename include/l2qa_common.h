@@ -0,0 +1,19 @@
+/*****************************************************************************
+FILE: l2qa_common.h
+  
+PURPOSE: Contains Level-2 QA common defines
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+*****************************************************************************/
+
+#ifndef L2QA_COMMON_H_
+#define L2QA_COMMON_H_
+
+#define L2QA_COMMON_VERSION "1.7.0"
+
+#endif
@@ -0,0 +1,71 @@
+/*****************************************************************************
+FILE: l2qa_perf.h
+  
+PURPOSE: Contains defines and function prototypes for counting the hardware
+events (cycles, instructions, branches, and cache accesses) of the QA kernels
+with the Linux perf_event_open interface.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. Counting is off until l2qa_perf_enable is called (i.e. for the --counters
+   option of benchmark_qa).  While it's off, or if no counter could be
+   opened, l2qa_perf_start and l2qa_perf_stop do nothing and every value is
+   L2QA_PERF_NOT_COUNTED, so the callers need no special cases.
+2. The counters follow the threads created after l2qa_perf_enable, so it must
+   be called before the first OpenMP parallel region for the threaded
+   kernels to be counted.  Only user-space events are counted.
+3. The counters must be started and stopped from one thread.
+*****************************************************************************/
+
+#ifndef L2QA_PERF_H
+#define L2QA_PERF_H
+
+#include <stdbool.h>
+
+/* Defines */
+#define L2QA_PERF_NOT_COUNTED -1    /* value of an event which wasn't
+                                       counted */
+#define L2QA_PERF_CACHE_LINE 64     /* bytes moved by a last-level cache
+                                       miss */
+
+/* Hardware events which are counted */
+typedef enum
+{
+    L2QA_PERF_CYCLES,            /* CPU cycles */
+    L2QA_PERF_INSTRUCTIONS,      /* instructions retired */
+    L2QA_PERF_BRANCHES,          /* branch instructions */
+    L2QA_PERF_BRANCH_MISSES,     /* mispredicted branches */
+    L2QA_PERF_CACHE_REFERENCES,  /* last-level cache references */
+    L2QA_PERF_CACHE_MISSES,      /* last-level cache misses */
+    L2QA_PERF_NUM_EVENTS
+} L2qa_perf_event_t;
+
+/* Counts of the events over a counted interval */
+typedef struct
+{
+    long long count[L2QA_PERF_NUM_EVENTS]; /* count of each event, or
+                                              L2QA_PERF_NOT_COUNTED */
+} L2qa_perf_counts_t;
+
+/* Function prototypes */
+int l2qa_perf_enable (void);
+
+const char *l2qa_perf_error (void);
+
+bool l2qa_perf_is_enabled (void);
+
+void l2qa_perf_start (void);
+
+void l2qa_perf_stop
+(
+    L2qa_perf_counts_t *counts  /* O: counts of the events since
+                                      l2qa_perf_start */
+);
+
+void l2qa_perf_disable (void);
+
+#endif
@@ -0,0 +1,89 @@
+/*****************************************************************************
+FILE: level2_qa_aerosol_bulk.h
+  
+PURPOSE: Contains data types and function prototypes for decoding whole
+arrays and strips of the LaSRC aerosol QA band.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. One pass over the aerosol QA values produces the aerosol level (0-3) of
+   each pixel, packed masks of the water, valid aerosol retrieval, and
+   aerosol interpolated pixels, and the counts of each category.  The values
+   match lasrc_qa_aerosol_level, lasrc_qa_is_water,
+   lasrc_qa_is_valid_aerosol_retrieval, and lasrc_qa_is_aerosol_interp.
+2. The packed masks have (npixels + 7) / 8 bytes.  Pixel i is stored in bit
+   (i % 8) of byte (i / 8), and the unused bits of the last byte are zero.
+3. Any of the outputs may be NULL if it isn't needed.
+*****************************************************************************/
+
+#ifndef LEVEL2_QA_AEROSOL_BULK_H
+#define LEVEL2_QA_AEROSOL_BULK_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "read_level2_qa.h"
+#include "level2_qa_strips.h"
+
+/* Data types */
+typedef struct
+{
+    uint64_t npixels;             /* total number of pixels */
+    uint64_t fill;                /* number of fill pixels */
+    uint64_t valid;               /* number of valid aerosol retrievals */
+    uint64_t interp;              /* number of aerosol interpolated pixels */
+    uint64_t water;               /* number of water pixels */
+    uint64_t level[4];            /* number of pixels for each aerosol level
+                                     (none, low, moderate, high) */
+} Lasrc_aerosol_counts_t;
+
+/* Function Prototypes */
+size_t level2_qa_mask_bytes
+(
+    size_t npixels          /* I: number of pixels */
+);
+
+void decode_lasrc_aerosol_values
+(
+    uint8_t *l2_qa,         /* I: LaSRC aerosol QA values */
+    size_t npixels,         /* I: number of pixels */
+    uint8_t *level,         /* O: aerosol level (0-3) per pixel (or NULL) */
+    uint8_t *water_mask,    /* O: packed mask of the water pixels (or NULL) */
+    uint8_t *valid_mask,    /* O: packed mask of the valid aerosol
+                                  retrievals (or NULL) */
+    uint8_t *interp_mask,   /* O: packed mask of the aerosol interpolated
+                                  pixels (or NULL) */
+    Lasrc_aerosol_counts_t *counts /* I/O: the counts of the pixels are added
+                                           to the counts (or NULL) */
+);
+
+int decode_next_lasrc_aerosol_strip
+(
+    Level2_qa_strips_t *strips, /* I/O: strip reader of the LaSRC aerosol
+                                        band */
+    uint8_t *level,         /* O: aerosol level per pixel of the strip (or
+                                  NULL) */
+    uint8_t *water_mask,    /* O: packed water mask of the strip (or NULL) */
+    uint8_t *valid_mask,    /* O: packed valid retrieval mask of the strip
+                                  (or NULL) */
+    uint8_t *interp_mask,   /* O: packed interpolated mask of the strip (or
+                                  NULL) */
+    Lasrc_aerosol_counts_t *counts, /* I/O: the counts of the strip are added
+                                            to the counts (or NULL) */
+    int *nlines             /* O: number of lines in the strip; 0 at the end
+                                  of the band */
+);
+
+int count_lasrc_aerosol_level2_qa
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    int strip_lines,        /* I: number of lines read at a time */
+    Lasrc_aerosol_counts_t *counts /* O: counts of the aerosol QA band */
+);
+
+#endif
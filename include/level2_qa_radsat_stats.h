@@ -0,0 +1,81 @@
+/*****************************************************************************
+FILE: level2_qa_radsat_stats.h
+  
+PURPOSE: Contains data types and function prototypes for counting the fill
+and saturated pixels of each spectral band in the LEDAPS and LaSRC radsat QA
+bands.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The counts are taken 64 pixels at a time.  The QA values are transposed
+   into one 64-bit word per QA bit (bit i of the word is the QA bit of pixel
+   i), and each word is counted with a single popcount.  All of the bits of
+   a pixel are counted in the same pass.
+2. The fill and saturation bits are counted as they are set, so a fill pixel
+   with saturation bits set is counted in both.
+*****************************************************************************/
+
+#ifndef LEVEL2_QA_RADSAT_STATS_H
+#define LEVEL2_QA_RADSAT_STATS_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "read_level2_qa.h"
+#include "level2_qa_strips.h"
+
+/* Defines */
+#define LEVEL2_RADSAT_MAX_BANDS LASRC_B11_SAT_BIT /* most spectral bands in a
+                                     radsat QA band */
+
+/* Data types */
+typedef struct
+{
+    Espa_level2_qa_type qa_category; /* LEDAPS_RADSAT or LASRC_RADSAT */
+    int nbands;                   /* number of spectral bands (7 or 11) */
+    uint64_t npixels;             /* total number of pixels */
+    uint64_t fill;                /* number of fill pixels */
+    uint64_t saturated[LEVEL2_RADSAT_MAX_BANDS]; /* number of pixels
+                                     saturated in each band; saturated[0] is
+                                     band 1 */
+    uint64_t saturated_any;       /* number of pixels saturated in at least
+                                     one band */
+} Level2_radsat_stats_t;
+
+/* Function Prototypes */
+int init_level2_radsat_stats
+(
+    Espa_level2_qa_type qa_category, /* I: LEDAPS_RADSAT or LASRC_RADSAT */
+    Level2_radsat_stats_t *stats  /* O: statistics with all counts zero */
+);
+
+void ledaps_radsat_stats_values
+(
+    uint8_t *l2_qa,         /* I: LEDAPS radsat QA values */
+    size_t npixels,         /* I: number of pixels */
+    Level2_radsat_stats_t *stats /* I/O: the counts of the pixels are added
+                                         to the statistics */
+);
+
+void lasrc_radsat_stats_values
+(
+    uint16_t *l2_qa,        /* I: LaSRC radsat QA values */
+    size_t npixels,         /* I: number of pixels */
+    Level2_radsat_stats_t *stats /* I/O: the counts of the pixels are added
+                                         to the statistics */
+);
+
+int radsat_stats_level2_qa
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    Espa_level2_qa_type qa_category, /* I: LEDAPS_RADSAT or LASRC_RADSAT */
+    int strip_lines,        /* I: number of lines read at a time */
+    Level2_radsat_stats_t *stats /* O: statistics of the radsat QA band */
+);
+
+#endif
@@ -0,0 +1,81 @@
+/*****************************************************************************
+FILE: write_pixel_qa.h
+  
+PURPOSE: Contains function prototypes for the Level-2 pixel QA band output.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+*****************************************************************************/
+
+#ifndef WRITE_PIXEL_QA_H
+#define WRITE_PIXEL_QA_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include "error_handler.h"
+#include "raw_binary_io.h"
+
+/* Data types */
+typedef struct
+{
+    int fd;                 /* file descriptor for the mapped pixel QA file */
+    size_t nbytes;          /* size of the mapping (nlines x nsamps x 2) */
+    uint16_t *pixel_qa;     /* writable view of the pixel QA band, in
+                               line-major order */
+} Pixel_qa_map_t;
+
+/* Defines */
+FILE *create_pixel_qa
+(
+    char *l2_qa_file       /* I: pixel QA filename to be created */
+);
+
+int write_pixel_qa
+(
+    FILE *fp_bqa,           /* I: pointer to pixel QA band open for writing */
+    int nlines,             /* I: number of lines to write to the QA file */
+    int nsamps,             /* I: number of samples to write to the QA file */
+    uint16_t *pixel_qa      /* I: pixel QA band values for the specified
+                                  number of lines */
+);
+
+int pwrite_all
+(
+    int fd,                 /* I: file descriptor open for writing */
+    const void *buf,        /* I: buffer to be written */
+    size_t nbytes,          /* I: number of bytes to write */
+    off_t offset            /* I: file offset to write to */
+);
+
+int write_pixel_qa_lines
+(
+    FILE *fp_bqa,           /* I: pointer to pixel QA band open for update */
+    int start_line,         /* I: first line to be rewritten in the QA file */
+    int nlines,             /* I: number of lines to write to the QA file */
+    int nsamps,             /* I: number of samples to write to the QA file */
+    uint16_t *pixel_qa      /* I: pixel QA band values for the specified
+                                  number of lines */
+);
+
+int create_mapped_pixel_qa
+(
+    char *l2_qa_file,       /* I: pixel QA filename to be created */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    Pixel_qa_map_t *qa_map  /* O: mapping of the pixel QA band */
+);
+
+int close_mapped_pixel_qa
+(
+    Pixel_qa_map_t *qa_map  /* I/O: mapping of the pixel QA band; will be
+                                    unmapped and closed upon return */
+);
+
+#endif
@@ -0,0 +1,129 @@
+#! /usr/bin/env python
+import numpy
+
+# Define the Level-1 QA bit values, as in read_level1_qa.h
+ESPA_L1_SINGLE_BIT = 0x01             # 00000001
+ESPA_L1_DOUBLE_BIT = 0x03             # 00000011
+
+ESPA_L1_DESIGNATED_FILL_BIT = 0       # one bit
+ESPA_L1_TERRAIN_OCCLUSION_BIT = 1     # one bit (L8/OLI)
+ESPA_L1_DROPPED_PIXEL_BIT = 1         # one bit (L4-7 TM/ETM+)
+ESPA_L1_RAD_SATURATION_BIT = 2        # two bits
+ESPA_L1_CLOUD_BIT = 4                 # one bit
+ESPA_L1_CLOUD_CONF_BIT = 5            # two bits
+ESPA_L1_CLOUD_SHADOW_CONF_BIT = 7     # two bits
+ESPA_L1_SNOW_ICE_CONF_BIT = 9         # two bits
+ESPA_L1_CIRRUS_CONF_BIT = 11          # two bits (L8/OLI)
+
+# The functions below mirror the inline functions of read_level1_qa.h.  They
+# take a Level-1 QA value or a NumPy array of them (any shape) and work on the
+# whole array with vectorized shifts and masks, returning a boolean array for
+# the single-bit tests and a uint8 array (0-3) for the two-bit fields.  Like
+# read_level1_qa.h they decode the Collection 1 bits only; the Collection 2
+# QA_PIXEL band has its bits at other positions.
+
+
+'''Returns the Level-1 QA values as a uint16 NumPy array, without copying
+   them if they already are one.
+'''
+def _level1_qa_array(l1_qa):
+    return numpy.asarray(l1_qa, dtype=numpy.uint16)
+
+
+'''Determines which of the Level-1 QA values have the specified single bit
+   set.
+'''
+def _level1_qa_single_bit(l1_qa, bit):
+    l1_qa = _level1_qa_array(l1_qa)
+    return (l1_qa & numpy.uint16(ESPA_L1_SINGLE_BIT << bit)) != 0
+
+
+'''Returns the two-bit field starting at the specified bit of each of the
+   Level-1 QA values.
+'''
+def _level1_qa_double_bit(l1_qa, bit):
+    l1_qa = _level1_qa_array(l1_qa)
+    return ((l1_qa >> numpy.uint16(bit)) &
+            numpy.uint16(ESPA_L1_DOUBLE_BIT)).astype(numpy.uint8)
+
+
+'''Determines if the Level-1 QA pixels are fill
+
+Returns:
+    True where the pixel is fill
+'''
+def level1_qa_is_fill(l1_qa):
+    return _level1_qa_single_bit(l1_qa, ESPA_L1_DESIGNATED_FILL_BIT)
+
+
+'''Determines if the Level-1 QA pixels are terrain occluded (L8/OLI)
+
+Returns:
+    True where the pixel is terrain occluded
+'''
+def level1_qa_is_terrain_occluded(l1_qa):
+    return _level1_qa_single_bit(l1_qa, ESPA_L1_TERRAIN_OCCLUSION_BIT)
+
+
+'''Determines if the Level-1 QA pixels are dropped pixels (L4-7 TM/ETM+)
+
+Returns:
+    True where the pixel is a dropped pixel
+'''
+def level1_qa_is_dropped_pixel(l1_qa):
+    return _level1_qa_single_bit(l1_qa, ESPA_L1_DROPPED_PIXEL_BIT)
+
+
+'''Returns the radiometric saturation value (0-3) of the Level-1 QA pixels
+
+Returns:
+    0-3 from the saturation bits (00, 01, 10, 11)
+'''
+def level1_qa_radiometric_saturation(l1_qa):
+    return _level1_qa_double_bit(l1_qa, ESPA_L1_RAD_SATURATION_BIT)
+
+
+'''Determines if the Level-1 QA pixels are cloud
+
+Returns:
+    True where the pixel is cloud
+'''
+def level1_qa_is_cloud(l1_qa):
+    return _level1_qa_single_bit(l1_qa, ESPA_L1_CLOUD_BIT)
+
+
+'''Returns the cloud confidence value (0-3) of the Level-1 QA pixels
+
+Returns:
+    0-3 from the confidence bits (00, 01, 10, 11)
+'''
+def level1_qa_cloud_confidence(l1_qa):
+    return _level1_qa_double_bit(l1_qa, ESPA_L1_CLOUD_CONF_BIT)
+
+
+'''Returns the cloud shadow confidence value (0-3) of the Level-1 QA pixels
+
+Returns:
+    0-3 from the confidence bits (00, 01, 10, 11)
+'''
+def level1_qa_cloud_shadow_confidence(l1_qa):
+    return _level1_qa_double_bit(l1_qa, ESPA_L1_CLOUD_SHADOW_CONF_BIT)
+
+
+'''Returns the snow/ice confidence value (0-3) of the Level-1 QA pixels
+
+Returns:
+    0-3 from the confidence bits (00, 01, 10, 11)
+'''
+def level1_qa_snow_ice_confidence(l1_qa):
+    return _level1_qa_double_bit(l1_qa, ESPA_L1_SNOW_ICE_CONF_BIT)
+
+
+'''Returns the cirrus confidence value (0-3) of the Level-1 QA pixels
+   (L8/OLI)
+
+Returns:
+    0-3 from the confidence bits (00, 01, 10, 11)
+'''
+def level1_qa_cirrus_confidence(l1_qa):
+    return _level1_qa_double_bit(l1_qa, ESPA_L1_CIRRUS_CONF_BIT)
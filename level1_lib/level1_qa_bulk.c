@@ -0,0 +1,475 @@
+/*****************************************************************************
+FILE: level1_qa_bulk.c
+  
+PURPOSE: Contains functions for evaluating the Level-1 QA predicates over
+whole arrays of Level-1 QA values.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. Refer to http://landsat.usgs.gov/collectionqualityband.php for the Level-1
+   QA band information.
+2. The named masks and fields (level1_qa_fill_mask, etc.) decode the
+   Collection 1 bit positions and return ERROR for Collection 2 data.
+   level1_qa_bit_mask and level1_qa_field_values take the bit, so they apply
+   to any layout.
+3. The SSE2 paths handle 16 pixels at a time.  The remaining pixels are
+   handled by the scalar loops, which are also the complete implementation
+   when SSE2 isn't available.
+*****************************************************************************/
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "level1_qa_bulk.h"
+
+/******************************************************************************
+MODULE:  level1_qa_mask_bytes
+
+PURPOSE: Returns the number of bytes in a packed mask of the pixels.
+
+RETURN VALUE:
+Type = size_t
+Value           Description
+-----           -----------
+n               Number of bytes in the mask
+
+NOTES:
+******************************************************************************/
+size_t level1_qa_mask_bytes
+(
+    size_t npixels          /* I: number of pixels */
+)
+{
+    return ((npixels + 7) / 8);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_bit_mask
+
+PURPOSE: Packs the specified bit of each Level-1 QA value into a bitmask.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. With SSE2, the bit of interest is shifted into the sign bit of each 16-bit
+   value, the values are packed to bytes with signed saturation (which keeps
+   the sign), and movemask gathers the 16 sign bits into two mask bytes.
+******************************************************************************/
+void level1_qa_bit_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    int bit,                /* I: Level-1 QA bit to be tested */
+    uint8_t *mask           /* O: packed mask of the pixels with the bit set */
+)
+{
+    size_t i = 0;           /* current pixel */
+    size_t k;               /* current pixel within the byte */
+    uint8_t byte;           /* current mask byte */
+#ifdef __SSE2__
+    int bits;               /* mask bits for 16 pixels */
+    __m128i shift = _mm_cvtsi32_si128 (15 - bit); /* moves the bit to the
+                               sign bit */
+    __m128i lo, hi;         /* QA values for 16 pixels */
+
+    for (; i + 16 <= npixels; i += 16)
+    {
+        lo = _mm_sll_epi16 (_mm_loadu_si128 ((__m128i *) &l1_qa[i]), shift);
+        hi = _mm_sll_epi16 (_mm_loadu_si128 ((__m128i *) &l1_qa[i+8]), shift);
+        bits = _mm_movemask_epi8 (_mm_packs_epi16 (lo, hi));
+        mask[i / 8] = bits & 0xff;
+        mask[i / 8 + 1] = (bits >> 8) & 0xff;
+    }
+#endif
+
+    for (; i < npixels; i += 8)
+    {
+        byte = 0;
+        for (k = 0; k < 8 && i + k < npixels; k++)
+            byte |= ((l1_qa[i + k] >> bit) & ESPA_L1_SINGLE_BIT) << k;
+        mask[i / 8] = byte;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_field_values
+
+PURPOSE: Extracts the specified two-bit field of each Level-1 QA value.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void level1_qa_field_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    int bit,                /* I: first Level-1 QA bit of the two-bit field */
+    uint8_t *values         /* O: value (0-3) of the field for each pixel */
+)
+{
+    size_t i = 0;           /* current pixel */
+#ifdef __SSE2__
+    __m128i shift = _mm_cvtsi32_si128 (bit); /* moves the field to bit 0 */
+    __m128i field = _mm_set1_epi16 (ESPA_L1_DOUBLE_BIT); /* field mask */
+    __m128i lo, hi;         /* QA values for 16 pixels */
+
+    for (; i + 16 <= npixels; i += 16)
+    {
+        lo = _mm_and_si128 (_mm_srl_epi16 (_mm_loadu_si128 (
+            (__m128i *) &l1_qa[i]), shift), field);
+        hi = _mm_and_si128 (_mm_srl_epi16 (_mm_loadu_si128 (
+            (__m128i *) &l1_qa[i+8]), shift), field);
+        _mm_storeu_si128 ((__m128i *) &values[i], _mm_packus_epi16 (lo, hi));
+    }
+#endif
+
+    for (; i < npixels; i++)
+        values[i] = (l1_qa[i] >> bit) & ESPA_L1_DOUBLE_BIT;
+}
+
+
+/******************************************************************************
+MODULE:  check_c1_category
+
+PURPOSE: Checks that the type of Level-1 QA data has the Collection 1 bit
+positions the named bulk functions decode.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         The QA category is L4-7 or L8
+
+NOTES:
+******************************************************************************/
+static int check_c1_category
+(
+    char *func_name,        /* I: name of the calling function */
+    Espa_level1_qa_type qa_category /* I: type of Level-1 QA data */
+)
+{
+    char errmsg[STR_SIZE];  /* error message */
+
+    if (qa_category == LEVEL1_L457 || qa_category == LEVEL1_L8)
+        return (SUCCESS);
+
+    sprintf (errmsg, "Only the Collection 1 Level-1 QA band is supported.  "
+        "Use the level1_qa_c2_* predicates, or level1_qa_bit_mask and "
+        "level1_qa_field_values with the bits of get_level1_qa_layout, for "
+        "the Collection 2 QA_PIXEL band");
+    error_handler (true, func_name, errmsg);
+    return (ERROR);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_fill_mask
+
+PURPOSE: Builds the packed mask of the fill pixels.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+******************************************************************************/
+int level1_qa_fill_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the fill pixels */
+)
+{
+    char FUNC_NAME[] = "level1_qa_fill_mask";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_bit_mask (l1_qa, npixels, ESPA_L1_DESIGNATED_FILL_BIT, mask);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_terrain_occluded_mask
+
+PURPOSE: Builds the packed mask of the terrain occluded pixels.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+1. Terrain occlusion only applies to L8/OLI.
+******************************************************************************/
+int level1_qa_terrain_occluded_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values (L8/OLI) */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the terrain occluded
+                                  pixels */
+)
+{
+    char FUNC_NAME[] = "level1_qa_terrain_occluded_mask";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_bit_mask (l1_qa, npixels, ESPA_L1_TERRAIN_OCCLUSION_BIT, mask);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_dropped_pixel_mask
+
+PURPOSE: Builds the packed mask of the dropped pixels.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+1. Dropped pixels only apply to L4-7 TM/ETM+.
+******************************************************************************/
+int level1_qa_dropped_pixel_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values (L4-7 TM/ETM+) */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the dropped pixels */
+)
+{
+    char FUNC_NAME[] = "level1_qa_dropped_pixel_mask";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_bit_mask (l1_qa, npixels, ESPA_L1_DROPPED_PIXEL_BIT, mask);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_cloud_mask
+
+PURPOSE: Builds the packed mask of the cloud pixels.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+******************************************************************************/
+int level1_qa_cloud_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the cloud pixels */
+)
+{
+    char FUNC_NAME[] = "level1_qa_cloud_mask";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_bit_mask (l1_qa, npixels, ESPA_L1_CLOUD_BIT, mask);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_radiometric_saturation_values
+
+PURPOSE: Extracts the radiometric saturation value of each pixel.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+******************************************************************************/
+int level1_qa_radiometric_saturation_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: radiometric saturation (0-3) per pixel */
+)
+{
+    char FUNC_NAME[] = "level1_qa_radiometric_saturation_values";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_field_values (l1_qa, npixels, ESPA_L1_RAD_SATURATION_BIT,
+        values);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_cloud_confidence_values
+
+PURPOSE: Extracts the cloud confidence of each pixel.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+******************************************************************************/
+int level1_qa_cloud_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: cloud confidence (0-3) per pixel */
+)
+{
+    char FUNC_NAME[] = "level1_qa_cloud_confidence_values";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_field_values (l1_qa, npixels, ESPA_L1_CLOUD_CONF_BIT, values);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_cloud_shadow_confidence_values
+
+PURPOSE: Extracts the cloud shadow confidence of each pixel.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+******************************************************************************/
+int level1_qa_cloud_shadow_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: cloud shadow confidence (0-3) per pixel */
+)
+{
+    char FUNC_NAME[] = "level1_qa_cloud_shadow_confidence_values";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_field_values (l1_qa, npixels, ESPA_L1_CLOUD_SHADOW_CONF_BIT,
+        values);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_snow_ice_confidence_values
+
+PURPOSE: Extracts the snow/ice confidence of each pixel.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+******************************************************************************/
+int level1_qa_snow_ice_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: snow/ice confidence (0-3) per pixel */
+)
+{
+    char FUNC_NAME[] = "level1_qa_snow_ice_confidence_values";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_field_values (l1_qa, npixels, ESPA_L1_SNOW_ICE_CONF_BIT,
+        values);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_cirrus_confidence_values
+
+PURPOSE: Extracts the cirrus confidence of each pixel.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The QA category isn't a Collection 1 category
+SUCCESS         Successfully built
+
+NOTES:
+1. Cirrus confidence only applies to L8/OLI.
+******************************************************************************/
+int level1_qa_cirrus_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values (L8/OLI) */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: cirrus confidence (0-3) per pixel */
+)
+{
+    char FUNC_NAME[] = "level1_qa_cirrus_confidence_values";  /* function name */
+
+    if (check_c1_category (FUNC_NAME, qa_category) != SUCCESS)
+        return (ERROR);
+
+    level1_qa_field_values (l1_qa, npixels, ESPA_L1_CIRRUS_CONF_BIT, values);
+    return (SUCCESS);
+}
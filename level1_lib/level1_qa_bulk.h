@@ -0,0 +1,141 @@
+/*****************************************************************************
+FILE: level1_qa_bulk.h
+  
+PURPOSE: Contains function prototypes for evaluating the Level-1 QA
+predicates over whole arrays of Level-1 QA values.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The single-bit predicates (fill, terrain occlusion, dropped pixel, cloud)
+   produce packed bitmasks of (npixels + 7) / 8 bytes.  Pixel i is stored in
+   bit (i % 8) of byte (i / 8), and the unused bits of the last byte are
+   zero.
+2. The two-bit fields (radiometric saturation and the confidences) produce
+   one uint8 value (0-3) per pixel, matching the values returned by the
+   inline functions in read_level1_qa.h.
+3. The named masks and fields (level1_qa_fill_mask, etc.) decode the
+   Collection 1 bit positions, like the inline functions in read_level1_qa.h,
+   and return ERROR for LEVEL1_C2.  For the Collection 2 QA_PIXEL band, pass
+   the bits of get_level1_qa_layout to level1_qa_bit_mask and
+   level1_qa_field_values, or use the level1_qa_c2_* predicates of
+   level1_qa_layout.h.
+4. The bulk functions use SSE2 when the compiler targets it, and otherwise
+   fall back to scalar loops with the same results.
+*****************************************************************************/
+
+#ifndef LEVEL1_QA_BULK_H
+#define LEVEL1_QA_BULK_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "read_level1_qa.h"
+
+/* Function Prototypes */
+size_t level1_qa_mask_bytes
+(
+    size_t npixels          /* I: number of pixels */
+);
+
+void level1_qa_bit_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    int bit,                /* I: Level-1 QA bit to be tested */
+    uint8_t *mask           /* O: packed mask of the pixels with the bit set */
+);
+
+void level1_qa_field_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    int bit,                /* I: first Level-1 QA bit of the two-bit field */
+    uint8_t *values         /* O: value (0-3) of the field for each pixel */
+);
+
+int level1_qa_fill_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the fill pixels */
+);
+
+int level1_qa_terrain_occluded_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values (L8/OLI) */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the terrain occluded
+                                  pixels */
+);
+
+int level1_qa_dropped_pixel_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values (L4-7 TM/ETM+) */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the dropped pixels */
+);
+
+int level1_qa_cloud_mask
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *mask           /* O: packed mask of the cloud pixels */
+);
+
+int level1_qa_radiometric_saturation_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: radiometric saturation (0-3) per pixel */
+);
+
+int level1_qa_cloud_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: cloud confidence (0-3) per pixel */
+);
+
+int level1_qa_cloud_shadow_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: cloud shadow confidence (0-3) per pixel */
+);
+
+int level1_qa_snow_ice_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: snow/ice confidence (0-3) per pixel */
+);
+
+int level1_qa_cirrus_confidence_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values (L8/OLI) */
+    size_t npixels,         /* I: number of pixels */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7,
+                                           L8); C2 is an error */
+    uint8_t *values         /* O: cirrus confidence (0-3) per pixel */
+);
+
+#endif
@@ -0,0 +1,376 @@
+/*****************************************************************************
+FILE: level1_qa_histogram.c
+  
+PURPOSE: Contains functions for building the full histogram of the Level-1 QA
+band and deriving class counts from it.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. When compiled with OpenMP, each thread counts into its own histogram and
+   the thread histograms are merged once at the end, so the threads never
+   contend on a shared bin.
+2. Refer to http://landsat.usgs.gov/collectionqualityband.php for the Level-1
+   QA band information.
+*****************************************************************************/
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "level1_qa_histogram.h"
+
+/* Number of lines read at a time when building the histogram of the band */
+#define HISTOGRAM_STRIP_LINES 256
+
+/******************************************************************************
+MODULE:  alloc_thread_histograms
+
+PURPOSE: Allocates a zeroed histogram for each thread.
+
+RETURN VALUE:
+Type = uint64_t *
+Value           Description
+-----           -----------
+NULL            Error allocating the histograms
+not NULL        nthreads consecutive histograms of LEVEL1_QA_NBINS bins
+
+NOTES:
+******************************************************************************/
+static uint64_t *alloc_thread_histograms
+(
+    int *nthreads           /* O: number of thread histograms */
+)
+{
+    *nthreads = 1;
+#ifdef _OPENMP
+    *nthreads = omp_get_max_threads ();
+#endif
+
+    return (calloc ((size_t) *nthreads * LEVEL1_QA_NBINS, sizeof (uint64_t)));
+}
+
+
+/******************************************************************************
+MODULE:  accumulate_thread_histograms
+
+PURPOSE: Counts the Level-1 QA values into the thread histograms, with the
+pixels split evenly across the threads.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void accumulate_thread_histograms
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    int nthreads,           /* I: number of thread histograms */
+    uint64_t *thread_hist   /* I/O: thread histograms */
+)
+{
+    long i;                 /* current pixel */
+    uint64_t *hist = thread_hist;  /* histogram of the current thread */
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(nthreads) firstprivate(hist)
+#endif
+    {
+#ifdef _OPENMP
+        hist = &thread_hist[(size_t) omp_get_thread_num () * LEVEL1_QA_NBINS];
+        #pragma omp for schedule(static)
+#endif
+        for (i = 0; i < (long) npixels; i++)
+            hist[l1_qa[i]]++;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  merge_thread_histograms
+
+PURPOSE: Adds the thread histograms into the histogram.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void merge_thread_histograms
+(
+    int nthreads,           /* I: number of thread histograms */
+    uint64_t *thread_hist,  /* I: thread histograms */
+    uint64_t *histogram     /* I/O: histogram the counts are added to */
+)
+{
+    int thread;             /* current thread histogram */
+    long bin;               /* current bin */
+
+    for (thread = 0; thread < nthreads; thread++)
+    {
+        for (bin = 0; bin < LEVEL1_QA_NBINS; bin++)
+            histogram[bin] +=
+                thread_hist[(size_t) thread * LEVEL1_QA_NBINS + bin];
+    }
+}
+
+
+/******************************************************************************
+MODULE:  histogram_level1_qa_values
+
+PURPOSE: Adds the counts of the Level-1 QA values to the histogram.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error allocating the thread histograms
+SUCCESS         Successfully counted
+
+NOTES:
+1. The histogram is not cleared, so it may be accumulated over several
+   calls.
+******************************************************************************/
+int histogram_level1_qa_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    uint64_t *histogram     /* I/O: LEVEL1_QA_NBINS bins; the counts of the
+                                    pixels are added to the bins */
+)
+{
+    char FUNC_NAME[] = "histogram_level1_qa_values";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int nthreads;             /* number of thread histograms */
+    uint64_t *thread_hist = NULL;  /* thread histograms */
+
+    thread_hist = alloc_thread_histograms (&nthreads);
+    if (thread_hist == NULL)
+    {
+        sprintf (errmsg, "Allocating memory for the thread histograms");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    accumulate_thread_histograms (l1_qa, npixels, nthreads, thread_hist);
+    merge_thread_histograms (nthreads, thread_hist, histogram);
+    free (thread_hist);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  histogram_level1_qa
+
+PURPOSE: Builds the histogram of the Level-1 QA band in a single pass over
+the band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the band or allocating memory
+SUCCESS         Successfully built
+
+NOTES:
+1. The band is read HISTOGRAM_STRIP_LINES lines at a time from the current
+   position of fp_bqa, typically the start of the band as returned by
+   open_level1_qa.  Each strip is counted in parallel into the thread
+   histograms, which are merged once the whole band has been read.
+******************************************************************************/
+int histogram_level1_qa
+(
+    FILE *fp_bqa,           /* I: pointer to the Level-1 QA band open for
+                                  reading */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint64_t *histogram     /* O: LEVEL1_QA_NBINS bins of the QA band */
+)
+{
+    char FUNC_NAME[] = "histogram_level1_qa";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int line;                 /* first line of the current strip */
+    int strip_lines;          /* number of lines in the current strip */
+    int nthreads;             /* number of thread histograms */
+    uint16_t *l1_qa = NULL;   /* Level-1 QA values for the current strip */
+    uint64_t *thread_hist = NULL;  /* thread histograms */
+
+    memset (histogram, 0, LEVEL1_QA_NBINS * sizeof (uint64_t));
+
+    l1_qa = calloc ((size_t) HISTOGRAM_STRIP_LINES * nsamps,
+        sizeof (uint16_t));
+    thread_hist = alloc_thread_histograms (&nthreads);
+    if (l1_qa == NULL || thread_hist == NULL)
+    {
+        sprintf (errmsg, "Allocating memory for the Level-1 QA histogram");
+        error_handler (true, FUNC_NAME, errmsg);
+        free (l1_qa);
+        free (thread_hist);
+        return (ERROR);
+    }
+
+    for (line = 0; line < nlines; line += HISTOGRAM_STRIP_LINES)
+    {
+        strip_lines = nlines - line;
+        if (strip_lines > HISTOGRAM_STRIP_LINES)
+            strip_lines = HISTOGRAM_STRIP_LINES;
+
+        if (read_level1_qa (fp_bqa, strip_lines, nsamps, l1_qa) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to read the Level-1 QA band");
+            error_handler (true, FUNC_NAME, errmsg);
+            free (l1_qa);
+            free (thread_hist);
+            return (ERROR);
+        }
+
+        accumulate_thread_histograms (l1_qa, (size_t) strip_lines * nsamps,
+            nthreads, thread_hist);
+    }
+
+    merge_thread_histograms (nthreads, thread_hist, histogram);
+    free (l1_qa);
+    free (thread_hist);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_histogram_count
+
+PURPOSE: Counts the pixels of the histogram for which the predicate is true.
+
+RETURN VALUE:
+Type = uint64_t
+Value           Description
+-----           -----------
+n               Number of pixels
+
+NOTES:
+1. Fill pixels are counted like any other pixel, so exclude them in the
+   predicate if needed.
+******************************************************************************/
+uint64_t level1_qa_histogram_count
+(
+    uint64_t *histogram,    /* I: LEVEL1_QA_NBINS bins */
+    bool (*predicate) (uint16_t) /* I: Level-1 QA predicate, such as
+                                       level1_qa_is_cloud */
+)
+{
+    long bin;               /* current bin */
+    uint64_t count = 0;     /* number of pixels */
+
+    for (bin = 0; bin < LEVEL1_QA_NBINS; bin++)
+    {
+        if (histogram[bin] != 0 && predicate ((uint16_t) bin))
+            count += histogram[bin];
+    }
+
+    return (count);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_histogram_field_count
+
+PURPOSE: Counts the pixels of the histogram for which the decoded field has
+the specified value.
+
+RETURN VALUE:
+Type = uint64_t
+Value           Description
+-----           -----------
+n               Number of pixels
+
+NOTES:
+1. Fill pixels are counted like any other pixel.
+******************************************************************************/
+uint64_t level1_qa_histogram_field_count
+(
+    uint64_t *histogram,    /* I: LEVEL1_QA_NBINS bins */
+    uint8_t (*decoder) (uint16_t), /* I: Level-1 QA field decoder, such as
+                                         level1_qa_cloud_confidence */
+    uint8_t value           /* I: field value to be counted */
+)
+{
+    long bin;               /* current bin */
+    uint64_t count = 0;     /* number of pixels */
+
+    for (bin = 0; bin < LEVEL1_QA_NBINS; bin++)
+    {
+        if (histogram[bin] != 0 && decoder ((uint16_t) bin) == value)
+            count += histogram[bin];
+    }
+
+    return (count);
+}
+
+
+/******************************************************************************
+MODULE:  summarize_level1_qa_histogram
+
+PURPOSE: Derives the Level-1 QA class counts of the scene from its histogram.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Other than npixels and fill, the counts are for the non-fill pixels.
+2. The bits are taken from the layout of the QA category.  Fields the layout
+   doesn't have (e.g. dropped pixels for L8, terrain occlusion for L4-7) are
+   counted as 0, so their pixels all land in the 0 bin of the confidences.
+******************************************************************************/
+void summarize_level1_qa_histogram
+(
+    uint64_t *histogram,    /* I: LEVEL1_QA_NBINS bins */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7, L8,
+                                           C2) */
+    Level1_qa_summary_t *summary /* O: class counts of the histogram */
+)
+{
+    long bin;               /* current bin */
+    uint16_t qa;            /* Level-1 QA value of the bin */
+    uint64_t count;         /* number of pixels in the bin */
+    const Level1_qa_layout_t *layout = NULL; /* layout of the QA category */
+
+    memset (summary, 0, sizeof (Level1_qa_summary_t));
+    layout = get_level1_qa_layout (qa_category);
+    if (layout == NULL)
+        return;
+
+    for (bin = 0; bin < LEVEL1_QA_NBINS; bin++)
+    {
+        count = histogram[bin];
+        if (count == 0)
+            continue;
+
+        qa = (uint16_t) bin;
+        summary->npixels += count;
+        if (level1_qa_layout_field (layout->fill_bit, 1, qa))
+        {
+            summary->fill += count;
+            continue;
+        }
+
+        if (level1_qa_layout_field (layout->terrain_occlusion_bit, 1, qa))
+            summary->terrain_occluded += count;
+        if (level1_qa_layout_field (layout->dropped_pixel_bit, 1, qa))
+            summary->dropped_pixel += count;
+        if (level1_qa_layout_field (layout->cloud_bit, 1, qa))
+            summary->cloud += count;
+        summary->radiometric_saturation[level1_qa_layout_field (
+            layout->radiometric_saturation_bit, 2, qa)] += count;
+        summary->cloud_conf[level1_qa_layout_field (layout->cloud_conf_bit,
+            2, qa)] += count;
+        summary->cloud_shadow_conf[level1_qa_layout_field (
+            layout->cloud_shadow_conf_bit, 2, qa)] += count;
+        summary->snow_ice_conf[level1_qa_layout_field (
+            layout->snow_ice_conf_bit, 2, qa)] += count;
+        summary->cirrus_conf[level1_qa_layout_field (layout->cirrus_conf_bit,
+            2, qa)] += count;
+    }
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************
+FILE: level1_qa_histogram.h
+  
+PURPOSE: Contains defines, data types, and function prototypes for building
+the full histogram of the Level-1 QA band and deriving class counts from it.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The histogram has one bin for every possible 16-bit Level-1 QA value.
+   Since every predicate depends only on the QA value, any class count is a
+   sum over at most LEVEL1_QA_NBINS bins, regardless of the scene size.
+*****************************************************************************/
+
+#ifndef LEVEL1_QA_HISTOGRAM_H
+#define LEVEL1_QA_HISTOGRAM_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "read_level1_qa.h"
+#include "level1_qa_layout.h"
+
+/* Defines */
+#define LEVEL1_QA_NBINS 65536     /* number of histogram bins */
+
+/* Data types */
+typedef struct
+{
+    uint64_t npixels;             /* total number of pixels */
+    uint64_t fill;                /* number of fill pixels */
+    uint64_t terrain_occluded;    /* number of terrain occluded pixels (C1
+                                     L8) */
+    uint64_t dropped_pixel;       /* number of dropped pixels (C1 L4-7) */
+    uint64_t cloud;               /* number of cloud pixels */
+    uint64_t radiometric_saturation[4]; /* number of pixels for each
+                                     radiometric saturation value (0-3)
+                                     (C1) */
+    uint64_t cloud_conf[4];       /* number of pixels for each cloud
+                                     confidence value (0-3) */
+    uint64_t cloud_shadow_conf[4];/* number of pixels for each cloud shadow
+                                     confidence value (0-3) */
+    uint64_t snow_ice_conf[4];    /* number of pixels for each snow/ice
+                                     confidence value (0-3) */
+    uint64_t cirrus_conf[4];      /* number of pixels for each cirrus
+                                     confidence value (0-3) (C1 L8, C2) */
+} Level1_qa_summary_t;
+
+/* Function Prototypes */
+int histogram_level1_qa_values
+(
+    uint16_t *l1_qa,        /* I: Level-1 QA values */
+    size_t npixels,         /* I: number of pixels */
+    uint64_t *histogram     /* I/O: LEVEL1_QA_NBINS bins; the counts of the
+                                    pixels are added to the bins */
+);
+
+int histogram_level1_qa
+(
+    FILE *fp_bqa,           /* I: pointer to the Level-1 QA band open for
+                                  reading */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint64_t *histogram     /* O: LEVEL1_QA_NBINS bins of the QA band */
+);
+
+uint64_t level1_qa_histogram_count
+(
+    uint64_t *histogram,    /* I: LEVEL1_QA_NBINS bins */
+    bool (*predicate) (uint16_t) /* I: Level-1 QA predicate, such as
+                                       level1_qa_is_cloud */
+);
+
+uint64_t level1_qa_histogram_field_count
+(
+    uint64_t *histogram,    /* I: LEVEL1_QA_NBINS bins */
+    uint8_t (*decoder) (uint16_t), /* I: Level-1 QA field decoder, such as
+                                         level1_qa_cloud_confidence */
+    uint8_t value           /* I: field value to be counted */
+);
+
+void summarize_level1_qa_histogram
+(
+    uint64_t *histogram,    /* I: LEVEL1_QA_NBINS bins */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7, L8,
+                                           C2) */
+    Level1_qa_summary_t *summary /* O: class counts of the histogram */
+);
+
+#endif
@@ -0,0 +1,137 @@
+/*****************************************************************************
+FILE: level1_qa_layout.c
+  
+PURPOSE: Contains the runtime table of the Level-1 QA bit layouts and the
+functions for looking them up.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The table is generated from LEVEL1_QA_LAYOUT_TABLE in level1_qa_layout.h.
+*****************************************************************************/
+#include "level1_qa_layout.h"
+
+/* Expand each layout of the table into a descriptor */
+#define LEVEL1_QA_LAYOUT_ENTRY(NAME, CATEGORY, BAND, DESCRIPTION, \
+    FILL, DROPPED, TERRAIN, SATURATION, CLOUD, DILATED, CIRRUS, SHADOW, \
+    SNOW, CLEAR, WATER, CLOUD_CONF, SHADOW_CONF, SNOW_CONF, CIRRUS_CONF) \
+    {CATEGORY, BAND, DESCRIPTION, FILL, DROPPED, TERRAIN, SATURATION, CLOUD, \
+     DILATED, CIRRUS, SHADOW, SNOW, CLEAR, WATER, CLOUD_CONF, SHADOW_CONF, \
+     SNOW_CONF, CIRRUS_CONF},
+
+static const Level1_qa_layout_t level1_qa_layouts[] =
+{
+    LEVEL1_QA_LAYOUT_TABLE (LEVEL1_QA_LAYOUT_ENTRY)
+};
+
+#define NUM_LEVEL1_QA_LAYOUTS \
+    (sizeof (level1_qa_layouts) / sizeof (level1_qa_layouts[0]))
+
+
+/******************************************************************************
+MODULE:  get_level1_qa_layout
+
+PURPOSE: Returns the bit layout of the type of Level-1 QA data.
+
+RETURN VALUE:
+Type = const Level1_qa_layout_t *
+Value           Description
+-----           -----------
+NULL            Unknown type of Level-1 QA data
+not NULL        Layout of the Level-1 QA data
+
+NOTES:
+******************************************************************************/
+const Level1_qa_layout_t *get_level1_qa_layout
+(
+    Espa_level1_qa_type qa_category /* I: type of Level-1 QA data */
+)
+{
+    size_t i;               /* looping variable */
+
+    for (i = 0; i < NUM_LEVEL1_QA_LAYOUTS; i++)
+    {
+        if (level1_qa_layouts[i].qa_category == qa_category)
+            return (&level1_qa_layouts[i]);
+    }
+
+    return (NULL);
+}
+
+
+/******************************************************************************
+MODULE:  find_level1_qa_layout
+
+PURPOSE: Determines the bit layout of a Level-1 QA band from its band name in
+the XML file and, for layouts which share a band name, the instrument.
+
+RETURN VALUE:
+Type = const Level1_qa_layout_t *
+Value           Description
+-----           -----------
+NULL            The band isn't a known Level-1 QA band
+not NULL        Layout of the Level-1 QA band
+
+NOTES:
+1. The Collection 1 TM/ETM+ and OLI/TIRS layouts share the bqa band name and
+   are told apart by get_level1_qa_category.
+******************************************************************************/
+const Level1_qa_layout_t *find_level1_qa_layout
+(
+    char *band_name,        /* I: name of the QA band in the XML file */
+    Espa_global_meta_t *gmeta /* I: global metadata from the XML file */
+)
+{
+    size_t i;               /* looping variable */
+    Espa_level1_qa_type instrument_category; /* Collection 1 category of the
+                               instrument */
+
+    instrument_category = get_level1_qa_category (gmeta);
+    for (i = 0; i < NUM_LEVEL1_QA_LAYOUTS; i++)
+    {
+        if (strcmp (level1_qa_layouts[i].band_name, band_name))
+            continue;
+
+        if (!strcmp (band_name, "bqa") &&
+            level1_qa_layouts[i].qa_category != instrument_category)
+            continue;
+
+        return (&level1_qa_layouts[i]);
+    }
+
+    return (NULL);
+}
+
+
+/******************************************************************************
+MODULE:  level1_qa_layout_field
+
+PURPOSE: Returns the value of a field of the Level-1 QA value, using a bit
+position from a layout descriptor at runtime.
+
+RETURN VALUE:
+Type = uint8_t
+Value           Description
+-----           -----------
+0-3             Value of the field; 0 if the layout doesn't have the field
+
+NOTES:
+1. This is the generic counterpart of the specialized inline predicates, for
+   code where the layout varies and speed isn't a concern.
+******************************************************************************/
+uint8_t level1_qa_layout_field
+(
+    int bit,                /* I: first bit of the field, or
+                                  LEVEL1_QA_NO_BIT */
+    int nbits,              /* I: number of bits in the field */
+    uint16_t l1_qa_pix      /* I: Level-1 QA value for current pixel */
+)
+{
+    if (bit == LEVEL1_QA_NO_BIT)
+        return (0);
+
+    return ((l1_qa_pix >> bit) & ((1 << nbits) - 1));
+}
@@ -0,0 +1,188 @@
+/*****************************************************************************
+FILE: level1_qa_layout.h
+  
+PURPOSE: Contains the bit layout descriptors of each supported Level-1 QA
+band, and the layout-specialized predicates generated from them.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. LEVEL1_QA_LAYOUT_TABLE is the single description of every layout.  It is
+   expanded at compile time into the runtime descriptor table, into the
+   inline predicates below (level1_qa_<name>_is_fill, etc.), and into the
+   specialized pixel QA translation kernels in generate_pixel_qa.c.  The bit
+   positions are constants in each expansion, so the specialized code has no
+   layout checks in its per-pixel loop.
+2. Supporting a new collection only needs a new line in the table.
+3. Refer to http://landsat.usgs.gov/collectionqualityband.php for the
+   Collection 1 Level-1 QA band, and to the Collection 2 Level-1 Data Format
+   Control Book for the QA_PIXEL band.
+*****************************************************************************/
+
+#ifndef LEVEL1_QA_LAYOUT_H
+#define LEVEL1_QA_LAYOUT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "read_level1_qa.h"
+
+/* Defines */
+#define LEVEL1_QA_NO_BIT -1     /* the layout doesn't have the field */
+
+/* Layout table.  Each entry is
+   LAYOUT (name, qa_category, band name, description,
+           fill, dropped pixel, terrain occlusion, radiometric saturation,
+           cloud, dilated cloud, cirrus, cloud shadow, snow, clear, water,
+           cloud conf, cloud shadow conf, snow/ice conf, cirrus conf)
+   where each field is the first bit of the field or LEVEL1_QA_NO_BIT.  The
+   saturation and confidence fields are two bits, the others one bit. */
+#define LEVEL1_QA_LAYOUT_TABLE(LAYOUT) \
+    LAYOUT (c1_tm_etm, LEVEL1_L457, "bqa", "Collection 1 TM/ETM+", \
+        0, 1, -1, 2, 4, -1, -1, -1, -1, -1, -1, 5, 7, 9, -1) \
+    LAYOUT (c1_oli, LEVEL1_L8, "bqa", "Collection 1 OLI/TIRS", \
+        0, -1, 1, 2, 4, -1, -1, -1, -1, -1, -1, 5, 7, 9, 11) \
+    LAYOUT (c2, LEVEL1_C2, "qa_pixel", "Collection 2 L4-9 QA_PIXEL", \
+        0, -1, -1, -1, 3, 1, 2, 4, 5, 6, 7, 8, 10, 12, 14)
+
+/* Data types */
+typedef struct
+{
+    Espa_level1_qa_type qa_category; /* type of Level-1 QA data */
+    char *band_name;              /* name of the QA band in the XML file */
+    char *description;            /* description of the layout */
+    int fill_bit;                 /* designated fill */
+    int dropped_pixel_bit;        /* dropped pixel */
+    int terrain_occlusion_bit;    /* terrain occlusion */
+    int radiometric_saturation_bit; /* radiometric saturation (two bits) */
+    int cloud_bit;                /* cloud */
+    int dilated_cloud_bit;        /* dilated cloud */
+    int cirrus_bit;               /* cirrus */
+    int cloud_shadow_bit;         /* cloud shadow */
+    int snow_bit;                 /* snow */
+    int clear_bit;                /* clear */
+    int water_bit;                /* water */
+    int cloud_conf_bit;           /* cloud confidence (two bits) */
+    int cloud_shadow_conf_bit;    /* cloud shadow confidence (two bits) */
+    int snow_ice_conf_bit;        /* snow/ice confidence (two bits) */
+    int cirrus_conf_bit;          /* cirrus confidence (two bits) */
+} Level1_qa_layout_t;
+
+/* Function Prototypes */
+const Level1_qa_layout_t *get_level1_qa_layout
+(
+    Espa_level1_qa_type qa_category /* I: type of Level-1 QA data */
+);
+
+const Level1_qa_layout_t *find_level1_qa_layout
+(
+    char *band_name,        /* I: name of the QA band in the XML file */
+    Espa_global_meta_t *gmeta /* I: global metadata from the XML file */
+);
+
+uint8_t level1_qa_layout_field
+(
+    int bit,                /* I: first bit of the field, or
+                                  LEVEL1_QA_NO_BIT */
+    int nbits,              /* I: number of bits in the field */
+    uint16_t l1_qa_pix      /* I: Level-1 QA value for current pixel */
+);
+
+
+/* Inline Function Prototypes */
+
+/******************************************************************************
+MODULE:  LEVEL1_QA_DEFINE_PREDICATES
+
+PURPOSE: Defines the predicates of a layout with its bit positions as
+constants.  For the layout named c1_oli these are level1_qa_c1_oli_is_fill,
+level1_qa_c1_oli_is_cloud, level1_qa_c1_oli_is_terrain_occluded,
+level1_qa_c1_oli_is_dropped_pixel, level1_qa_c1_oli_is_dilated_cloud,
+level1_qa_c1_oli_is_cirrus, level1_qa_c1_oli_is_cloud_shadow,
+level1_qa_c1_oli_is_snow, level1_qa_c1_oli_is_clear,
+level1_qa_c1_oli_is_water, level1_qa_c1_oli_radiometric_saturation,
+level1_qa_c1_oli_cloud_confidence, level1_qa_c1_oli_cloud_shadow_confidence,
+level1_qa_c1_oli_snow_ice_confidence, and level1_qa_c1_oli_cirrus_confidence.
+
+NOTES:
+1. A field the layout doesn't have is always false or 0.  The bit position is
+   a constant, so the check is resolved at compile time.
+******************************************************************************/
+#define LEVEL1_QA_FIELD(PIX, BIT, MASK) \
+    (((BIT) < 0) ? 0 : (((PIX) >> ((BIT) < 0 ? 0 : (BIT))) & (MASK)))
+
+#define LEVEL1_QA_DEFINE_PREDICATES(NAME, CATEGORY, BAND, DESCRIPTION, \
+    FILL, DROPPED, TERRAIN, SATURATION, CLOUD, DILATED, CIRRUS, SHADOW, \
+    SNOW, CLEAR, WATER, CLOUD_CONF, SHADOW_CONF, SNOW_CONF, CIRRUS_CONF) \
+static inline bool level1_qa_##NAME##_is_fill (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, FILL, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_cloud (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, CLOUD, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_terrain_occluded \
+    (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, TERRAIN, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_dropped_pixel (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, DROPPED, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_dilated_cloud (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, DILATED, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_cirrus (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, CIRRUS, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_cloud_shadow (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, SHADOW, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_snow (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, SNOW, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_clear (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, CLEAR, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline bool level1_qa_##NAME##_is_water (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, WATER, ESPA_L1_SINGLE_BIT) == 1); \
+} \
+static inline uint8_t level1_qa_##NAME##_radiometric_saturation \
+    (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, SATURATION, ESPA_L1_DOUBLE_BIT)); \
+} \
+static inline uint8_t level1_qa_##NAME##_cloud_confidence \
+    (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, CLOUD_CONF, ESPA_L1_DOUBLE_BIT)); \
+} \
+static inline uint8_t level1_qa_##NAME##_cloud_shadow_confidence \
+    (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, SHADOW_CONF, ESPA_L1_DOUBLE_BIT)); \
+} \
+static inline uint8_t level1_qa_##NAME##_snow_ice_confidence \
+    (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, SNOW_CONF, ESPA_L1_DOUBLE_BIT)); \
+} \
+static inline uint8_t level1_qa_##NAME##_cirrus_confidence \
+    (uint16_t l1_qa_pix) \
+{ \
+    return (LEVEL1_QA_FIELD (l1_qa_pix, CIRRUS_CONF, ESPA_L1_DOUBLE_BIT)); \
+}
+
+LEVEL1_QA_LAYOUT_TABLE (LEVEL1_QA_DEFINE_PREDICATES)
+
+#endif
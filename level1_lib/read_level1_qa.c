@@ -18,6 +18,8 @@ NOTES:
    QA band information.
 *****************************************************************************/
 #include "read_level1_qa.h"
+#include "level1_qa_layout.h"
+#include "l2qa_timing.h"
 
 /******************************************************************************
 MODULE:  open_level1_qa
@@ -37,6 +39,8 @@ NOTES:
    when obtaining information about the QA band from the XML file.
 2. A file pointer to the Level-1 QA band will be returned. It is expected the
    calling routine will handle closing this file pointer when complete.
+3. The Collection 1 (bqa) and Collection 2 (qa_pixel) QA bands are
+   recognized, using the layouts in level1_qa_layout.h.
 ******************************************************************************/
 FILE *open_level1_qa
 (
@@ -45,13 +49,16 @@ FILE *open_level1_qa
                                  allocated ahead of time) */
     int *nlines,           /* O: number of lines in the QA band */
     int *nsamps,           /* O: number of samples in the QA band */
-    Espa_level1_qa_type *qa_category /* O: type of Level-1 QA data (L4-7, L8) */
+    Espa_level1_qa_type *qa_category /* O: type of Level-1 QA data (L4-7, L8,
+                                           C2) */
 )
 {
     char FUNC_NAME[] = "open_level1_qa";  /* function name */
     char errmsg[STR_SIZE];    /* error message */
+    L2qa_timer_t timer;       /* start time of the timed phase */
     int i;                    /* looping variable */
-    bool found;               /* was the Level-1 QA band found? */
+    const Level1_qa_layout_t *layout = NULL; /* layout of the Level-1 QA
+                                 band; NULL until the band is found */
     Espa_internal_meta_t xml_metadata;  /* XML metadata structure to be
                                  populated by reading the XML metadata file */
     Espa_global_meta_t *gmeta;/* pointer to the global metadata structure */
@@ -59,10 +66,13 @@ FILE *open_level1_qa
     FILE *fp_bqa = NULL;      /* file pointer for the band quality band */
 
     /* Validate the input metadata file */
+    l2qa_timer_start (&timer);
     if (validate_xml_file (espa_xml_file) != SUCCESS)
     {  /* Error messages already written */
         return (NULL);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_VALIDATE_XML,
+        l2qa_timing_file_size (espa_xml_file), 0);
 
     /* Initialize the metadata structure */
     init_metadata_struct (&xml_metadata);
@@ -70,19 +80,23 @@ FILE *open_level1_qa
     /* Parse the metadata file into our internal metadata structure; also
        allocates space as needed for various pointers in the global and band
        metadata */
+    l2qa_timer_start (&timer);
     if (parse_metadata (espa_xml_file, &xml_metadata) != SUCCESS)
     {  /* Error messages already written */
         return (NULL);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_PARSE_METADATA,
+        l2qa_timing_file_size (espa_xml_file), 0);
     gmeta = &xml_metadata.global;
     bmeta = xml_metadata.band;
 
     /* Loop through the bands and look for the Level-1 QA band */
-    found = false;
     for (i = 0; i < xml_metadata.nbands; i++)
     {
         /* Is this the Level-1 quality band */
-        if (!strcmp (bmeta[i].name, "bqa") && !strcmp (bmeta[i].category, "qa"))
+        if (!strcmp (bmeta[i].category, "qa"))
+            layout = find_level1_qa_layout (bmeta[i].name, gmeta);
+        if (layout != NULL)
         {
             strcpy (l1_qa_file, bmeta[i].file_name);
             *nlines = bmeta[i].nlines;
@@ -95,13 +109,12 @@ FILE *open_level1_qa
                 error_handler (true, FUNC_NAME, errmsg);
                 return (NULL);
             }
-            found = true;
             break;
         }
     }
 
     /* Make sure the Level-1 QA band was found */
-    if (!found)
+    if (layout == NULL)
     {
         sprintf (errmsg, "Unable to find the Level-1 QA band");
         error_handler (true, FUNC_NAME, errmsg);
@@ -117,11 +130,8 @@ FILE *open_level1_qa
         return (NULL);
     }
 
-    /* Determine the instrument type for actual QA bit identification */
-    if (!strcmp (gmeta->instrument, "TM") || !strcmp (gmeta->instrument, "ETM"))
-        *qa_category = LEVEL1_L457;
-    else
-        *qa_category = LEVEL1_L8;
+    /* Identify the layout for actual QA bit identification */
+    *qa_category = layout->qa_category;
 
     /* Free the metadata structure */
     free_metadata (&xml_metadata);
@@ -160,8 +170,10 @@ int read_level1_qa
 {
     char FUNC_NAME[] = "read_level1_qa";  /* function name */
     char errmsg[STR_SIZE];    /* error message */
+    L2qa_timer_t timer;       /* start time of the read */
 
     /* Read the current line from the band quality band */
+    l2qa_timer_start (&timer);
     if (read_raw_binary (fp_bqa, nlines, nsamps, sizeof (uint16_t), level1_qa)
         != SUCCESS)
     {   
@@ -169,12 +181,47 @@ int read_level1_qa
         error_handler (true, FUNC_NAME, errmsg);
         return (ERROR);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_READ,
+        (long long) nlines * nsamps * sizeof (uint16_t),
+        (long long) nlines * nsamps);
 
     /* Successful read */
     return (SUCCESS);
 }
 
 
+/******************************************************************************
+MODULE:  get_level1_qa_category
+
+PURPOSE: Determines the type of Level-1 QA data from the instrument in the
+global metadata.
+
+RETURN VALUE:
+Type = Espa_level1_qa_type
+Value           Description
+-----           -----------
+LEVEL1_L457     TM or ETM+ Level-1 QA
+LEVEL1_L8       OLI/TIRS Level-1 QA
+
+NOTES:
+1. open_level1_qa uses this to tell the Collection 1 layouts apart.  It's
+   also available to applications which obtain the Level-1 QA values some
+   other way (i.e. a QA stream) and need the matching bit layout.
+2. Only the Collection 1 categories are returned.  The Collection 2 QA_PIXEL
+   band is identified by its band name (see find_level1_qa_layout).
+******************************************************************************/
+Espa_level1_qa_type get_level1_qa_category
+(
+    Espa_global_meta_t *gmeta  /* I: global metadata from the XML file */
+)
+{
+    if (!strcmp (gmeta->instrument, "TM") || !strcmp (gmeta->instrument, "ETM"))
+        return (LEVEL1_L457);
+    else
+        return (LEVEL1_L8);
+}
+
+
 /******************************************************************************
 MODULE:  close_level1_qa
 
@@ -9,6 +9,11 @@ at the USGS EROS
 LICENSE TYPE:  NASA Open Source Agreement Version 1.3
 
 NOTES:
+1. The ESPA_L1_* bits and the inline functions below decode the Collection 1
+   Level-1 QA band (LEVEL1_L457 and LEVEL1_L8) only.  open_level1_qa also
+   opens the Collection 2 QA_PIXEL band (LEVEL1_C2), whose bits are at other
+   positions; decode it with the level1_qa_c2_* functions of
+   level1_qa_layout.h.
 *****************************************************************************/
 
 #ifndef READ_LEVEL1_QA_H
@@ -41,8 +46,9 @@ NOTES:
 /* Data types */
 typedef enum
 {
-    LEVEL1_L457, LEVEL1_L8
-} Espa_level1_qa_type;
+    LEVEL1_L457, LEVEL1_L8, LEVEL1_C2
+} Espa_level1_qa_type;   /* Collection 1 L4-7, Collection 1 L8, and
+                            Collection 2 L4-9 QA_PIXEL */
 
 /* Function Prototypes */
 FILE *open_level1_qa
@@ -51,7 +57,8 @@ FILE *open_level1_qa
     char *l1_qa_file,      /* O: output Level-1 QA filename */
     int *nlines,           /* O: number of lines in the QA band */
     int *nsamps,           /* O: number of samples in the QA band */
-    Espa_level1_qa_type *qa_category /* O: type of Level-1 QA data (L4-7, L8) */
+    Espa_level1_qa_type *qa_category /* O: type of Level-1 QA data (L4-7, L8,
+                                           C2) */
 );
 
 int read_level1_qa
@@ -66,6 +73,11 @@ int read_level1_qa
                                  calling this routine) */
 );
 
+Espa_level1_qa_type get_level1_qa_category
+(
+    Espa_global_meta_t *gmeta  /* I: global metadata from the XML file */
+);
+
 void close_level1_qa
 (
     FILE *fp_bqa           /* I/O: pointer to the open Level-1 QA band;will
@@ -0,0 +1,200 @@
+#! /usr/bin/env python
+import numpy
+
+# Define the Level-2 QA bit values, as in read_level2_qa.h
+ESPA_L2_SINGLE_BIT = 0x01            # 00000001
+ESPA_L2_DOUBLE_BIT = 0x03            # 00000011
+
+# LEDAPS QA bits - cloud
+LEDAPS_DDV_BIT = 0                   # one bit
+LEDAPS_CLOUD_BIT = 1                 # one bit
+LEDAPS_CLOUD_SHADOW_BIT = 2          # one bit
+LEDAPS_ADJ_CLOUD_BIT = 3             # one bit
+LEDAPS_SNOW_BIT = 4                  # one bit
+LEDAPS_LAND_WATER_BIT = 5            # one bit (1=land, 0=water)
+
+# LEDAPS QA bits - radsat
+LEDAPS_FILL_BIT = 0                  # one bit
+LEDAPS_B1_SAT_BIT = 1                # one bit
+LEDAPS_B2_SAT_BIT = 2                # one bit
+LEDAPS_B3_SAT_BIT = 3                # one bit
+LEDAPS_B4_SAT_BIT = 4                # one bit
+LEDAPS_B5_SAT_BIT = 5                # one bit
+LEDAPS_B6_SAT_BIT = 6                # one bit
+LEDAPS_B7_SAT_BIT = 7                # one bit
+
+# LaSRC QA bits - aerosol (bits 4 and 5 are internal use only)
+LASRC_FILL_BIT = 0                   # one bit
+LASRC_VALID_AEROSOL_RET_BIT = 1      # one bit
+LASRC_AEROSOL_INTERP_BIT = 2         # one bit
+LASRC_WATER_BIT = 3                  # one bit
+LASRC_AEROSOL_LEVEL_BIT = 6          # two bits
+
+# LaSRC QA bits - radsat
+LASRC_B1_SAT_BIT = 1                 # one bit
+LASRC_B2_SAT_BIT = 2                 # one bit
+LASRC_B3_SAT_BIT = 3                 # one bit
+LASRC_B4_SAT_BIT = 4                 # one bit
+LASRC_B5_SAT_BIT = 5                 # one bit
+LASRC_B6_SAT_BIT = 6                 # one bit
+LASRC_B7_SAT_BIT = 7                 # one bit
+LASRC_B8_SAT_BIT = 8                 # one bit
+LASRC_B9_SAT_BIT = 9                 # one bit
+LASRC_B10_SAT_BIT = 10               # one bit
+LASRC_B11_SAT_BIT = 11               # one bit
+
+# The functions below mirror the inline functions of read_level2_qa.h.  They
+# take a Level-2 QA value or a NumPy array of them (any shape) and work on the
+# whole array with vectorized shifts and masks, returning a boolean array for
+# the single-bit tests and a uint8 array (0-3) for the aerosol level.  The
+# LEDAPS and LaSRC aerosol bands are uint8, and the LaSRC radsat band is
+# uint16.
+
+
+'''Determines which of the Level-2 QA values have the specified single bit
+   set.
+'''
+def _level2_qa_single_bit(l2_qa, bit, dtype):
+    l2_qa = numpy.asarray(l2_qa, dtype=dtype)
+    return (l2_qa & dtype(ESPA_L2_SINGLE_BIT << bit)) != 0
+
+
+'''Determines if the LEDAPS radsat QA pixels are fill
+
+Returns:
+    True where the pixel is fill
+'''
+def ledaps_qa_is_fill(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LEDAPS_FILL_BIT, numpy.uint8)
+
+
+'''Determines if the LEDAPS radsat QA pixels are saturated in the band of
+   the specified bit (LEDAPS_B1_SAT_BIT, ..., LEDAPS_B7_SAT_BIT)
+
+Returns:
+    True where the pixel is saturated
+'''
+def ledaps_qa_is_saturated(l2_qa, bit):
+    return _level2_qa_single_bit(l2_qa, bit, numpy.uint8)
+
+
+'''Determines if the LEDAPS cloud QA pixels are dark dense vegetation
+
+Returns:
+    True where the pixel is DDV
+'''
+def ledaps_qa_is_ddv(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LEDAPS_DDV_BIT, numpy.uint8)
+
+
+'''Determines if the LEDAPS cloud QA pixels are cloud
+
+Returns:
+    True where the pixel is cloud
+'''
+def ledaps_qa_is_cloud(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LEDAPS_CLOUD_BIT, numpy.uint8)
+
+
+'''Determines if the LEDAPS cloud QA pixels are cloud shadow
+
+Returns:
+    True where the pixel is cloud shadow
+'''
+def ledaps_qa_is_cloud_shadow(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LEDAPS_CLOUD_SHADOW_BIT, numpy.uint8)
+
+
+'''Determines if the LEDAPS cloud QA pixels are adjacent to cloud
+
+Returns:
+    True where the pixel is adjacent cloud
+'''
+def ledaps_qa_is_adj_cloud(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LEDAPS_ADJ_CLOUD_BIT, numpy.uint8)
+
+
+'''Determines if the LEDAPS cloud QA pixels are snow
+
+Returns:
+    True where the pixel is snow
+'''
+def ledaps_qa_is_snow(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LEDAPS_SNOW_BIT, numpy.uint8)
+
+
+'''Determines if the LEDAPS cloud QA pixels are land (rather than water)
+
+Returns:
+    True where the pixel is land
+    False where the pixel is water
+'''
+def ledaps_qa_is_land_water(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LEDAPS_LAND_WATER_BIT, numpy.uint8)
+
+
+'''Determines if the LaSRC radsat QA pixels are fill
+
+Returns:
+    True where the pixel is fill
+'''
+def lasrc_radsat_qa_is_fill(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LASRC_FILL_BIT, numpy.uint16)
+
+
+'''Determines if the LaSRC radsat QA pixels are saturated in the band of the
+   specified bit (LASRC_B1_SAT_BIT, ..., LASRC_B11_SAT_BIT)
+
+Returns:
+    True where the pixel is saturated
+'''
+def lasrc_radsat_qa_is_saturated(l2_qa, bit):
+    return _level2_qa_single_bit(l2_qa, bit, numpy.uint16)
+
+
+'''Determines if the LaSRC aerosol QA pixels are fill
+
+Returns:
+    True where the pixel is fill
+'''
+def lasrc_qa_is_fill(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LASRC_FILL_BIT, numpy.uint8)
+
+
+'''Determines if the LaSRC aerosol QA pixels are valid aerosol retrievals
+
+Returns:
+    True where the aerosol retrieval is valid
+'''
+def lasrc_qa_is_valid_aerosol_retrieval(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LASRC_VALID_AEROSOL_RET_BIT,
+                                 numpy.uint8)
+
+
+'''Determines if the LaSRC aerosol QA pixels are aerosol interpolated
+
+Returns:
+    True where the aerosol is interpolated
+'''
+def lasrc_qa_is_aerosol_interp(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LASRC_AEROSOL_INTERP_BIT, numpy.uint8)
+
+
+'''Determines if the LaSRC aerosol QA pixels are water
+
+Returns:
+    True where the pixel is water
+'''
+def lasrc_qa_is_water(l2_qa):
+    return _level2_qa_single_bit(l2_qa, LASRC_WATER_BIT, numpy.uint8)
+
+
+'''Returns the aerosol level (0-3) of the LaSRC aerosol QA pixels
+
+Returns:
+    0-3 from the aerosol level bits (00, 01, 10, 11)
+'''
+def lasrc_qa_aerosol_level(l2_qa):
+    l2_qa = numpy.asarray(l2_qa, dtype=numpy.uint8)
+    return (l2_qa >> numpy.uint8(LASRC_AEROSOL_LEVEL_BIT)) & \
+        numpy.uint8(ESPA_L2_DOUBLE_BIT)
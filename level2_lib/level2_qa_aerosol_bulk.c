@@ -0,0 +1,296 @@
+/*****************************************************************************
+FILE: level2_qa_aerosol_bulk.c
+  
+PURPOSE: Contains functions for decoding whole arrays and strips of the
+LaSRC aerosol QA band.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The SSE2 path handles 16 pixels at a time.  The remaining pixels are
+   handled by the scalar loop, which is also the complete implementation
+   when SSE2 isn't available.
+*****************************************************************************/
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "level2_qa_aerosol_bulk.h"
+
+/******************************************************************************
+MODULE:  level2_qa_mask_bytes
+
+PURPOSE: Returns the number of bytes in a packed mask of the pixels.
+
+RETURN VALUE:
+Type = size_t
+Value           Description
+-----           -----------
+n               Number of bytes in the mask
+
+NOTES:
+******************************************************************************/
+size_t level2_qa_mask_bytes
+(
+    size_t npixels          /* I: number of pixels */
+)
+{
+    return ((npixels + 7) / 8);
+}
+
+
+/******************************************************************************
+MODULE:  decode_lasrc_aerosol_values
+
+PURPOSE: Decodes the aerosol level, the water, valid retrieval, and
+interpolated masks, and the category counts of the LaSRC aerosol QA values
+in one pass.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. With SSE2, each QA bit of interest is shifted into the top bit of each
+   byte and movemask gathers it for the 16 pixels.  The same bit words give
+   the counts with a popcount, including the aerosol level counts from the
+   two level bits.
+******************************************************************************/
+void decode_lasrc_aerosol_values
+(
+    uint8_t *l2_qa,         /* I: LaSRC aerosol QA values */
+    size_t npixels,         /* I: number of pixels */
+    uint8_t *level,         /* O: aerosol level (0-3) per pixel (or NULL) */
+    uint8_t *water_mask,    /* O: packed mask of the water pixels (or NULL) */
+    uint8_t *valid_mask,    /* O: packed mask of the valid aerosol
+                                  retrievals (or NULL) */
+    uint8_t *interp_mask,   /* O: packed mask of the aerosol interpolated
+                                  pixels (or NULL) */
+    Lasrc_aerosol_counts_t *counts /* I/O: the counts of the pixels are added
+                                           to the counts (or NULL) */
+)
+{
+    size_t i = 0;           /* current pixel */
+    size_t k;               /* current pixel within the byte */
+    uint8_t pix;            /* current QA value */
+    uint8_t lev;            /* aerosol level of the current pixel */
+    uint8_t water_byte;     /* current byte of the water mask */
+    uint8_t valid_byte;     /* current byte of the valid retrieval mask */
+    uint8_t interp_byte;    /* current byte of the interpolated mask */
+    Lasrc_aerosol_counts_t local; /* counts of these pixels */
+#ifdef __SSE2__
+    int fill_bits;          /* fill bit of the 16 pixels */
+    int water_bits;         /* water bit of the 16 pixels */
+    int valid_bits;         /* valid retrieval bit of the 16 pixels */
+    int interp_bits;        /* interpolated bit of the 16 pixels */
+    int lo_bits;            /* low aerosol level bit of the 16 pixels */
+    int hi_bits;            /* high aerosol level bit of the 16 pixels */
+    __m128i qa;             /* QA values for 16 pixels */
+    __m128i level_field = _mm_set1_epi8 (ESPA_L2_DOUBLE_BIT); /* level mask */
+#endif
+
+    memset (&local, 0, sizeof (local));
+
+#ifdef __SSE2__
+    for (; i + 16 <= npixels; i += 16)
+    {
+        qa = _mm_loadu_si128 ((__m128i *) &l2_qa[i]);
+
+        if (level != NULL)
+            _mm_storeu_si128 ((__m128i *) &level[i], _mm_and_si128 (
+                _mm_srli_epi16 (qa, LASRC_AEROSOL_LEVEL_BIT), level_field));
+
+        fill_bits = _mm_movemask_epi8 (_mm_slli_epi16 (qa,
+            7 - LASRC_FILL_BIT));
+        valid_bits = _mm_movemask_epi8 (_mm_slli_epi16 (qa,
+            7 - LASRC_VALID_AEROSOL_RET_BIT));
+        interp_bits = _mm_movemask_epi8 (_mm_slli_epi16 (qa,
+            7 - LASRC_AEROSOL_INTERP_BIT));
+        water_bits = _mm_movemask_epi8 (_mm_slli_epi16 (qa,
+            7 - LASRC_WATER_BIT));
+        lo_bits = _mm_movemask_epi8 (_mm_slli_epi16 (qa,
+            7 - LASRC_AEROSOL_LEVEL_BIT));
+        hi_bits = _mm_movemask_epi8 (_mm_slli_epi16 (qa,
+            6 - LASRC_AEROSOL_LEVEL_BIT));
+
+        if (water_mask != NULL)
+        {
+            water_mask[i / 8] = water_bits & 0xff;
+            water_mask[i / 8 + 1] = (water_bits >> 8) & 0xff;
+        }
+        if (valid_mask != NULL)
+        {
+            valid_mask[i / 8] = valid_bits & 0xff;
+            valid_mask[i / 8 + 1] = (valid_bits >> 8) & 0xff;
+        }
+        if (interp_mask != NULL)
+        {
+            interp_mask[i / 8] = interp_bits & 0xff;
+            interp_mask[i / 8 + 1] = (interp_bits >> 8) & 0xff;
+        }
+
+        local.fill += __builtin_popcount (fill_bits);
+        local.valid += __builtin_popcount (valid_bits);
+        local.interp += __builtin_popcount (interp_bits);
+        local.water += __builtin_popcount (water_bits);
+        local.level[1] += __builtin_popcount (lo_bits & ~hi_bits);
+        local.level[2] += __builtin_popcount (hi_bits & ~lo_bits);
+        local.level[3] += __builtin_popcount (hi_bits & lo_bits);
+    }
+#endif
+
+    for (; i < npixels; i += 8)
+    {
+        water_byte = 0;
+        valid_byte = 0;
+        interp_byte = 0;
+        for (k = 0; k < 8 && i + k < npixels; k++)
+        {
+            pix = l2_qa[i + k];
+            lev = (pix >> LASRC_AEROSOL_LEVEL_BIT) & ESPA_L2_DOUBLE_BIT;
+            if (level != NULL)
+                level[i + k] = lev;
+            water_byte |= ((pix >> LASRC_WATER_BIT) & ESPA_L2_SINGLE_BIT) << k;
+            valid_byte |= ((pix >> LASRC_VALID_AEROSOL_RET_BIT) &
+                ESPA_L2_SINGLE_BIT) << k;
+            interp_byte |= ((pix >> LASRC_AEROSOL_INTERP_BIT) &
+                ESPA_L2_SINGLE_BIT) << k;
+            local.fill += (pix >> LASRC_FILL_BIT) & ESPA_L2_SINGLE_BIT;
+            local.level[lev]++;
+        }
+
+        if (water_mask != NULL)
+            water_mask[i / 8] = water_byte;
+        if (valid_mask != NULL)
+            valid_mask[i / 8] = valid_byte;
+        if (interp_mask != NULL)
+            interp_mask[i / 8] = interp_byte;
+        local.water += __builtin_popcount (water_byte);
+        local.valid += __builtin_popcount (valid_byte);
+        local.interp += __builtin_popcount (interp_byte);
+    }
+
+    if (counts != NULL)
+    {
+        /* Level 0 is every pixel not at levels 1-3 */
+        local.level[0] = npixels - local.level[1] - local.level[2] -
+            local.level[3];
+        counts->npixels += npixels;
+        counts->fill += local.fill;
+        counts->valid += local.valid;
+        counts->interp += local.interp;
+        counts->water += local.water;
+        for (k = 0; k < 4; k++)
+            counts->level[k] += local.level[k];
+    }
+}
+
+
+/******************************************************************************
+MODULE:  decode_next_lasrc_aerosol_strip
+
+PURPOSE: Reads the next strip of the LaSRC aerosol QA band and decodes it.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Not an aerosol band reader, or error reading the strip
+SUCCESS         Successfully read and decoded, or at the end of the band
+
+NOTES:
+1. The level buffer must hold strip_lines * nsamps values and the masks
+   level2_qa_mask_bytes (strip_lines * nsamps) bytes, for the strip_lines
+   and nsamps of the reader.
+******************************************************************************/
+int decode_next_lasrc_aerosol_strip
+(
+    Level2_qa_strips_t *strips, /* I/O: strip reader of the LaSRC aerosol
+                                        band */
+    uint8_t *level,         /* O: aerosol level per pixel of the strip (or
+                                  NULL) */
+    uint8_t *water_mask,    /* O: packed water mask of the strip (or NULL) */
+    uint8_t *valid_mask,    /* O: packed valid retrieval mask of the strip
+                                  (or NULL) */
+    uint8_t *interp_mask,   /* O: packed interpolated mask of the strip (or
+                                  NULL) */
+    Lasrc_aerosol_counts_t *counts, /* I/O: the counts of the strip are added
+                                            to the counts (or NULL) */
+    int *nlines             /* O: number of lines in the strip; 0 at the end
+                                  of the band */
+)
+{
+    char FUNC_NAME[] = "decode_next_lasrc_aerosol_strip";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    uint8_t *l2_qa = NULL;    /* current strip of the aerosol QA band */
+
+    *nlines = 0;
+    if (strips->qa_category != LASRC_AEROSOL)
+    {
+        sprintf (errmsg, "Strip reader isn't for the LaSRC aerosol QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (next_level2_qa_strip_uint8 (strips, &l2_qa, nlines) != SUCCESS)
+    {
+        sprintf (errmsg, "Reading the LaSRC aerosol QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (*nlines > 0)
+        decode_lasrc_aerosol_values (l2_qa, (size_t) *nlines * strips->nsamps,
+            level, water_mask, valid_mask, interp_mask, counts);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  count_lasrc_aerosol_level2_qa
+
+PURPOSE: Reads the LaSRC aerosol QA band a strip at a time and counts each
+of its categories.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error opening or reading the aerosol QA band
+SUCCESS         Successfully counted
+
+NOTES:
+******************************************************************************/
+int count_lasrc_aerosol_level2_qa
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    int strip_lines,        /* I: number of lines read at a time */
+    Lasrc_aerosol_counts_t *counts /* O: counts of the aerosol QA band */
+)
+{
+    int nread;                /* number of lines in the current strip */
+    Level2_qa_strips_t strips; /* strip reader of the aerosol QA band */
+
+    memset (counts, 0, sizeof (Lasrc_aerosol_counts_t));
+
+    if (open_level2_qa_strips (espa_xml_file, LASRC_AEROSOL, strip_lines,
+        false, &strips) != SUCCESS)
+    {  /* Error messages already written */
+        return (ERROR);
+    }
+
+    do
+    {
+        if (decode_next_lasrc_aerosol_strip (&strips, NULL, NULL, NULL, NULL,
+            counts, &nread) != SUCCESS)
+        {  /* Error messages already written */
+            close_level2_qa_strips (&strips);
+            return (ERROR);
+        }
+    } while (nread > 0);
+
+    close_level2_qa_strips (&strips);
+    return (SUCCESS);
+}
@@ -0,0 +1,301 @@
+/*****************************************************************************
+FILE: level2_qa_radsat_stats.c
+  
+PURPOSE: Contains functions for counting the fill and saturated pixels of
+each spectral band in the LEDAPS and LaSRC radsat QA bands.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The SSE2 paths transpose 64 pixels at a time into one word per QA bit.
+   The remaining pixels are counted by the scalar loops, which are also the
+   complete implementation when SSE2 isn't available.
+2. The order of the pixels within a transposed word doesn't matter, since
+   the words are only counted.
+*****************************************************************************/
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "level2_qa_radsat_stats.h"
+
+/******************************************************************************
+MODULE:  init_level2_radsat_stats
+
+PURPOSE: Initializes the statistics of a radsat QA band with zero counts.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           QA category isn't a radsat QA band
+SUCCESS         Successfully initialized
+
+NOTES:
+******************************************************************************/
+int init_level2_radsat_stats
+(
+    Espa_level2_qa_type qa_category, /* I: LEDAPS_RADSAT or LASRC_RADSAT */
+    Level2_radsat_stats_t *stats  /* O: statistics with all counts zero */
+)
+{
+    char FUNC_NAME[] = "init_level2_radsat_stats";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+
+    memset (stats, 0, sizeof (Level2_radsat_stats_t));
+    stats->qa_category = qa_category;
+    if (qa_category == LEDAPS_RADSAT)
+        stats->nbands = LEDAPS_B7_SAT_BIT;
+    else if (qa_category == LASRC_RADSAT)
+        stats->nbands = LASRC_B11_SAT_BIT;
+    else
+    {
+        sprintf (errmsg, "Saturation statistics are only available for the "
+            "LEDAPS and LaSRC radsat QA bands");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+#ifdef __SSE2__
+/******************************************************************************
+MODULE:  count_planes
+
+PURPOSE: Adds the counts of a block of 64 transposed pixels to the
+statistics.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. planes[0] is the fill bit and planes[b] is the saturation bit of band b.
+******************************************************************************/
+static inline void count_planes
+(
+    uint64_t *planes,       /* I: one word per QA bit of the 64 pixels */
+    Level2_radsat_stats_t *stats /* I/O: statistics to be updated */
+)
+{
+    int band;               /* looping variable for the spectral bands */
+    uint64_t any = 0;       /* pixels saturated in at least one band */
+
+    stats->fill += __builtin_popcountll (planes[0]);
+    for (band = 1; band <= stats->nbands; band++)
+    {
+        stats->saturated[band-1] += __builtin_popcountll (planes[band]);
+        any |= planes[band];
+    }
+    stats->saturated_any += __builtin_popcountll (any);
+}
+#endif
+
+
+/******************************************************************************
+MODULE:  ledaps_radsat_stats_values
+
+PURPOSE: Adds the fill and per band saturation counts of the LEDAPS radsat QA
+values to the statistics.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. With SSE2, movemask gathers the top bit of each of 16 QA values, and
+   adding each vector to itself moves the next lower bit to the top.  Eight
+   steps transpose the 8 QA bits of the 16 pixels.
+******************************************************************************/
+void ledaps_radsat_stats_values
+(
+    uint8_t *l2_qa,         /* I: LEDAPS radsat QA values */
+    size_t npixels,         /* I: number of pixels */
+    Level2_radsat_stats_t *stats /* I/O: the counts of the pixels are added
+                                         to the statistics */
+)
+{
+    size_t i = 0;           /* current pixel */
+    int band;               /* looping variable for the spectral bands */
+    uint8_t satbits;        /* saturation bits of the current pixel */
+#ifdef __SSE2__
+    int k;                  /* 16-pixel group within the block */
+    int bit;                /* looping variable for the QA bits */
+    uint64_t planes[LEDAPS_B7_SAT_BIT+1]; /* one word per QA bit */
+    __m128i qa[4];          /* QA values for the 64 pixels */
+
+    for (; i + 64 <= npixels; i += 64)
+    {
+        for (k = 0; k < 4; k++)
+            qa[k] = _mm_loadu_si128 ((__m128i *) &l2_qa[i + 16*k]);
+
+        for (bit = LEDAPS_B7_SAT_BIT; bit >= LEDAPS_FILL_BIT; bit--)
+        {
+            planes[bit] = 0;
+            for (k = 0; k < 4; k++)
+            {
+                planes[bit] |= (uint64_t) (_mm_movemask_epi8 (qa[k]) & 0xffff)
+                    << (16*k);
+                qa[k] = _mm_add_epi8 (qa[k], qa[k]);
+            }
+        }
+        count_planes (planes, stats);
+    }
+#endif
+
+    for (; i < npixels; i++)
+    {
+        stats->fill += (l2_qa[i] >> LEDAPS_FILL_BIT) & ESPA_L2_SINGLE_BIT;
+        satbits = l2_qa[i] >> LEDAPS_B1_SAT_BIT;
+        stats->saturated_any += (satbits != 0);
+        for (band = 0; satbits != 0; band++, satbits >>= 1)
+            stats->saturated[band] += satbits & ESPA_L2_SINGLE_BIT;
+    }
+
+    stats->npixels += npixels;
+}
+
+
+/******************************************************************************
+MODULE:  lasrc_radsat_stats_values
+
+PURPOSE: Adds the fill and per band saturation counts of the LaSRC radsat QA
+values to the statistics.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. With SSE2, the 12 used QA bits are first shifted to the top of each
+   16-bit value.  Packing two vectors to bytes with signed saturation keeps
+   the sign bits, movemask gathers them, and adding each vector to itself
+   moves the next lower bit to the top.  Twelve steps transpose the 12 QA
+   bits of the 16 pixels.
+******************************************************************************/
+void lasrc_radsat_stats_values
+(
+    uint16_t *l2_qa,        /* I: LaSRC radsat QA values */
+    size_t npixels,         /* I: number of pixels */
+    Level2_radsat_stats_t *stats /* I/O: the counts of the pixels are added
+                                         to the statistics */
+)
+{
+    size_t i = 0;           /* current pixel */
+    int band;               /* looping variable for the spectral bands */
+    uint16_t satbits;       /* saturation bits of the current pixel */
+#ifdef __SSE2__
+    int k;                  /* 16-pixel group within the block */
+    int bit;                /* looping variable for the QA bits */
+    uint64_t planes[LASRC_B11_SAT_BIT+1]; /* one word per QA bit */
+    __m128i lo[4], hi[4];   /* QA values for the 64 pixels */
+
+    for (; i + 64 <= npixels; i += 64)
+    {
+        for (k = 0; k < 4; k++)
+        {
+            lo[k] = _mm_slli_epi16 (_mm_loadu_si128 (
+                (__m128i *) &l2_qa[i + 16*k]), 15 - LASRC_B11_SAT_BIT);
+            hi[k] = _mm_slli_epi16 (_mm_loadu_si128 (
+                (__m128i *) &l2_qa[i + 16*k + 8]), 15 - LASRC_B11_SAT_BIT);
+        }
+
+        for (bit = LASRC_B11_SAT_BIT; bit >= LASRC_FILL_BIT; bit--)
+        {
+            planes[bit] = 0;
+            for (k = 0; k < 4; k++)
+            {
+                planes[bit] |= (uint64_t) (_mm_movemask_epi8 (
+                    _mm_packs_epi16 (lo[k], hi[k])) & 0xffff) << (16*k);
+                lo[k] = _mm_add_epi16 (lo[k], lo[k]);
+                hi[k] = _mm_add_epi16 (hi[k], hi[k]);
+            }
+        }
+        count_planes (planes, stats);
+    }
+#endif
+
+    for (; i < npixels; i++)
+    {
+        stats->fill += (l2_qa[i] >> LASRC_FILL_BIT) & ESPA_L2_SINGLE_BIT;
+        satbits = (l2_qa[i] >> LASRC_B1_SAT_BIT) &
+            ((1 << LASRC_B11_SAT_BIT) - 1);
+        stats->saturated_any += (satbits != 0);
+        for (band = 0; satbits != 0; band++, satbits >>= 1)
+            stats->saturated[band] += satbits & ESPA_L2_SINGLE_BIT;
+    }
+
+    stats->npixels += npixels;
+}
+
+
+/******************************************************************************
+MODULE:  radsat_stats_level2_qa
+
+PURPOSE: Reads the radsat QA band a strip at a time and counts its fill and
+saturated pixels.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error opening or reading the radsat QA band
+SUCCESS         Successfully counted
+
+NOTES:
+******************************************************************************/
+int radsat_stats_level2_qa
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    Espa_level2_qa_type qa_category, /* I: LEDAPS_RADSAT or LASRC_RADSAT */
+    int strip_lines,        /* I: number of lines read at a time */
+    Level2_radsat_stats_t *stats /* O: statistics of the radsat QA band */
+)
+{
+    char FUNC_NAME[] = "radsat_stats_level2_qa";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int status;               /* status of reading a strip */
+    int nread;                /* number of lines in the current strip */
+    uint8_t *qa8 = NULL;      /* current strip of the LEDAPS band */
+    uint16_t *qa16 = NULL;    /* current strip of the LaSRC band */
+    Level2_qa_strips_t strips; /* strip reader of the radsat QA band */
+
+    if (init_level2_radsat_stats (qa_category, stats) != SUCCESS)
+    {  /* Error messages already written */
+        return (ERROR);
+    }
+
+    if (open_level2_qa_strips (espa_xml_file, qa_category, strip_lines, false,
+        &strips) != SUCCESS)
+    {  /* Error messages already written */
+        return (ERROR);
+    }
+
+    while (1)
+    {
+        if (qa_category == LASRC_RADSAT)
+            status = next_level2_qa_strip_uint16 (&strips, &qa16, &nread);
+        else
+            status = next_level2_qa_strip_uint8 (&strips, &qa8, &nread);
+        if (status != SUCCESS)
+        {
+            sprintf (errmsg, "Reading the radsat QA band");
+            error_handler (true, FUNC_NAME, errmsg);
+            close_level2_qa_strips (&strips);
+            return (ERROR);
+        }
+        if (nread == 0)
+            break;
+
+        if (qa_category == LASRC_RADSAT)
+            lasrc_radsat_stats_values (qa16, (size_t) nread * strips.nsamps,
+                stats);
+        else
+            ledaps_radsat_stats_values (qa8, (size_t) nread * strips.nsamps,
+                stats);
+    }
+
+    close_level2_qa_strips (&strips);
+    return (SUCCESS);
+}
@@ -0,0 +1,347 @@
+/*****************************************************************************
+FILE: level2_qa_strips.c
+  
+PURPOSE: Contains functions for reading the LEDAPS and LaSRC Level-2 QA bands
+as typed strips of lines.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+*****************************************************************************/
+#include "level2_qa_strips.h"
+
+/******************************************************************************
+MODULE:  level2_qa_bytes_per_pixel
+
+PURPOSE: Returns the number of bytes per pixel of the Level-2 QA band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+0               Unknown Level-2 QA category
+1               8-bit band (LEDAPS radsat, LEDAPS cloud, LaSRC aerosol)
+2               16-bit band (LaSRC radsat)
+
+NOTES:
+******************************************************************************/
+int level2_qa_bytes_per_pixel
+(
+    Espa_level2_qa_type qa_category /* I: type of Level-2 QA data */
+)
+{
+    switch (qa_category)
+    {
+        case LEDAPS_RADSAT:
+        case LEDAPS_CLOUD:
+        case LASRC_AEROSOL:
+            return (sizeof (uint8_t));
+
+        case LASRC_RADSAT:
+            return (sizeof (uint16_t));
+
+        default:
+            return (0);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  init_level2_qa_strips
+
+PURPOSE: Sets up a strip reader for a Level-2 QA band which is already open.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error allocating the strip buffers
+SUCCESS         Successfully set up
+
+NOTES:
+1. The band isn't closed by close_level2_qa_strips; the caller still owns
+   fp_l2qa.
+2. Strips are read from the current position of fp_l2qa.
+******************************************************************************/
+int init_level2_qa_strips
+(
+    FILE *fp_l2qa,          /* I: Level-2 QA band open for reading, as
+                                  returned by open_level2_qa */
+    Espa_level2_qa_type qa_category, /* I: type of Level-2 QA data */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    int strip_lines,        /* I: maximum number of lines in a strip */
+    bool widen,             /* I: widen the 8-bit bands to uint16? */
+    Level2_qa_strips_t *strips /* O: strip reader */
+)
+{
+    char FUNC_NAME[] = "init_level2_qa_strips";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int nbytes;               /* bytes per pixel of the band */
+    size_t npixels;           /* number of pixels in a strip */
+
+    memset (strips, 0, sizeof (Level2_qa_strips_t));
+    nbytes = level2_qa_bytes_per_pixel (qa_category);
+    if (nbytes == 0 || strip_lines < 1)
+    {
+        sprintf (errmsg, "Invalid Level-2 QA category or strip size");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    strips->fp_l2qa = fp_l2qa;
+    strips->close_band = false;
+    strips->qa_category = qa_category;
+    strips->nlines = nlines;
+    strips->nsamps = nsamps;
+    strips->strip_lines = (strip_lines < nlines) ? strip_lines : nlines;
+    strips->widen = widen;
+
+    /* The 8-bit buffer is also the read buffer when widening */
+    npixels = (size_t) strips->strip_lines * nsamps;
+    if (nbytes == sizeof (uint8_t))
+        strips->qa8 = calloc (npixels, sizeof (uint8_t));
+    if (nbytes == sizeof (uint16_t) || widen)
+        strips->qa16 = calloc (npixels, sizeof (uint16_t));
+    if ((nbytes == sizeof (uint8_t) && strips->qa8 == NULL) ||
+        ((nbytes == sizeof (uint16_t) || widen) && strips->qa16 == NULL))
+    {
+        sprintf (errmsg, "Allocating memory for the Level-2 QA strips");
+        error_handler (true, FUNC_NAME, errmsg);
+        free (strips->qa8);
+        free (strips->qa16);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  open_level2_qa_strips
+
+PURPOSE: Opens the Level-2 QA band from the XML file and sets up a strip
+reader for it.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error opening the band
+SUCCESS         Successfully opened
+
+NOTES:
+1. The band is closed by close_level2_qa_strips.
+******************************************************************************/
+int open_level2_qa_strips
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    Espa_level2_qa_type qa_category, /* I: type of Level-2 QA data */
+    int strip_lines,        /* I: maximum number of lines in a strip */
+    bool widen,             /* I: widen the 8-bit bands to uint16? */
+    Level2_qa_strips_t *strips /* O: strip reader */
+)
+{
+    char FUNC_NAME[] = "open_level2_qa_strips";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    char l2_qa_file[STR_SIZE];  /* Level-2 QA filename */
+    int nlines;               /* number of lines in the QA band */
+    int nsamps;               /* number of samples in the QA band */
+    FILE *fp_l2qa = NULL;     /* Level-2 QA band */
+
+    fp_l2qa = open_level2_qa (espa_xml_file, qa_category, l2_qa_file, &nlines,
+        &nsamps);
+    if (fp_l2qa == NULL)
+    {
+        sprintf (errmsg, "Unable to open the Level-2 QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (init_level2_qa_strips (fp_l2qa, qa_category, nlines, nsamps,
+        strip_lines, widen, strips) != SUCCESS)
+    {
+        sprintf (errmsg, "Unable to set up the Level-2 QA strip reader");
+        error_handler (true, FUNC_NAME, errmsg);
+        close_level2_qa (fp_l2qa);
+        return (ERROR);
+    }
+    strips->close_band = true;
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  read_next_strip
+
+PURPOSE: Reads the next strip of the band into the strip buffers, widening
+the 8-bit values if requested.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the strip
+SUCCESS         Successfully read, or at the end of the band
+******************************************************************************/
+static int read_next_strip
+(
+    Level2_qa_strips_t *strips /* I/O: strip reader */
+)
+{
+    char FUNC_NAME[] = "read_next_strip";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    size_t i;                 /* looping variable */
+    size_t npixels;           /* number of pixels in the strip */
+    void *buffer = NULL;      /* buffer the band is read into */
+
+    strips->line += strips->nstrip_lines;
+    strips->nstrip_lines = strips->nlines - strips->line;
+    if (strips->nstrip_lines > strips->strip_lines)
+        strips->nstrip_lines = strips->strip_lines;
+    if (strips->nstrip_lines <= 0)
+    {
+        strips->nstrip_lines = 0;
+        return (SUCCESS);
+    }
+
+    if (strips->qa8 != NULL)
+        buffer = strips->qa8;
+    else
+        buffer = strips->qa16;
+    if (read_level2_qa (strips->fp_l2qa, strips->nstrip_lines, strips->nsamps,
+        strips->qa_category, buffer) != SUCCESS)
+    {
+        sprintf (errmsg, "Reading lines %d-%d of the Level-2 QA band",
+            strips->line, strips->line + strips->nstrip_lines - 1);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (strips->qa8 != NULL && strips->widen)
+    {
+        npixels = (size_t) strips->nstrip_lines * strips->nsamps;
+        for (i = 0; i < npixels; i++)
+            strips->qa16[i] = strips->qa8[i];
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  next_level2_qa_strip_uint8
+
+PURPOSE: Reads the next strip of an 8-bit Level-2 QA band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the strip, or the strips aren't uint8
+SUCCESS         Successfully read, or at the end of the band
+
+NOTES:
+1. Only for the 8-bit bands read without the widen option.
+2. The first line of the strip is strips->line.
+******************************************************************************/
+int next_level2_qa_strip_uint8
+(
+    Level2_qa_strips_t *strips, /* I/O: strip reader */
+    uint8_t **level2_qa,    /* O: values of the next strip, valid until the
+                                  next read */
+    int *nlines             /* O: number of lines in the strip; 0 at the end
+                                  of the band */
+)
+{
+    char FUNC_NAME[] = "next_level2_qa_strip_uint8";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+
+    if (strips->qa8 == NULL || strips->widen)
+    {
+        sprintf (errmsg, "The Level-2 QA strips are uint16; use "
+            "next_level2_qa_strip_uint16");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (read_next_strip (strips) != SUCCESS)
+        return (ERROR);
+
+    *level2_qa = strips->qa8;
+    *nlines = strips->nstrip_lines;
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  next_level2_qa_strip_uint16
+
+PURPOSE: Reads the next strip of a 16-bit Level-2 QA band, or of an 8-bit
+band read with the widen option.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the strip, or the strips aren't uint16
+SUCCESS         Successfully read, or at the end of the band
+
+NOTES:
+1. The first line of the strip is strips->line.
+******************************************************************************/
+int next_level2_qa_strip_uint16
+(
+    Level2_qa_strips_t *strips, /* I/O: strip reader */
+    uint16_t **level2_qa,   /* O: values of the next strip, valid until the
+                                  next read */
+    int *nlines             /* O: number of lines in the strip; 0 at the end
+                                  of the band */
+)
+{
+    char FUNC_NAME[] = "next_level2_qa_strip_uint16";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+
+    if (strips->qa16 == NULL)
+    {
+        sprintf (errmsg, "The Level-2 QA strips are uint8; use "
+            "next_level2_qa_strip_uint8 or the widen option");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (read_next_strip (strips) != SUCCESS)
+        return (ERROR);
+
+    *level2_qa = strips->qa16;
+    *nlines = strips->nstrip_lines;
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  close_level2_qa_strips
+
+PURPOSE: Frees the strip buffers, and closes the band if it was opened by
+open_level2_qa_strips.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void close_level2_qa_strips
+(
+    Level2_qa_strips_t *strips /* I/O: strip reader to be closed */
+)
+{
+    if (strips->close_band && strips->fp_l2qa != NULL)
+        close_level2_qa (strips->fp_l2qa);
+    free (strips->qa8);
+    free (strips->qa16);
+    memset (strips, 0, sizeof (Level2_qa_strips_t));
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************
+FILE: level2_qa_strips.h
+  
+PURPOSE: Contains data types and function prototypes for reading the LEDAPS
+and LaSRC Level-2 QA bands as typed strips of lines.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. A strip reader returns the band a strip of lines at a time in a buffer it
+   owns and reuses, so only one strip of the band is in memory.
+2. The LEDAPS radsat, LEDAPS cloud, and LaSRC aerosol bands are read as
+   uint8 strips, and the LaSRC radsat band as uint16 strips.  With the widen
+   option the 8-bit bands are converted to uint16 strips as they are read, so
+   a consumer can handle every Level-2 QA band as uint16.
+*****************************************************************************/
+
+#ifndef LEVEL2_QA_STRIPS_H
+#define LEVEL2_QA_STRIPS_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "read_level2_qa.h"
+
+/* Data types */
+typedef struct
+{
+    FILE *fp_l2qa;          /* Level-2 QA band open for reading */
+    bool close_band;        /* close fp_l2qa when the reader is closed? */
+    Espa_level2_qa_type qa_category; /* type of Level-2 QA data */
+    int nlines;             /* number of lines in the QA band */
+    int nsamps;             /* number of samples in the QA band */
+    int strip_lines;        /* maximum number of lines in a strip */
+    bool widen;             /* widen the 8-bit bands to uint16? */
+    int line;               /* first line of the current strip */
+    int nstrip_lines;       /* number of lines in the current strip */
+    uint8_t *qa8;           /* current strip of an 8-bit band */
+    uint16_t *qa16;         /* current strip of a 16-bit or widened band */
+} Level2_qa_strips_t;
+
+/* Function Prototypes */
+int level2_qa_bytes_per_pixel
+(
+    Espa_level2_qa_type qa_category /* I: type of Level-2 QA data */
+);
+
+int init_level2_qa_strips
+(
+    FILE *fp_l2qa,          /* I: Level-2 QA band open for reading, as
+                                  returned by open_level2_qa */
+    Espa_level2_qa_type qa_category, /* I: type of Level-2 QA data */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    int strip_lines,        /* I: maximum number of lines in a strip */
+    bool widen,             /* I: widen the 8-bit bands to uint16? */
+    Level2_qa_strips_t *strips /* O: strip reader */
+);
+
+int open_level2_qa_strips
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    Espa_level2_qa_type qa_category, /* I: type of Level-2 QA data */
+    int strip_lines,        /* I: maximum number of lines in a strip */
+    bool widen,             /* I: widen the 8-bit bands to uint16? */
+    Level2_qa_strips_t *strips /* O: strip reader */
+);
+
+int next_level2_qa_strip_uint8
+(
+    Level2_qa_strips_t *strips, /* I/O: strip reader */
+    uint8_t **level2_qa,    /* O: values of the next strip, valid until the
+                                  next read */
+    int *nlines             /* O: number of lines in the strip; 0 at the end
+                                  of the band */
+);
+
+int next_level2_qa_strip_uint16
+(
+    Level2_qa_strips_t *strips, /* I/O: strip reader */
+    uint16_t **level2_qa,   /* O: values of the next strip, valid until the
+                                  next read */
+    int *nlines             /* O: number of lines in the strip; 0 at the end
+                                  of the band */
+);
+
+void close_level2_qa_strips
+(
+    Level2_qa_strips_t *strips /* I/O: strip reader to be closed */
+);
+
+#endif
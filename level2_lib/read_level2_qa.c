@@ -18,6 +18,117 @@ NOTES:
    QA band information.
 *****************************************************************************/
 #include "read_level2_qa.h"
+#include "l2qa_timing.h"
+
+/******************************************************************************
+MODULE:  level2_qa_band_label
+
+PURPOSE: Returns the label and band name of the Level-2 QA category, for
+messages.
+
+RETURN VALUE:
+Type = char *
+Value           Description
+-----           -----------
+string          Label and band name, e.g. "LEDAPS CLOUD: sr_cloud_qa"
+
+NOTES:
+******************************************************************************/
+static char *level2_qa_band_label
+(
+    Espa_level2_qa_type qa_category /* I: type of Level-2 QA data */
+)
+{
+    switch (qa_category)
+    {
+        case LEDAPS_RADSAT:
+            return ("LEDAPS RADSAT: radsat_qa");
+        case LEDAPS_CLOUD:
+            return ("LEDAPS CLOUD: sr_cloud_qa");
+        case LASRC_AEROSOL:
+            return ("LASRC AEROSOL: sr_aerosol");
+        case LASRC_RADSAT:
+            return ("LASRC RADSAT: radsat_qa");
+        default:
+            return ("unknown");
+    }
+}
+
+
+/******************************************************************************
+MODULE:  find_level2_qa_band
+
+PURPOSE: Looks through the parsed XML metadata for the Level-2 QA band of the
+specified category and checks its data type.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The band was found but doesn't have the expected data type
+SUCCESS         Band was found (band_index >= 0) or isn't in the XML file
+                (band_index = -1)
+
+NOTES:
+1. For applications which have already parsed the XML file and only want to
+   use the band if it's there.
+******************************************************************************/
+int find_level2_qa_band
+(
+    Espa_internal_meta_t *xml_metadata, /* I: parsed XML metadata */
+    Espa_level2_qa_type qa_category, /* I: type of Level-2 QA data */
+    int *band_index        /* O: index of the band in the metadata; -1 if
+                                 not found */
+)
+{
+    char FUNC_NAME[] = "find_level2_qa_band";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int i;                    /* looping variable */
+    Espa_band_meta_t *bmeta = xml_metadata->band; /* array of bands metadata */
+
+    /* Loop through the bands and look for the desired Level-2 QA band */
+    *band_index = -1;
+    for (i = 0; i < xml_metadata->nbands; i++)
+    {
+        /* Is this the desired Level-2 quality band */
+        if ((qa_category == LEDAPS_RADSAT &&
+               (!strcmp (bmeta[i].name, "radsat_qa") &&
+                !strcmp (bmeta[i].category, "qa"))) ||
+            (qa_category == LEDAPS_CLOUD &&
+               (!strcmp (bmeta[i].name, "sr_cloud_qa") &&
+                !strcmp (bmeta[i].category, "qa"))) ||
+            (qa_category == LASRC_AEROSOL &&
+               (!strcmp (bmeta[i].name, "sr_aerosol") &&
+                !strcmp (bmeta[i].category, "qa"))) ||
+            (qa_category == LASRC_RADSAT &&
+               (!strcmp (bmeta[i].name, "radsat_qa") &&
+                !strcmp (bmeta[i].category, "qa"))))
+        {
+            if (qa_category != LASRC_RADSAT && bmeta[i].data_type != ESPA_UINT8)
+            {
+                sprintf (errmsg, "Expecting UINT8 data type for Level-2 QA "
+                    "band (%s), however the data type was something other than "
+                    "UINT8.  Please check the input XML file.", bmeta[i].name);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            else if (qa_category == LASRC_RADSAT &&
+                     bmeta[i].data_type != ESPA_UINT16)
+            {
+                sprintf (errmsg, "Expecting UINT16 data type for Level-2 QA "
+                    "band (%s), however the data type was something other than "
+                    "UINT16.  Please check the input XML file.", bmeta[i].name);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            *band_index = i;
+            break;
+        }
+    }
+
+    return (SUCCESS);
+}
+
 
 /******************************************************************************
 MODULE:  open_level2_qa
@@ -53,19 +164,21 @@ FILE *open_level2_qa
 {
     char FUNC_NAME[] = "open_level2_qa";  /* function name */
     char errmsg[STR_SIZE];    /* error message */
-    int i;                    /* looping variable */
-    bool found;               /* was the Level-2 QA band found? */
+    L2qa_timer_t timer;       /* start time of the timed phase */
+    int i;                    /* index of the Level-2 QA band */
     Espa_internal_meta_t xml_metadata;  /* XML metadata structure to be
                                  populated by reading the XML metadata file */
-    Espa_global_meta_t *gmeta;/* pointer to the global metadata structure */
     Espa_band_meta_t *bmeta;  /* pointer to the array of bands metadata */
     FILE *fp_l2qa = NULL;     /* file pointer for the Level-2 QA band */
 
     /* Validate the input metadata file */
+    l2qa_timer_start (&timer);
     if (validate_xml_file (espa_xml_file) != SUCCESS)
     {  /* Error messages already written */
         return (NULL);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_VALIDATE_XML,
+        l2qa_timing_file_size (espa_xml_file), 0);
 
     /* Initialize the metadata structure */
     init_metadata_struct (&xml_metadata);
@@ -73,84 +186,35 @@ FILE *open_level2_qa
     /* Parse the metadata file into our internal metadata structure; also
        allocates space as needed for various pointers in the global and band
        metadata */
+    l2qa_timer_start (&timer);
     if (parse_metadata (espa_xml_file, &xml_metadata) != SUCCESS)
     {  /* Error messages already written */
         return (NULL);
     }
-    gmeta = &xml_metadata.global;
+    l2qa_timer_stop (&timer, L2QA_PHASE_PARSE_METADATA,
+        l2qa_timing_file_size (espa_xml_file), 0);
     bmeta = xml_metadata.band;
 
-    /* Loop through the bands and look for the desired Level-2 QA band */
-    found = false;
-    for (i = 0; i < xml_metadata.nbands; i++)
-    {
-        /* Is this the desired Level-2 quality band */
-        if ((qa_category == LEDAPS_RADSAT &&
-               (!strcmp (bmeta[i].name, "radsat_qa") &&
-                !strcmp (bmeta[i].category, "qa"))) ||
-            (qa_category == LEDAPS_CLOUD &&
-               (!strcmp (bmeta[i].name, "sr_cloud_qa") &&
-                !strcmp (bmeta[i].category, "qa"))) ||
-            (qa_category == LASRC_AEROSOL &&
-               (!strcmp (bmeta[i].name, "sr_aerosol") &&
-                !strcmp (bmeta[i].category, "qa"))) ||
-            (qa_category == LASRC_RADSAT &&
-               (!strcmp (bmeta[i].name, "radsat_qa") &&
-                !strcmp (bmeta[i].category, "qa"))))
-        {
-            strcpy (l2_qa_file, bmeta[i].file_name);
-            *nlines = bmeta[i].nlines;
-            *nsamps = bmeta[i].nsamps;
-            if (qa_category != LASRC_RADSAT && bmeta[i].data_type != ESPA_UINT8)
-            {
-                sprintf (errmsg, "Expecting UINT8 data type for Level-2 QA "
-                    "band (%s), however the data type was something other than "
-                    "UINT8.  Please check the input XML file.", bmeta[i].name);
-                error_handler (true, FUNC_NAME, errmsg);
-                return (NULL);
-            }
-            else if (qa_category == LASRC_RADSAT &&
-                     bmeta[i].data_type != ESPA_UINT16)
-            {
-                sprintf (errmsg, "Expecting UINT16 data type for Level-2 QA "
-                    "band (%s), however the data type was something other than "
-                    "UINT16.  Please check the input XML file.", bmeta[i].name);
-                error_handler (true, FUNC_NAME, errmsg);
-                return (NULL);
-            }
-            found = true;
-            break;
-        }
+    /* Look for the desired Level-2 QA band */
+    if (find_level2_qa_band (&xml_metadata, qa_category, &i) != SUCCESS)
+    {  /* Error messages already written */
+        free_metadata (&xml_metadata);
+        return (NULL);
     }
 
     /* Make sure the desired Level-2 QA band was found */
-    if (!found)
+    if (i < 0)
     {
-        switch (qa_category)
-        {
-            case LEDAPS_RADSAT:
-                sprintf (errmsg, "Unable to find the specified Level-2 QA band "
-                    "for LEDAPS RADSAT: radsat_qa");
-                break;
-
-            case LEDAPS_CLOUD:
-                sprintf (errmsg, "Unable to find the specified Level-2 QA band "
-                    "for LEDAPS CLOUD: sr_cloud_qa");
-                break;
-
-            case LASRC_AEROSOL:
-                sprintf (errmsg, "Unable to find the specified Level-2 QA band "
-                    "for LASRC AEROSOL: sr_aerosol");
-                break;
-
-            case LASRC_RADSAT:
-                sprintf (errmsg, "Unable to find the specified Level-2 QA band "
-                    "for LASRC RADSAT: radsat_qa");
-                break;
-        }
+        sprintf (errmsg, "Unable to find the specified Level-2 QA band for %s",
+            level2_qa_band_label (qa_category));
         error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&xml_metadata);
         return (NULL);
     }
+    strcpy (l2_qa_file, bmeta[i].file_name);
+    *nlines = bmeta[i].nlines;
+    *nsamps = bmeta[i].nsamps;
+    free_metadata (&xml_metadata);
 
     /* Open the Level-2 QA band for read only */
     fp_l2qa = open_raw_binary (l2_qa_file, "r");
@@ -161,11 +225,183 @@ FILE *open_level2_qa
         return (NULL);
     }
 
+    /* Successfully opened the Level-2 QA band */
+    return (fp_l2qa);
+}
+
+
+/******************************************************************************
+MODULE:  open_level2_qa_multi
+
+PURPOSE: Reads the ESPA XML file once and opens each of the requested Level-2
+QA bands.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error parsing the XML file, a band with an unexpected data
+                type, or error opening one of the bands found
+SUCCESS         Successfully read; the found flag of each band tells whether
+                it was opened
+
+NOTES:
+1. The XML file is validated and parsed once for all of the bands, rather
+   than once per band as with open_level2_qa.
+2. Requested bands which aren't in the XML file aren't an error.  Their found
+   flag is false, their file pointer is NULL, and a single warning lists all
+   of them.  The caller decides which bands it can do without.
+3. On error no bands are left open.  On success close_level2_qa_multi closes
+   the bands which were opened.
+******************************************************************************/
+int open_level2_qa_multi
+(
+    char *espa_xml_file,   /* I: input ESPA XML filename */
+    int nbands,            /* I: number of Level-2 QA bands requested */
+    Level2_qa_band_t *bands, /* I/O: requested bands; qa_category is set by
+                                 the caller, the rest is filled in */
+    int *nfound            /* O: number of requested bands found and opened */
+)
+{
+    int status;               /* status of opening the bands */
+    Espa_internal_meta_t xml_metadata;  /* XML metadata structure to be
+                                 populated by reading the XML metadata file */
+    L2qa_timer_t timer;       /* start time of the timed phase */
+
+    *nfound = 0;
+
+    /* Validate the input metadata file */
+    l2qa_timer_start (&timer);
+    if (validate_xml_file (espa_xml_file) != SUCCESS)
+    {  /* Error messages already written */
+        return (ERROR);
+    }
+    l2qa_timer_stop (&timer, L2QA_PHASE_VALIDATE_XML,
+        l2qa_timing_file_size (espa_xml_file), 0);
+
+    /* Initialize the metadata structure */
+    init_metadata_struct (&xml_metadata);
+
+    /* Parse the metadata file into our internal metadata structure */
+    l2qa_timer_start (&timer);
+    if (parse_metadata (espa_xml_file, &xml_metadata) != SUCCESS)
+    {  /* Error messages already written */
+        return (ERROR);
+    }
+    l2qa_timer_stop (&timer, L2QA_PHASE_PARSE_METADATA,
+        l2qa_timing_file_size (espa_xml_file), 0);
+
+    /* Open the requested bands */
+    status = open_level2_qa_bands (&xml_metadata, nbands, bands, nfound);
+
     /* Free the metadata structure */
     free_metadata (&xml_metadata);
 
-    /* Successfully opened the Level-2 QA band */
-    return (fp_l2qa);
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  open_level2_qa_bands
+
+PURPOSE: Opens each of the requested Level-2 QA bands from XML metadata the
+caller has already parsed.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           A band with an unexpected data type, or error opening one of
+                the bands found
+SUCCESS         Successfully read; the found flag of each band tells whether
+                it was opened
+
+NOTES:
+1. For applications which need the parsed metadata for other bands as well.
+   See open_level2_qa_multi for the handling of missing bands.
+******************************************************************************/
+int open_level2_qa_bands
+(
+    Espa_internal_meta_t *xml_metadata, /* I: metadata already parsed from
+                                 the ESPA XML file */
+    int nbands,            /* I: number of Level-2 QA bands requested */
+    Level2_qa_band_t *bands, /* I/O: requested bands; qa_category is set by
+                                 the caller, the rest is filled in */
+    int *nfound            /* O: number of requested bands found and opened */
+)
+{
+    char FUNC_NAME[] = "open_level2_qa_bands";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int i;                    /* looping variable for the requested bands */
+    int indx;                 /* index of the band in the metadata */
+    int nmissing;             /* number of requested bands not found */
+    Espa_band_meta_t *bmeta = xml_metadata->band; /* array of bands metadata */
+
+    *nfound = 0;
+    for (i = 0; i < nbands; i++)
+    {
+        bands[i].found = false;
+        bands[i].l2_qa_file[0] = '\0';
+        bands[i].nlines = 0;
+        bands[i].nsamps = 0;
+        bands[i].fp_l2qa = NULL;
+    }
+
+    /* Find each of the requested bands */
+    for (i = 0; i < nbands; i++)
+    {
+        if (find_level2_qa_band (xml_metadata, bands[i].qa_category, &indx)
+            != SUCCESS)
+        {  /* Error messages already written */
+            return (ERROR);
+        }
+        if (indx < 0)
+            continue;
+
+        bands[i].found = true;
+        strcpy (bands[i].l2_qa_file, bmeta[indx].file_name);
+        bands[i].nlines = bmeta[indx].nlines;
+        bands[i].nsamps = bmeta[indx].nsamps;
+    }
+
+    /* Report all of the missing bands in one message */
+    nmissing = 0;
+    strcpy (errmsg, "Requested Level-2 QA bands not found in the XML file:");
+    for (i = 0; i < nbands; i++)
+    {
+        if (bands[i].found)
+            continue;
+        if (strlen (errmsg) + 40 < STR_SIZE)
+        {
+            strcat (errmsg, (nmissing > 0) ? ", " : " ");
+            strcat (errmsg, level2_qa_band_label (bands[i].qa_category));
+        }
+        nmissing++;
+    }
+    if (nmissing > 0)
+        error_handler (false, FUNC_NAME, errmsg);
+
+    /* Open the bands which were found for read only */
+    for (i = 0; i < nbands; i++)
+    {
+        if (!bands[i].found)
+            continue;
+
+        bands[i].fp_l2qa = open_raw_binary (bands[i].l2_qa_file, "r");
+        if (bands[i].fp_l2qa == NULL)
+        {
+            sprintf (errmsg, "Opening the Level-2 QA band for %s",
+                level2_qa_band_label (bands[i].qa_category));
+            error_handler (true, FUNC_NAME, errmsg);
+            close_level2_qa_multi (nbands, bands);
+            *nfound = 0;
+            return (ERROR);
+        }
+        (*nfound)++;
+    }
+
+    /* Successfully opened the Level-2 QA bands */
+    return (SUCCESS);
 }
 
 
@@ -202,6 +438,7 @@ int read_level2_qa
     char FUNC_NAME[] = "read_level2_qa";  /* function name */
     char errmsg[STR_SIZE];    /* error message */
     int nbits;                /* number of bits per pixel for this QA type */
+    L2qa_timer_t timer;       /* start time of the read */
 
     /* How many bits per pixel for this Level-2 QA type */
     switch (qa_category)
@@ -225,12 +462,15 @@ int read_level2_qa
     }
 
     /* Read the current line(s) from the band quality band */
+    l2qa_timer_start (&timer);
     if (read_raw_binary (fp_l2qa, nlines, nsamps, nbits, level2_qa) != SUCCESS)
     {   
         sprintf (errmsg, "Reading %d lines from Level-2 QA band", nlines);
         error_handler (true, FUNC_NAME, errmsg);
         return (ERROR);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_READ,
+        (long long) nlines * nsamps * nbits, (long long) nlines * nsamps);
 
     /* Successful read */
     return (SUCCESS);
@@ -255,3 +495,32 @@ void close_level2_qa
 {
     close_raw_binary (fp_l2qa);
 }
+
+
+/******************************************************************************
+MODULE:  close_level2_qa_multi
+
+PURPOSE: Closes the Level-2 QA bands opened by open_level2_qa_multi.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Bands which weren't found or opened are skipped.
+******************************************************************************/
+void close_level2_qa_multi
+(
+    int nbands,            /* I: number of Level-2 QA bands */
+    Level2_qa_band_t *bands /* I/O: bands opened by open_level2_qa_multi; will
+                                   be closed upon return */
+)
+{
+    int i;                    /* looping variable */
+
+    for (i = 0; i < nbands; i++)
+    {
+        if (bands[i].fp_l2qa != NULL)
+            close_raw_binary (bands[i].fp_l2qa);
+        bands[i].fp_l2qa = NULL;
+    }
+}
@@ -75,6 +75,17 @@ typedef enum
     LEDAPS_RADSAT, LEDAPS_CLOUD, LASRC_AEROSOL, LASRC_RADSAT
 } Espa_level2_qa_type;
 
+/* One Level-2 QA band requested from open_level2_qa_multi */
+typedef struct
+{
+    Espa_level2_qa_type qa_category; /* I: type of Level-2 QA data */
+    bool found;            /* O: was the band found in the XML file? */
+    char l2_qa_file[STR_SIZE]; /* O: Level-2 QA filename */
+    int nlines;            /* O: number of lines in the QA band */
+    int nsamps;            /* O: number of samples in the QA band */
+    FILE *fp_l2qa;         /* O: band open for reading; NULL if not found */
+} Level2_qa_band_t;
+
 /* Function Prototypes */
 FILE *open_level2_qa
 (
@@ -87,6 +98,33 @@ FILE *open_level2_qa
     int *nsamps            /* O: number of samples in the QA band */
 );
 
+int find_level2_qa_band
+(
+    Espa_internal_meta_t *xml_metadata, /* I: parsed XML metadata */
+    Espa_level2_qa_type qa_category, /* I: type of Level-2 QA data */
+    int *band_index        /* O: index of the band in the metadata; -1 if
+                                 not found */
+);
+
+int open_level2_qa_multi
+(
+    char *espa_xml_file,   /* I: input ESPA XML filename */
+    int nbands,            /* I: number of Level-2 QA bands requested */
+    Level2_qa_band_t *bands, /* I/O: requested bands; qa_category is set by
+                                 the caller, the rest is filled in */
+    int *nfound            /* O: number of requested bands found and opened */
+);
+
+int open_level2_qa_bands
+(
+    Espa_internal_meta_t *xml_metadata, /* I: metadata already parsed from
+                                 the ESPA XML file */
+    int nbands,            /* I: number of Level-2 QA bands requested */
+    Level2_qa_band_t *bands, /* I/O: requested bands; qa_category is set by
+                                 the caller, the rest is filled in */
+    int *nfound            /* O: number of requested bands found and opened */
+);
+
 int read_level2_qa
 (
     FILE *fp_l2qa,         /* I: pointer to the Level-2 QA band open for
@@ -108,6 +146,13 @@ void close_level2_qa
                                    be closed upon return */
 );
 
+void close_level2_qa_multi
+(
+    int nbands,            /* I: number of Level-2 QA bands */
+    Level2_qa_band_t *bands /* I/O: bands opened by open_level2_qa_multi; will
+                                   be closed upon return */
+);
+
 
 /* Inline Function Prototypes */
 
@@ -0,0 +1,966 @@
+/*****************************************************************************
+FILE: combine_qa_mask.c
+  
+PURPOSE: Contains functions for combining the pixel QA band and the
+LEDAPS/LaSRC Level-2 QA bands into a single 8-bit mask band.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The input bands are read in lockstep a strip of lines at a time, and each
+   rule is evaluated over the strip a term at a time, so the choice of
+   decoder is made once per term and strip rather than once per pixel.
+*****************************************************************************/
+#include <ctype.h>
+#include <time.h>
+#include "combine_qa_mask.h"
+
+/* Input bands of the combiner */
+typedef enum
+{
+    QA_SRC_PIXEL_QA, QA_SRC_RADSAT, QA_SRC_CLOUD, QA_SRC_AEROSOL, QA_NSRC
+} Qa_mask_source_t;
+
+/* Term names, and how each is written */
+typedef struct
+{
+    char *name;                /* name of the term in the rules */
+    Qa_mask_term_type_t type;  /* what the term tests */
+    Qa_mask_source_t source;   /* band the term tests */
+    bool has_level;            /* followed by a comparison and level? */
+    bool has_bands;            /* followed by a band range? */
+} Qa_mask_term_name_t;
+
+static Qa_mask_term_name_t term_names[] =
+{
+    {"fill", QA_TERM_FILL, QA_SRC_PIXEL_QA, false, false},
+    {"clear", QA_TERM_CLEAR, QA_SRC_PIXEL_QA, false, false},
+    {"water", QA_TERM_WATER, QA_SRC_PIXEL_QA, false, false},
+    {"cloud_shadow", QA_TERM_CLOUD_SHADOW, QA_SRC_PIXEL_QA, false, false},
+    {"snow", QA_TERM_SNOW, QA_SRC_PIXEL_QA, false, false},
+    {"cloud", QA_TERM_CLOUD, QA_SRC_PIXEL_QA, false, false},
+    {"terrain_occlusion", QA_TERM_TERRAIN_OCCL, QA_SRC_PIXEL_QA, false, false},
+    {"cloud_conf", QA_TERM_CLOUD_CONF, QA_SRC_PIXEL_QA, true, false},
+    {"cirrus_conf", QA_TERM_CIRRUS_CONF, QA_SRC_PIXEL_QA, true, false},
+    {"radsat_fill", QA_TERM_RADSAT_FILL, QA_SRC_RADSAT, false, false},
+    {"sat", QA_TERM_SATURATED, QA_SRC_RADSAT, false, true},
+    {"ledaps_ddv", QA_TERM_LEDAPS_DDV, QA_SRC_CLOUD, false, false},
+    {"ledaps_cloud", QA_TERM_LEDAPS_CLOUD, QA_SRC_CLOUD, false, false},
+    {"ledaps_cloud_shadow", QA_TERM_LEDAPS_CLOUD_SHADOW, QA_SRC_CLOUD, false,
+        false},
+    {"ledaps_adj_cloud", QA_TERM_LEDAPS_ADJ_CLOUD, QA_SRC_CLOUD, false, false},
+    {"ledaps_snow", QA_TERM_LEDAPS_SNOW, QA_SRC_CLOUD, false, false},
+    {"ledaps_land", QA_TERM_LEDAPS_LAND, QA_SRC_CLOUD, false, false},
+    {"aerosol_fill", QA_TERM_AEROSOL_FILL, QA_SRC_AEROSOL, false, false},
+    {"aerosol_valid", QA_TERM_AEROSOL_VALID, QA_SRC_AEROSOL, false, false},
+    {"aerosol_interp", QA_TERM_AEROSOL_INTERP, QA_SRC_AEROSOL, false, false},
+    {"aerosol_water", QA_TERM_AEROSOL_WATER, QA_SRC_AEROSOL, false, false},
+    {"aerosol_level", QA_TERM_AEROSOL_LEVEL, QA_SRC_AEROSOL, true, false},
+    {NULL, 0, 0, false, false}
+};
+
+/* Level names accepted in place of 0-3 */
+static char *level_names[] = {"none", "low", "moderate", "high"};
+
+/******************************************************************************
+MODULE:  find_term_name
+
+PURPOSE: Looks up the term name in the table of term names.
+
+RETURN VALUE:
+Type = Qa_mask_term_name_t *
+Value           Description
+-----           -----------
+NULL            Unknown term name
+not NULL        Table entry of the term
+
+NOTES:
+******************************************************************************/
+static Qa_mask_term_name_t *find_term_name
+(
+    Qa_mask_term_type_t type  /* I: term type */
+)
+{
+    int i;                    /* looping variable */
+
+    for (i = 0; term_names[i].name != NULL; i++)
+    {
+        if (term_names[i].type == type)
+            return (&term_names[i]);
+    }
+    return (NULL);
+}
+
+
+/******************************************************************************
+MODULE:  parse_term
+
+PURPOSE: Parses a single term of a rule, with the whitespace removed.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Unknown term or badly formed comparison or band range
+SUCCESS         Successfully parsed
+
+NOTES:
+******************************************************************************/
+static int parse_term
+(
+    char *text,             /* I: text of the term */
+    Qa_mask_term_t *term    /* O: parsed term */
+)
+{
+    char FUNC_NAME[] = "parse_term";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int i;                    /* looping variable */
+    size_t len;               /* length of the term name */
+    char *cptr;               /* pointer into the term text */
+    char *endptr;             /* end of a number in the term text */
+    Qa_mask_term_name_t *entry = NULL; /* table entry of the term */
+
+    memset (term, 0, sizeof (Qa_mask_term_t));
+    cptr = text;
+    if (*cptr == '!')
+    {
+        term->negate = true;
+        cptr++;
+    }
+
+    /* The name runs up to a comparison or band range */
+    len = strcspn (cptr, "<>=!:");
+    for (i = 0; term_names[i].name != NULL; i++)
+    {
+        if (strlen (term_names[i].name) == len &&
+            !strncmp (term_names[i].name, cptr, len))
+        {
+            entry = &term_names[i];
+            break;
+        }
+    }
+    if (entry == NULL)
+    {
+        snprintf (errmsg, sizeof (errmsg), "Unknown QA mask term: %.80s", text);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    term->type = entry->type;
+    cptr += len;
+
+    if (entry->has_level)
+    {
+        /* Comparison, then a level number or name */
+        if (!strncmp (cptr, "<=", 2))
+            { term->cmp = QA_CMP_LE; cptr += 2; }
+        else if (!strncmp (cptr, ">=", 2))
+            { term->cmp = QA_CMP_GE; cptr += 2; }
+        else if (!strncmp (cptr, "!=", 2))
+            { term->cmp = QA_CMP_NE; cptr += 2; }
+        else if (*cptr == '<')
+            { term->cmp = QA_CMP_LT; cptr++; }
+        else if (*cptr == '>')
+            { term->cmp = QA_CMP_GT; cptr++; }
+        else if (*cptr == '=')
+            { term->cmp = QA_CMP_EQ; cptr++; }
+        else
+        {
+            snprintf (errmsg, sizeof (errmsg), "Missing comparison in QA mask "
+                "term: %.80s", text);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        term->level = -1;
+        for (i = 0; i < 4; i++)
+        {
+            if (!strcmp (cptr, level_names[i]))
+                term->level = i;
+        }
+        if (term->level < 0)
+        {
+            term->level = strtol (cptr, &endptr, 10);
+            if (endptr == cptr || *endptr != '\0' || term->level < 0 ||
+                term->level > 3)
+            {
+                snprintf (errmsg, sizeof (errmsg), "Level must be 0-3 or "
+                    "none/low/moderate/high in QA mask term: %.80s", text);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+        }
+    }
+    else if (entry->has_bands)
+    {
+        /* Band, or first and last band */
+        if (*cptr == ':')
+            cptr++;
+        term->first_band = strtol (cptr, &endptr, 10);
+        term->last_band = term->first_band;
+        if (endptr != cptr && *endptr == '-')
+        {
+            cptr = endptr + 1;
+            term->last_band = strtol (cptr, &endptr, 10);
+        }
+        if (endptr == cptr || *endptr != '\0' || term->first_band < 1 ||
+            term->last_band < term->first_band)
+        {
+            snprintf (errmsg, sizeof (errmsg), "Expecting sat:<band> or "
+                "sat:<first band>-<last band> in QA mask term: %.80s", text);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+    else if (*cptr != '\0')
+    {
+        snprintf (errmsg, sizeof (errmsg), "Unexpected text after QA mask "
+            "term: %.80s", text);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  parse_qa_mask_rules
+
+PURPOSE: Parses the text of the mask rules.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error parsing the rules
+SUCCESS         Successfully parsed
+
+NOTES:
+1. See combine_qa_mask.h for the form of the rules.
+2. radsat_category defaults to LEDAPS_RADSAT, or LASRC_RADSAT if the rules
+   use the aerosol band.  combine_qa_mask sets it from the data type of the
+   radsat_qa band.
+******************************************************************************/
+int parse_qa_mask_rules
+(
+    char *rule_text,        /* I: rules, see the notes above */
+    Qa_mask_rules_t *rules  /* O: parsed rules */
+)
+{
+    char FUNC_NAME[] = "parse_qa_mask_rules";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    char text[STR_SIZE];      /* rule text without the whitespace */
+    char *rule;               /* current rule */
+    char *term;               /* current term */
+    char *rule_save;          /* strtok_r state for the rules */
+    char *term_save;          /* strtok_r state for the terms */
+    char *cptr;               /* pointer into the rule text */
+    size_t len;               /* length of the text without whitespace */
+    Qa_mask_rule_t *curr;     /* rule being parsed */
+    Qa_mask_term_name_t *entry; /* table entry of a term */
+    int i, j;                 /* looping variables */
+
+    memset (rules, 0, sizeof (Qa_mask_rules_t));
+    rules->radsat_category = LEDAPS_RADSAT;
+
+    /* Remove the whitespace */
+    len = 0;
+    for (cptr = rule_text; *cptr != '\0'; cptr++)
+    {
+        if (isspace ((unsigned char) *cptr))
+            continue;
+        if (len == STR_SIZE - 1)
+        {
+            sprintf (errmsg, "QA mask rules are too long");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        text[len++] = *cptr;
+    }
+    text[len] = '\0';
+
+    for (rule = strtok_r (text, ";", &rule_save); rule != NULL;
+         rule = strtok_r (NULL, ";", &rule_save))
+    {
+        if (rules->nrules == QA_MASK_MAX_RULES)
+        {
+            sprintf (errmsg, "At most %d QA mask rules are allowed, one per "
+                "bit of the mask", QA_MASK_MAX_RULES);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        curr = &rules->rules[rules->nrules];
+        strcpy (curr->text, rule);
+
+        for (term = strtok_r (rule, "&", &term_save); term != NULL;
+             term = strtok_r (NULL, "&", &term_save))
+        {
+            if (curr->nterms == QA_MASK_MAX_TERMS)
+            {
+                sprintf (errmsg, "At most %d terms are allowed in a QA mask "
+                    "rule", QA_MASK_MAX_TERMS);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            if (parse_term (term, &curr->terms[curr->nterms]) != SUCCESS)
+            {  /* Error messages already written */
+                return (ERROR);
+            }
+            curr->nterms++;
+        }
+
+        if (curr->nterms == 0)
+            continue;
+        rules->nrules++;
+    }
+
+    if (rules->nrules == 0)
+    {
+        sprintf (errmsg, "No QA mask rules were specified");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* The aerosol band comes with the LaSRC radsat band */
+    for (i = 0; i < rules->nrules; i++)
+    {
+        for (j = 0; j < rules->rules[i].nterms; j++)
+        {
+            entry = find_term_name (rules->rules[i].terms[j].type);
+            if (entry->source == QA_SRC_AEROSOL)
+                rules->radsat_category = LASRC_RADSAT;
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  compare_level
+
+PURPOSE: Compares a confidence or aerosol level against the level of a term.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The comparison holds
+false           The comparison doesn't hold
+
+NOTES:
+******************************************************************************/
+static inline bool compare_level
+(
+    uint8_t value,          /* I: level of the pixel */
+    Qa_mask_cmp_t cmp,      /* I: comparison */
+    int level               /* I: level of the term */
+)
+{
+    switch (cmp)
+    {
+        case QA_CMP_LT: return (value < level);
+        case QA_CMP_LE: return (value <= level);
+        case QA_CMP_EQ: return (value == level);
+        case QA_CMP_NE: return (value != level);
+        case QA_CMP_GE: return (value >= level);
+        default:        return (value > level);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  is_saturated
+
+PURPOSE: Determines if the radsat QA pixel is saturated in any of the bands
+of the term.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            Saturated in at least one of the bands
+false           Not saturated in any of the bands
+
+NOTES:
+******************************************************************************/
+static inline bool is_saturated
+(
+    uint16_t radsat_pix,    /* I: radsat QA value, widened to uint16 */
+    Espa_level2_qa_type radsat_category, /* I: LEDAPS or LaSRC radsat */
+    int first_band,         /* I: first band tested */
+    int last_band           /* I: last band tested */
+)
+{
+    int band;               /* looping variable for the bands */
+
+    for (band = first_band; band <= last_band; band++)
+    {
+        if (radsat_category == LASRC_RADSAT)
+        {
+            if (lasrc_radsat_qa_is_saturated (radsat_pix, band))
+                return true;
+        }
+        else if (ledaps_qa_is_saturated (radsat_pix, band))
+            return true;
+    }
+    return false;
+}
+
+
+/* Clears the rule bit of every pixel where the test doesn't match the
+   negation of the term */
+#define QA_MASK_TERM_LOOP(test) \
+    for (i = 0; i < npixels; i++) \
+    { \
+        if ((test) == term->negate) \
+            mask[i] &= clear_bit; \
+    }
+
+/******************************************************************************
+MODULE:  evaluate_qa_mask_rules
+
+PURPOSE: Evaluates the rules for a strip of pixels and sets the mask bits.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The bands used by the rules must be provided; the others may be NULL.
+2. Each term clears its rule bit wherever it doesn't hold, so the bit is left
+   set only where all of the terms of the rule hold.
+******************************************************************************/
+void evaluate_qa_mask_rules
+(
+    Qa_mask_rules_t *rules, /* I: rules to evaluate */
+    int npixels,            /* I: number of pixels */
+    uint16_t *pixel_qa,     /* I: pixel QA values (NULL if unused) */
+    uint16_t *radsat_qa,    /* I: radsat QA values, widened to uint16 (NULL
+                                  if unused) */
+    uint8_t *cloud_qa,      /* I: LEDAPS cloud QA values (NULL if unused) */
+    uint8_t *aerosol_qa,    /* I: LaSRC aerosol QA values (NULL if unused) */
+    uint8_t *mask           /* O: mask values, bit i set where rule i holds */
+)
+{
+    int i;                  /* looping variable for the pixels */
+    int r;                  /* looping variable for the rules */
+    int t;                  /* looping variable for the terms */
+    uint8_t clear_bit;      /* mask with the bit of the current rule clear */
+    Qa_mask_term_t *term;   /* current term */
+    Espa_level2_qa_type radsat_category = rules->radsat_category;
+
+    memset (mask, (1 << rules->nrules) - 1, npixels);
+
+    for (r = 0; r < rules->nrules; r++)
+    {
+        clear_bit = ~(1 << r);
+        for (t = 0; t < rules->rules[r].nterms; t++)
+        {
+            term = &rules->rules[r].terms[t];
+            switch (term->type)
+            {
+                case QA_TERM_FILL:
+                    QA_MASK_TERM_LOOP (pixel_qa_is_fill (pixel_qa[i]))
+                    break;
+                case QA_TERM_CLEAR:
+                    QA_MASK_TERM_LOOP (pixel_qa_is_clear (pixel_qa[i]))
+                    break;
+                case QA_TERM_WATER:
+                    QA_MASK_TERM_LOOP (pixel_qa_is_water (pixel_qa[i]))
+                    break;
+                case QA_TERM_CLOUD_SHADOW:
+                    QA_MASK_TERM_LOOP (pixel_qa_is_cloud_shadow (pixel_qa[i]))
+                    break;
+                case QA_TERM_SNOW:
+                    QA_MASK_TERM_LOOP (pixel_qa_is_snow (pixel_qa[i]))
+                    break;
+                case QA_TERM_CLOUD:
+                    QA_MASK_TERM_LOOP (pixel_qa_is_cloud (pixel_qa[i]))
+                    break;
+                case QA_TERM_TERRAIN_OCCL:
+                    QA_MASK_TERM_LOOP (pixel_qa_is_terrain_occluded (
+                        pixel_qa[i]))
+                    break;
+                case QA_TERM_CLOUD_CONF:
+                    QA_MASK_TERM_LOOP (compare_level (
+                        pixel_qa_cloud_confidence (pixel_qa[i]), term->cmp,
+                        term->level))
+                    break;
+                case QA_TERM_CIRRUS_CONF:
+                    QA_MASK_TERM_LOOP (compare_level (
+                        pixel_qa_cirrus_confidence (pixel_qa[i]), term->cmp,
+                        term->level))
+                    break;
+
+                case QA_TERM_RADSAT_FILL:
+                    if (radsat_category == LASRC_RADSAT)
+                        QA_MASK_TERM_LOOP (lasrc_radsat_qa_is_fill (
+                            radsat_qa[i]))
+                    else
+                        QA_MASK_TERM_LOOP (ledaps_qa_is_fill (radsat_qa[i]))
+                    break;
+                case QA_TERM_SATURATED:
+                    QA_MASK_TERM_LOOP (is_saturated (radsat_qa[i],
+                        radsat_category, term->first_band, term->last_band))
+                    break;
+
+                case QA_TERM_LEDAPS_DDV:
+                    QA_MASK_TERM_LOOP (ledaps_qa_is_ddv (cloud_qa[i]))
+                    break;
+                case QA_TERM_LEDAPS_CLOUD:
+                    QA_MASK_TERM_LOOP (ledaps_qa_is_cloud (cloud_qa[i]))
+                    break;
+                case QA_TERM_LEDAPS_CLOUD_SHADOW:
+                    QA_MASK_TERM_LOOP (ledaps_qa_is_cloud_shadow (cloud_qa[i]))
+                    break;
+                case QA_TERM_LEDAPS_ADJ_CLOUD:
+                    QA_MASK_TERM_LOOP (ledaps_qa_is_adj_cloud (cloud_qa[i]))
+                    break;
+                case QA_TERM_LEDAPS_SNOW:
+                    QA_MASK_TERM_LOOP (ledaps_qa_is_snow (cloud_qa[i]))
+                    break;
+                case QA_TERM_LEDAPS_LAND:
+                    QA_MASK_TERM_LOOP (ledaps_qa_is_land_water (cloud_qa[i]))
+                    break;
+
+                case QA_TERM_AEROSOL_FILL:
+                    QA_MASK_TERM_LOOP (lasrc_qa_is_fill (aerosol_qa[i]))
+                    break;
+                case QA_TERM_AEROSOL_VALID:
+                    QA_MASK_TERM_LOOP (lasrc_qa_is_valid_aerosol_retrieval (
+                        aerosol_qa[i]))
+                    break;
+                case QA_TERM_AEROSOL_INTERP:
+                    QA_MASK_TERM_LOOP (lasrc_qa_is_aerosol_interp (
+                        aerosol_qa[i]))
+                    break;
+                case QA_TERM_AEROSOL_WATER:
+                    QA_MASK_TERM_LOOP (lasrc_qa_is_water (aerosol_qa[i]))
+                    break;
+                case QA_TERM_AEROSOL_LEVEL:
+                    QA_MASK_TERM_LOOP (compare_level (
+                        lasrc_qa_aerosol_level (aerosol_qa[i]), term->cmp,
+                        term->level))
+                    break;
+            }
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  append_qa_mask_band
+
+PURPOSE: Writes the ENVI header of the mask band and adds the band to the XML
+file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the header or updating the XML file
+SUCCESS         Successfully written
+
+NOTES:
+1. The bitmap description of each mask bit is the text of its rule.
+******************************************************************************/
+static int append_qa_mask_band
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    Espa_internal_meta_t *xml_metadata, /* I: parsed XML metadata */
+    Espa_band_meta_t *pqa_bmeta, /* I: band metadata of the pixel QA band */
+    Qa_mask_rules_t *rules, /* I: rules of the mask bits */
+    char *mask_file         /* I: mask band filename */
+)
+{
+    char FUNC_NAME[] = "append_qa_mask_band";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    char envi_file[STR_SIZE]; /* name of the output ENVI header file */
+    char production_date[MAX_DATE_LEN+1]; /* current date/time for production */
+    char *cptr;               /* pointer to the file extension */
+    int i;                    /* looping variable for the mask bits */
+    time_t tp;                /* time structure */
+    struct tm *tm = NULL;     /* time structure for UTC time */
+    Espa_internal_meta_t mask_metadata; /* metadata of the mask band */
+    Espa_band_meta_t *mask_bmeta; /* band metadata of the mask band */
+    Envi_header_t envi_hdr;   /* output ENVI header information */
+
+    init_metadata_struct (&mask_metadata);
+    if (allocate_band_metadata (&mask_metadata, 1) != SUCCESS)
+    {
+        sprintf (errmsg, "Allocating band metadata for the QA mask.");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    mask_bmeta = &mask_metadata.band[0];
+
+    strcpy (mask_bmeta->product, "level2_qa");
+    strcpy (mask_bmeta->source, "level2_qa");
+    strcpy (mask_bmeta->name, "qa_mask");
+    strcpy (mask_bmeta->category, "qa");
+    mask_bmeta->data_type = ESPA_UINT8;
+    mask_bmeta->nlines = pqa_bmeta->nlines;
+    mask_bmeta->nsamps = pqa_bmeta->nsamps;
+    snprintf (mask_bmeta->short_name, sizeof (mask_bmeta->short_name),
+        "%.4sQMSK", pqa_bmeta->short_name);
+    strcpy (mask_bmeta->long_name, "combined QA mask");
+    mask_bmeta->pixel_size[0] = pqa_bmeta->pixel_size[0];
+    mask_bmeta->pixel_size[1] = pqa_bmeta->pixel_size[1];
+    strcpy (mask_bmeta->pixel_units, pqa_bmeta->pixel_units);
+    strcpy (mask_bmeta->data_units, "bitmap");
+    sprintf (mask_bmeta->app_version, "combine_qa_mask_%s",
+        L2QA_COMMON_VERSION);
+    strcpy (mask_bmeta->file_name, mask_file);
+
+    if (allocate_bitmap_metadata (mask_bmeta, 8) != SUCCESS)
+    {
+        sprintf (errmsg, "Cannot allocate memory for the QA mask bitmap");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&mask_metadata);
+        return (ERROR);
+    }
+    for (i = 0; i < 8; i++)
+    {
+        if (i < rules->nrules)
+            snprintf (mask_bmeta->bitmap_description[i], STR_SIZE, "%s",
+                rules->rules[i].text);
+        else
+            strcpy (mask_bmeta->bitmap_description[i], "unused");
+    }
+
+    /* Get the current date/time (UTC) for the production date */
+    if (time (&tp) == -1 || (tm = gmtime (&tp)) == NULL ||
+        strftime (production_date, MAX_DATE_LEN, "%Y-%m-%dT%H:%M:%SZ", tm)
+        == 0)
+    {
+        sprintf (errmsg, "Formatting the production date/time.");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&mask_metadata);
+        return (ERROR);
+    }
+    strcpy (mask_bmeta->production_date, production_date);
+
+    /* Create and write the ENVI header */
+    if (create_envi_struct (mask_bmeta, &xml_metadata->global, &envi_hdr) !=
+        SUCCESS)
+    {
+        sprintf (errmsg, "Creating ENVI header structure.");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&mask_metadata);
+        return (ERROR);
+    }
+    strcpy (envi_file, mask_bmeta->file_name);
+    cptr = strrchr (envi_file, '.');
+    strcpy (cptr, ".hdr");
+    if (write_envi_hdr (envi_file, &envi_hdr) != SUCCESS)
+    {
+        sprintf (errmsg, "Writing ENVI header file.");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&mask_metadata);
+        return (ERROR);
+    }
+
+    /* Add the mask band to the XML file */
+    if (append_metadata (1, mask_bmeta, espa_xml_file) != SUCCESS)
+    {
+        sprintf (errmsg, "Appending QA mask band to XML file.");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&mask_metadata);
+        return (ERROR);
+    }
+
+    free_metadata (&mask_metadata);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  combine_qa_mask
+
+PURPOSE: Reads the pixel QA and Level-2 QA bands used by the rules in a
+single pass, a strip at a time, and writes the combined 8-bit mask band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the bands or writing the mask
+SUCCESS         Successfully combined
+
+NOTES:
+1. The XML file is parsed once for all of the input bands.
+2. The mask is written next to the pixel QA band as *_qa_mask.img with an
+   ENVI header, and added to the XML file as the qa_mask band.
+3. The saturation terms are decoded as LaSRC if the radsat_qa band is 16-bit
+   and LEDAPS if it is 8-bit.
+******************************************************************************/
+int combine_qa_mask
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    Qa_mask_rules_t *rules, /* I/O: rules to evaluate; radsat_category is set
+                                    from the radsat_qa band */
+    int strip_lines         /* I: number of lines per strip */
+)
+{
+    char FUNC_NAME[] = "combine_qa_mask";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    char mask_file[STR_SIZE]; /* mask band filename */
+    char *cptr;               /* pointer to the file extension */
+    bool used[QA_NSRC];       /* is each input band used by the rules? */
+    int i, r, t;              /* looping variables */
+    int status;               /* status of the combining */
+    int nlines = 0;           /* number of lines in the bands */
+    int nsamps = 0;           /* number of samples in the bands */
+    int line;                 /* first line of the current strip */
+    int nstrip = 0;           /* number of lines in the current strip */
+    int nread;                /* number of lines read from a Level-2 band */
+    int nl2;                  /* number of Level-2 QA bands used */
+    int nfound;               /* number of Level-2 QA bands opened */
+    int pqa_indx = -1;        /* index of the pixel QA band in the XML */
+    Espa_internal_meta_t xml_metadata; /* parsed XML metadata */
+    Espa_band_meta_t *bmeta;  /* array of bands metadata */
+    Level2_qa_band_t l2_bands[3]; /* Level-2 QA bands used by the rules */
+    Level2_qa_strips_t l2_strips[3]; /* strip readers of the Level-2 bands */
+    Qa_mask_source_t l2_source[3]; /* input band of each Level-2 band */
+    Qa_mask_term_name_t *entry; /* table entry of a term */
+    FILE *fp_pqa = NULL;      /* pixel QA band */
+    FILE *fp_mask = NULL;     /* mask band */
+    uint16_t *pixel_qa = NULL; /* strip of the pixel QA band */
+    uint16_t *radsat_qa = NULL; /* strip of the radsat QA band */
+    uint8_t *cloud_qa = NULL; /* strip of the LEDAPS cloud QA band */
+    uint8_t *aerosol_qa = NULL; /* strip of the LaSRC aerosol QA band */
+    uint8_t *mask = NULL;     /* strip of the mask band */
+
+    /* Which bands do the rules use? */
+    memset (used, 0, sizeof (used));
+    for (r = 0; r < rules->nrules; r++)
+    {
+        for (t = 0; t < rules->rules[r].nterms; t++)
+        {
+            entry = find_term_name (rules->rules[r].terms[t].type);
+            used[entry->source] = true;
+        }
+    }
+
+    /* Parse the XML file once for all of the bands */
+    if (validate_xml_file (espa_xml_file) != SUCCESS)
+    {  /* Error messages already written */
+        return (ERROR);
+    }
+    init_metadata_struct (&xml_metadata);
+    if (parse_metadata (espa_xml_file, &xml_metadata) != SUCCESS)
+    {  /* Error messages already written */
+        return (ERROR);
+    }
+    bmeta = xml_metadata.band;
+
+    /* The pixel QA band names the mask, and the radsat_qa data type tells
+       LEDAPS from LaSRC */
+    for (i = 0; i < xml_metadata.nbands; i++)
+    {
+        if (!strcmp (bmeta[i].name, "pixel_qa") &&
+            !strcmp (bmeta[i].category, "qa"))
+            pqa_indx = i;
+        if (!strcmp (bmeta[i].name, "radsat_qa") &&
+            !strcmp (bmeta[i].category, "qa"))
+            rules->radsat_category = (bmeta[i].data_type == ESPA_UINT16) ?
+                LASRC_RADSAT : LEDAPS_RADSAT;
+    }
+    if (pqa_indx < 0)
+    {
+        sprintf (errmsg, "Unable to find the pixel QA band in the XML file");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&xml_metadata);
+        return (ERROR);
+    }
+    nlines = bmeta[pqa_indx].nlines;
+    nsamps = bmeta[pqa_indx].nsamps;
+
+    /* Check the saturation bands against the radsat band */
+    for (r = 0; r < rules->nrules; r++)
+    {
+        for (t = 0; t < rules->rules[r].nterms; t++)
+        {
+            if (rules->rules[r].terms[t].type == QA_TERM_SATURATED &&
+                rules->rules[r].terms[t].last_band >
+                    ((rules->radsat_category == LASRC_RADSAT) ?
+                    LASRC_B11_SAT_BIT : LEDAPS_B7_SAT_BIT))
+            {
+                sprintf (errmsg, "Saturation band out of range for the "
+                    "radsat_qa band in rule %d", r);
+                error_handler (true, FUNC_NAME, errmsg);
+                free_metadata (&xml_metadata);
+                return (ERROR);
+            }
+        }
+    }
+
+    /* Open the Level-2 QA bands used by the rules */
+    nl2 = 0;
+    if (used[QA_SRC_RADSAT])
+    {
+        l2_bands[nl2].qa_category = rules->radsat_category;
+        l2_source[nl2++] = QA_SRC_RADSAT;
+    }
+    if (used[QA_SRC_CLOUD])
+    {
+        l2_bands[nl2].qa_category = LEDAPS_CLOUD;
+        l2_source[nl2++] = QA_SRC_CLOUD;
+    }
+    if (used[QA_SRC_AEROSOL])
+    {
+        l2_bands[nl2].qa_category = LASRC_AEROSOL;
+        l2_source[nl2++] = QA_SRC_AEROSOL;
+    }
+    if (open_level2_qa_bands (&xml_metadata, nl2, l2_bands, &nfound) !=
+        SUCCESS)
+    {  /* Error messages already written */
+        free_metadata (&xml_metadata);
+        return (ERROR);
+    }
+    memset (l2_strips, 0, sizeof (l2_strips));
+    status = SUCCESS;
+    if (nfound != nl2)
+    {
+        sprintf (errmsg, "The rules use Level-2 QA bands which aren't in the "
+            "XML file");
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+    for (i = 0; status == SUCCESS && i < nl2; i++)
+    {
+        if (l2_bands[i].nlines != nlines || l2_bands[i].nsamps != nsamps)
+        {
+            sprintf (errmsg, "Level-2 QA band for %s doesn't match the size "
+                "of the pixel QA band", (l2_source[i] == QA_SRC_RADSAT) ?
+                "radsat" : (l2_source[i] == QA_SRC_CLOUD) ? "cloud" :
+                "aerosol");
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+        else if (init_level2_qa_strips (l2_bands[i].fp_l2qa,
+            l2_bands[i].qa_category, nlines, nsamps, strip_lines,
+            l2_source[i] == QA_SRC_RADSAT, &l2_strips[i]) != SUCCESS)
+        {
+            sprintf (errmsg, "Setting up the Level-2 QA strip readers");
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+
+    /* Open the pixel QA band */
+    if (status == SUCCESS && used[QA_SRC_PIXEL_QA])
+    {
+        fp_pqa = open_raw_binary (bmeta[pqa_indx].file_name, "r");
+        pixel_qa = calloc ((size_t) strip_lines * nsamps, sizeof (uint16_t));
+        if (fp_pqa == NULL || pixel_qa == NULL)
+        {
+            sprintf (errmsg, "Opening the pixel QA band");
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+
+    /* Create the mask band next to the pixel QA band, replacing pixel_qa in
+       the name with qa_mask */
+    if (status == SUCCESS)
+    {
+        snprintf (mask_file, sizeof (mask_file), "%s",
+            bmeta[pqa_indx].file_name);
+        cptr = strstr (mask_file, "pixel_qa.");
+        if (cptr == NULL)
+            cptr = strrchr (mask_file, '.');
+        if (cptr == NULL || cptr - mask_file + strlen ("_qa_mask.img") >=
+            STR_SIZE)
+        {
+            sprintf (errmsg, "Unable to name the QA mask band from the pixel "
+                "QA band");
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+        else
+        {
+            strcpy (cptr, (*cptr == '.') ? "_qa_mask.img" : "qa_mask.img");
+            fp_mask = open_raw_binary (mask_file, "w");
+            mask = calloc ((size_t) strip_lines * nsamps, sizeof (uint8_t));
+            if (fp_mask == NULL || mask == NULL)
+            {
+                sprintf (errmsg, "Creating the QA mask band");
+                error_handler (true, FUNC_NAME, errmsg);
+                status = ERROR;
+            }
+        }
+    }
+
+    /* Stream all of the bands in lockstep, a strip at a time */
+    for (line = 0; status == SUCCESS && line < nlines; line += nstrip)
+    {
+        nstrip = (nlines - line < strip_lines) ? nlines - line : strip_lines;
+
+        if (fp_pqa != NULL &&
+            read_pixel_qa (fp_pqa, nstrip, nsamps, pixel_qa) != SUCCESS)
+        {
+            sprintf (errmsg, "Reading lines %d-%d of the pixel QA band", line,
+                line + nstrip - 1);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+            break;
+        }
+
+        for (i = 0; status == SUCCESS && i < nl2; i++)
+        {
+            if (l2_source[i] == QA_SRC_RADSAT)
+                status = next_level2_qa_strip_uint16 (&l2_strips[i],
+                    &radsat_qa, &nread);
+            else if (l2_source[i] == QA_SRC_CLOUD)
+                status = next_level2_qa_strip_uint8 (&l2_strips[i], &cloud_qa,
+                    &nread);
+            else
+                status = next_level2_qa_strip_uint8 (&l2_strips[i],
+                    &aerosol_qa, &nread);
+            if (status != SUCCESS || nread != nstrip)
+            {
+                sprintf (errmsg, "Reading lines %d-%d of the Level-2 QA "
+                    "bands", line, line + nstrip - 1);
+                error_handler (true, FUNC_NAME, errmsg);
+                status = ERROR;
+            }
+        }
+        if (status != SUCCESS)
+            break;
+
+        evaluate_qa_mask_rules (rules, nstrip * nsamps, pixel_qa, radsat_qa,
+            cloud_qa, aerosol_qa, mask);
+
+        if (write_raw_binary (fp_mask, nstrip, nsamps, sizeof (uint8_t), mask)
+            != SUCCESS)
+        {
+            sprintf (errmsg, "Writing lines %d-%d of the QA mask band", line,
+                line + nstrip - 1);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+
+    /* Close the mask and add it to the XML file */
+    if (fp_mask != NULL)
+        close_raw_binary (fp_mask);
+    if (status == SUCCESS)
+        status = append_qa_mask_band (espa_xml_file, &xml_metadata,
+            &bmeta[pqa_indx], rules, mask_file);
+
+    /* Close the input bands and free the buffers */
+    for (i = 0; i < nl2; i++)
+        close_level2_qa_strips (&l2_strips[i]);
+    close_level2_qa_multi (nl2, l2_bands);
+    if (fp_pqa != NULL)
+        close_pixel_qa (fp_pqa);
+    free (pixel_qa);
+    free (mask);
+    free_metadata (&xml_metadata);
+
+    return (status);
+}
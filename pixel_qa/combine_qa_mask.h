@@ -0,0 +1,140 @@
+/*****************************************************************************
+FILE: combine_qa_mask.h
+  
+PURPOSE: Contains defines, data types, and function prototypes for combining
+the pixel QA band and the LEDAPS/LaSRC Level-2 QA bands into a single 8-bit
+mask band, using a set of rules evaluated in one pass over all the bands.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. Each rule is the AND of one or more terms, and sets its own bit of the
+   mask (rule 0 is bit 0), so a mask holds up to 8 rules.  Rules are
+   separated by ';' and terms by '&'.  A term starting with '!' is negated.
+   Whitespace is ignored.
+2. Terms on the pixel QA band:
+      fill, clear, water, cloud_shadow, snow, cloud, terrain_occlusion
+      cloud_conf<op><level>, cirrus_conf<op><level>
+   Terms on the radsat_qa band (LEDAPS or LaSRC, from its data type):
+      radsat_fill
+      sat:<band> or sat:<first band>-<last band> (saturated in any of them)
+   Terms on the LEDAPS sr_cloud_qa band:
+      ledaps_ddv, ledaps_cloud, ledaps_cloud_shadow, ledaps_adj_cloud,
+      ledaps_snow, ledaps_land
+   Terms on the LaSRC sr_aerosol band:
+      aerosol_fill, aerosol_valid, aerosol_interp, aerosol_water,
+      aerosol_level<op><level>
+   where <op> is one of <, <=, =, !=, >=, > and <level> is 0-3 or one of
+   none, low, moderate, high.
+3. Example, clear and not saturated in bands 2-5 with less than high aerosol
+   content in bit 0, and water in bit 1:
+      clear & !sat:2-5 & aerosol_level<high; water
+4. Only the bands used by the rules are read.
+*****************************************************************************/
+
+#ifndef COMBINE_QA_MASK_H
+#define COMBINE_QA_MASK_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "error_handler.h"
+#include "espa_metadata.h"
+#include "parse_metadata.h"
+#include "raw_binary_io.h"
+#include "read_pixel_qa.h"
+#include "read_level2_qa.h"
+#include "level2_qa_strips.h"
+#include "l2qa_common.h"
+#include "write_metadata.h"
+#include "envi_header.h"
+
+/* Defines */
+#define MAX_DATE_LEN 28            /* same as in generate_pixel_qa.h */
+#define QA_MASK_MAX_RULES 8        /* one rule per bit of the mask */
+#define QA_MASK_MAX_TERMS 16       /* maximum number of terms in a rule */
+#define QA_MASK_STRIP_LINES 256    /* default lines per strip */
+
+/* Data types */
+typedef enum
+{
+    /* pixel QA */
+    QA_TERM_FILL, QA_TERM_CLEAR, QA_TERM_WATER, QA_TERM_CLOUD_SHADOW,
+    QA_TERM_SNOW, QA_TERM_CLOUD, QA_TERM_TERRAIN_OCCL, QA_TERM_CLOUD_CONF,
+    QA_TERM_CIRRUS_CONF,
+
+    /* radsat QA */
+    QA_TERM_RADSAT_FILL, QA_TERM_SATURATED,
+
+    /* LEDAPS cloud QA */
+    QA_TERM_LEDAPS_DDV, QA_TERM_LEDAPS_CLOUD, QA_TERM_LEDAPS_CLOUD_SHADOW,
+    QA_TERM_LEDAPS_ADJ_CLOUD, QA_TERM_LEDAPS_SNOW, QA_TERM_LEDAPS_LAND,
+
+    /* LaSRC aerosol QA */
+    QA_TERM_AEROSOL_FILL, QA_TERM_AEROSOL_VALID, QA_TERM_AEROSOL_INTERP,
+    QA_TERM_AEROSOL_WATER, QA_TERM_AEROSOL_LEVEL
+} Qa_mask_term_type_t;
+
+typedef enum
+{
+    QA_CMP_LT, QA_CMP_LE, QA_CMP_EQ, QA_CMP_NE, QA_CMP_GE, QA_CMP_GT
+} Qa_mask_cmp_t;
+
+typedef struct
+{
+    Qa_mask_term_type_t type;  /* what the term tests */
+    bool negate;               /* term is true where the test is false */
+    int first_band;            /* first band tested for saturation */
+    int last_band;             /* last band tested for saturation */
+    Qa_mask_cmp_t cmp;         /* comparison for the confidence and aerosol
+                                  level terms */
+    int level;                 /* level compared against (0-3) */
+} Qa_mask_term_t;
+
+typedef struct
+{
+    char text[STR_SIZE];       /* rule as given, for the band metadata */
+    int nterms;                /* number of terms ANDed together */
+    Qa_mask_term_t terms[QA_MASK_MAX_TERMS]; /* terms of the rule */
+} Qa_mask_rule_t;
+
+typedef struct
+{
+    int nrules;                /* number of rules (mask bits) */
+    Qa_mask_rule_t rules[QA_MASK_MAX_RULES]; /* rules, rule i sets bit i */
+    Espa_level2_qa_type radsat_category; /* LEDAPS_RADSAT or LASRC_RADSAT;
+                                  how the saturation terms are decoded */
+} Qa_mask_rules_t;
+
+/* Function prototypes */
+int parse_qa_mask_rules
+(
+    char *rule_text,        /* I: rules, see the notes above */
+    Qa_mask_rules_t *rules  /* O: parsed rules */
+);
+
+void evaluate_qa_mask_rules
+(
+    Qa_mask_rules_t *rules, /* I: rules to evaluate */
+    int npixels,            /* I: number of pixels */
+    uint16_t *pixel_qa,     /* I: pixel QA values (NULL if unused) */
+    uint16_t *radsat_qa,    /* I: radsat QA values, widened to uint16 (NULL
+                                  if unused) */
+    uint8_t *cloud_qa,      /* I: LEDAPS cloud QA values (NULL if unused) */
+    uint8_t *aerosol_qa,    /* I: LaSRC aerosol QA values (NULL if unused) */
+    uint8_t *mask           /* O: mask values, bit i set where rule i holds */
+);
+
+int combine_qa_mask
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    Qa_mask_rules_t *rules, /* I/O: rules to evaluate; radsat_category is set
+                                    from the radsat_qa band */
+    int strip_lines         /* I: number of lines per strip */
+);
+
+#endif
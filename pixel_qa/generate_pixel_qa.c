@@ -19,126 +19,39 @@ NOTES:
 #include "pixel_qa.h"
 #include "generate_pixel_qa.h"
 #include "read_level1_qa.h"
+#include "l2qa_timing.h"
 
 /******************************************************************************
-MODULE:  generate_pixel_qa
+MODULE:  translate_level1_qa
 
-PURPOSE: Generates the pixel QA band, using input from the input Level-1
-quality band, and adds the band to the XML file.
+PURPOSE: Translates the Level-1 QA values into the pixel QA values.
 
 RETURN VALUE:
-Type = int
-Value           Description
------           -----------
-ERROR           Error generating the pixel QA
-SUCCESS         Successfully generated
+Type = None
 
 NOTES:
-1. This QA band will be an unsigned 16-bit integer containing some of the
-   pixel-level QA information from the Level-1 QA band.  The bits represented
-   are identified in the pixel_qa.h include file.
+1. The bits represented in the pixel QA are identified in the pixel_qa.h
+   include file.
 2. Refer to http://landsat.usgs.gov/collectionqualityband.php for the Level-1
    QA band information.
+3. This is the reference translation for the Collection 1 layouts, checking
+   the QA category for every pixel.  The generation uses the specialized
+   kernels from get_level1_qa_translator, which must match it.
 ******************************************************************************/
-int generate_pixel_qa
+void translate_level1_qa
 (
-    char *espa_xml_file    /* I: input ESPA XML filename */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    int npixels,           /* I: number of pixels to be translated */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7, L8) */
+    uint16_t *l2_qa        /* O: pixel QA values */
 )
 {
-    char FUNC_NAME[] = "generate_pixel_qa";  /* function name */
-    char errmsg[STR_SIZE];     /* error message */
-    char l1_qa_file[STR_SIZE]; /* input Level-1 QA filename */
-    char l2_qa_file[STR_SIZE]; /* output pixel QA filename */
-    char tmpstr[STR_SIZE];     /* tempoary string for filenames */
-    char envi_file[STR_SIZE];  /* name of the output ENVI header file */
-    char production_date[MAX_DATE_LEN+1]; /* current date/time for production */
-    char *cptr = NULL;         /* character pointer for the '.' in XML name
-                                  and image name */
-    int i;                     /* looping variable */
-    int nlines;                /* number of lines in the QA band */
-    int nsamps;                /* number of samples in the QA band */
-    int refl_indx = -99;       /* index of band1 or first band */
-    uint16_t *l2_qa = NULL;    /* pixel QA band values */
-    uint16_t *l1_qa = NULL;    /* Level-1 QA band values */
-    FILE *l1_fp_bqa = NULL;    /* file pointer for the Level-1 QA band */
-    FILE *l2_fp_bqa = NULL;    /* file pointer for the pixel QA band */
-    time_t tp;                 /* time structure */
-    struct tm *tm = NULL;      /* time structure for UTC time */
-    Espa_level1_qa_type qa_category;    /* type of Level-1 QA data (L4-7, L8) */
-    Espa_internal_meta_t l2qa_metadata; /* metadata container to hold the band
-                                  metadata for the L2 QA band; global metadata
-                                  won't be valid */
-    Espa_internal_meta_t xml_metadata;  /* XML metadata structure to be
-                                  populated by reading the XML metadata file */
-    Espa_band_meta_t *l2qa_bmeta; /* pointer to the array of bands in the
-                                     pixel QA metadata */
-    Espa_band_meta_t *bmeta;    /* pointer to the array of bands metadata */
-    Envi_header_t envi_hdr;     /* output ENVI header information */
-
-    /* Open the Level-1 QA file */
-    l1_fp_bqa = open_level1_qa (espa_xml_file, l1_qa_file, &nlines, &nsamps,
-        &qa_category);
-    if (l1_fp_bqa == NULL)
-    {
-        sprintf (errmsg, "Unable to open the Level-1 QA file");
-        error_handler (true, FUNC_NAME, errmsg);
-        return (ERROR);
-    }
-
-    /* Allocate memory for the Level-1 QA band */
-    l1_qa = calloc (nlines * nsamps, sizeof (uint16_t));
-    if (l1_qa == NULL)
-    {
-        sprintf (errmsg, "Allocating memory for Level-1 QA data");
-        error_handler (true, FUNC_NAME, errmsg);
-        return (ERROR);
-    }
-
-    /* Read the Level-1 QA band */
-    if (read_level1_qa (l1_fp_bqa, nlines, nsamps, l1_qa) != SUCCESS)
-    {
-        sprintf (errmsg, "Unable to read the entire Level-1 QA band");
-        error_handler (true, FUNC_NAME, errmsg);
-        return (ERROR);
-    }
+    int i;                 /* looping variable */
 
-    /* Close the Level-1 QA file */
-    close_level1_qa (l1_fp_bqa);
-
-    /* Allocate memory for the pixel QA band; also initializes these values
-       to L2QA_CLEAR. */
-    l2_qa = calloc (nlines * nsamps, sizeof (uint16_t));
-    if (l2_qa == NULL)
-    {
-        sprintf (errmsg, "Allocating memory for pixel QA data");
-        error_handler (true, FUNC_NAME, errmsg);
-        return (ERROR);
-    }
-
-    for (i = 0; i < nlines * nsamps; i++)
+    /* Initialize the pixel QA values to L2QA_CLEAR */
+    for (i = 0; i < npixels; i++)
         l2_qa[i] = (1 << L2QA_CLEAR);
 
-    /* Determine the name of the pixel QA file */
-    strcpy (l2_qa_file, espa_xml_file);
-    cptr = strrchr (l2_qa_file, '.');
-    if (!cptr)
-    {
-        sprintf (errmsg, "Unable to find the file extension in the XML file. "
-            "Error creating the pixel QA filename.");
-        error_handler (true, FUNC_NAME, errmsg);
-        return (ERROR);
-    }
-    sprintf (cptr, "_pixel_qa.img");
-
-    /* Create the pixel QA file */
-    l2_fp_bqa = create_pixel_qa (l2_qa_file);
-    if (l2_fp_bqa == NULL)
-    {
-        sprintf (errmsg, "Unable to create the pixel QA file");
-        error_handler (true, FUNC_NAME, errmsg);
-        return (ERROR);
-    }
-
     /* Loop through the pixels in the Level-1 QA band and create the pixel QA
        band.  Buffers were already initialized with the L2QA_CLEAR bit set.  It
        needs to be turned off if any condition is turned on, except the low or
@@ -148,7 +61,7 @@ int generate_pixel_qa
        cloud shadow confidence.  The pixel QA will be turned on for snow and
        cloud shadow if the confidence is high (i.e. both bits turned on is a
        value of 3). */
-    for (i = 0; i < nlines * nsamps; i++)
+    for (i = 0; i < npixels; i++)
     {
         if (level1_qa_is_fill (l1_qa[i]))
         { /* if it's fill then we are done */
@@ -210,21 +123,603 @@ int generate_pixel_qa
             }
         }
     }
+}
+
+
+/******************************************************************************
+MODULE:  DEFINE_TRANSLATE_KERNEL
+
+PURPOSE: Defines translate_level1_qa_<name>, the translation of the Level-1
+QA values into the pixel QA values for one layout of LEVEL1_QA_LAYOUT_TABLE.
+
+NOTES:
+1. The rules are those of translate_level1_qa.  The layout predicates have
+   constant bit positions, so the fields the layout doesn't have (terrain
+   occlusion, cirrus confidence) drop out at compile time rather than being
+   checked for every pixel.
+2. Layouts with the classification flags of the Collection 2 QA_PIXEL band
+   use them in place of the Collection 1 rules: the cloud shadow and snow
+   flags replace the high cloud shadow and snow/ice confidences, a pixel
+   which isn't flagged clear or is flagged dilated cloud isn't clear, the
+   cirrus flag is high cirrus confidence, and the water flag marks the
+   pixels which are still clear as water, as set_pixel_qa_water does.
+3. If l1_sat isn't NULL, the radiometric saturation and dropped pixel fields
+   are copied to it in the same pass, as described in pixel_qa.h.
+******************************************************************************/
+#define DEFINE_TRANSLATE_KERNEL(NAME, CATEGORY, BAND, DESCRIPTION, \
+    FILL, DROPPED, TERRAIN, SATURATION, CLOUD, DILATED, CIRRUS, SHADOW, \
+    SNOW, CLEAR, WATER, CLOUD_CONF, SHADOW_CONF, SNOW_CONF, CIRRUS_CONF) \
+static void translate_level1_qa_##NAME \
+( \
+    uint16_t *l1_qa,       /* I: Level-1 QA values */ \
+    int npixels,           /* I: number of pixels to be translated */ \
+    uint16_t *l2_qa,       /* O: pixel QA values */ \
+    uint8_t *l1_sat        /* O: Level-1 saturation QA values (or NULL) */ \
+) \
+{ \
+    int i;                 /* looping variable */ \
+    uint16_t qa;           /* Level-1 QA value of the current pixel */ \
+    uint16_t pqa;          /* pixel QA value of the current pixel */ \
+    uint8_t conf;          /* confidence of the current pixel */ \
+\
+    for (i = 0; i < npixels; i++) \
+    { \
+        qa = l1_qa[i]; \
+        if (l1_sat != NULL) \
+            l1_sat[i] = (level1_qa_##NAME##_radiometric_saturation (qa) << \
+                L1SAT_RADSAT) | \
+                (level1_qa_##NAME##_is_dropped_pixel (qa) << L1SAT_DROPPED); \
+\
+        if (level1_qa_##NAME##_is_fill (qa)) \
+        { \
+            l2_qa[i] = (1 << L2QA_FILL); \
+            continue; \
+        } \
+\
+        pqa = (1 << L2QA_CLEAR); \
+        if ((CLEAR) != LEVEL1_QA_NO_BIT && !level1_qa_##NAME##_is_clear (qa)) \
+            pqa = 0; \
+        if ((DILATED) != LEVEL1_QA_NO_BIT && \
+            level1_qa_##NAME##_is_dilated_cloud (qa)) \
+            pqa = 0; \
+\
+        if ((SHADOW) != LEVEL1_QA_NO_BIT ? \
+            level1_qa_##NAME##_is_cloud_shadow (qa) : \
+            level1_qa_##NAME##_cloud_shadow_confidence (qa) == \
+            L2QA_HIGH_CONF) \
+            pqa = (pqa & ~(1 << L2QA_CLEAR)) | (1 << L2QA_CLD_SHADOW); \
+        if ((SNOW) != LEVEL1_QA_NO_BIT ? level1_qa_##NAME##_is_snow (qa) : \
+            level1_qa_##NAME##_snow_ice_confidence (qa) == L2QA_HIGH_CONF) \
+            pqa = (pqa & ~(1 << L2QA_CLEAR)) | (1 << L2QA_SNOW); \
+        if (level1_qa_##NAME##_is_cloud (qa)) \
+            pqa = (pqa & ~(1 << L2QA_CLEAR)) | (1 << L2QA_CLOUD); \
+\
+        conf = level1_qa_##NAME##_cloud_confidence (qa); \
+        if (conf == L2QA_HIGH_CONF) \
+            pqa &= ~(1 << L2QA_CLEAR); \
+        pqa |= conf << L2QA_CLOUD_CONF1; \
+\
+        if ((CIRRUS_CONF) != LEVEL1_QA_NO_BIT) \
+            pqa |= level1_qa_##NAME##_cirrus_confidence (qa) << \
+                L2QA_CIRRUS_CONF1; \
+        if ((CIRRUS) != LEVEL1_QA_NO_BIT && level1_qa_##NAME##_is_cirrus (qa)) \
+            pqa |= L2QA_HIGH_CONF << L2QA_CIRRUS_CONF1; \
+        if ((TERRAIN) != LEVEL1_QA_NO_BIT && \
+            level1_qa_##NAME##_is_terrain_occluded (qa)) \
+            pqa |= (1 << L2QA_TERRAIN_OCCL); \
+\
+        if ((WATER) != LEVEL1_QA_NO_BIT && (pqa & (1 << L2QA_CLEAR)) && \
+            level1_qa_##NAME##_is_water (qa)) \
+            pqa = (pqa & ~(1 << L2QA_CLEAR)) | (1 << L2QA_WATER); \
+\
+        l2_qa[i] = pqa; \
+    } \
+}
+
+LEVEL1_QA_LAYOUT_TABLE (DEFINE_TRANSLATE_KERNEL)
+
+
+/******************************************************************************
+MODULE:  get_level1_qa_translator
+
+PURPOSE: Returns the specialized translation kernel for the type of Level-1
+QA data.  The kernel is selected once per scene.
+
+RETURN VALUE:
+Type = Level1_qa_translator_t
+Value           Description
+-----           -----------
+NULL            Unknown type of Level-1 QA data
+not NULL        Translation kernel for the layout
 
-    /* Write the pixel QA band */
-    if (write_pixel_qa (l2_fp_bqa, nlines, nsamps, l2_qa) != SUCCESS)
+NOTES:
+1. The confidence values (low 01, moderate 10, high 11) are copied straight
+   into the two pixel QA confidence bits, which is what translate_level1_qa
+   does one value at a time.
+******************************************************************************/
+#define TRANSLATOR_CASE(NAME, CATEGORY, BAND, DESCRIPTION, \
+    FILL, DROPPED, TERRAIN, SATURATION, CLOUD, DILATED, CIRRUS, SHADOW, \
+    SNOW, CLEAR, WATER, CLOUD_CONF, SHADOW_CONF, SNOW_CONF, CIRRUS_CONF) \
+        case CATEGORY: \
+            return (translate_level1_qa_##NAME);
+
+Level1_qa_translator_t get_level1_qa_translator
+(
+    Espa_level1_qa_type qa_category /* I: type of Level-1 QA data */
+)
+{
+    switch (qa_category)
     {
-        sprintf (errmsg, "Unable to write the entire pixel QA band");
+        LEVEL1_QA_LAYOUT_TABLE (TRANSLATOR_CASE)
+        default:
+            return (NULL);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  set_pixel_qa_water
+
+PURPOSE: Sets the water bit of the pixel QA values from the water flag of the
+LaSRC aerosol or LEDAPS cloud QA values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. As with the cfmask-type water classification, only clear pixels are
+   marked as water, and the clear bit of those pixels is turned off.  Fill,
+   cloud, cloud shadow, and snow pixels are left as they are.
+2. The LEDAPS land/water bit is 1 for land and 0 for water.
+******************************************************************************/
+void set_pixel_qa_water
+(
+    uint8_t *l2_qa_water,  /* I: LaSRC aerosol or LEDAPS cloud QA values */
+    Espa_level2_qa_type water_category, /* I: LASRC_AEROSOL or LEDAPS_CLOUD */
+    int npixels,           /* I: number of pixels */
+    uint16_t *l2_qa        /* I/O: pixel QA values; the water bit is set */
+)
+{
+    int i;                 /* looping variable */
+    int water_bit;         /* bit of the water flag in the Level-2 QA */
+    uint8_t water_value;   /* value of the water flag for water */
+    uint16_t is_water;     /* is the current pixel clear water? */
+
+    if (water_category == LASRC_AEROSOL)
+    {
+        water_bit = LASRC_WATER_BIT;
+        water_value = 1;
+    }
+    else
+    {
+        water_bit = LEDAPS_LAND_WATER_BIT;
+        water_value = 0;
+    }
+
+    /* Clear water pixels have the clear bit on and the water bit off, so
+       toggling both moves them from clear to water */
+    for (i = 0; i < npixels; i++)
+    {
+        is_water = (((l2_qa_water[i] >> water_bit) & ESPA_L2_SINGLE_BIT) ==
+            water_value) & ((l2_qa[i] >> L2QA_CLEAR) & L2QA_SINGLE_BIT);
+        l2_qa[i] ^= (is_water << L2QA_CLEAR) | (is_water << L2QA_WATER);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  open_level2_water
+
+PURPOSE: Opens a strip reader for the Level-2 QA band providing the water
+flag, if the XML file has one.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error opening the band, or it doesn't match the Level-1 QA
+SUCCESS         Successfully opened, or there is no such band (found is
+                false)
+
+NOTES:
+1. The LaSRC aerosol band is used if available, otherwise the LEDAPS cloud
+   band.
+******************************************************************************/
+static int open_level2_water
+(
+    Espa_internal_meta_t *xml_metadata, /* I: parsed XML metadata */
+    int nlines,            /* I: number of lines in the Level-1 QA band */
+    int nsamps,            /* I: number of samples in the Level-1 QA band */
+    bool *found,           /* O: was a water band found and opened? */
+    Level2_qa_strips_t *strips /* O: strip reader of the water band */
+)
+{
+    char FUNC_NAME[] = "open_level2_water";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    int i;                     /* looping variable for the categories */
+    int indx;                  /* index of the band in the metadata */
+    FILE *fp_l2qa = NULL;      /* water band */
+    Espa_band_meta_t *bmeta;   /* metadata of the water band */
+    Espa_level2_qa_type categories[] = {LASRC_AEROSOL, LEDAPS_CLOUD};
+                               /* water bands, in order of preference */
+
+    *found = false;
+    for (i = 0; i < 2; i++)
+    {
+        if (find_level2_qa_band (xml_metadata, categories[i], &indx)
+            != SUCCESS)
+        {  /* Error messages already written */
+            return (ERROR);
+        }
+        if (indx >= 0)
+            break;
+    }
+    if (indx < 0)
+        return (SUCCESS);
+
+    bmeta = &xml_metadata->band[indx];
+    if (bmeta->nlines != nlines || bmeta->nsamps != nsamps)
+    {
+        sprintf (errmsg, "Size of the %.80s band does not match the Level-1 "
+            "quality band", bmeta->name);
         error_handler (true, FUNC_NAME, errmsg);
         return (ERROR);
     }
 
-    /* Close the pixel QA file */
-    close_pixel_qa (l2_fp_bqa);
+    fp_l2qa = open_raw_binary (bmeta->file_name, "r");
+    if (fp_l2qa == NULL)
+    {
+        sprintf (errmsg, "Opening the %.80s band", bmeta->name);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
 
-    /* Free the Level-1 and pixel QA buffers */
-    free (l1_qa);
-    free (l2_qa);
+    if (init_level2_qa_strips (fp_l2qa, categories[i], nlines, nsamps,
+        QA_STREAM_STRIP_LINES, false, strips) != SUCCESS)
+    {
+        sprintf (errmsg, "Setting up the %.80s strip reader", bmeta->name);
+        error_handler (true, FUNC_NAME, errmsg);
+        close_level2_qa (fp_l2qa);
+        return (ERROR);
+    }
+    strips->close_band = true;
+    *found = true;
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  generate_pixel_qa
+
+PURPOSE: Generates the pixel QA band, using input from the input Level-1
+quality band, and adds the band to the XML file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error generating the pixel QA
+SUCCESS         Successfully generated
+
+NOTES:
+1. This QA band will be an unsigned 16-bit integer containing some of the
+   pixel-level QA information from the Level-1 QA band.  The bits represented
+   are identified in the pixel_qa.h include file.
+2. Refer to http://landsat.usgs.gov/collectionqualityband.php for the Level-1
+   QA band information.
+******************************************************************************/
+int generate_pixel_qa
+(
+    char *espa_xml_file    /* I: input ESPA XML filename */
+)
+{
+    Pixel_qa_options_t options;  /* default generation options */
+
+    init_pixel_qa_options (&options);
+    return (generate_pixel_qa_with_options (espa_xml_file, &options));
+}
+
+
+/******************************************************************************
+MODULE:  init_pixel_qa_options
+
+PURPOSE: Sets the pixel QA generation options to the defaults, which produce
+only the raw binary pixel QA band from the raw binary Level-1 QA band.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void init_pixel_qa_options
+(
+    Pixel_qa_options_t *options /* O: generation options set to the defaults */
+)
+{
+    memset (options, 0, sizeof (Pixel_qa_options_t));
+    options->l1_stream = NULL;
+    options->l2_stream = NULL;
+    options->write_geotiff = false;
+    options->geotiff_overviews = 0;
+    options->write_bitplanes = false;
+    options->write_saturation = false;
+}
+
+
+/******************************************************************************
+MODULE:  append_level1_sat_band
+
+PURPOSE: Writes the ENVI header of the Level-1 saturation QA band and adds
+the band to the XML file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the header or updating the XML file
+SUCCESS         Successfully written
+
+NOTES:
+1. The bits are described in pixel_qa.h.  The fields the layout doesn't have
+   are described as unused.
+******************************************************************************/
+static int append_level1_sat_band
+(
+    char *espa_xml_file,   /* I: input ESPA XML filename */
+    Espa_global_meta_t *gmeta, /* I: global metadata from the XML file */
+    Espa_band_meta_t *bmeta, /* I: metadata of the representative band */
+    const Level1_qa_layout_t *layout, /* I: layout of the Level-1 QA */
+    char *sat_file,        /* I: Level-1 saturation QA filename */
+    char *production_date  /* I: production date of the pixel QA band */
+)
+{
+    char FUNC_NAME[] = "append_level1_sat_band";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    char envi_file[STR_SIZE];  /* name of the output ENVI header file */
+    char *cptr = NULL;         /* character pointer for the '.' */
+    int i;                     /* looping variable */
+    Espa_internal_meta_t sat_metadata; /* metadata of the saturation band */
+    Espa_band_meta_t *sat_bmeta; /* band metadata of the saturation band */
+    Envi_header_t envi_hdr;    /* output ENVI header information */
+
+    init_metadata_struct (&sat_metadata);
+    if (allocate_band_metadata (&sat_metadata, 1) != SUCCESS)
+    {
+        sprintf (errmsg, "Allocating band metadata for the Level-1 "
+            "saturation QA.");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    sat_bmeta = &sat_metadata.band[0];
+
+    /* Set up the band metadata like the pixel QA band */
+    strcpy (sat_bmeta->product, "level2_qa");
+    strcpy (sat_bmeta->source, "level1");
+    strcpy (sat_bmeta->name, "level1_sat_qa");
+    strcpy (sat_bmeta->category, "qa");
+    sat_bmeta->data_type = ESPA_UINT8;
+    sat_bmeta->nlines = bmeta->nlines;
+    sat_bmeta->nsamps = bmeta->nsamps;
+    sprintf (sat_bmeta->short_name, "%.4sL1SAT", bmeta->short_name);
+    strcpy (sat_bmeta->long_name,
+        "level-1 radiometric saturation and dropped pixel band");
+    sat_bmeta->pixel_size[0] = bmeta->pixel_size[0];
+    sat_bmeta->pixel_size[1] = bmeta->pixel_size[1];
+    strcpy (sat_bmeta->pixel_units, bmeta->pixel_units);
+    strcpy (sat_bmeta->data_units, "quality/feature classification");
+    sprintf (sat_bmeta->app_version, "generate_pixel_qa_%s",
+        L2QA_COMMON_VERSION);
+    strcpy (sat_bmeta->file_name, sat_file);
+    strcpy (sat_bmeta->production_date, production_date);
+
+    if (allocate_bitmap_metadata (sat_bmeta, 8) != SUCCESS)
+    {
+        sprintf (errmsg, "Cannot allocate memory for the Level-1 saturation "
+            "QA bitmap");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&sat_metadata);
+        return (ERROR);
+    }
+    for (i = 0; i < 8; i++)
+        strcpy (sat_bmeta->bitmap_description[i], "unused");
+    if (layout->radiometric_saturation_bit != LEVEL1_QA_NO_BIT)
+    {
+        strcpy (sat_bmeta->bitmap_description[L1SAT_RADSAT],
+            "radiometric saturation");
+        strcpy (sat_bmeta->bitmap_description[L1SAT_RADSAT+1],
+            "radiometric saturation");
+    }
+    if (layout->dropped_pixel_bit != LEVEL1_QA_NO_BIT)
+        strcpy (sat_bmeta->bitmap_description[L1SAT_DROPPED],
+            "dropped pixel");
+
+    /* Create and write the ENVI header */
+    if (create_envi_struct (sat_bmeta, gmeta, &envi_hdr) != SUCCESS)
+    {
+        sprintf (errmsg, "Creating ENVI header structure.");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&sat_metadata);
+        return (ERROR);
+    }
+    strcpy (envi_file, sat_bmeta->file_name);
+    cptr = strrchr (envi_file, '.');
+    strcpy (cptr, ".hdr");
+    if (write_envi_hdr (envi_file, &envi_hdr) != SUCCESS)
+    {
+        sprintf (errmsg, "Writing ENVI header file.");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&sat_metadata);
+        return (ERROR);
+    }
+
+    /* Add the band to the XML file */
+    if (append_metadata (1, sat_bmeta, espa_xml_file) != SUCCESS)
+    {
+        sprintf (errmsg, "Appending Level-1 saturation QA band to XML file.");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&sat_metadata);
+        return (ERROR);
+    }
+
+    free_metadata (&sat_metadata);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  generate_pixel_qa_with_options
+
+PURPOSE: Generates the pixel QA band, as done by generate_pixel_qa, with the
+option of reading the Level-1 QA band from a QA stream and/or writing the
+pixel QA band to a QA stream instead of the raw binary files, and of also
+writing the pixel QA band as a tiled GeoTIFF and/or as packed bitplanes.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error generating the pixel QA
+SUCCESS         Successfully generated
+
+NOTES:
+1. If l1_stream is NULL, the Level-1 QA band identified in the XML file is
+   read.  Otherwise the Level-1 QA is read from the stream, which must be a
+   UINT16 stream the same size as band 1 in the XML file.
+2. If l2_stream is NULL, the pixel QA band is written to the _pixel_qa.img
+   file.  Otherwise the pixel QA is written to the stream and no image file
+   is created.  The ENVI header and the XML band entry are still written, as
+   the downstream application which consumes the stream is expected to
+   write the _pixel_qa.img file.
+3. The band is processed QA_STREAM_STRIP_LINES lines at a time, so only one
+   strip of the Level-1 QA band is held in memory.
+4. The QA stream format is described in pixel_qa_stream.h.
+5. If write_geotiff is set, the pixel QA band is also written to the
+   _pixel_qa.tif GeoTIFF as each strip is generated, with the requested
+   number of internal overviews.  The GeoTIFF is not added to the XML file.
+6. If write_bitplanes is set, each defined pixel QA bit is also written to
+   its own packed 1-bit plane of the _pixel_qa_bitplanes.img file, as
+   described in pixel_qa_bitplanes.h.  It is not added to the XML file.
+7. If the XML file has the LaSRC sr_aerosol or LEDAPS sr_cloud_qa band, it
+   is read strip by strip along with the Level-1 QA and the water bit is set
+   in the same pass (see set_pixel_qa_water).  Otherwise the water bit is
+   left for a downstream application.
+8. If write_saturation is set, the Level-1 radiometric saturation and
+   dropped pixel fields are also written, in the same pass, to the 8-bit
+   _level1_sat_qa.img band described in pixel_qa.h.  It is added to the XML
+   file after the pixel QA band.  Only the Collection 1 layouts have these
+   fields.
+9. Each phase (XML validation and parsing, reading, translation, water,
+   writing, and the ENVI/XML append) is timed for l2qa_timing_report when
+   timing is on.  The pixel QA band is generated directly into its file
+   mapping, so its write is timed when the mapping is flushed and closed.
+******************************************************************************/
+int generate_pixel_qa_with_options
+(
+    char *espa_xml_file,   /* I: input ESPA XML filename */
+    Pixel_qa_options_t *options /* I: generation options */
+)
+{
+    char FUNC_NAME[] = "generate_pixel_qa_with_options";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    char l1_qa_file[STR_SIZE]; /* input Level-1 QA filename */
+    char l2_qa_file[STR_SIZE]; /* output pixel QA filename */
+    char geotiff_file[STR_SIZE]; /* output pixel QA GeoTIFF filename */
+    char bitplane_file[STR_SIZE]; /* output pixel QA bitplane filename */
+    char sat_file[STR_SIZE];   /* output Level-1 saturation QA filename */
+    char tmpstr[STR_SIZE];     /* tempoary string for filenames */
+    char envi_file[STR_SIZE];  /* name of the output ENVI header file */
+    char production_date[MAX_DATE_LEN+1]; /* current date/time for production */
+    char *cptr = NULL;         /* character pointer for the '.' in XML name
+                                  and image name */
+    int i;                     /* looping variable */
+    int nlines;                /* number of lines in the QA band */
+    int nsamps;                /* number of samples in the QA band */
+    int line;                  /* first line of the current strip */
+    int strip_lines;           /* number of lines in the current strip */
+    int water_lines;           /* number of lines read from the water band */
+    int refl_indx = -99;       /* index of band1 or first band */
+    bool have_water = false;   /* is there a Level-2 QA band with water? */
+    uint8_t *water_qa = NULL;  /* water band values for the current strip */
+    uint8_t *sat_strip = NULL; /* Level-1 saturation QA values for the
+                                  current strip */
+    FILE *fp_sat = NULL;       /* Level-1 saturation QA band */
+    const Level1_qa_layout_t *layout = NULL; /* layout of the Level-1 QA */
+    uint16_t *l2_qa = NULL;    /* pixel QA band values for the current strip
+                                  (file mapping or stream buffer) */
+    uint16_t *l2_strip = NULL; /* pixel QA strip buffer for the stream */
+    uint16_t *l1_qa = NULL;    /* Level-1 QA band values for the current
+                                  strip */
+    FILE *l1_fp_bqa = NULL;    /* file pointer for the Level-1 QA band */
+    FILE *l1_stream = options->l1_stream; /* Level-1 QA input stream */
+    FILE *l2_stream = options->l2_stream; /* pixel QA output stream */
+    Pixel_qa_map_t l2_qa_map;  /* mapping of the pixel QA band */
+    Pixel_qa_geotiff_t geotiff; /* pixel QA GeoTIFF being written */
+    Pixel_qa_bitplanes_t bitplanes; /* pixel QA bitplanes being written */
+    Level2_qa_strips_t water_strips; /* strip reader of the water band */
+    Qa_stream_header_t stream_hdr; /* header for the input/output stream */
+    time_t tp;                 /* time structure */
+    struct tm *tm = NULL;      /* time structure for UTC time */
+    Espa_level1_qa_type qa_category;    /* type of Level-1 QA data (L4-7, L8,
+                                           C2) */
+    Level1_qa_translator_t translate = NULL; /* translation kernel for the
+                                           layout of the Level-1 QA */
+    Espa_internal_meta_t l2qa_metadata; /* metadata container to hold the band
+                                  metadata for the L2 QA band; global metadata
+                                  won't be valid */
+    Espa_internal_meta_t xml_metadata;  /* XML metadata structure to be
+                                  populated by reading the XML metadata file */
+    Espa_band_meta_t *l2qa_bmeta; /* pointer to the array of bands in the
+                                     pixel QA metadata */
+    Espa_band_meta_t *bmeta;    /* pointer to the array of bands metadata */
+    Envi_header_t envi_hdr;     /* output ENVI header information */
+    L2qa_timer_t timer;         /* start time of the timed phase */
+    long long npixels;          /* number of pixels in the current strip */
+    long long write_bytes;      /* bytes written for the current strip */
+
+    if (l1_stream == NULL)
+    {
+        /* Open the Level-1 QA file */
+        l1_fp_bqa = open_level1_qa (espa_xml_file, l1_qa_file, &nlines,
+            &nsamps, &qa_category);
+        if (l1_fp_bqa == NULL)
+        {
+            sprintf (errmsg, "Unable to open the Level-1 QA file");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+    else
+    {
+        /* Validate the input metadata file, since the Level-1 QA band isn't
+           being opened via the XML */
+        l2qa_timer_start (&timer);
+        if (validate_xml_file (espa_xml_file) != SUCCESS)
+        {  /* Error messages already written */
+            return (ERROR);
+        }
+        l2qa_timer_stop (&timer, L2QA_PHASE_VALIDATE_XML,
+            l2qa_timing_file_size (espa_xml_file), 0);
+
+        /* Read the header of the Level-1 QA stream */
+        if (read_qa_stream_header (l1_stream, &stream_hdr) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to read the Level-1 QA stream");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (stream_hdr.data_type != ESPA_UINT16)
+        {
+            sprintf (errmsg, "Expecting UINT16 data type for the Level-1 QA "
+                "stream, however the data type was something other than "
+                "UINT16.");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        nlines = stream_hdr.nlines;
+        nsamps = stream_hdr.nsamps;
+    }
 
     /* Initialize the metadata structure */
     init_metadata_struct (&xml_metadata);
@@ -232,10 +727,47 @@ int generate_pixel_qa
     /* Parse the metadata file into our internal metadata structure; also
        allocates space as needed for various pointers in the global and band
        metadata */
+    l2qa_timer_start (&timer);
     if (parse_metadata (espa_xml_file, &xml_metadata) != SUCCESS)
     {  /* Error messages already written */
         return (ERROR);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_PARSE_METADATA,
+        l2qa_timing_file_size (espa_xml_file), 0);
+
+    /* Determine the instrument type for the stream, since the Level-1 QA
+       band wasn't opened via the XML */
+    if (l1_stream != NULL)
+    {
+        qa_category = get_level1_qa_category (&xml_metadata.global);
+        for (i = 0; i < xml_metadata.nbands; i++)
+        {
+            if (!strcmp (xml_metadata.band[i].name, "qa_pixel"))
+                qa_category = LEVEL1_C2;
+        }
+    }
+
+    /* Select the translation kernel for the layout once for the scene */
+    translate = get_level1_qa_translator (qa_category);
+    if (translate == NULL)
+    {
+        sprintf (errmsg, "Unsupported type of Level-1 QA data: %d",
+            qa_category);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* The saturation band needs at least one of its fields in the layout */
+    layout = get_level1_qa_layout (qa_category);
+    if (options->write_saturation && (layout == NULL ||
+        (layout->radiometric_saturation_bit == LEVEL1_QA_NO_BIT &&
+         layout->dropped_pixel_bit == LEVEL1_QA_NO_BIT)))
+    {
+        sprintf (errmsg, "The Level-1 QA band has no radiometric saturation "
+            "or dropped pixel fields for the saturation QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
 
     /* Use band 1 as the representative band in the XML */
     for (i = 0; i < xml_metadata.nbands; i++)
@@ -270,6 +802,315 @@ int generate_pixel_qa
         return (ERROR);
     }
 
+    /* Open the Level-2 QA band with the water flag, if there is one */
+    if (open_level2_water (&xml_metadata, nlines, nsamps, &have_water,
+        &water_strips) != SUCCESS)
+    {
+        sprintf (errmsg, "Unable to open the Level-2 QA band for water");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Allocate memory for a strip of the Level-1 QA band */
+    l1_qa = calloc (QA_STREAM_STRIP_LINES * nsamps, sizeof (uint16_t));
+    if (l1_qa == NULL)
+    {
+        sprintf (errmsg, "Allocating memory for Level-1 QA data");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Determine the name of the pixel QA file */
+    strcpy (l2_qa_file, espa_xml_file);
+    cptr = strrchr (l2_qa_file, '.');
+    if (!cptr)
+    {
+        sprintf (errmsg, "Unable to find the file extension in the XML file. "
+            "Error creating the pixel QA filename.");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    sprintf (cptr, "_pixel_qa.img");
+
+    if (l2_stream == NULL)
+    {
+        /* Create the pixel QA file and map it for writing.  The pixel QA
+           values are generated directly into the file mapping. */
+        if (create_mapped_pixel_qa (l2_qa_file, nlines, nsamps, &l2_qa_map)
+            != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to create the pixel QA file");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+    else
+    {
+        /* Write the header of the pixel QA stream */
+        stream_hdr.nlines = nlines;
+        stream_hdr.nsamps = nsamps;
+        stream_hdr.data_type = ESPA_UINT16;
+        stream_hdr.strip_lines = QA_STREAM_STRIP_LINES;
+        if (write_qa_stream_header (l2_stream, &stream_hdr) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to write the pixel QA stream");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        /* Allocate memory for a strip of the pixel QA band */
+        l2_strip = calloc (QA_STREAM_STRIP_LINES * nsamps, sizeof (uint16_t));
+        if (l2_strip == NULL)
+        {
+            sprintf (errmsg, "Allocating memory for pixel QA data");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    if (options->write_geotiff)
+    {
+        /* Create the pixel QA GeoTIFF alongside the pixel QA band */
+        strcpy (geotiff_file, l2_qa_file);
+        cptr = strrchr (geotiff_file, '.');
+        strcpy (cptr, ".tif");
+        if (create_pixel_qa_geotiff (geotiff_file, nlines, nsamps,
+            options->geotiff_overviews, &xml_metadata.global,
+            bmeta->pixel_size, &geotiff) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to create the pixel QA GeoTIFF");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    if (options->write_bitplanes)
+    {
+        /* Create the pixel QA bitplanes alongside the pixel QA band */
+        if (make_pixel_qa_bitplane_filename (l2_qa_file, bitplane_file)
+            != SUCCESS ||
+            create_pixel_qa_bitplanes (bitplane_file, nlines, nsamps,
+            &bitplanes) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to create the pixel QA bitplanes");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    if (options->write_saturation)
+    {
+        /* Create the Level-1 saturation QA band alongside the pixel QA
+           band */
+        strcpy (sat_file, l2_qa_file);
+        cptr = strstr (sat_file, "_pixel_qa.img");
+        strcpy (cptr, "_level1_sat_qa.img");
+        fp_sat = open_raw_binary (sat_file, "w");
+        sat_strip = calloc (QA_STREAM_STRIP_LINES * nsamps, sizeof (uint8_t));
+        if (fp_sat == NULL || sat_strip == NULL)
+        {
+            sprintf (errmsg, "Unable to create the Level-1 saturation QA "
+                "band");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    /* Loop through the strips of the Level-1 QA band and create the pixel QA
+       band */
+    for (line = 0; line < nlines; line += QA_STREAM_STRIP_LINES)
+    {
+        strip_lines = nlines - line;
+        if (strip_lines > QA_STREAM_STRIP_LINES)
+            strip_lines = QA_STREAM_STRIP_LINES;
+
+        /* Read the current strip of the Level-1 QA band */
+        if (l1_stream == NULL)
+        {
+            if (read_level1_qa (l1_fp_bqa, strip_lines, nsamps, l1_qa)
+                != SUCCESS)
+            {
+                sprintf (errmsg, "Unable to read the entire Level-1 QA band");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+        }
+        else
+        {
+            l2qa_timer_start (&timer);
+            if (read_raw_binary (l1_stream, strip_lines, nsamps,
+                sizeof (uint16_t), l1_qa) != SUCCESS)
+            {
+                sprintf (errmsg, "Unable to read the entire Level-1 QA "
+                    "stream");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            l2qa_timer_stop (&timer, L2QA_PHASE_READ,
+                (long long) strip_lines * nsamps * sizeof (uint16_t),
+                (long long) strip_lines * nsamps);
+        }
+
+        /* Translate the strip into the file mapping or the stream buffer */
+        npixels = (long long) strip_lines * nsamps;
+        if (l2_stream == NULL)
+            l2_qa = &l2_qa_map.pixel_qa[(size_t) line * nsamps];
+        else
+            l2_qa = l2_strip;
+        l2qa_timer_start (&timer);
+        translate (l1_qa, strip_lines * nsamps, l2_qa, sat_strip);
+        l2qa_timer_stop (&timer, L2QA_PHASE_TRANSLATE, npixels *
+            (2 * sizeof (uint16_t) + (sat_strip ? sizeof (uint8_t) : 0)),
+            npixels);
+
+        /* Set the water bit from the same strip of the water band.  The
+           strip read is timed as a read by read_level2_qa, so only setting
+           the bit is timed as water. */
+        if (have_water)
+        {
+            if (next_level2_qa_strip_uint8 (&water_strips, &water_qa,
+                &water_lines) != SUCCESS || water_lines != strip_lines)
+            {
+                sprintf (errmsg, "Unable to read the entire Level-2 QA band "
+                    "for water");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            l2qa_timer_start (&timer);
+            set_pixel_qa_water (water_qa, water_strips.qa_category,
+                strip_lines * nsamps, l2_qa);
+            l2qa_timer_stop (&timer, L2QA_PHASE_WATER,
+                npixels * (sizeof (uint8_t) + sizeof (uint16_t)), npixels);
+        }
+
+        /* Write the current strip of the pixel QA stream */
+        l2qa_timer_start (&timer);
+        write_bytes = 0;
+        if (l2_stream != NULL)
+        {
+            if (write_raw_binary (l2_stream, strip_lines, nsamps,
+                sizeof (uint16_t), l2_qa) != SUCCESS)
+            {
+                sprintf (errmsg, "Unable to write the entire pixel QA stream");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            write_bytes += npixels * sizeof (uint16_t);
+        }
+
+        /* Write the current strip of the pixel QA GeoTIFF */
+        if (options->write_geotiff)
+        {
+            if (write_pixel_qa_geotiff (&geotiff, strip_lines, l2_qa)
+                != SUCCESS)
+            {
+                sprintf (errmsg, "Unable to write the pixel QA GeoTIFF");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            write_bytes += npixels * sizeof (uint16_t);
+        }
+
+        /* Write the current strip of the pixel QA bitplanes */
+        if (options->write_bitplanes)
+        {
+            if (write_pixel_qa_bitplanes (&bitplanes, strip_lines, l2_qa)
+                != SUCCESS)
+            {
+                sprintf (errmsg, "Unable to write the pixel QA bitplanes");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            write_bytes += npixels * sizeof (uint16_t);
+        }
+
+        /* Write the current strip of the Level-1 saturation QA band */
+        if (options->write_saturation)
+        {
+            if (write_raw_binary (fp_sat, strip_lines, nsamps,
+                sizeof (uint8_t), sat_strip) != SUCCESS)
+            {
+                sprintf (errmsg, "Unable to write the entire Level-1 "
+                    "saturation QA band");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            write_bytes += npixels * sizeof (uint8_t);
+        }
+        l2qa_timer_stop (&timer, L2QA_PHASE_WRITE, write_bytes,
+            (l2_stream != NULL) ? npixels : 0);
+    }
+    l2_qa = NULL;
+
+    /* Close the Level-1 QA file and the water band */
+    if (l1_stream == NULL)
+        close_level1_qa (l1_fp_bqa);
+    if (have_water)
+        close_level2_qa_strips (&water_strips);
+
+    /* Close the Level-1 saturation QA band */
+    if (options->write_saturation)
+    {
+        close_raw_binary (fp_sat);
+        free (sat_strip);
+    }
+
+    /* Write the overviews and directories and close the GeoTIFF */
+    l2qa_timer_start (&timer);
+    if (options->write_geotiff)
+    {
+        if (close_pixel_qa_geotiff (&geotiff) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to write the pixel QA GeoTIFF");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    /* Close the pixel QA bitplanes */
+    if (options->write_bitplanes)
+    {
+        if (close_pixel_qa_bitplanes (&bitplanes) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to write the pixel QA bitplanes");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+
+    if (l2_stream == NULL)
+    {
+        /* Unmap and close the pixel QA file */
+        if (close_mapped_pixel_qa (&l2_qa_map) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to write the entire pixel QA band");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        l2qa_timer_stop (&timer, L2QA_PHASE_WRITE,
+            (long long) nlines * nsamps * sizeof (uint16_t),
+            (long long) nlines * nsamps);
+    }
+    else
+    {
+        /* Push the last strip to the downstream reader */
+        if (fflush (l2_stream) != 0)
+        {
+            sprintf (errmsg, "Unable to write the entire pixel QA stream");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        free (l2_strip);
+
+        /* The stream strips were counted as they were written, so only the
+           GeoTIFF and bitplane closes are left to be counted */
+        if (options->write_geotiff || options->write_bitplanes)
+            l2qa_timer_stop (&timer, L2QA_PHASE_WRITE, 0, 0);
+    }
+
+    /* Free the Level-1 QA buffer */
+    free (l1_qa);
+
     /* Initialize the internal metadata for the output product. The global
        metadata won't be updated, however the band metadata will be updated
        and used for appending to the original XML file. */
@@ -331,13 +1172,15 @@ int generate_pixel_qa
     strcpy (l2qa_bmeta->bitmap_description[15], "unused");
 
     /* If processing L8, then we need to support the cirrus confidence and
-       terrain occlusion */
-    if (qa_category == LEVEL1_L8)
+       terrain occlusion.  Collection 2 has cirrus confidence but no terrain
+       occlusion. */
+    if (qa_category == LEVEL1_L8 || qa_category == LEVEL1_C2)
     {
         strcpy (l2qa_bmeta->bitmap_description[8], "cirrus confidence");
         strcpy (l2qa_bmeta->bitmap_description[9], "cirrus confidence");
-        strcpy (l2qa_bmeta->bitmap_description[10], "terrain occlusion");
     }
+    if (qa_category == LEVEL1_L8)
+        strcpy (l2qa_bmeta->bitmap_description[10], "terrain occlusion");
 
     /* Get the current date/time (UTC) for the production date of each band */
     if (time (&tp) == -1)
@@ -364,6 +1207,7 @@ int generate_pixel_qa
     strcpy (l2qa_bmeta->production_date, production_date);
 
     /* Create the ENVI header file this band */
+    l2qa_timer_start (&timer);
     if (create_envi_struct (l2qa_bmeta, &xml_metadata.global, &envi_hdr) !=
         SUCCESS)
     {
@@ -391,6 +1235,21 @@ int generate_pixel_qa
         return (ERROR);
     }
 
+    /* Add the Level-1 saturation QA band to the XML file */
+    if (options->write_saturation)
+    {
+        if (append_level1_sat_band (espa_xml_file, &xml_metadata.global,
+            bmeta, layout, sat_file, production_date) != SUCCESS)
+        {
+            sprintf (errmsg, "Appending Level-1 saturation QA band to XML "
+                "file.");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+    l2qa_timer_stop (&timer, L2QA_PHASE_APPEND_METADATA,
+        l2qa_timing_file_size (espa_xml_file), 0);
+
     /* Free the input and output XML metadata */
     free_metadata (&xml_metadata);
     free_metadata (&l2qa_metadata);
@@ -20,8 +20,14 @@ NOTES:
 #include <stdint.h>
 #include <string.h>
 #include "read_level1_qa.h"
+#include "level1_qa_layout.h"
+#include "read_level2_qa.h"
+#include "level2_qa_strips.h"
 #include "read_pixel_qa.h"
 #include "write_pixel_qa.h"
+#include "pixel_qa_stream.h"
+#include "write_pixel_qa_geotiff.h"
+#include "pixel_qa_bitplanes.h"
 #include "l2qa_common.h"
 #include "write_metadata.h"
 #include "envi_header.h"
@@ -29,10 +35,68 @@ NOTES:
 /* Defines */
 #define MAX_DATE_LEN 28
 
+/* Data types */
+typedef void (*Level1_qa_translator_t)
+(
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    int npixels,           /* I: number of pixels to be translated */
+    uint16_t *l2_qa,       /* O: pixel QA values */
+    uint8_t *l1_sat        /* O: Level-1 saturation QA values (NULL if not
+                                 wanted) */
+);
+
+typedef struct
+{
+    FILE *l1_stream;       /* Level-1 QA stream open for reading; NULL to read
+                              the Level-1 QA band from the XML */
+    FILE *l2_stream;       /* pixel QA stream open for writing; NULL to write
+                              the pixel QA band to the image file */
+    bool write_geotiff;    /* also write the pixel QA band as a tiled
+                              GeoTIFF? */
+    int geotiff_overviews; /* number of internal overview levels in the
+                              GeoTIFF */
+    bool write_bitplanes;  /* also write the pixel QA bits as packed 1-bit
+                              planes? */
+    bool write_saturation; /* also write the Level-1 radiometric saturation
+                              and dropped pixels as a band? */
+} Pixel_qa_options_t;
+
 /* Function prototypes */
+void translate_level1_qa
+(
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    int npixels,           /* I: number of pixels to be translated */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data (L4-7, L8) */
+    uint16_t *l2_qa        /* O: pixel QA values */
+);
+
 int generate_pixel_qa
 (
     char *espa_xml_file    /* I: input ESPA XML filename */
 );
 
+Level1_qa_translator_t get_level1_qa_translator
+(
+    Espa_level1_qa_type qa_category /* I: type of Level-1 QA data */
+);
+
+void set_pixel_qa_water
+(
+    uint8_t *l2_qa_water,  /* I: LaSRC aerosol or LEDAPS cloud QA values */
+    Espa_level2_qa_type water_category, /* I: LASRC_AEROSOL or LEDAPS_CLOUD */
+    int npixels,           /* I: number of pixels */
+    uint16_t *l2_qa        /* I/O: pixel QA values; the water bit is set */
+);
+
+void init_pixel_qa_options
+(
+    Pixel_qa_options_t *options /* O: generation options set to the defaults */
+);
+
+int generate_pixel_qa_with_options
+(
+    char *espa_xml_file,   /* I: input ESPA XML filename */
+    Pixel_qa_options_t *options /* I: generation options */
+);
+
 #endif
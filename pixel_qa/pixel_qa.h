@@ -17,7 +17,8 @@ LICENSE TYPE:  NASA Open Source Agreement Version 1.3
    ----------------------------------------
 0: fill (pulled from level-1 QA)
 1: clear (pulled from level-1 QA)
-2: water (generated at level-2, using cfmask-type application)
+2: water (from the LaSRC aerosol or LEDAPS cloud QA in generate_pixel_qa if
+   available, otherwise generated at level-2, using cfmask-type application)
 3: cloud shadow (pulled from level-1 QA)
 4: snow (pulled from level-1 QA)
 5: cloud (pulled from level-1 QA and dilated at level-2, using cfmask-type
@@ -49,4 +50,15 @@ LICENSE TYPE:  NASA Open Source Agreement Version 1.3
 #define L2QA_MODERATE_CONF 2      /* moderate confidence (10) */
 #define L2QA_HIGH_CONF 3          /* high confidence (11) */
 
+/* Defines for the bits in the Level-1 saturation QA band, optionally written
+   alongside the pixel QA band by generate_pixel_qa
+   ----------------------------------------
+0-1: radiometric saturation (pulled from level-1 QA, Collection 1 only)
+2: dropped pixel (pulled from level-1 QA, Collection 1 L4-7 only)
+3-7: reserved for later use
+*/
+
+#define L1SAT_RADSAT 0            /* two bits */
+#define L1SAT_DROPPED 2
+
 #endif /* PIXEL_QA_H */
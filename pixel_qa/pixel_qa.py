@@ -1,6 +1,22 @@
 #! /usr/bin/env python
 import sys
 import os
+import re
+import multiprocessing
+import xml.etree.ElementTree as ElementTree
+
+# NumPy is only needed for the array methods
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+# The _pixel_qa extension module (make python) is only needed for the native
+# functions at the end of this file
+try:
+    import _pixel_qa
+except ImportError:
+    _pixel_qa = None
 
 # Define the Pixel QA bit values
 PQA_FILL = 0                      # 1
@@ -156,4 +172,503 @@ class PixelQA():
         else:
             return False
 
+
+    # The array methods below are the counterparts of the scalar methods
+    # above.  They take a NumPy array of Level-2 pixel QA values (any shape)
+    # and return an array of the same shape, working on the whole array with
+    # vectorized shifts and masks rather than a Python call per pixel.
+
+    '''Returns the pixel QA values as a uint16 NumPy array, without copying
+       them if they already are one.
+    '''
+    @staticmethod
+    def _pixel_qa_array(l2_qa):
+        if numpy is None:
+            raise ImportError('NumPy is required for the PixelQA array '
+                              'methods')
+        return numpy.asarray(l2_qa, dtype=numpy.uint16)
+
+
+    '''Determines which of the Level-2 pixel QA values have the specified
+       single bit set.
+
+    Returns:
+        Boolean array, True where the bit is set
+    '''
+    @staticmethod
+    def pixel_qa_single_bit_array(l2_qa, bit):
+        l2_qa = PixelQA._pixel_qa_array(l2_qa)
+        return (l2_qa & numpy.uint16(PQA_SINGLE_BIT << bit)) != 0
+
+
+    '''Returns the two-bit field starting at the specified bit of each of the
+       Level-2 pixel QA values.
+
+    Returns:
+        uint8 array of values 0-3
+    '''
+    @staticmethod
+    def pixel_qa_double_bit_array(l2_qa, bit):
+        l2_qa = PixelQA._pixel_qa_array(l2_qa)
+        return ((l2_qa >> numpy.uint16(bit)) &
+                numpy.uint16(PQA_DOUBLE_BIT)).astype(numpy.uint8)
+
+
+    '''Determines which of the Level-2 pixel QA values are fill
+
+    Returns:
+        Boolean array, True where the pixel is fill
+    '''
+    @staticmethod
+    def pixel_qa_is_fill_array(l2_qa):
+        return PixelQA.pixel_qa_single_bit_array(l2_qa, PQA_FILL)
+
+
+    '''Determines which of the Level-2 pixel QA values are clear
+
+    Returns:
+        Boolean array, True where the pixel is clear
+    '''
+    @staticmethod
+    def pixel_qa_is_clear_array(l2_qa):
+        return PixelQA.pixel_qa_single_bit_array(l2_qa, PQA_CLEAR)
+
+
+    '''Determines which of the Level-2 pixel QA values are water
+
+    Returns:
+        Boolean array, True where the pixel is water
+    '''
+    @staticmethod
+    def pixel_qa_is_water_array(l2_qa):
+        return PixelQA.pixel_qa_single_bit_array(l2_qa, PQA_WATER)
+
+
+    '''Determines which of the Level-2 pixel QA values are cloud shadow
+
+    Returns:
+        Boolean array, True where the pixel is cloud shadow
+    '''
+    @staticmethod
+    def pixel_qa_is_cloud_shadow_array(l2_qa):
+        return PixelQA.pixel_qa_single_bit_array(l2_qa, PQA_CLD_SHADOW)
+
+
+    '''Determines which of the Level-2 pixel QA values are snow
+
+    Returns:
+        Boolean array, True where the pixel is snow
+    '''
+    @staticmethod
+    def pixel_qa_is_snow_array(l2_qa):
+        return PixelQA.pixel_qa_single_bit_array(l2_qa, PQA_SNOW)
+
+
+    '''Determines which of the Level-2 pixel QA values are cloud
+
+    Returns:
+        Boolean array, True where the pixel is cloud
+    '''
+    @staticmethod
+    def pixel_qa_is_cloud_array(l2_qa):
+        return PixelQA.pixel_qa_single_bit_array(l2_qa, PQA_CLOUD)
+
+
+    '''Returns the cloud confidence value (0-3) of each of the Level-2 pixel
+       QA values.
+
+    Returns:
+        uint8 array of cloud confidence values
+    '''
+    @staticmethod
+    def pixel_qa_cloud_confidence_array(l2_qa):
+        return PixelQA.pixel_qa_double_bit_array(l2_qa, PQA_CLOUD_CONF1)
+
+
+    '''Returns the cirrus confidence value (0-3) of each of the Level-2 pixel
+       QA values. These are valid for L8 only.
+
+    Returns:
+        uint8 array of cirrus confidence values
+    '''
+    @staticmethod
+    def pixel_qa_cirrus_confidence_array(l2_qa):
+        return PixelQA.pixel_qa_double_bit_array(l2_qa, PQA_CIRRUS_CONF1)
+
+
+    '''Determines which of the Level-2 pixel QA values are terrain occluded
+
+    Returns:
+        Boolean array, True where the pixel is terrain occluded
+    '''
+    @staticmethod
+    def pixel_qa_is_terrain_occluded_array(l2_qa):
+        return PixelQA.pixel_qa_single_bit_array(l2_qa, PQA_TERRAIN_OCCL)
+
 # ##### end of PixelQA class #####
+
+
+
+# The functions below call the C libraries in-process through the _pixel_qa
+# extension module, allocating the NumPy arrays it fills in place.  The
+# lower-level _pixel_qa functions take caller-allocated arrays directly.
+
+'''Returns the _pixel_qa extension module, or raises ImportError if it
+   hasn't been built.
+'''
+def _native():
+    if _pixel_qa is None or numpy is None:
+        raise ImportError('The _pixel_qa extension module and NumPy are '
+                          'required for the native functions')
+    return _pixel_qa
+
+
+'''Reads the Level-1 QA band of the scene
+
+Returns:
+    (uint16 array of lines x samples, Level-1 QA category)
+'''
+def read_level1_qa_array(xml_file):
+    (data, nlines, nsamps, qa_category) = _native().read_level1_qa(xml_file)
+    l1_qa = numpy.frombuffer(data, dtype=numpy.uint16)
+    return (l1_qa.reshape(nlines, nsamps), qa_category)
+
+
+'''Reads a LEDAPS or LaSRC Level-2 QA band of the scene
+
+Returns:
+    uint16 (LASRC_RADSAT) or uint8 array of lines x samples
+'''
+def read_level2_qa_array(xml_file, qa_category):
+    (data, nlines, nsamps) = _native().read_level2_qa(xml_file, qa_category)
+    if qa_category == _pixel_qa.LASRC_RADSAT:
+        dtype = numpy.uint16
+    else:
+        dtype = numpy.uint8
+    return numpy.frombuffer(data, dtype=dtype).reshape(nlines, nsamps)
+
+
+'''Translates the Level-1 QA values to pixel QA values
+
+Returns:
+    uint16 array of pixel QA values of the same shape, or a tuple of it and
+    the uint8 Level-1 saturation QA values if saturation is True
+'''
+def translate_level1_qa_array(l1_qa, qa_category, saturation=False):
+    l1_qa = numpy.ascontiguousarray(l1_qa, dtype=numpy.uint16)
+    l2_qa = numpy.empty_like(l1_qa)
+    if saturation:
+        l1_sat = numpy.empty(l1_qa.shape, dtype=numpy.uint8)
+        _native().translate_level1_qa(l1_qa, qa_category, l2_qa, l1_sat)
+        return (l2_qa, l1_sat)
+    _native().translate_level1_qa(l1_qa, qa_category, l2_qa)
+    return l2_qa
+
+
+'''Dilates the specified bit of the 2-D pixel QA values by the specified
+   distance
+
+Returns:
+    uint16 array of the dilated pixel QA values
+'''
+def dilate_pixel_qa_array(l2_qa, bit, distance):
+    l2_qa = numpy.ascontiguousarray(l2_qa, dtype=numpy.uint16)
+    output = numpy.empty_like(l2_qa)
+    _native().dilate_pixel_qa(l2_qa, bit, distance, output)
+    return output
+
+
+
+# Data types of the ESPA raw binary bands, which are little endian
+ESPA_DATA_TYPES = {'INT8': 'i1', 'UINT8': 'u1', 'INT16': '<i2',
+                   'UINT16': '<u2', 'INT32': '<i4', 'UINT32': '<u4',
+                   'FLOAT32': '<f4', 'FLOAT64': '<f8'}
+
+
+'''Finds the specified band in the ESPA XML file
+
+Returns:
+    (image filename, number of lines, number of samples, NumPy dtype)
+
+    The image filename is relative to the directory of the XML file, as the
+    band filenames in the XML are.
+'''
+def find_espa_band(xml_file, band_name, band_category):
+    for element in ElementTree.parse(xml_file).iter():
+        # Ignore the namespace of the schema
+        if element.tag.split('}')[-1] != 'band':
+            continue
+        if (element.get('name') != band_name or
+                element.get('category') != band_category):
+            continue
+
+        file_name = None
+        for child in element:
+            if child.tag.split('}')[-1] == 'file_name':
+                file_name = child.text.strip()
+        if file_name is None:
+            raise ValueError('No file_name for the {} band in {}'
+                             .format(band_name, xml_file))
+        file_name = os.path.join(os.path.dirname(xml_file), file_name)
+        return (file_name, int(element.get('nlines')),
+                int(element.get('nsamps')),
+                ESPA_DATA_TYPES[element.get('data_type')])
+
+    raise ValueError('No {} band in {}'.format(band_name, xml_file))
+
+
+'''Opens the pixel QA band of the ESPA XML file as a memory-mapped array,
+   so only the lines of the windows which are accessed are read.  For
+   example, read_pixel_qa_memmap(xml)[1000:1500, 2000:2500] reads just
+   those 500 lines from the band.
+
+Returns:
+    numpy.memmap of lines x samples uint16 pixel QA values
+'''
+def read_pixel_qa_memmap(xml_file, mode='r'):
+    if numpy is None:
+        raise ImportError('NumPy is required for read_pixel_qa_memmap')
+    (file_name, nlines, nsamps, dtype) = find_espa_band(xml_file, 'pixel_qa',
+                                                        'qa')
+    return numpy.memmap(file_name, dtype=dtype, mode=mode,
+                        shape=(nlines, nsamps))
+
+
+
+# Bits and confidence fields which may be used in the mask expressions, named
+# as in the combine_qa_mask rules
+PQA_MASK_BITS = {'fill': PQA_FILL, 'clear': PQA_CLEAR, 'water': PQA_WATER,
+                 'cloud_shadow': PQA_CLD_SHADOW, 'snow': PQA_SNOW,
+                 'cloud': PQA_CLOUD, 'terrain_occlusion': PQA_TERRAIN_OCCL}
+PQA_MASK_FIELDS = {'cloud_conf': PQA_CLOUD_CONF1,
+                   'cirrus_conf': PQA_CIRRUS_CONF1}
+PQA_MASK_LEVELS = {'none': 0, 'low': PQA_LOW_CONF,
+                   'moderate': PQA_MODERATE_CONF, 'high': PQA_HIGH_CONF,
+                   '0': 0, '1': 1, '2': 2, '3': 3}
+PQA_MASK_TOKENS = re.compile(r'\s*(<=|>=|==|!=|[<>=!&|()]|\w+)')
+
+
+class PixelQAMask():
+    '''Compiles a boolean expression over the pixel QA bits into a lookup
+       table of all 65536 pixel QA values, so the mask of a scene is made
+       with a single take() rather than a pass per term.
+
+       The expression is made of the bit names (fill, clear, water,
+       cloud_shadow, snow, cloud, terrain_occlusion) and comparisons of the
+       confidences (cloud_conf, cirrus_conf) with a level (none, low,
+       moderate, high, or 0-3) using <, <=, = or ==, !=, >=, or >.  These are
+       combined with not (!), and (&), or (|), and parentheses, with the
+       precedence of Python.  For example:
+           clear and not snow or (water and cloud_conf < high)
+    '''
+
+    def __init__(self, expression):
+        if numpy is None:
+            raise ImportError('NumPy is required for PixelQAMask')
+        self.expression = expression
+        self._tokens = self._tokenize(expression)
+        self._pos = 0
+        self._values = numpy.arange(65536, dtype=numpy.uint16)
+        self.lut = self._parse_or()
+        if self._pos != len(self._tokens):
+            raise ValueError('Unexpected {} in pixel QA mask expression {}'
+                             .format(self._tokens[self._pos], expression))
+        del self._tokens, self._values
+
+
+    '''Applies the mask to an array of pixel QA values
+
+    Returns:
+        Boolean array of the same shape, True where the expression is true
+    '''
+    def apply(self, l2_qa):
+        return self.lut.take(PixelQA._pixel_qa_array(l2_qa))
+
+
+    '''Splits the expression into tokens, mapping the symbols to the words
+    '''
+    @staticmethod
+    def _tokenize(expression):
+        words = {'!': 'not', '&': 'and', '|': 'or', '==': '='}
+        tokens = []
+        pos = 0
+        expression = expression.strip()
+        while pos < len(expression):
+            match = PQA_MASK_TOKENS.match(expression, pos)
+            if match is None:
+                raise ValueError('Invalid pixel QA mask expression {}'
+                                 .format(expression))
+            token = match.group(1)
+            tokens.append(words.get(token.lower(), token.lower()))
+            pos = match.end()
+        return tokens
+
+
+    def _next(self):
+        if self._pos >= len(self._tokens):
+            raise ValueError('Incomplete pixel QA mask expression {}'
+                             .format(self.expression))
+        token = self._tokens[self._pos]
+        self._pos += 1
+        return token
+
+
+    def _peek(self):
+        if self._pos < len(self._tokens):
+            return self._tokens[self._pos]
+        return None
+
+
+    def _parse_or(self):
+        lut = self._parse_and()
+        while self._peek() == 'or':
+            self._next()
+            lut = lut | self._parse_and()
+        return lut
+
+
+    def _parse_and(self):
+        lut = self._parse_not()
+        while self._peek() == 'and':
+            self._next()
+            lut = lut & self._parse_not()
+        return lut
+
+
+    def _parse_not(self):
+        if self._peek() == 'not':
+            self._next()
+            return ~self._parse_not()
+        return self._parse_term()
+
+
+    '''Evaluates a parenthesized expression, bit name, or confidence
+       comparison over all the pixel QA values
+    '''
+    def _parse_term(self):
+        token = self._next()
+        if token == '(':
+            lut = self._parse_or()
+            if self._next() != ')':
+                raise ValueError('Missing ) in pixel QA mask expression {}'
+                                 .format(self.expression))
+            return lut
+
+        if token in PQA_MASK_BITS:
+            return PixelQA.pixel_qa_single_bit_array(self._values,
+                                                     PQA_MASK_BITS[token])
+
+        if token in PQA_MASK_FIELDS:
+            conf = PixelQA.pixel_qa_double_bit_array(self._values,
+                                                     PQA_MASK_FIELDS[token])
+            op = self._next()
+            level = self._next()
+            if level not in PQA_MASK_LEVELS:
+                raise ValueError('Invalid confidence level {} in pixel QA '
+                                 'mask expression {}'
+                                 .format(level, self.expression))
+            level = PQA_MASK_LEVELS[level]
+            if op == '<':
+                return conf < level
+            elif op == '<=':
+                return conf <= level
+            elif op == '=':
+                return conf == level
+            elif op == '!=':
+                return conf != level
+            elif op == '>=':
+                return conf >= level
+            elif op == '>':
+                return conf > level
+            raise ValueError('Invalid comparison {} in pixel QA mask '
+                             'expression {}'.format(op, self.expression))
+
+        raise ValueError('Unknown term {} in pixel QA mask expression {}'
+                         .format(token, self.expression))
+
+
+
+# Bits counted by pixel_qa_scene_stats
+PQA_STATS_BITS = {'fill': PQA_FILL, 'clear': PQA_CLEAR, 'water': PQA_WATER,
+                  'cloud_shadow': PQA_CLD_SHADOW, 'snow': PQA_SNOW,
+                  'cloud': PQA_CLOUD, 'terrain_occlusion': PQA_TERRAIN_OCCL}
+
+
+'''Returns the histogram of the pixel QA values of a chunk of lines of the
+   pixel QA image.  This runs in the worker processes of pixel_qa_scene_stats,
+   each of which maps the image itself, so the chunks are shared through the
+   page cache rather than copied between the processes.
+'''
+def _pixel_qa_chunk_histogram(args):
+    (file_name, dtype, nlines, nsamps, first_line, chunk_lines) = args
+    band = numpy.memmap(file_name, dtype=dtype, mode='r',
+                        shape=(nlines, nsamps))
+    chunk = band[first_line:first_line + chunk_lines]
+    hist = numpy.bincount(chunk.ravel(), minlength=65536)
+    del band, chunk
+    return hist
+
+
+'''Computes the statistics of the pixel QA band of the ESPA XML file.  The
+   band is processed in chunks of chunk_lines lines by nprocs processes (all
+   the CPUs by default), so no more than nprocs chunks are in memory at once.
+
+   Each chunk is reduced to a histogram of its pixel QA values, and all the
+   counts are taken from the histogram of the scene, so the band is read once
+   whatever the number of statistics.
+
+Returns:
+    Dictionary of
+        npixels: number of pixels
+        bits: number of pixels with each bit of PQA_STATS_BITS set
+        cloud_conf, cirrus_conf: number of pixels at each confidence level
+                                 (none, low, moderate, high)
+        fractions: fraction of the non-fill pixels which are clear, cloud,
+                   snow, and water
+'''
+def pixel_qa_scene_stats(xml_file, chunk_lines=256, nprocs=None):
+    if numpy is None:
+        raise ImportError('NumPy is required for pixel_qa_scene_stats')
+    (file_name, nlines, nsamps, dtype) = find_espa_band(xml_file, 'pixel_qa',
+                                                        'qa')
+    chunks = [(file_name, dtype, nlines, nsamps, line, chunk_lines)
+              for line in range(0, nlines, chunk_lines)]
+
+    hist = numpy.zeros(65536, dtype=numpy.int64)
+    if nprocs is None:
+        nprocs = os.cpu_count() or 1
+    if nprocs <= 1 or len(chunks) <= 1:
+        for chunk in chunks:
+            hist += _pixel_qa_chunk_histogram(chunk)
+    else:
+        pool = multiprocessing.Pool(min(nprocs, len(chunks)))
+        try:
+            for chunk_hist in pool.imap_unordered(_pixel_qa_chunk_histogram,
+                                                  chunks):
+                hist += chunk_hist
+        finally:
+            pool.close()
+            pool.join()
+
+    values = numpy.arange(65536, dtype=numpy.uint16)
+    stats = {'npixels': int(hist.sum()), 'bits': {}}
+    for (name, bit) in PQA_STATS_BITS.items():
+        is_set = PixelQA.pixel_qa_single_bit_array(values, bit)
+        stats['bits'][name] = int(hist[is_set].sum())
+    for (name, bit) in (('cloud_conf', PQA_CLOUD_CONF1),
+                        ('cirrus_conf', PQA_CIRRUS_CONF1)):
+        conf = PixelQA.pixel_qa_double_bit_array(values, bit)
+        stats[name] = [int(hist[conf == level].sum()) for level in range(4)]
+
+    not_fill = ~PixelQA.pixel_qa_is_fill_array(values)
+    nvalid = stats['npixels'] - stats['bits']['fill']
+    stats['fractions'] = {}
+    for name in ('clear', 'cloud', 'snow', 'water'):
+        is_set = PixelQA.pixel_qa_single_bit_array(values,
+                                                   PQA_STATS_BITS[name])
+        if nvalid > 0:
+            stats['fractions'][name] = (int(hist[is_set & not_fill].sum()) /
+                                        float(nvalid))
+        else:
+            stats['fractions'][name] = 0.0
+    return stats
@@ -0,0 +1,600 @@
+/*****************************************************************************
+FILE: pixel_qa_bitplanes.c
+  
+PURPOSE: Contains functions for storing the Level-2 pixel QA band as separate
+packed 1-bit planes, and for reading back only the planes of interest.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The layout of the bitplane file is described in pixel_qa_bitplanes.h.
+*****************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pixel_qa_bitplanes.h"
+#include "read_pixel_qa.h"
+#include "pixel_qa_stream.h"
+#include "write_pixel_qa.h"
+
+/******************************************************************************
+MODULE:  pixel_qa_bitplane_row_bytes
+
+PURPOSE: Returns the number of bytes in a row of a packed bitplane.
+
+RETURN VALUE:
+Type = size_t
+Value           Description
+-----           -----------
+n               Number of bytes in a row
+
+NOTES:
+******************************************************************************/
+size_t pixel_qa_bitplane_row_bytes
+(
+    int nsamps              /* I: number of samples in the QA band */
+)
+{
+    return (((size_t) nsamps + 7) / 8);
+}
+
+
+/******************************************************************************
+MODULE:  pack_pixel_qa_bitplanes
+
+PURPOSE: Packs each of the defined pixel QA bits into its own 1-bit plane.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Eight pixels are packed at a time, producing one byte of every plane.
+******************************************************************************/
+void pack_pixel_qa_bitplanes
+(
+    uint16_t *pixel_qa,     /* I: pixel QA values */
+    int nlines,             /* I: number of lines of pixel QA values */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint8_t **planes        /* O: packed plane for each pixel QA bit; each
+                                  must hold nlines rows of
+                                  pixel_qa_bitplane_row_bytes bytes */
+)
+{
+    int line;               /* current line */
+    int plane;              /* current plane */
+    int samp;               /* first sample of the current byte */
+    int k;                  /* current sample within the byte */
+    int nbits;              /* number of samples in the current byte */
+    size_t row_bytes = pixel_qa_bitplane_row_bytes (nsamps); /* bytes in a
+                               row of a plane */
+    size_t byte;            /* current byte of the plane */
+    uint16_t *qa = NULL;    /* pixel QA values for the current line */
+    uint8_t bits[PIXEL_QA_NPLANES]; /* current byte of each plane */
+
+    for (line = 0; line < nlines; line++)
+    {
+        qa = &pixel_qa[(size_t) line * nsamps];
+        for (samp = 0; samp < nsamps; samp += 8)
+        {
+            nbits = nsamps - samp;
+            if (nbits > 8)
+                nbits = 8;
+
+            memset (bits, 0, sizeof (bits));
+            for (k = 0; k < nbits; k++)
+            {
+                for (plane = 0; plane < PIXEL_QA_NPLANES; plane++)
+                    bits[plane] |= ((qa[samp + k] >> plane) & 1) << k;
+            }
+
+            byte = (size_t) line * row_bytes + samp / 8;
+            for (plane = 0; plane < PIXEL_QA_NPLANES; plane++)
+                planes[plane][byte] = bits[plane];
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  unpack_pixel_qa_bitplanes
+
+PURPOSE: Rebuilds the pixel QA values from the requested packed bitplanes.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Bits which are not in plane_mask are zero in the output pixel QA values.
+******************************************************************************/
+void unpack_pixel_qa_bitplanes
+(
+    uint8_t **planes,       /* I: packed plane for each pixel QA bit; only
+                                  the planes in plane_mask are used */
+    uint16_t plane_mask,    /* I: mask of the bits to unpack (bit n set to
+                                  unpack plane n) */
+    int nlines,             /* I: number of lines of pixel QA values */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint16_t *pixel_qa      /* O: pixel QA values containing only the bits in
+                                  plane_mask */
+)
+{
+    int line;               /* current line */
+    int plane;              /* current plane */
+    int samp;               /* current sample */
+    size_t row_bytes = pixel_qa_bitplane_row_bytes (nsamps); /* bytes in a
+                               row of a plane */
+    uint8_t *row = NULL;    /* current row of the plane */
+    uint16_t *qa = NULL;    /* pixel QA values for the current line */
+
+    memset (pixel_qa, 0, (size_t) nlines * nsamps * sizeof (uint16_t));
+    for (plane = 0; plane < PIXEL_QA_NPLANES; plane++)
+    {
+        if (((plane_mask >> plane) & 1) == 0)
+            continue;
+
+        for (line = 0; line < nlines; line++)
+        {
+            row = &planes[plane][(size_t) line * row_bytes];
+            qa = &pixel_qa[(size_t) line * nsamps];
+            for (samp = 0; samp < nsamps; samp++)
+                qa[samp] |= ((row[samp / 8] >> (samp % 8)) & 1) << plane;
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  make_pixel_qa_bitplane_filename
+
+PURPOSE: Determines the name of the bitplane file from the pixel QA filename,
+inserting _bitplanes ahead of the file extension.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error creating the filename
+SUCCESS         Successfully created
+******************************************************************************/
+int make_pixel_qa_bitplane_filename
+(
+    char *l2_qa_file,       /* I: pixel QA filename */
+    char *bitplane_file     /* O: pixel QA bitplane filename */
+)
+{
+    char FUNC_NAME[] = "make_pixel_qa_bitplane_filename";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    char *cptr = NULL;        /* pointer to the file extension */
+
+    cptr = strrchr (l2_qa_file, '.');
+    if (cptr == NULL || (cptr - l2_qa_file) + strlen ("_bitplanes.img") >=
+        STR_SIZE)
+    {
+        sprintf (errmsg, "Unable to create the bitplane filename from the "
+            "pixel QA filename: %s", l2_qa_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    sprintf (bitplane_file, "%.*s_bitplanes.img", (int) (cptr - l2_qa_file),
+        l2_qa_file);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  find_pixel_qa_bitplanes
+
+PURPOSE: Finds the pixel QA band in the XML file and determines the name of
+its bitplane file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error finding the pixel QA band
+SUCCESS         Successfully found
+
+NOTES:
+1. The bitplane file is the pixel QA filename with _bitplanes inserted ahead
+   of the file extension.  It doesn't need to exist yet.
+******************************************************************************/
+int find_pixel_qa_bitplanes
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    char *bitplane_file,    /* O: pixel QA bitplane filename */
+    int *nlines,            /* O: number of lines in the QA band */
+    int *nsamps             /* O: number of samples in the QA band */
+)
+{
+    char FUNC_NAME[] = "find_pixel_qa_bitplanes";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    char l2_qa_file[STR_SIZE]; /* pixel QA filename */
+
+    if (find_pixel_qa (espa_xml_file, l2_qa_file, nlines, nsamps) != SUCCESS ||
+        make_pixel_qa_bitplane_filename (l2_qa_file, bitplane_file)
+        != SUCCESS)
+    {
+        sprintf (errmsg, "Unable to find the pixel QA band in the XML file");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  create_pixel_qa_bitplanes
+
+PURPOSE: Creates the bitplane file and makes it available for writing.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error creating the bitplane file
+SUCCESS         Successfully created
+
+NOTES:
+1. The file is sized for all the planes up front, so each plane can be
+   written in place as the lines are received.
+******************************************************************************/
+int create_pixel_qa_bitplanes
+(
+    char *bitplane_file,    /* I: bitplane filename to be created */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    Pixel_qa_bitplanes_t *bitplanes /* O: bitplane file being written */
+)
+{
+    char FUNC_NAME[] = "create_pixel_qa_bitplanes";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    off_t nbytes;             /* size of the bitplane file */
+
+    memset (bitplanes, 0, sizeof (Pixel_qa_bitplanes_t));
+    bitplanes->nlines = nlines;
+    bitplanes->nsamps = nsamps;
+    bitplanes->row_bytes = pixel_qa_bitplane_row_bytes (nsamps);
+    bitplanes->bitplane_file = strdup (bitplane_file);
+    if (bitplanes->bitplane_file == NULL)
+    {
+        sprintf (errmsg, "Allocating memory for the bitplane filename");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    bitplanes->fd = open (bitplane_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (bitplanes->fd < 0)
+    {
+        sprintf (errmsg, "Creating the bitplane file: %s", bitplane_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        free (bitplanes->bitplane_file);
+        return (ERROR);
+    }
+
+    nbytes = (off_t) PIXEL_QA_NPLANES * nlines * bitplanes->row_bytes;
+    if (ftruncate (bitplanes->fd, nbytes) != 0)
+    {
+        sprintf (errmsg, "Sizing the bitplane file: %s", bitplane_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        close (bitplanes->fd);
+        free (bitplanes->bitplane_file);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_pixel_qa_bitplanes
+
+PURPOSE: Packs the next lines of the pixel QA band and writes them to each of
+the planes of the bitplane file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the bitplanes
+SUCCESS         Successfully written
+
+NOTES:
+1. Lines must be written in order, top to bottom.
+******************************************************************************/
+int write_pixel_qa_bitplanes
+(
+    Pixel_qa_bitplanes_t *bitplanes, /* I/O: bitplane file being written */
+    int nlines,             /* I: number of lines to write */
+    uint16_t *pixel_qa      /* I: pixel QA values for the next nlines lines
+                                  of the band */
+)
+{
+    char FUNC_NAME[] = "write_pixel_qa_bitplanes";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int plane;                /* current plane */
+    size_t strip_bytes;       /* bytes of a plane for the nlines lines */
+    off_t plane_bytes;        /* bytes in a full plane */
+    off_t offset;             /* file offset of the lines in the plane */
+    uint8_t *planes[PIXEL_QA_NPLANES]; /* lines of each plane in the strip */
+
+    if (bitplanes->lines_written + nlines > bitplanes->nlines)
+    {
+        sprintf (errmsg, "Writing past the last line of the bitplane file: "
+            "%s", bitplanes->bitplane_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Grow the strip buffer if more lines are written than before */
+    strip_bytes = (size_t) nlines * bitplanes->row_bytes;
+    if (nlines > bitplanes->strip_lines)
+    {
+        free (bitplanes->strip);
+        bitplanes->strip = malloc (PIXEL_QA_NPLANES * strip_bytes);
+        if (bitplanes->strip == NULL)
+        {
+            sprintf (errmsg, "Allocating memory for the bitplanes");
+            error_handler (true, FUNC_NAME, errmsg);
+            bitplanes->strip_lines = 0;
+            return (ERROR);
+        }
+        bitplanes->strip_lines = nlines;
+    }
+
+    for (plane = 0; plane < PIXEL_QA_NPLANES; plane++)
+        planes[plane] = &bitplanes->strip[plane * strip_bytes];
+    pack_pixel_qa_bitplanes (pixel_qa, nlines, bitplanes->nsamps, planes);
+
+    /* Write the lines of each plane in place */
+    plane_bytes = (off_t) bitplanes->nlines * bitplanes->row_bytes;
+    for (plane = 0; plane < PIXEL_QA_NPLANES; plane++)
+    {
+        offset = plane * plane_bytes +
+            (off_t) bitplanes->lines_written * bitplanes->row_bytes;
+        if (pwrite_all (bitplanes->fd, planes[plane], strip_bytes, offset)
+            != SUCCESS)
+        {
+            sprintf (errmsg, "Writing plane %d of the bitplane file: %s",
+                plane, bitplanes->bitplane_file);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+    }
+    bitplanes->lines_written += nlines;
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  close_pixel_qa_bitplanes
+
+PURPOSE: Closes the bitplane file and frees the buffers of the writer.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error closing the file or not all lines were written
+SUCCESS         Successfully closed
+
+NOTES:
+******************************************************************************/
+int close_pixel_qa_bitplanes
+(
+    Pixel_qa_bitplanes_t *bitplanes /* I/O: bitplane file being written; will
+                                             be closed upon return */
+)
+{
+    char FUNC_NAME[] = "close_pixel_qa_bitplanes";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int status = SUCCESS;     /* return status */
+
+    if (bitplanes->lines_written != bitplanes->nlines)
+    {
+        sprintf (errmsg, "Only %d of %d lines were written to the bitplane "
+            "file: %s", bitplanes->lines_written, bitplanes->nlines,
+            bitplanes->bitplane_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+
+    if (close (bitplanes->fd) != 0)
+    {
+        sprintf (errmsg, "Closing the bitplane file: %s",
+            bitplanes->bitplane_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+
+    free (bitplanes->strip);
+    free (bitplanes->bitplane_file);
+    bitplanes->strip = NULL;
+    bitplanes->bitplane_file = NULL;
+    bitplanes->fd = -1;
+
+    return (status);
+}
+
+
+/******************************************************************************
+MODULE:  read_pixel_qa_bitplanes
+
+PURPOSE: Reads the requested planes from the bitplane file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the bitplanes
+SUCCESS         Successfully read
+
+NOTES:
+1. Only the planes set in plane_mask are read; the other entries of planes
+   are not used and may be NULL.
+******************************************************************************/
+int read_pixel_qa_bitplanes
+(
+    char *bitplane_file,    /* I: bitplane filename */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint16_t plane_mask,    /* I: mask of the planes to read (bit n set to
+                                  read plane n) */
+    uint8_t **planes        /* O: packed plane for each requested bit; each
+                                  requested plane must hold nlines rows of
+                                  pixel_qa_bitplane_row_bytes bytes */
+)
+{
+    char FUNC_NAME[] = "read_pixel_qa_bitplanes";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int fd;                   /* file descriptor of the bitplane file */
+    int plane;                /* current plane */
+    size_t plane_bytes;       /* bytes in a plane */
+    size_t nread;             /* bytes of the plane read so far */
+    ssize_t status;           /* bytes returned by pread */
+
+    fd = open (bitplane_file, O_RDONLY);
+    if (fd < 0)
+    {
+        sprintf (errmsg, "Opening the bitplane file: %s", bitplane_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    plane_bytes = (size_t) nlines * pixel_qa_bitplane_row_bytes (nsamps);
+    for (plane = 0; plane < PIXEL_QA_NPLANES; plane++)
+    {
+        if (((plane_mask >> plane) & 1) == 0)
+            continue;
+
+        nread = 0;
+        while (nread < plane_bytes)
+        {
+            status = pread (fd, &planes[plane][nread], plane_bytes - nread,
+                (off_t) plane * plane_bytes + nread);
+            if (status < 0 && errno == EINTR)
+                continue;
+            if (status <= 0)
+            {
+                sprintf (errmsg, "Reading plane %d of the bitplane file: %s",
+                    plane, bitplane_file);
+                error_handler (true, FUNC_NAME, errmsg);
+                close (fd);
+                return (ERROR);
+            }
+            nread += status;
+        }
+    }
+
+    close (fd);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  convert_pixel_qa_to_bitplanes
+
+PURPOSE: Converts the pixel QA band in the XML file to the bitplane file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error converting the pixel QA band
+SUCCESS         Successfully converted
+
+NOTES:
+1. The pixel QA band is read QA_STREAM_STRIP_LINES lines at a time.
+2. The bitplane file is not added to the XML file; it is an alternate
+   storage of the pixel QA band, which remains in place.
+******************************************************************************/
+int convert_pixel_qa_to_bitplanes
+(
+    char *espa_xml_file     /* I: input ESPA XML filename */
+)
+{
+    char FUNC_NAME[] = "convert_pixel_qa_to_bitplanes";  /* function name */
+    char errmsg[STR_SIZE];      /* error message */
+    char l2_qa_file[STR_SIZE];  /* pixel QA filename */
+    char bitplane_file[STR_SIZE]; /* bitplane filename */
+    int nlines;                 /* number of lines in the QA band */
+    int nsamps;                 /* number of samples in the QA band */
+    int line;                   /* first line of the current strip */
+    int strip_lines;            /* number of lines in the current strip */
+    uint16_t *pixel_qa = NULL;  /* pixel QA values for the current strip */
+    FILE *fp_bqa = NULL;        /* file pointer for the pixel QA band */
+    Pixel_qa_bitplanes_t bitplanes; /* bitplane file being written */
+
+    if (find_pixel_qa (espa_xml_file, l2_qa_file, &nlines, &nsamps)
+        != SUCCESS ||
+        make_pixel_qa_bitplane_filename (l2_qa_file, bitplane_file)
+        != SUCCESS)
+    {
+        sprintf (errmsg, "Unable to find the pixel QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    fp_bqa = open_raw_binary (l2_qa_file, "r");
+    if (fp_bqa == NULL)
+    {
+        sprintf (errmsg, "Opening the pixel QA band for conversion");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    pixel_qa = calloc ((size_t) QA_STREAM_STRIP_LINES * nsamps,
+        sizeof (uint16_t));
+    if (pixel_qa == NULL)
+    {
+        sprintf (errmsg, "Allocating memory for the pixel QA");
+        error_handler (true, FUNC_NAME, errmsg);
+        close_pixel_qa (fp_bqa);
+        return (ERROR);
+    }
+
+    if (create_pixel_qa_bitplanes (bitplane_file, nlines, nsamps, &bitplanes)
+        != SUCCESS)
+    {
+        sprintf (errmsg, "Unable to create the bitplane file");
+        error_handler (true, FUNC_NAME, errmsg);
+        free (pixel_qa);
+        close_pixel_qa (fp_bqa);
+        return (ERROR);
+    }
+
+    for (line = 0; line < nlines; line += QA_STREAM_STRIP_LINES)
+    {
+        strip_lines = nlines - line;
+        if (strip_lines > QA_STREAM_STRIP_LINES)
+            strip_lines = QA_STREAM_STRIP_LINES;
+
+        if (read_pixel_qa (fp_bqa, strip_lines, nsamps, pixel_qa) != SUCCESS ||
+            write_pixel_qa_bitplanes (&bitplanes, strip_lines, pixel_qa)
+            != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to convert the pixel QA band");
+            error_handler (true, FUNC_NAME, errmsg);
+            close_pixel_qa_bitplanes (&bitplanes);
+            free (pixel_qa);
+            close_pixel_qa (fp_bqa);
+            return (ERROR);
+        }
+    }
+
+    free (pixel_qa);
+    close_pixel_qa (fp_bqa);
+    if (close_pixel_qa_bitplanes (&bitplanes) != SUCCESS)
+    {
+        sprintf (errmsg, "Unable to write the bitplane file");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
@@ -0,0 +1,166 @@
+/*****************************************************************************
+FILE: pixel_qa_bitplanes.h
+  
+PURPOSE: Contains defines, data types, and function prototypes for storing the
+Level-2 pixel QA band as separate packed 1-bit planes.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The bitplane file holds one plane for each defined pixel QA bit, from
+   L2QA_FILL (plane 0) through L2QA_TERRAIN_OCCL (plane 10), one after the
+   other.  Each plane is nlines rows of (nsamps + 7) / 8 bytes, with sample i
+   of a row stored in bit (i % 8) of byte (i / 8) of the row.  The unused bits
+   at the end of a row are zero.
+2. The file has no header.  The number of lines and samples are those of the
+   pixel QA band in the XML file, and the file is named after the pixel QA
+   band, i.e. *_pixel_qa_bitplanes.img.
+3. A query on a single bit reads 1/16th of the data of the pixel QA band.
+*****************************************************************************/
+
+#ifndef PIXEL_QA_BITPLANES_H
+#define PIXEL_QA_BITPLANES_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "error_handler.h"
+#include "pixel_qa.h"
+
+/* Defines */
+#define PIXEL_QA_NPLANES (L2QA_TERRAIN_OCCL + 1) /* number of bitplanes */
+#define PIXEL_QA_ALL_PLANES ((1 << PIXEL_QA_NPLANES) - 1) /* mask of all the
+                                                        bitplanes */
+
+/* Data types */
+typedef struct
+{
+    int fd;                 /* file descriptor of the bitplane file */
+    char *bitplane_file;    /* bitplane filename */
+    int nlines;             /* number of lines in the QA band */
+    int nsamps;             /* number of samples in the QA band */
+    int lines_written;      /* number of lines written so far */
+    size_t row_bytes;       /* number of bytes in a row of a plane */
+    uint8_t *strip;         /* packed planes for the lines being written */
+    int strip_lines;        /* number of lines strip can hold */
+} Pixel_qa_bitplanes_t;
+
+/* Function prototypes */
+size_t pixel_qa_bitplane_row_bytes
+(
+    int nsamps              /* I: number of samples in the QA band */
+);
+
+void pack_pixel_qa_bitplanes
+(
+    uint16_t *pixel_qa,     /* I: pixel QA values */
+    int nlines,             /* I: number of lines of pixel QA values */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint8_t **planes        /* O: packed plane for each pixel QA bit; each
+                                  must hold nlines rows of
+                                  pixel_qa_bitplane_row_bytes bytes */
+);
+
+void unpack_pixel_qa_bitplanes
+(
+    uint8_t **planes,       /* I: packed plane for each pixel QA bit; only
+                                  the planes in plane_mask are used */
+    uint16_t plane_mask,    /* I: mask of the bits to unpack (bit n set to
+                                  unpack plane n) */
+    int nlines,             /* I: number of lines of pixel QA values */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint16_t *pixel_qa      /* O: pixel QA values containing only the bits in
+                                  plane_mask */
+);
+
+int make_pixel_qa_bitplane_filename
+(
+    char *l2_qa_file,       /* I: pixel QA filename */
+    char *bitplane_file     /* O: pixel QA bitplane filename */
+);
+
+int find_pixel_qa_bitplanes
+(
+    char *espa_xml_file,    /* I: input ESPA XML filename */
+    char *bitplane_file,    /* O: pixel QA bitplane filename */
+    int *nlines,            /* O: number of lines in the QA band */
+    int *nsamps             /* O: number of samples in the QA band */
+);
+
+int create_pixel_qa_bitplanes
+(
+    char *bitplane_file,    /* I: bitplane filename to be created */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    Pixel_qa_bitplanes_t *bitplanes /* O: bitplane file being written */
+);
+
+int write_pixel_qa_bitplanes
+(
+    Pixel_qa_bitplanes_t *bitplanes, /* I/O: bitplane file being written */
+    int nlines,             /* I: number of lines to write */
+    uint16_t *pixel_qa      /* I: pixel QA values for the next nlines lines
+                                  of the band */
+);
+
+int close_pixel_qa_bitplanes
+(
+    Pixel_qa_bitplanes_t *bitplanes /* I/O: bitplane file being written; will
+                                             be closed upon return */
+);
+
+int read_pixel_qa_bitplanes
+(
+    char *bitplane_file,    /* I: bitplane filename */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    uint16_t plane_mask,    /* I: mask of the planes to read (bit n set to
+                                  read plane n) */
+    uint8_t **planes        /* O: packed plane for each requested bit; each
+                                  requested plane must hold nlines rows of
+                                  pixel_qa_bitplane_row_bytes bytes */
+);
+
+int convert_pixel_qa_to_bitplanes
+(
+    char *espa_xml_file     /* I: input ESPA XML filename */
+);
+
+
+/* Inline Function Prototypes */
+
+/******************************************************************************
+MODULE:  pixel_qa_bitplane_is_set
+
+PURPOSE: Determines if the pixel is set in the packed bitplane
+
+RETURN VALUE:
+Type = boolean
+Value           Description
+-----           -----------
+true            Bit is set for the pixel
+false           Bit is not set for the pixel
+
+NOTES:
+1. This is an inline function so it should be fast as the function call overhead
+   is eliminated by dropping the code inline with the original application.
+******************************************************************************/
+static inline bool pixel_qa_bitplane_is_set
+(
+    uint8_t *plane,         /* I: packed bitplane */
+    size_t row_bytes,       /* I: number of bytes in a row of the plane */
+    int line,               /* I: line of the pixel */
+    int samp                /* I: sample of the pixel */
+)
+{
+    if (((plane[line * row_bytes + samp / 8] >> (samp % 8)) & 1) == 1)
+        return true;
+    else
+        return false;
+}
+
+#endif
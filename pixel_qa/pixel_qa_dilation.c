@@ -31,6 +31,32 @@ void dilate_pixel_qa
     int ncols,             /* I: Number of colums in the data */
     uint16_t *output_data  /* O: Data after dilation */
 )
+{
+    dilate_pixel_qa_rows(input_data, search_bit, distance, nrows, ncols,
+                         0, nrows, output_data);
+}
+
+
+/*****************************************************************************
+METHOD: dilate_pixel_qa_rows
+
+PURPOSE: Dilate the input data, as done by dilate_pixel_qa, producing only
+         the output rows first_row through first_row + strip_rows - 1.  The
+         window still searches the entire input data, so a band processed
+         strip by strip is identical to one processed all at once.
+*****************************************************************************/
+void dilate_pixel_qa_rows
+(
+    uint16_t *input_data,  /* I: Data to dilate */
+    uint8_t search_bit,    /* I: Bit to dilate */
+    int distance,          /* I: Distance to dilate */
+    int nrows,             /* I: Number of rows in the data */
+    int ncols,             /* I: Number of colums in the data */
+    int first_row,         /* I: First row of the output strip */
+    int strip_rows,        /* I: Number of rows in the output strip */
+    uint16_t *output_data  /* O: Strip of data after dilation; row 0 of the
+                                 strip is first_row of the data */
+)
 {
     bool found;       /* flag to add the bit to the output mask */
     /* loop indices */
@@ -45,6 +71,7 @@ void dilate_pixel_qa
     int window_row_index;  /* window */
     int output_index;
     int input_index;
+    int strip_offset;   /* offset of the strip in the input data */
     uint16_t input_val; /* value for specified bit from input QA band */
     int user_bit_mask;  /* mask based on the search bit */
     int cleaning_bit_mask; /* mask based on bits to clean because otherwise 
@@ -72,22 +99,27 @@ void dilate_pixel_qa
        found, the current pixel is within the dilation region of the 2nd pixel,
        so set the requested bit for the current pixel on */
 
+    /* Output indices are relative to the strip; adding the strip offset
+       gives the matching input index */
+    strip_offset = first_row * ncols;
+
 #ifdef _OPENMP
     #pragma omp parallel for private(start_row, end_row, col, output_index, start_col, end_col, found, window_row, window_row_index, window_col, input_index)
 #endif
-    for (row = 0; row < nrows; row++)
+    for (row = first_row; row < first_row + strip_rows; row++)
     {
         start_row = row - distance;
         end_row = row + distance;
 
-        output_index = row * ncols;
+        output_index = (row - first_row) * ncols;
 
         for (col = 0; col < ncols; col++, output_index++)
         {
             /* Skip processing input that is a fill pixel */
-            if (pixel_qa_is_fill(input_data[output_index]))
+            if (pixel_qa_is_fill(input_data[strip_offset + output_index]))
             {
-                output_data[output_index] = input_data[output_index];
+                output_data[output_index] =
+                    input_data[strip_offset + output_index];
                 continue;
             }
 
@@ -130,16 +162,88 @@ void dilate_pixel_qa
             if (found)
             {
                 /* Dilate by turning the requested bit on */
-                output_data[output_index] = input_data[output_index] 
-                    | user_bit_mask;
+                output_data[output_index] =
+                    input_data[strip_offset + output_index] | user_bit_mask;
 
                 /* Turn off some bits that contradict the dilation */
                 output_data[output_index] &= cleaning_bit_mask;
             }
             else
             {
-                output_data[output_index] = input_data[output_index];
+                output_data[output_index] =
+                    input_data[strip_offset + output_index];
             }
         }
     }
 }
+
+
+/*****************************************************************************
+METHOD: dilate_pixel_qa_reference
+
+PURPOSE: Dilate the input data as dilate_pixel_qa does, with a plain
+         single-threaded scan of the whole window around each pixel.  It is
+         kept as the reference that dilate_pixel_qa,
+         dilate_pixel_qa_rows, and any faster dilation must match bit for
+         bit (see tools/test_qa_kernels.c), so it must not be optimized.
+*****************************************************************************/
+void dilate_pixel_qa_reference
+(
+    uint16_t *input_data,  /* I: Data to dilate */
+    uint8_t search_bit,    /* I: Bit to dilate */
+    int distance,          /* I: Distance to dilate */
+    int nrows,             /* I: Number of rows in the data */
+    int ncols,             /* I: Number of colums in the data */
+    uint16_t *output_data  /* O: Data after dilation */
+)
+{
+    bool found;       /* flag to add the bit to the output mask */
+    int row, col;     /* loop indices */
+    int window_row;   /* row in the window */
+    int window_col;   /* column in the window */
+    int index;        /* index of the current pixel */
+    uint16_t cleaning_bit_mask = 0xffff; /* bits kept in a dilated pixel */
+
+    /* If cloud is being dilated, then turn off clear and cloud shadow */
+    if (search_bit == L2QA_CLOUD)
+    {
+        cleaning_bit_mask &= ~(1 << L2QA_CLEAR);
+        cleaning_bit_mask &= ~(1 << L2QA_CLD_SHADOW);
+    }
+
+    for (row = 0; row < nrows; row++)
+    {
+        for (col = 0; col < ncols; col++)
+        {
+            index = row * ncols + col;
+            output_data[index] = input_data[index];
+
+            /* Fill pixels are never dilated */
+            if (pixel_qa_is_fill (input_data[index]))
+                continue;
+
+            found = false;
+            for (window_row = row - distance;
+                 window_row <= row + distance && !found; window_row++)
+            {
+                if (window_row < 0 || window_row > (nrows - 1))
+                    continue;
+
+                for (window_col = col - distance;
+                     window_col <= col + distance && !found; window_col++)
+                {
+                    if (window_col < 0 || window_col > (ncols - 1))
+                        continue;
+
+                    if ((input_data[window_row * ncols + window_col] >>
+                        search_bit) & L2QA_SINGLE_BIT)
+                        found = true;
+                }
+            }
+
+            if (found)
+                output_data[index] = (input_data[index] |
+                    (1 << search_bit)) & cleaning_bit_mask;
+        }
+    }
+}
@@ -19,3 +19,28 @@ void dilate_pixel_qa
     int ncols,             /* I: Number of colums in the data */
     uint16_t *output_data  /* O: Data after dilation */
 );
+
+
+void dilate_pixel_qa_rows
+(
+    uint16_t *input_data,  /* I: Data to dilate */
+    uint8_t search_bit,    /* I: Bit to dilate */
+    int distance,          /* I: Distance to dilate */
+    int nrows,             /* I: Number of rows in the data */
+    int ncols,             /* I: Number of colums in the data */
+    int first_row,         /* I: First row of the output strip */
+    int strip_rows,        /* I: Number of rows in the output strip */
+    uint16_t *output_data  /* O: Strip of data after dilation; row 0 of the
+                                 strip is first_row of the data */
+);
+
+
+void dilate_pixel_qa_reference
+(
+    uint16_t *input_data,  /* I: Data to dilate */
+    uint8_t search_bit,    /* I: Bit to dilate */
+    int distance,          /* I: Distance to dilate */
+    int nrows,             /* I: Number of rows in the data */
+    int ncols,             /* I: Number of colums in the data */
+    uint16_t *output_data  /* O: Data after dilation */
+);
@@ -0,0 +1,878 @@
+/*****************************************************************************
+FILE: pixel_qa_module.c
+
+PURPOSE: Contains the _pixel_qa Python extension module, which gives Python
+applications in-process access to the pixel QA generation, dilation, and the
+Level-1 and Level-2 QA read and decode functions.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The arrays are passed through the buffer protocol, so NumPy arrays (or any
+   other C-contiguous buffers of the right item size) are used in place with
+   no copies.  The output arrays are allocated by the caller; pixel_qa.py has
+   wrappers which allocate them with NumPy.
+2. The read functions return a bytearray holding the band, which
+   numpy.frombuffer wraps without a copy.
+3. The GIL is released while the C functions run, so scenes may be processed
+   in parallel from Python threads.
+4. The C functions report their errors through error_handler (to stderr); the
+   module raises RuntimeError when they fail.
+*****************************************************************************/
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <limits.h>
+#include "generate_pixel_qa.h"
+#include "pixel_qa_dilation.h"
+#include "level1_qa_bulk.h"
+#include "level2_qa_aerosol_bulk.h"
+
+
+/******************************************************************************
+MODULE:  get_qa_buffer
+
+PURPOSE: Gets a C-contiguous buffer of the specified item size from a Python
+object.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              The object doesn't provide a suitable buffer (the Python
+                exception is set)
+0               Successful; the buffer must be released with PyBuffer_Release
+
+NOTES:
+******************************************************************************/
+static int get_qa_buffer
+(
+    PyObject *obj,         /* I: object providing the buffer */
+    Py_ssize_t itemsize,   /* I: required item size (bytes) */
+    bool writable,         /* I: will the buffer be written? */
+    const char *name,      /* I: name of the argument for error messages */
+    Py_buffer *view        /* O: buffer of the object */
+)
+{
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT;  /* buffer request */
+
+    if (writable)
+        flags |= PyBUF_WRITABLE;
+    if (PyObject_GetBuffer (obj, view, flags) != 0)
+        return -1;
+
+    if (view->itemsize != itemsize)
+    {
+        PyErr_Format (PyExc_TypeError, "%s must have %d-byte items", name,
+            (int) itemsize);
+        PyBuffer_Release (view);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************
+MODULE:  buffer_npixels
+
+PURPOSE: Returns the number of items in a buffer.
+
+RETURN VALUE:
+Type = Py_ssize_t
+Value           Description
+-----           -----------
+n               Number of items in the buffer
+
+NOTES:
+******************************************************************************/
+static Py_ssize_t buffer_npixels
+(
+    Py_buffer *view        /* I: buffer from get_qa_buffer */
+)
+{
+    return view->len / view->itemsize;
+}
+
+
+/******************************************************************************
+MODULE:  buffers_overlap
+
+PURPOSE: Determines if two buffers share any bytes.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The byte ranges of the buffers overlap
+false           The buffers are disjoint
+
+NOTES:
+1. Views of the same NumPy array (a[:10] and a[5:15]) overlap without
+   starting at the same address, so the whole byte ranges are compared.
+******************************************************************************/
+static bool buffers_overlap
+(
+    Py_buffer *view1,      /* I: first buffer */
+    Py_buffer *view2       /* I: second buffer */
+)
+{
+    const char *start1 = view1->buf;    /* first byte of view1 */
+    const char *start2 = view2->buf;    /* first byte of view2 */
+
+    return start1 < start2 + view2->len && start2 < start1 + view1->len;
+}
+
+
+/******************************************************************************
+MODULE:  py_generate_pixel_qa
+
+PURPOSE: generate_pixel_qa(xml, geotiff=False, overviews=0, bitplanes=False,
+saturation=False) generates the pixel QA band of the scene, as done by the
+generate_pixel_qa application.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Error generating the pixel QA band
+Py_None         Successful
+
+NOTES:
+******************************************************************************/
+static PyObject *py_generate_pixel_qa
+(
+    PyObject *self,        /* I: module */
+    PyObject *args,        /* I: positional arguments */
+    PyObject *kwargs       /* I: keyword arguments */
+)
+{
+    static char *kwlist[] = {"xml", "geotiff", "overviews", "bitplanes",
+        "saturation", NULL};
+    char *espa_xml_file = NULL;  /* input ESPA XML filename */
+    int geotiff = 0;             /* also write the GeoTIFF? */
+    int overviews = 0;           /* number of GeoTIFF overview levels */
+    int bitplanes = 0;           /* also write the bitplanes? */
+    int saturation = 0;          /* also write the Level-1 saturation QA? */
+    int status;                  /* return status of the generation */
+    Pixel_qa_options_t options;  /* generation options */
+
+    if (!PyArg_ParseTupleAndKeywords (args, kwargs, "s|pipp", kwlist,
+        &espa_xml_file, &geotiff, &overviews, &bitplanes, &saturation))
+        return NULL;
+    if (overviews < 0 || overviews > GEOTIFF_MAX_OVERVIEWS)
+    {
+        PyErr_Format (PyExc_ValueError, "overviews must be between 0 and %d",
+            GEOTIFF_MAX_OVERVIEWS);
+        return NULL;
+    }
+
+    init_pixel_qa_options (&options);
+    options.write_geotiff = geotiff || overviews > 0;
+    options.geotiff_overviews = overviews;
+    options.write_bitplanes = bitplanes;
+    options.write_saturation = saturation;
+
+    Py_BEGIN_ALLOW_THREADS
+    status = generate_pixel_qa_with_options (espa_xml_file, &options);
+    Py_END_ALLOW_THREADS
+
+    if (status != SUCCESS)
+    {
+        PyErr_Format (PyExc_RuntimeError, "Unable to generate the pixel QA "
+            "band for %s", espa_xml_file);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+/******************************************************************************
+MODULE:  py_translate_level1_qa
+
+PURPOSE: translate_level1_qa(l1_qa, qa_category, l2_qa, l1_sat=None)
+translates the uint16 Level-1 QA values to pixel QA values, and optionally
+the uint8 Level-1 saturation QA values, in place in the output buffers.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Invalid arguments
+Py_None         Successful
+
+NOTES:
+******************************************************************************/
+static PyObject *py_translate_level1_qa
+(
+    PyObject *self,        /* I: module */
+    PyObject *args         /* I: positional arguments */
+)
+{
+    PyObject *l1_obj = NULL;     /* Level-1 QA values */
+    PyObject *l2_obj = NULL;     /* pixel QA values */
+    PyObject *sat_obj = Py_None; /* Level-1 saturation QA values */
+    int qa_category;             /* type of Level-1 QA data */
+    Py_buffer l1_view;           /* buffer of the Level-1 QA values */
+    Py_buffer l2_view;           /* buffer of the pixel QA values */
+    Py_buffer sat_view;          /* buffer of the saturation QA values */
+    Py_ssize_t npixels;          /* number of pixels */
+    uint8_t *l1_sat = NULL;      /* saturation QA values, or NULL */
+    Level1_qa_translator_t translate;  /* translation kernel */
+
+    if (!PyArg_ParseTuple (args, "OiO|O", &l1_obj, &qa_category, &l2_obj,
+        &sat_obj))
+        return NULL;
+    if (qa_category < LEVEL1_L457 || qa_category > LEVEL1_C2)
+    {
+        PyErr_SetString (PyExc_ValueError, "Invalid Level-1 QA category");
+        return NULL;
+    }
+
+    if (get_qa_buffer (l1_obj, sizeof (uint16_t), false, "l1_qa", &l1_view))
+        return NULL;
+    if (get_qa_buffer (l2_obj, sizeof (uint16_t), true, "l2_qa", &l2_view))
+    {
+        PyBuffer_Release (&l1_view);
+        return NULL;
+    }
+    npixels = buffer_npixels (&l1_view);
+    if (buffer_npixels (&l2_view) != npixels || npixels > INT_MAX)
+    {
+        PyErr_SetString (PyExc_ValueError, "l2_qa must be the size of "
+            "l1_qa, which must have fewer than 2^31 pixels");
+        goto fail;
+    }
+    if (sat_obj != Py_None)
+    {
+        if (get_qa_buffer (sat_obj, sizeof (uint8_t), true, "l1_sat",
+            &sat_view))
+            goto fail;
+        if (buffer_npixels (&sat_view) != npixels)
+        {
+            PyBuffer_Release (&sat_view);
+            PyErr_SetString (PyExc_ValueError, "l1_sat must be the size of "
+                "l1_qa");
+            goto fail;
+        }
+        l1_sat = sat_view.buf;
+    }
+
+    translate = get_level1_qa_translator ((Espa_level1_qa_type) qa_category);
+    Py_BEGIN_ALLOW_THREADS
+    translate (l1_view.buf, (int) npixels, l2_view.buf, l1_sat);
+    Py_END_ALLOW_THREADS
+
+    if (l1_sat != NULL)
+        PyBuffer_Release (&sat_view);
+    PyBuffer_Release (&l1_view);
+    PyBuffer_Release (&l2_view);
+    Py_RETURN_NONE;
+
+fail:
+    PyBuffer_Release (&l1_view);
+    PyBuffer_Release (&l2_view);
+    return NULL;
+}
+
+
+/******************************************************************************
+MODULE:  py_set_pixel_qa_water
+
+PURPOSE: set_pixel_qa_water(l2_qa_water, water_category, l2_qa) sets the
+water bit of the pixel QA values from the uint8 LaSRC aerosol or LEDAPS cloud
+QA values, in place.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Invalid arguments
+Py_None         Successful
+
+NOTES:
+******************************************************************************/
+static PyObject *py_set_pixel_qa_water
+(
+    PyObject *self,        /* I: module */
+    PyObject *args         /* I: positional arguments */
+)
+{
+    PyObject *water_obj = NULL;  /* water band values */
+    PyObject *l2_obj = NULL;     /* pixel QA values */
+    int water_category;          /* type of the water band */
+    Py_buffer water_view;        /* buffer of the water band values */
+    Py_buffer l2_view;           /* buffer of the pixel QA values */
+    Py_ssize_t npixels;          /* number of pixels */
+
+    if (!PyArg_ParseTuple (args, "OiO", &water_obj, &water_category,
+        &l2_obj))
+        return NULL;
+    if (water_category != LASRC_AEROSOL && water_category != LEDAPS_CLOUD)
+    {
+        PyErr_SetString (PyExc_ValueError, "The water category must be "
+            "LASRC_AEROSOL or LEDAPS_CLOUD");
+        return NULL;
+    }
+
+    if (get_qa_buffer (water_obj, sizeof (uint8_t), false, "l2_qa_water",
+        &water_view))
+        return NULL;
+    if (get_qa_buffer (l2_obj, sizeof (uint16_t), true, "l2_qa", &l2_view))
+    {
+        PyBuffer_Release (&water_view);
+        return NULL;
+    }
+    npixels = buffer_npixels (&l2_view);
+    if (buffer_npixels (&water_view) != npixels || npixels > INT_MAX)
+    {
+        PyErr_SetString (PyExc_ValueError, "l2_qa_water must be the size of "
+            "l2_qa, which must have fewer than 2^31 pixels");
+        PyBuffer_Release (&water_view);
+        PyBuffer_Release (&l2_view);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    set_pixel_qa_water (water_view.buf, (Espa_level2_qa_type) water_category,
+        (int) npixels, l2_view.buf);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release (&water_view);
+    PyBuffer_Release (&l2_view);
+    Py_RETURN_NONE;
+}
+
+
+/******************************************************************************
+MODULE:  py_dilate_pixel_qa
+
+PURPOSE: dilate_pixel_qa(l2_qa, bit, distance, output) dilates the specified
+bit of the 2-D uint16 pixel QA array into the output array, as done by the
+dilate_pixel_qa application.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Invalid arguments
+Py_None         Successful
+
+NOTES:
+1. The arrays must be 2-D (lines x samples) so the window knows the shape.
+2. The output must not share any memory with the input, since the window
+   reads the input around each output pixel.
+3. A distance beyond the larger dimension of the scene dilates the same as
+   that dimension, so it is clamped before the row and column window limits
+   are computed and can't overflow.
+******************************************************************************/
+static PyObject *py_dilate_pixel_qa
+(
+    PyObject *self,        /* I: module */
+    PyObject *args         /* I: positional arguments */
+)
+{
+    PyObject *in_obj = NULL;     /* pixel QA values */
+    PyObject *out_obj = NULL;    /* dilated pixel QA values */
+    int bit;                     /* bit to dilate */
+    int distance;                /* distance to dilate */
+    Py_buffer in_view;           /* buffer of the pixel QA values */
+    Py_buffer out_view;          /* buffer of the dilated values */
+    int nrows, ncols;            /* shape of the arrays */
+
+    if (!PyArg_ParseTuple (args, "OiiO", &in_obj, &bit, &distance, &out_obj))
+        return NULL;
+    if (bit < 0 || bit > 15 || distance < 0)
+    {
+        PyErr_SetString (PyExc_ValueError, "bit must be 0-15 and distance "
+            "must not be negative");
+        return NULL;
+    }
+
+    if (get_qa_buffer (in_obj, sizeof (uint16_t), false, "l2_qa", &in_view))
+        return NULL;
+    if (get_qa_buffer (out_obj, sizeof (uint16_t), true, "output",
+        &out_view))
+    {
+        PyBuffer_Release (&in_view);
+        return NULL;
+    }
+    if (in_view.ndim != 2 || out_view.ndim != 2 ||
+        in_view.shape[0] != out_view.shape[0] ||
+        in_view.shape[1] != out_view.shape[1] ||
+        in_view.shape[0] > INT_MAX || in_view.shape[1] > INT_MAX ||
+        buffers_overlap (&in_view, &out_view))
+    {
+        PyErr_SetString (PyExc_ValueError, "l2_qa and output must be "
+            "non-overlapping 2-D arrays of the same shape");
+        PyBuffer_Release (&in_view);
+        PyBuffer_Release (&out_view);
+        return NULL;
+    }
+    nrows = (int) in_view.shape[0];
+    ncols = (int) in_view.shape[1];
+    if (distance > nrows && distance > ncols)
+        distance = nrows > ncols ? nrows : ncols;
+
+    Py_BEGIN_ALLOW_THREADS
+    dilate_pixel_qa (in_view.buf, (uint8_t) bit, distance, nrows, ncols,
+        out_view.buf);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release (&in_view);
+    PyBuffer_Release (&out_view);
+    Py_RETURN_NONE;
+}
+
+
+/******************************************************************************
+MODULE:  py_read_level1_qa
+
+PURPOSE: read_level1_qa(xml) reads the entire Level-1 QA band of the scene.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Error reading the Level-1 QA band
+tuple           (bytearray of the uint16 values, nlines, nsamps, qa_category)
+
+NOTES:
+******************************************************************************/
+static PyObject *py_read_level1_qa
+(
+    PyObject *self,        /* I: module */
+    PyObject *args         /* I: positional arguments */
+)
+{
+    char *espa_xml_file = NULL;  /* input ESPA XML filename */
+    char l1_qa_file[STR_SIZE];   /* Level-1 QA filename */
+    int nlines, nsamps;          /* size of the Level-1 QA band */
+    int status = ERROR;          /* return status of the read */
+    Espa_level1_qa_type qa_category;  /* type of Level-1 QA data */
+    FILE *fp_bqa = NULL;         /* Level-1 QA band */
+    PyObject *data = NULL;       /* Level-1 QA values */
+
+    if (!PyArg_ParseTuple (args, "s", &espa_xml_file))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    fp_bqa = open_level1_qa (espa_xml_file, l1_qa_file, &nlines, &nsamps,
+        &qa_category);
+    Py_END_ALLOW_THREADS
+    if (fp_bqa == NULL)
+    {
+        PyErr_Format (PyExc_RuntimeError, "Unable to open the Level-1 QA "
+            "band for %s", espa_xml_file);
+        return NULL;
+    }
+
+    data = PyByteArray_FromStringAndSize (NULL,
+        (Py_ssize_t) nlines * nsamps * sizeof (uint16_t));
+    if (data != NULL)
+    {
+        Py_BEGIN_ALLOW_THREADS
+        status = read_level1_qa (fp_bqa, nlines, nsamps,
+            (uint16_t *) PyByteArray_AS_STRING (data));
+        Py_END_ALLOW_THREADS
+    }
+    close_level1_qa (fp_bqa);
+    if (data == NULL)
+        return NULL;
+    if (status != SUCCESS)
+    {
+        Py_DECREF (data);
+        PyErr_Format (PyExc_RuntimeError, "Unable to read the Level-1 QA "
+            "band %s", l1_qa_file);
+        return NULL;
+    }
+
+    return Py_BuildValue ("Niii", data, nlines, nsamps, (int) qa_category);
+}
+
+
+/******************************************************************************
+MODULE:  py_read_level2_qa
+
+PURPOSE: read_level2_qa(xml, qa_category) reads the entire LEDAPS or LaSRC
+Level-2 QA band of the scene.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Error reading the Level-2 QA band
+tuple           (bytearray of the values, nlines, nsamps); the values are
+                uint16 for LASRC_RADSAT and uint8 otherwise
+
+NOTES:
+******************************************************************************/
+static PyObject *py_read_level2_qa
+(
+    PyObject *self,        /* I: module */
+    PyObject *args         /* I: positional arguments */
+)
+{
+    char *espa_xml_file = NULL;  /* input ESPA XML filename */
+    char l2_qa_file[STR_SIZE];   /* Level-2 QA filename */
+    int qa_category;             /* type of Level-2 QA data */
+    int nlines, nsamps;          /* size of the Level-2 QA band */
+    int status = ERROR;          /* return status of the read */
+    size_t itemsize;             /* size of the QA values */
+    FILE *fp_l2qa = NULL;        /* Level-2 QA band */
+    PyObject *data = NULL;       /* Level-2 QA values */
+
+    if (!PyArg_ParseTuple (args, "si", &espa_xml_file, &qa_category))
+        return NULL;
+    if (qa_category < LEDAPS_RADSAT || qa_category > LASRC_RADSAT)
+    {
+        PyErr_SetString (PyExc_ValueError, "Invalid Level-2 QA category");
+        return NULL;
+    }
+    itemsize = qa_category == LASRC_RADSAT ? sizeof (uint16_t) :
+        sizeof (uint8_t);
+
+    Py_BEGIN_ALLOW_THREADS
+    fp_l2qa = open_level2_qa (espa_xml_file,
+        (Espa_level2_qa_type) qa_category, l2_qa_file, &nlines, &nsamps);
+    Py_END_ALLOW_THREADS
+    if (fp_l2qa == NULL)
+    {
+        PyErr_Format (PyExc_RuntimeError, "Unable to open the Level-2 QA "
+            "band for %s", espa_xml_file);
+        return NULL;
+    }
+
+    data = PyByteArray_FromStringAndSize (NULL,
+        (Py_ssize_t) nlines * nsamps * itemsize);
+    if (data != NULL)
+    {
+        Py_BEGIN_ALLOW_THREADS
+        status = read_level2_qa (fp_l2qa, nlines, nsamps,
+            (Espa_level2_qa_type) qa_category, PyByteArray_AS_STRING (data));
+        Py_END_ALLOW_THREADS
+    }
+    close_level2_qa (fp_l2qa);
+    if (data == NULL)
+        return NULL;
+    if (status != SUCCESS)
+    {
+        Py_DECREF (data);
+        PyErr_Format (PyExc_RuntimeError, "Unable to read the Level-2 QA "
+            "band %s", l2_qa_file);
+        return NULL;
+    }
+
+    return Py_BuildValue ("Nii", data, nlines, nsamps);
+}
+
+
+/******************************************************************************
+MODULE:  py_level1_qa_bits
+
+PURPOSE: Common code of level1_qa_bit_mask and level1_qa_field_values.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Invalid arguments
+Py_None         Successful
+
+NOTES:
+******************************************************************************/
+static PyObject *py_level1_qa_bits
+(
+    PyObject *args,        /* I: positional arguments */
+    bool packed            /* I: packed mask (true) or field values? */
+)
+{
+    PyObject *l1_obj = NULL;     /* Level-1 QA values */
+    PyObject *out_obj = NULL;    /* mask or field values */
+    int bit;                     /* Level-1 QA bit */
+    Py_buffer l1_view;           /* buffer of the Level-1 QA values */
+    Py_buffer out_view;          /* buffer of the mask or field values */
+    Py_ssize_t npixels;          /* number of pixels */
+    Py_ssize_t nout;             /* required size of the output */
+
+    if (!PyArg_ParseTuple (args, "OiO", &l1_obj, &bit, &out_obj))
+        return NULL;
+    if (bit < 0 || bit > (packed ? 15 : 14))
+    {
+        PyErr_SetString (PyExc_ValueError, "Invalid Level-1 QA bit");
+        return NULL;
+    }
+
+    if (get_qa_buffer (l1_obj, sizeof (uint16_t), false, "l1_qa", &l1_view))
+        return NULL;
+    if (get_qa_buffer (out_obj, sizeof (uint8_t), true, "output", &out_view))
+    {
+        PyBuffer_Release (&l1_view);
+        return NULL;
+    }
+    npixels = buffer_npixels (&l1_view);
+    nout = packed ? (Py_ssize_t) level1_qa_mask_bytes (npixels) : npixels;
+    if (out_view.len < nout)
+    {
+        PyErr_Format (PyExc_ValueError, "output must have at least %zd "
+            "bytes", nout);
+        PyBuffer_Release (&l1_view);
+        PyBuffer_Release (&out_view);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    if (packed)
+        level1_qa_bit_mask (l1_view.buf, npixels, bit, out_view.buf);
+    else
+        level1_qa_field_values (l1_view.buf, npixels, bit, out_view.buf);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release (&l1_view);
+    PyBuffer_Release (&out_view);
+    Py_RETURN_NONE;
+}
+
+
+/******************************************************************************
+MODULE:  py_level1_qa_bit_mask
+
+PURPOSE: level1_qa_bit_mask(l1_qa, bit, mask) writes the packed mask of the
+uint16 Level-1 QA values with the specified bit set.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Invalid arguments
+Py_None         Successful
+
+NOTES:
+******************************************************************************/
+static PyObject *py_level1_qa_bit_mask
+(
+    PyObject *self,        /* I: module */
+    PyObject *args         /* I: positional arguments */
+)
+{
+    return py_level1_qa_bits (args, true);
+}
+
+
+/******************************************************************************
+MODULE:  py_level1_qa_field_values
+
+PURPOSE: level1_qa_field_values(l1_qa, bit, values) writes the value (0-3)
+of the two-bit field starting at the specified bit of each of the uint16
+Level-1 QA values.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Invalid arguments
+Py_None         Successful
+
+NOTES:
+******************************************************************************/
+static PyObject *py_level1_qa_field_values
+(
+    PyObject *self,        /* I: module */
+    PyObject *args         /* I: positional arguments */
+)
+{
+    return py_level1_qa_bits (args, false);
+}
+
+
+/******************************************************************************
+MODULE:  py_decode_lasrc_aerosol_values
+
+PURPOSE: decode_lasrc_aerosol_values(l2_qa, level=None, water_mask=None,
+valid_mask=None, interp_mask=None) decodes the uint8 LaSRC aerosol QA values
+into the given outputs and counts them.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Invalid arguments
+dict            Counts of the pixels (npixels, fill, valid, interp, water,
+                level)
+
+NOTES:
+1. level has one value per pixel and the masks are packed, as in
+   level2_qa_aerosol_bulk.h.
+******************************************************************************/
+static PyObject *py_decode_lasrc_aerosol_values
+(
+    PyObject *self,        /* I: module */
+    PyObject *args,        /* I: positional arguments */
+    PyObject *kwargs       /* I: keyword arguments */
+)
+{
+    static char *kwlist[] = {"l2_qa", "level", "water_mask", "valid_mask",
+        "interp_mask", NULL};
+    static const char *names[] = {"level", "water_mask", "valid_mask",
+        "interp_mask"};
+    PyObject *l2_obj = NULL;     /* LaSRC aerosol QA values */
+    PyObject *out_obj[4] = {Py_None, Py_None, Py_None, Py_None};
+                                 /* outputs */
+    Py_buffer l2_view;           /* buffer of the aerosol QA values */
+    Py_buffer out_view[4];       /* buffers of the outputs */
+    uint8_t *out[4] = {NULL, NULL, NULL, NULL};  /* outputs, or NULL */
+    Py_ssize_t npixels;          /* number of pixels */
+    Py_ssize_t nout;             /* required size of the output */
+    int i;                       /* looping variable */
+    Lasrc_aerosol_counts_t counts;  /* counts of the pixels */
+
+    if (!PyArg_ParseTupleAndKeywords (args, kwargs, "O|OOOO", kwlist,
+        &l2_obj, &out_obj[0], &out_obj[1], &out_obj[2], &out_obj[3]))
+        return NULL;
+
+    if (get_qa_buffer (l2_obj, sizeof (uint8_t), false, "l2_qa", &l2_view))
+        return NULL;
+    npixels = buffer_npixels (&l2_view);
+    for (i = 0; i < 4; i++)
+    {
+        if (out_obj[i] == Py_None)
+            continue;
+        if (get_qa_buffer (out_obj[i], sizeof (uint8_t), true, names[i],
+            &out_view[i]))
+            goto fail;
+        out[i] = out_view[i].buf;
+        nout = i == 0 ? npixels : (Py_ssize_t) level2_qa_mask_bytes (npixels);
+        if (out_view[i].len < nout)
+        {
+            PyErr_Format (PyExc_ValueError, "%s must have at least %zd bytes",
+                names[i], nout);
+            i++;
+            goto fail;
+        }
+    }
+
+    memset (&counts, 0, sizeof (counts));
+    Py_BEGIN_ALLOW_THREADS
+    decode_lasrc_aerosol_values (l2_view.buf, npixels, out[0], out[1],
+        out[2], out[3], &counts);
+    Py_END_ALLOW_THREADS
+
+    for (i = 0; i < 4; i++)
+    {
+        if (out[i] != NULL)
+            PyBuffer_Release (&out_view[i]);
+    }
+    PyBuffer_Release (&l2_view);
+
+    return Py_BuildValue ("{s:K,s:K,s:K,s:K,s:K,s:(KKKK)}",
+        "npixels", (unsigned long long) counts.npixels,
+        "fill", (unsigned long long) counts.fill,
+        "valid", (unsigned long long) counts.valid,
+        "interp", (unsigned long long) counts.interp,
+        "water", (unsigned long long) counts.water,
+        "level", (unsigned long long) counts.level[0],
+        (unsigned long long) counts.level[1],
+        (unsigned long long) counts.level[2],
+        (unsigned long long) counts.level[3]);
+
+fail:
+    /* Release the outputs obtained before the failure */
+    while (--i >= 0)
+    {
+        if (out[i] != NULL)
+            PyBuffer_Release (&out_view[i]);
+    }
+    PyBuffer_Release (&l2_view);
+    return NULL;
+}
+
+
+/* Functions of the module */
+static PyMethodDef pixel_qa_methods[] =
+{
+    {"generate_pixel_qa", (PyCFunction) (void (*) (void)) py_generate_pixel_qa,
+        METH_VARARGS | METH_KEYWORDS,
+        "generate_pixel_qa(xml, geotiff=False, overviews=0, bitplanes=False, "
+        "saturation=False)\n\nGenerates the pixel QA band of the scene."},
+    {"translate_level1_qa", py_translate_level1_qa, METH_VARARGS,
+        "translate_level1_qa(l1_qa, qa_category, l2_qa, l1_sat=None)\n\n"
+        "Translates Level-1 QA values to pixel QA values in place."},
+    {"set_pixel_qa_water", py_set_pixel_qa_water, METH_VARARGS,
+        "set_pixel_qa_water(l2_qa_water, water_category, l2_qa)\n\n"
+        "Sets the water bit of the pixel QA values in place."},
+    {"dilate_pixel_qa", py_dilate_pixel_qa, METH_VARARGS,
+        "dilate_pixel_qa(l2_qa, bit, distance, output)\n\n"
+        "Dilates a bit of the 2-D pixel QA array into output."},
+    {"read_level1_qa", py_read_level1_qa, METH_VARARGS,
+        "read_level1_qa(xml) -> (data, nlines, nsamps, qa_category)\n\n"
+        "Reads the Level-1 QA band into a bytearray of uint16 values."},
+    {"read_level2_qa", py_read_level2_qa, METH_VARARGS,
+        "read_level2_qa(xml, qa_category) -> (data, nlines, nsamps)\n\n"
+        "Reads a Level-2 QA band into a bytearray."},
+    {"level1_qa_bit_mask", py_level1_qa_bit_mask, METH_VARARGS,
+        "level1_qa_bit_mask(l1_qa, bit, mask)\n\n"
+        "Writes the packed mask of the Level-1 QA values with the bit set."},
+    {"level1_qa_field_values", py_level1_qa_field_values, METH_VARARGS,
+        "level1_qa_field_values(l1_qa, bit, values)\n\n"
+        "Writes the two-bit field of the Level-1 QA values."},
+    {"decode_lasrc_aerosol_values",
+        (PyCFunction) (void (*) (void)) py_decode_lasrc_aerosol_values,
+        METH_VARARGS | METH_KEYWORDS,
+        "decode_lasrc_aerosol_values(l2_qa, level=None, water_mask=None, "
+        "valid_mask=None, interp_mask=None) -> counts\n\n"
+        "Decodes and counts the LaSRC aerosol QA values."},
+    {NULL, NULL, 0, NULL}
+};
+
+
+/* Definition of the module */
+static struct PyModuleDef pixel_qa_module =
+{
+    PyModuleDef_HEAD_INIT,
+    "_pixel_qa",
+    "In-process access to the pixel QA, Level-1 QA, and Level-2 QA "
+    "functions of the espa-l2qa-tools libraries.",
+    -1,
+    pixel_qa_methods
+};
+
+
+/******************************************************************************
+MODULE:  PyInit__pixel_qa
+
+PURPOSE: Creates the _pixel_qa module and adds the QA category constants.
+
+RETURN VALUE:
+Type = PyObject *
+Value           Description
+-----           -----------
+NULL            Error creating the module
+module          Successful
+
+NOTES:
+******************************************************************************/
+PyMODINIT_FUNC PyInit__pixel_qa (void)
+{
+    PyObject *module = NULL;     /* the module */
+
+    module = PyModule_Create (&pixel_qa_module);
+    if (module == NULL)
+        return NULL;
+
+    if (PyModule_AddIntConstant (module, "LEVEL1_L457", LEVEL1_L457) ||
+        PyModule_AddIntConstant (module, "LEVEL1_L8", LEVEL1_L8) ||
+        PyModule_AddIntConstant (module, "LEVEL1_C2", LEVEL1_C2) ||
+        PyModule_AddIntConstant (module, "LEDAPS_RADSAT", LEDAPS_RADSAT) ||
+        PyModule_AddIntConstant (module, "LEDAPS_CLOUD", LEDAPS_CLOUD) ||
+        PyModule_AddIntConstant (module, "LASRC_AEROSOL", LASRC_AEROSOL) ||
+        PyModule_AddIntConstant (module, "LASRC_RADSAT", LASRC_RADSAT))
+    {
+        Py_DECREF (module);
+        return NULL;
+    }
+
+    return module;
+}
@@ -0,0 +1,218 @@
+/*****************************************************************************
+FILE: pixel_qa_stream.c
+  
+PURPOSE: Contains functions for reading and writing the header of a QA stream.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The stream layout is described in pixel_qa_stream.h.  Once the header
+     has been handled, the strips are read and written with read_raw_binary
+     and write_raw_binary, just as for the raw binary files.
+*****************************************************************************/
+#include "pixel_qa_stream.h"
+
+/******************************************************************************
+MODULE:  put_stream_uint32 (private)
+
+PURPOSE: Stores a 32-bit value as little-endian bytes in the header buffer.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void put_stream_uint32
+(
+    unsigned char *buf,    /* O: location in the header buffer */
+    uint32_t value         /* I: value to be stored */
+)
+{
+    buf[0] = value & 0xff;
+    buf[1] = (value >> 8) & 0xff;
+    buf[2] = (value >> 16) & 0xff;
+    buf[3] = (value >> 24) & 0xff;
+}
+
+
+/******************************************************************************
+MODULE:  get_stream_uint32 (private)
+
+PURPOSE: Obtains a 32-bit value from little-endian bytes in the header buffer.
+
+RETURN VALUE:
+Type = uint32_t
+Value           Description
+-----           -----------
+value           Value stored at this location of the header
+
+NOTES:
+******************************************************************************/
+static uint32_t get_stream_uint32
+(
+    unsigned char *buf     /* I: location in the header buffer */
+)
+{
+    return ((uint32_t) buf[0] | ((uint32_t) buf[1] << 8) |
+            ((uint32_t) buf[2] << 16) | ((uint32_t) buf[3] << 24));
+}
+
+
+/******************************************************************************
+MODULE:  qa_stream_data_size
+
+PURPOSE: Returns the number of bytes per pixel for the data in the stream.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1              Data type is not supported in a QA stream
+1, 2            Number of bytes per pixel
+
+NOTES:
+******************************************************************************/
+int qa_stream_data_size
+(
+    Qa_stream_header_t *header  /* I: stream header */
+)
+{
+    switch (header->data_type)
+    {
+        case ESPA_UINT8:
+            return (sizeof (uint8_t));
+
+        case ESPA_UINT16:
+            return (sizeof (uint16_t));
+
+        default:
+            return (-1);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  write_qa_stream_header
+
+PURPOSE: Writes the QA stream header, which must come before any of the band
+data in the stream.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the stream header
+SUCCESS         Successfully written
+
+NOTES:
+******************************************************************************/
+int write_qa_stream_header
+(
+    FILE *fp_stream,            /* I: stream open for writing */
+    Qa_stream_header_t *header  /* I: stream header to be written */
+)
+{
+    char FUNC_NAME[] = "write_qa_stream_header";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    unsigned char buf[QA_STREAM_HEADER_LEN];  /* header as written */
+
+    if (header->nlines <= 0 || header->nsamps <= 0 ||
+        header->strip_lines <= 0 || qa_stream_data_size (header) < 0)
+    {
+        sprintf (errmsg, "Invalid QA stream header: %d lines, %d samples, "
+            "data type %d, %d lines per strip", header->nlines,
+            header->nsamps, header->data_type, header->strip_lines);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    memcpy (buf, QA_STREAM_MAGIC, QA_STREAM_MAGIC_LEN);
+    put_stream_uint32 (&buf[8], QA_STREAM_VERSION);
+    put_stream_uint32 (&buf[12], header->nlines);
+    put_stream_uint32 (&buf[16], header->nsamps);
+    put_stream_uint32 (&buf[20], header->data_type);
+    put_stream_uint32 (&buf[24], header->strip_lines);
+
+    if (fwrite (buf, 1, QA_STREAM_HEADER_LEN, fp_stream) !=
+        QA_STREAM_HEADER_LEN)
+    {
+        sprintf (errmsg, "Writing the QA stream header");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Successful write */
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  read_qa_stream_header
+
+PURPOSE: Reads and validates the QA stream header from the start of the
+stream.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the stream header, or it is not a QA stream
+SUCCESS         Successfully read
+
+NOTES:
+******************************************************************************/
+int read_qa_stream_header
+(
+    FILE *fp_stream,            /* I: stream open for reading */
+    Qa_stream_header_t *header  /* O: stream header read from the stream */
+)
+{
+    char FUNC_NAME[] = "read_qa_stream_header";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    unsigned char buf[QA_STREAM_HEADER_LEN];  /* header as read */
+    uint32_t version;         /* stream format version */
+
+    if (fread (buf, 1, QA_STREAM_HEADER_LEN, fp_stream) !=
+        QA_STREAM_HEADER_LEN)
+    {
+        sprintf (errmsg, "Reading the QA stream header");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    if (memcmp (buf, QA_STREAM_MAGIC, QA_STREAM_MAGIC_LEN))
+    {
+        sprintf (errmsg, "Input is not a QA stream");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    version = get_stream_uint32 (&buf[8]);
+    if (version != QA_STREAM_VERSION)
+    {
+        sprintf (errmsg, "Unsupported QA stream version %u (expecting %d)",
+            version, QA_STREAM_VERSION);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    header->nlines = get_stream_uint32 (&buf[12]);
+    header->nsamps = get_stream_uint32 (&buf[16]);
+    header->data_type = get_stream_uint32 (&buf[20]);
+    header->strip_lines = get_stream_uint32 (&buf[24]);
+    if (header->nlines <= 0 || header->nsamps <= 0 ||
+        header->strip_lines <= 0 || qa_stream_data_size (header) < 0)
+    {
+        sprintf (errmsg, "Invalid QA stream header: %d lines, %d samples, "
+            "data type %d, %d lines per strip", header->nlines,
+            header->nsamps, header->data_type, header->strip_lines);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Successful read */
+    return (SUCCESS);
+}
@@ -0,0 +1,72 @@
+/*****************************************************************************
+FILE: pixel_qa_stream.h
+  
+PURPOSE: Contains defines and function prototypes for passing QA bands between
+the QA tools as a stream (i.e. through a pipe) rather than as raw binary files.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. A QA stream is a fixed-size header followed by the band data in line-major
+   order, written as consecutive strips of up to strip_lines lines.  The
+   header is:
+       bytes  0-7   magic string "L2QASTRM"
+       bytes  8-11  stream format version
+       bytes 12-15  number of lines
+       bytes 16-19  number of samples
+       bytes 20-23  data type of the band (Espa_data_type; UINT8 or UINT16)
+       bytes 24-27  number of lines per strip
+   The header values are unsigned 32-bit little-endian integers.  The band
+   data is in the native byte order, the same as the raw binary files.
+*****************************************************************************/
+
+#ifndef PIXEL_QA_STREAM_H
+#define PIXEL_QA_STREAM_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "error_handler.h"
+#include "espa_metadata.h"
+#include "raw_binary_io.h"
+
+/* Defines */
+#define QA_STREAM_MAGIC "L2QASTRM"    /* identifies the start of a stream */
+#define QA_STREAM_MAGIC_LEN 8         /* length of the magic string */
+#define QA_STREAM_VERSION 1           /* current stream format version */
+#define QA_STREAM_HEADER_LEN 28       /* size of the stream header in bytes */
+#define QA_STREAM_STRIP_LINES 64      /* default number of lines per strip */
+
+/* Data types */
+typedef struct
+{
+    int nlines;                 /* number of lines in the band */
+    int nsamps;                 /* number of samples in the band */
+    Espa_data_type data_type;   /* data type of the band (UINT8 or UINT16) */
+    int strip_lines;            /* number of lines in each strip; the last
+                                   strip may be shorter */
+} Qa_stream_header_t;
+
+/* Function prototypes */
+int write_qa_stream_header
+(
+    FILE *fp_stream,            /* I: stream open for writing */
+    Qa_stream_header_t *header  /* I: stream header to be written */
+);
+
+int read_qa_stream_header
+(
+    FILE *fp_stream,            /* I: stream open for reading */
+    Qa_stream_header_t *header  /* O: stream header read from the stream */
+);
+
+int qa_stream_data_size
+(
+    Qa_stream_header_t *header  /* I: stream header */
+);
+
+#endif
@@ -15,29 +15,28 @@ NOTES:
      http://espa.cr.usgs.gov/schema/espa_internal_metadata_vx_x.xsd.
 *****************************************************************************/
 #include "read_pixel_qa.h"
+#include "l2qa_timing.h"
 
 
 /******************************************************************************
-MODULE:  open_pixel_qa
+MODULE:  find_pixel_qa
 
-PURPOSE: Opens the ESPA XML file and opens the pixel QA band for read and
-update.  The XML and pixel QA files must exist.
+PURPOSE: Reads the ESPA XML file and obtains the filename and size of the
+pixel QA band.  The pixel QA file itself doesn't need to exist.
 
 RETURN VALUE:
-Type = FILE *
+Type = int
 Value           Description
 -----           -----------
-NULL            Error parsing the XML file or opening the pixel QA band
-not NULL        Successfully read
+ERROR           Error parsing the XML file or finding the pixel QA band
+SUCCESS         Successfully found
 
 NOTES:
 1. It is expected that this QA band will be an unsigned 16-bit integer. If the
    data type does not match that expectation, then an error will be flagged
    when obtaining information about the QA band from the XML file.
-2. A file pointer to the pixel QA band will be returned. It is expected the
-   calling routine will handle closing this file pointer when complete.
 ******************************************************************************/
-FILE *open_pixel_qa
+int find_pixel_qa
 (
     char *espa_xml_file,   /* I: input ESPA XML filename */
     char *l2_qa_file,      /* O: output pixel filename (memory must be
@@ -46,22 +45,23 @@ FILE *open_pixel_qa
     int *nsamps            /* O: number of samples in the QA band */
 )
 {
-    char FUNC_NAME[] = "open_pixel_qa";  /* function name */
+    char FUNC_NAME[] = "find_pixel_qa";  /* function name */
     char errmsg[STR_SIZE];    /* error message */
-    char curr_band[STR_SIZE]; /* current band to process */
+    L2qa_timer_t timer;       /* start time of the timed phase */
     int i;                    /* looping variable */
     bool found;               /* was the pixel QA band found? */
     Espa_internal_meta_t xml_metadata;  /* XML metadata structure to be
                                  populated by reading the XML metadata file */
-    Espa_global_meta_t *gmeta;/* pointer to the global metadata structure */
     Espa_band_meta_t *bmeta;  /* pointer to the array of bands metadata */
-    FILE *fp_bqa = NULL;      /* file pointer for the QA band */
 
     /* Validate the input metadata file */
+    l2qa_timer_start (&timer);
     if (validate_xml_file (espa_xml_file) != SUCCESS)
     {  /* Error messages already written */
-        return (NULL);
+        return (ERROR);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_VALIDATE_XML,
+        l2qa_timing_file_size (espa_xml_file), 0);
 
     /* Initialize the metadata structure */
     init_metadata_struct (&xml_metadata);
@@ -69,11 +69,13 @@ FILE *open_pixel_qa
     /* Parse the metadata file into our internal metadata structure; also
        allocates space as needed for various pointers in the global and band
        metadata */
+    l2qa_timer_start (&timer);
     if (parse_metadata (espa_xml_file, &xml_metadata) != SUCCESS)
     {  /* Error messages already written */
-        return (NULL);
+        return (ERROR);
     }
-    gmeta = &xml_metadata.global;
+    l2qa_timer_stop (&timer, L2QA_PHASE_PARSE_METADATA,
+        l2qa_timing_file_size (espa_xml_file), 0);
     bmeta = xml_metadata.band;
 
     /* Loop through the bands and look for the pixel QA band */
@@ -81,7 +83,6 @@ FILE *open_pixel_qa
     for (i = 0; i < xml_metadata.nbands; i++)
     {
         /* Is this the pixel quality band */
-        sprintf (curr_band, "qa");
         if (!strcmp (bmeta[i].name, "pixel_qa") &&
             !strcmp (bmeta[i].category, "qa"))
         {
@@ -94,17 +95,64 @@ FILE *open_pixel_qa
                     "band, however the data type was something other than "
                     "UINT16. Please check the input XML file.");
                 error_handler (true, FUNC_NAME, errmsg);
-                return (NULL);
+                return (ERROR);
             }
             found = true;
         }
     }
 
+    /* Free the metadata structure */
+    free_metadata (&xml_metadata);
+
     /* Make sure the pixel QA band was found */
     if (!found)
     {
         sprintf (errmsg, "Unable to find the pixel QA band");
         error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Successfully found the pixel QA band */
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  open_pixel_qa
+
+PURPOSE: Opens the ESPA XML file and opens the pixel QA band for read and
+update.  The XML and pixel QA files must exist.
+
+RETURN VALUE:
+Type = FILE *
+Value           Description
+-----           -----------
+NULL            Error parsing the XML file or opening the pixel QA band
+not NULL        Successfully read
+
+NOTES:
+1. It is expected that this QA band will be an unsigned 16-bit integer. If the
+   data type does not match that expectation, then an error will be flagged
+   when obtaining information about the QA band from the XML file.
+2. A file pointer to the pixel QA band will be returned. It is expected the
+   calling routine will handle closing this file pointer when complete.
+******************************************************************************/
+FILE *open_pixel_qa
+(
+    char *espa_xml_file,   /* I: input ESPA XML filename */
+    char *l2_qa_file,      /* O: output pixel filename (memory must be
+                                 allocated ahead of time) */
+    int *nlines,           /* O: number of lines in the QA band */
+    int *nsamps            /* O: number of samples in the QA band */
+)
+{
+    char FUNC_NAME[] = "open_pixel_qa";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    FILE *fp_bqa = NULL;      /* file pointer for the QA band */
+
+    /* Find the pixel QA band in the XML file */
+    if (find_pixel_qa (espa_xml_file, l2_qa_file, nlines, nsamps) != SUCCESS)
+    {  /* Error messages already written */
         return (NULL);
     }
 
@@ -117,9 +165,6 @@ FILE *open_pixel_qa
         return (NULL);
     }
 
-    /* Free the metadata structure */
-    free_metadata (&xml_metadata);
-
     /* Successfully opened the pixel QA band */
     return (fp_bqa);
 }
@@ -153,8 +198,10 @@ int read_pixel_qa
 {
     char FUNC_NAME[] = "read_pixel_qa";  /* function name */
     char errmsg[STR_SIZE];    /* error message */
+    L2qa_timer_t timer;       /* start time of the read */
 
     /* Read the current line from the pixel QA band */
+    l2qa_timer_start (&timer);
     if (read_raw_binary (fp_bqa, nlines, nsamps, sizeof (uint16_t), pixel_qa)
         != SUCCESS)
     {   
@@ -162,6 +209,9 @@ int read_pixel_qa
         error_handler (true, FUNC_NAME, errmsg);
         return (ERROR);
     }
+    l2qa_timer_stop (&timer, L2QA_PHASE_READ,
+        (long long) nlines * nsamps * sizeof (uint16_t),
+        (long long) nlines * nsamps);
 
     /* Successful read */
     return (SUCCESS);
@@ -25,6 +25,14 @@ NOTES:
 #include "pixel_qa.h"
 
 /* Function prototypes */
+int find_pixel_qa
+(
+    char *espa_xml_file,   /* I: input ESPA XML filename */
+    char *l2_qa_file,      /* O: output pixel QA filename */
+    int *nlines,           /* O: number of lines in the QA band */
+    int *nsamps            /* O: number of samples in the QA band */
+);
+
 FILE *open_pixel_qa
 (
     char *espa_xml_file,   /* I: input ESPA XML filename */
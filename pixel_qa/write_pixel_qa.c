@@ -14,6 +14,10 @@ NOTES:
      the ESPA internal metadata format is available at
      http://espa.cr.usgs.gov/schema/espa_internal_metadata_vx_x.xsd.
 *****************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "write_pixel_qa.h"
 
 /******************************************************************************
@@ -95,6 +99,242 @@ int write_pixel_qa
 }
 
 
+/******************************************************************************
+MODULE:  pwrite_all
+
+PURPOSE: Writes the buffer at the file offset, picking up where a partial
+write left off.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the buffer
+SUCCESS         Successfully written
+
+NOTES:
+1. pwrite is retried when interrupted by a signal.  The file position of fd
+   is neither used nor changed.
+******************************************************************************/
+int pwrite_all
+(
+    int fd,                 /* I: file descriptor open for writing */
+    const void *buf,        /* I: buffer to be written */
+    size_t nbytes,          /* I: number of bytes to write */
+    off_t offset            /* I: file offset to write to */
+)
+{
+    const char *next = buf;   /* next byte to be written */
+    ssize_t nwritten;         /* number of bytes written by pwrite */
+
+    while (nbytes > 0)
+    {
+        nwritten = pwrite (fd, next, nbytes, offset);
+        if (nwritten < 0 && errno == EINTR)
+            continue;
+        if (nwritten <= 0)
+            return (ERROR);
+        next += nwritten;
+        nbytes -= nwritten;
+        offset += nwritten;
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_pixel_qa_lines
+
+PURPOSE: Rewrites the specified lines of an existing pixel QA band in place,
+without changing the rest of the band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the pixel QA
+SUCCESS         Successfully written
+
+NOTES:
+1. The band must be open for update (i.e. via open_pixel_qa).  The lines are
+   written with a positioned write at start_line, so the current position of
+   the file pointer is neither used nor changed.
+******************************************************************************/
+int write_pixel_qa_lines
+(
+    FILE *fp_bqa,           /* I: pointer to pixel QA band open for update */
+    int start_line,         /* I: first line to be rewritten in the QA file */
+    int nlines,             /* I: number of lines to write to the QA file */
+    int nsamps,             /* I: number of samples to write to the QA file */
+    uint16_t *pixel_qa      /* I: pixel QA band values for the specified
+                                  number of lines */
+)
+{
+    char FUNC_NAME[] = "write_pixel_qa_lines";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    size_t nbytes;            /* number of bytes to write */
+    off_t offset;             /* file offset of the first line */
+
+    nbytes = (size_t) nlines * nsamps * sizeof (uint16_t);
+    offset = (off_t) start_line * nsamps * sizeof (uint16_t);
+
+    /* Write the current line(s) to the pixel QA band */
+    if (pwrite_all (fileno (fp_bqa), pixel_qa, nbytes, offset) != SUCCESS)
+    {
+        sprintf (errmsg, "Writing %d line(s) starting at line %d to the "
+            "pixel QA band", nlines, start_line);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Successful write */
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  create_mapped_pixel_qa
+
+PURPOSE: Creates the pixel QA band at its final size and maps it into memory
+for writing, so the pixel QA values can be generated directly into the file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error creating or mapping the pixel QA band
+SUCCESS         Successfully created and mapped
+
+NOTES:
+1. The file is truncated and then sized to nlines x nsamps x 2 bytes.  The
+   disk blocks are reserved up front with posix_fallocate so an out-of-space
+   condition is reported here, rather than as a fault while writing through
+   the mapping.  File systems which don't support preallocation fall back to
+   the (sparse) ftruncate size.
+2. The contents of the mapping are zero upon return.  The calling routine is
+   responsible for calling close_mapped_pixel_qa when complete.
+******************************************************************************/
+int create_mapped_pixel_qa
+(
+    char *l2_qa_file,       /* I: pixel QA filename to be created */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    Pixel_qa_map_t *qa_map  /* O: mapping of the pixel QA band */
+)
+{
+    char FUNC_NAME[] = "create_mapped_pixel_qa";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int status;               /* return status from posix_fallocate */
+    void *addr = NULL;        /* address of the mapping */
+
+    qa_map->fd = -1;
+    qa_map->pixel_qa = NULL;
+    qa_map->nbytes = (size_t) nlines * nsamps * sizeof (uint16_t);
+    if (nlines <= 0 || nsamps <= 0)
+    {
+        sprintf (errmsg, "Invalid pixel QA size: %d lines x %d samples",
+            nlines, nsamps);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Create the pixel QA band for read and write */
+    qa_map->fd = open (l2_qa_file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (qa_map->fd < 0)
+    {
+        sprintf (errmsg, "Creating the pixel QA file: %s", l2_qa_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Size the file and reserve the blocks for the entire band */
+    if (ftruncate (qa_map->fd, (off_t) qa_map->nbytes) != 0)
+    {
+        sprintf (errmsg, "Sizing the pixel QA file to %zu bytes: %s",
+            qa_map->nbytes, l2_qa_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        close (qa_map->fd);
+        qa_map->fd = -1;
+        return (ERROR);
+    }
+
+    status = posix_fallocate (qa_map->fd, 0, (off_t) qa_map->nbytes);
+    if (status != 0 && status != EOPNOTSUPP && status != EINVAL)
+    {
+        sprintf (errmsg, "Preallocating %zu bytes for the pixel QA file: %s",
+            qa_map->nbytes, l2_qa_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        close (qa_map->fd);
+        qa_map->fd = -1;
+        return (ERROR);
+    }
+
+    /* Map the band so it can be written in place */
+    addr = mmap (NULL, qa_map->nbytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+        qa_map->fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        sprintf (errmsg, "Mapping the pixel QA file: %s", l2_qa_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        close (qa_map->fd);
+        qa_map->fd = -1;
+        return (ERROR);
+    }
+    qa_map->pixel_qa = addr;
+
+    /* Successfully created and mapped the pixel QA band */
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  close_mapped_pixel_qa
+
+PURPOSE: Unmaps and closes the pixel QA band created by create_mapped_pixel_qa.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error unmapping or closing the pixel QA band
+SUCCESS         Successfully closed
+
+NOTES:
+1. The modified pages are written back by the kernel; as with fclose, the
+   data isn't forced to disk.
+******************************************************************************/
+int close_mapped_pixel_qa
+(
+    Pixel_qa_map_t *qa_map  /* I/O: mapping of the pixel QA band; will be
+                                    unmapped and closed upon return */
+)
+{
+    char FUNC_NAME[] = "close_mapped_pixel_qa";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int status = SUCCESS;     /* return status */
+
+    if (qa_map->pixel_qa != NULL &&
+        munmap (qa_map->pixel_qa, qa_map->nbytes) != 0)
+    {
+        sprintf (errmsg, "Unmapping the pixel QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+    qa_map->pixel_qa = NULL;
+
+    if (qa_map->fd >= 0 && close (qa_map->fd) != 0)
+    {
+        sprintf (errmsg, "Closing the pixel QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+    qa_map->fd = -1;
+
+    return (status);
+}
+
+
 /******************************************************************************
 MODULE:  close_pixel_qa
 
@@ -0,0 +1,1148 @@
+/*****************************************************************************
+FILE: write_pixel_qa_geotiff.c
+  
+PURPOSE: Contains functions for writing the Level-2 pixel QA band as a tiled
+GeoTIFF, with optional internal overviews.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. Lines are passed to the writer in order, top to bottom.  Tiles are
+     written as soon as a full row of tiles has been received, so only
+     GEOTIFF_TILE_SIZE lines of each resolution level are held in memory.
+  2. Overview levels are built in the same pass.  Each overview pixel is the
+     bitwise OR of the 2x2 block of pixels in the level above it, so a QA bit
+     set anywhere in the block remains set in the overview.
+  3. The image file directories (IFDs) are written after all the tiles, once
+     the tile offsets are known.  The first IFD is the full resolution band
+     and carries the georeferencing; the following IFDs are the overviews
+     (NewSubfileType = reduced resolution), which is how GDAL and most GIS
+     packages recognize internal overviews.
+  4. The georeferencing is built when the GeoTIFF is created, so an
+     unsupported projection is reported before any tiles are written, and a
+     GeoTIFF which can't be finished is removed rather than left behind.
+*****************************************************************************/
+#include <limits.h>
+#include <unistd.h>
+#include "write_pixel_qa_geotiff.h"
+
+/* TIFF field types */
+#define TIFF_ASCII 2
+#define TIFF_SHORT 3
+#define TIFF_LONG 4
+#define TIFF_DOUBLE 12
+
+/* TIFF tags written */
+#define TAG_NEW_SUBFILE_TYPE 254
+#define TAG_IMAGE_WIDTH 256
+#define TAG_IMAGE_LENGTH 257
+#define TAG_BITS_PER_SAMPLE 258
+#define TAG_COMPRESSION 259
+#define TAG_PHOTOMETRIC 262
+#define TAG_SAMPLES_PER_PIXEL 277
+#define TAG_PLANAR_CONFIG 284
+#define TAG_TILE_WIDTH 322
+#define TAG_TILE_LENGTH 323
+#define TAG_TILE_OFFSETS 324
+#define TAG_TILE_BYTE_COUNTS 325
+#define TAG_SAMPLE_FORMAT 339
+#define TAG_MODEL_PIXEL_SCALE 33550
+#define TAG_MODEL_TIEPOINT 33922
+#define TAG_GEO_KEY_DIRECTORY 34735
+#define TAG_GEO_DOUBLE_PARAMS 34736
+#define TAG_GDAL_NODATA 42113
+
+/* GeoKeys written */
+#define GT_MODEL_TYPE_KEY 1024
+#define GT_RASTER_TYPE_KEY 1025
+#define GEOGRAPHIC_TYPE_KEY 2048
+#define GEOG_ANGULAR_UNITS_KEY 2054
+#define PROJECTED_CS_TYPE_KEY 3072
+#define PROJECTION_KEY 3074
+#define PROJ_COORD_TRANS_KEY 3075
+#define PROJ_LINEAR_UNITS_KEY 3076
+#define PROJ_STD_PARALLEL1_KEY 3078
+#define PROJ_STD_PARALLEL2_KEY 3079
+#define PROJ_NAT_ORIGIN_LONG_KEY 3080
+#define PROJ_NAT_ORIGIN_LAT_KEY 3081
+#define PROJ_FALSE_EASTING_KEY 3082
+#define PROJ_FALSE_NORTHING_KEY 3083
+#define PROJ_SCALE_AT_NAT_ORIGIN_KEY 3092
+#define PROJ_STRAIGHT_VERT_POLE_LONG_KEY 3095
+
+/* GeoKey values */
+#define MODEL_TYPE_PROJECTED 1
+#define MODEL_TYPE_GEOGRAPHIC 2
+#define RASTER_PIXEL_IS_AREA 1
+#define USER_DEFINED 32767
+#define CT_ALBERS_EQUAL_AREA 11
+#define CT_POLAR_STEREOGRAPHIC 15
+#define LINEAR_METER 9001
+#define ANGULAR_DEGREE 9102
+
+#define MAX_IFD_ENTRIES 20
+
+/* Directory entry, with its value either inline or in the extra data which
+   follows the directory */
+typedef struct
+{
+    uint16_t tag;             /* TIFF tag */
+    uint16_t type;            /* TIFF field type */
+    uint32_t count;           /* number of values */
+    uint8_t inline_value[4];  /* value, if it fits in four bytes */
+    size_t extra_pos;         /* position of the value in the extra data */
+} Tiff_entry_t;
+
+typedef struct
+{
+    int nentries;                         /* number of entries */
+    Tiff_entry_t entry[MAX_IFD_ENTRIES];  /* entries, in ascending tag order */
+    uint8_t *extra;                       /* values too large to be inline */
+    size_t extra_size;                    /* bytes used in extra */
+} Tiff_ifd_t;
+
+typedef struct
+{
+    uint16_t key;             /* GeoKey ID */
+    uint16_t location;        /* 0 for a SHORT value, otherwise the tag
+                                 holding the value */
+    uint16_t value;           /* SHORT value or index into the doubles */
+} Geo_key_t;
+
+
+/******************************************************************************
+MODULE:  type_size
+
+PURPOSE: Returns the size in bytes of a single value of the TIFF field type.
+******************************************************************************/
+static size_t type_size
+(
+    uint16_t type           /* I: TIFF field type */
+)
+{
+    switch (type)
+    {
+        case TIFF_SHORT:
+            return (2);
+        case TIFF_LONG:
+            return (4);
+        case TIFF_DOUBLE:
+            return (8);
+        default:
+            return (1);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  add_ifd_entry
+
+PURPOSE: Adds an entry to the image file directory.  Values which don't fit
+in the entry itself are appended to the extra data of the directory.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error allocating memory for the extra data
+SUCCESS         Successfully added
+
+NOTES:
+1. Entries must be added in ascending tag order, as TIFF requires.
+******************************************************************************/
+static int add_ifd_entry
+(
+    Tiff_ifd_t *ifd,        /* I/O: image file directory */
+    uint16_t tag,           /* I: TIFF tag */
+    uint16_t type,          /* I: TIFF field type */
+    uint32_t count,         /* I: number of values */
+    const void *values      /* I: values in native byte order */
+)
+{
+    char FUNC_NAME[] = "add_ifd_entry";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    Tiff_entry_t *entry = &ifd->entry[ifd->nentries];  /* new entry */
+    size_t nbytes = count * type_size (type);  /* size of the values */
+    uint8_t *extra = NULL;    /* reallocated extra data */
+
+    entry->tag = tag;
+    entry->type = type;
+    entry->count = count;
+    memset (entry->inline_value, 0, sizeof (entry->inline_value));
+    if (nbytes <= sizeof (entry->inline_value))
+        memcpy (entry->inline_value, values, nbytes);
+    else
+    {
+        /* Keep the extra values word aligned, as TIFF requires */
+        extra = realloc (ifd->extra, ifd->extra_size + nbytes + 1);
+        if (extra == NULL)
+        {
+            sprintf (errmsg, "Allocating memory for TIFF tag %d", tag);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        ifd->extra = extra;
+        entry->extra_pos = ifd->extra_size;
+        memcpy (&ifd->extra[ifd->extra_size], values, nbytes);
+        ifd->extra_size += nbytes;
+        if (ifd->extra_size % 2 != 0)
+            ifd->extra[ifd->extra_size++] = 0;
+    }
+
+    ifd->nentries++;
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_ifd
+
+PURPOSE: Writes the image file directory and its extra data at the specified
+offset of the GeoTIFF.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the directory
+SUCCESS         Successfully written
+
+NOTES:
+1. The file is expected to be positioned at ifd_offset.
+******************************************************************************/
+static int write_ifd
+(
+    FILE *fp,               /* I: GeoTIFF file open for writing */
+    Tiff_ifd_t *ifd,        /* I: image file directory */
+    uint32_t ifd_offset,    /* I: file offset of the directory */
+    uint32_t next_offset    /* I: file offset of the next directory; 0 if
+                                  this is the last one */
+)
+{
+    char FUNC_NAME[] = "write_ifd";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int i;                    /* looping variable */
+    uint16_t nentries = ifd->nentries;  /* number of entries */
+    uint32_t extra_offset;    /* file offset of the extra data */
+    uint32_t value_offset;    /* file offset of an entry's values */
+    Tiff_entry_t *entry = NULL;  /* current entry */
+
+    extra_offset = ifd_offset + 2 + 12 * nentries + 4;
+    if (fwrite (&nentries, sizeof (nentries), 1, fp) != 1)
+    {
+        sprintf (errmsg, "Writing the TIFF directory");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    for (i = 0; i < nentries; i++)
+    {
+        entry = &ifd->entry[i];
+        if (fwrite (&entry->tag, sizeof (entry->tag), 1, fp) != 1 ||
+            fwrite (&entry->type, sizeof (entry->type), 1, fp) != 1 ||
+            fwrite (&entry->count, sizeof (entry->count), 1, fp) != 1)
+        {
+            sprintf (errmsg, "Writing TIFF tag %d", entry->tag);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (entry->count * type_size (entry->type) <=
+            sizeof (entry->inline_value))
+        {
+            if (fwrite (entry->inline_value, sizeof (entry->inline_value), 1,
+                fp) != 1)
+            {
+                sprintf (errmsg, "Writing TIFF tag %d", entry->tag);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+        }
+        else
+        {
+            value_offset = extra_offset + entry->extra_pos;
+            if (fwrite (&value_offset, sizeof (value_offset), 1, fp) != 1)
+            {
+                sprintf (errmsg, "Writing TIFF tag %d", entry->tag);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+        }
+    }
+
+    if (fwrite (&next_offset, sizeof (next_offset), 1, fp) != 1 ||
+        (ifd->extra_size > 0 &&
+         fwrite (ifd->extra, ifd->extra_size, 1, fp) != 1))
+    {
+        sprintf (errmsg, "Writing the TIFF directory");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  add_geo_key
+
+PURPOSE: Adds a SHORT or DOUBLE valued GeoKey to the list of GeoKeys.
+
+RETURN VALUE: None
+
+NOTES:
+1. Double values are appended to the GeoDoubleParams values.
+******************************************************************************/
+static void add_geo_key
+(
+    Geo_key_t *keys,        /* I/O: GeoKeys */
+    int *nkeys,             /* I/O: number of GeoKeys */
+    double *doubles,        /* I/O: GeoDoubleParams values */
+    int *ndoubles,          /* I/O: number of GeoDoubleParams values */
+    uint16_t key,           /* I: GeoKey ID */
+    bool is_double,         /* I: is the value a DOUBLE? */
+    double value            /* I: GeoKey value */
+)
+{
+    keys[*nkeys].key = key;
+    if (is_double)
+    {
+        keys[*nkeys].location = TAG_GEO_DOUBLE_PARAMS;
+        keys[*nkeys].value = *ndoubles;
+        doubles[(*ndoubles)++] = value;
+    }
+    else
+    {
+        keys[*nkeys].location = 0;
+        keys[*nkeys].value = (uint16_t) value;
+    }
+    (*nkeys)++;
+}
+
+
+/******************************************************************************
+MODULE:  compare_geo_keys
+
+PURPOSE: qsort comparison of GeoKeys by ID.
+******************************************************************************/
+static int compare_geo_keys
+(
+    const void *a,          /* I: first GeoKey */
+    const void *b           /* I: second GeoKey */
+)
+{
+    return ((int) ((const Geo_key_t *) a)->key -
+            (int) ((const Geo_key_t *) b)->key);
+}
+
+
+/******************************************************************************
+MODULE:  build_georeferencing
+
+PURPOSE: Builds the values of the georeferencing tags for the full resolution
+band from the projection information.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Unsupported projection, datum, or UTM zone
+SUCCESS         Successfully built
+
+NOTES:
+1. UTM and geographic scenes on the WGS84, NAD83, and NAD27 datums are
+   written with their EPSG codes.  The NAD83 and NAD27 UTM codes only cover
+   the zones of North America (NAD83 zones 1-23 as 26901-26923, NAD27 zones
+   1-22 as 26701-26722, and both datums' zones 59 and 60 with their own
+   codes), so other zones on those datums are an error rather than another
+   coordinate system.  Albers Equal Area and Polar Stereographic
+   scenes are written as user-defined projections on the scene datum.
+2. The ESPA corner coordinates refer to the center of the pixel when the grid
+   origin is CENTER.  GeoTIFF tiepoints are written for the outer corner of
+   the upper left pixel (PixelIsArea).
+******************************************************************************/
+static int build_georeferencing
+(
+    Espa_proj_meta_t *proj,   /* I: projection information */
+    double pixel_size[2],     /* I: pixel size (x, y) of the band */
+    Geotiff_georef_t *georef  /* O: values of the georeferencing tags */
+)
+{
+    char FUNC_NAME[] = "build_georeferencing";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int i;                    /* looping variable */
+    int nkeys = 0;            /* number of GeoKeys */
+    int ndoubles = 0;         /* number of GeoDoubleParams values */
+    int gcs;                  /* EPSG geographic coordinate system */
+    int utm_base;             /* EPSG code of UTM zone 0 for the datum */
+    int utm_max_zone;         /* last zone numbered from utm_base */
+    int utm_zone59;           /* EPSG code of UTM zone 59 (0 if none) */
+    int utm_code = 0;         /* EPSG code of the UTM zone */
+    int zone;                 /* UTM zone number */
+    uint16_t *key_directory = georef->key_directory;  /* GeoKeyDirectory */
+    double *doubles = georef->doubles;  /* GeoDoubleParams values */
+    double *scale = georef->scale;  /* ModelPixelScale values */
+    double *tiepoint = georef->tiepoint;  /* ModelTiepoint values */
+    Geo_key_t keys[GEOTIFF_MAX_GEO_KEYS];  /* GeoKeys */
+
+    memset (georef, 0, sizeof (Geotiff_georef_t));
+
+    /* Determine the geographic coordinate system of the datum */
+    switch (proj->datum_type)
+    {
+        case ESPA_WGS84:
+            gcs = 4326;
+            utm_base = (proj->utm_zone < 0) ? 32700 : 32600;
+            utm_max_zone = 60;
+            utm_zone59 = 0;
+            break;
+        case ESPA_NAD83:
+            gcs = 4269;
+            utm_base = 26900;
+            utm_max_zone = 23;
+            utm_zone59 = 3372;   /* NAD83 / UTM zone 59N; 60N is 3373 */
+            break;
+        case ESPA_NAD27:
+            gcs = 4267;
+            utm_base = 26700;
+            utm_max_zone = 22;
+            utm_zone59 = 3370;   /* NAD27 / UTM zone 59N; 60N is 3371 */
+            break;
+        default:
+            sprintf (errmsg, "Unsupported datum for the GeoTIFF: %d",
+                proj->datum_type);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+    }
+
+    add_geo_key (keys, &nkeys, doubles, &ndoubles, GT_RASTER_TYPE_KEY, false,
+        RASTER_PIXEL_IS_AREA);
+    switch (proj->proj_type)
+    {
+        case GCTP_GEO_PROJ:
+            add_geo_key (keys, &nkeys, doubles, &ndoubles, GT_MODEL_TYPE_KEY,
+                false, MODEL_TYPE_GEOGRAPHIC);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                GEOGRAPHIC_TYPE_KEY, false, gcs);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                GEOG_ANGULAR_UNITS_KEY, false, ANGULAR_DEGREE);
+            break;
+
+        case GCTP_UTM_PROJ:
+            /* Only WGS84 has southern hemisphere zones */
+            zone = abs (proj->utm_zone);
+            if (proj->utm_zone > 0 || proj->datum_type == ESPA_WGS84)
+            {
+                if (zone >= 1 && zone <= utm_max_zone)
+                    utm_code = utm_base + zone;
+                else if (utm_zone59 != 0 && (zone == 59 || zone == 60))
+                    utm_code = utm_zone59 + (zone - 59);
+            }
+            if (utm_code == 0)
+            {
+                sprintf (errmsg, "Unsupported UTM zone for the GeoTIFF: %d",
+                    proj->utm_zone);
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+            add_geo_key (keys, &nkeys, doubles, &ndoubles, GT_MODEL_TYPE_KEY,
+                false, MODEL_TYPE_PROJECTED);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                PROJECTED_CS_TYPE_KEY, false, utm_code);
+            break;
+
+        case GCTP_ALBERS_PROJ:
+        case GCTP_PS_PROJ:
+            add_geo_key (keys, &nkeys, doubles, &ndoubles, GT_MODEL_TYPE_KEY,
+                false, MODEL_TYPE_PROJECTED);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                GEOGRAPHIC_TYPE_KEY, false, gcs);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                PROJECTED_CS_TYPE_KEY, false, USER_DEFINED);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles, PROJECTION_KEY,
+                false, USER_DEFINED);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                PROJ_LINEAR_UNITS_KEY, false, LINEAR_METER);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                PROJ_FALSE_EASTING_KEY, true, proj->false_easting);
+            add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                PROJ_FALSE_NORTHING_KEY, true, proj->false_northing);
+            if (proj->proj_type == GCTP_ALBERS_PROJ)
+            {
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_COORD_TRANS_KEY, false, CT_ALBERS_EQUAL_AREA);
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_STD_PARALLEL1_KEY, true, proj->standard_parallel1);
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_STD_PARALLEL2_KEY, true, proj->standard_parallel2);
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_NAT_ORIGIN_LONG_KEY, true, proj->central_meridian);
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_NAT_ORIGIN_LAT_KEY, true, proj->origin_latitude);
+            }
+            else
+            {
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_COORD_TRANS_KEY, false, CT_POLAR_STEREOGRAPHIC);
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_NAT_ORIGIN_LAT_KEY, true, proj->latitude_true_scale);
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_SCALE_AT_NAT_ORIGIN_KEY, true, 1.0);
+                add_geo_key (keys, &nkeys, doubles, &ndoubles,
+                    PROJ_STRAIGHT_VERT_POLE_LONG_KEY, true,
+                    proj->longitude_pole);
+            }
+            break;
+
+        default:
+            sprintf (errmsg, "Unsupported projection for the GeoTIFF: %d",
+                proj->proj_type);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+    }
+
+    /* Build the GeoKeyDirectory, with the keys sorted by ID */
+    qsort (keys, nkeys, sizeof (Geo_key_t), compare_geo_keys);
+    key_directory[0] = 1;         /* directory version */
+    key_directory[1] = 1;         /* key revision */
+    key_directory[2] = 0;         /* minor revision */
+    key_directory[3] = nkeys;
+    for (i = 0; i < nkeys; i++)
+    {
+        key_directory[4 * (i + 1)] = keys[i].key;
+        key_directory[4 * (i + 1) + 1] = keys[i].location;
+        key_directory[4 * (i + 1) + 2] = 1;
+        key_directory[4 * (i + 1) + 3] = keys[i].value;
+    }
+    georef->nkeys = nkeys;
+    georef->ndoubles = ndoubles;
+
+    /* Tie the outer corner of the upper left pixel to the model */
+    scale[0] = pixel_size[0];
+    scale[1] = pixel_size[1];
+    scale[2] = 0.0;
+    tiepoint[0] = 0.0;
+    tiepoint[1] = 0.0;
+    tiepoint[2] = 0.0;
+    tiepoint[3] = proj->ul_corner[0];
+    tiepoint[4] = proj->ul_corner[1];
+    tiepoint[5] = 0.0;
+    if (!strcmp (proj->grid_origin, "CENTER"))
+    {
+        tiepoint[3] -= 0.5 * scale[0];
+        tiepoint[4] += 0.5 * scale[1];
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  add_georeferencing
+
+PURPOSE: Adds the georeferencing tags for the full resolution band to the
+image file directory.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error adding the tags
+SUCCESS         Successfully added
+
+NOTES:
+1. The tag values are built by build_georeferencing when the GeoTIFF is
+   created.
+******************************************************************************/
+static int add_georeferencing
+(
+    Geotiff_georef_t *georef, /* I: values of the georeferencing tags */
+    Tiff_ifd_t *ifd           /* I/O: full resolution image file directory */
+)
+{
+    char FUNC_NAME[] = "add_georeferencing";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+
+    if (add_ifd_entry (ifd, TAG_MODEL_PIXEL_SCALE, TIFF_DOUBLE, 3,
+        georef->scale) != SUCCESS ||
+        add_ifd_entry (ifd, TAG_MODEL_TIEPOINT, TIFF_DOUBLE, 6,
+        georef->tiepoint) != SUCCESS ||
+        add_ifd_entry (ifd, TAG_GEO_KEY_DIRECTORY, TIFF_SHORT,
+            4 * (georef->nkeys + 1), georef->key_directory) != SUCCESS ||
+        (georef->ndoubles > 0 &&
+         add_ifd_entry (ifd, TAG_GEO_DOUBLE_PARAMS, TIFF_DOUBLE,
+             georef->ndoubles, georef->doubles) != SUCCESS))
+    {
+        sprintf (errmsg, "Adding the georeferencing tags");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_tile_row
+
+PURPOSE: Writes the buffered row of tiles of a resolution level to the
+GeoTIFF.  Tiles extending past the edges of the band are padded with zeros.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the tiles
+SUCCESS         Successfully written
+
+NOTES:
+******************************************************************************/
+static int write_tile_row
+(
+    Pixel_qa_geotiff_t *tiff, /* I/O: GeoTIFF being written */
+    Geotiff_level_t *level    /* I/O: resolution level to be written */
+)
+{
+    char FUNC_NAME[] = "write_tile_row";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int tile;                 /* current tile in the row */
+    int line;                 /* current line in the tile */
+    int samp0;                /* first sample of the tile */
+    int ncopy;                /* number of samples of the band in the tile */
+    int index;                /* index of the tile in the level */
+    uint32_t tile_bytes = GEOTIFF_TILE_SIZE * GEOTIFF_TILE_SIZE *
+        sizeof (uint16_t);    /* size of a tile in bytes */
+
+    for (tile = 0; tile < level->tiles_across; tile++)
+    {
+        samp0 = tile * GEOTIFF_TILE_SIZE;
+        ncopy = level->nsamps - samp0;
+        if (ncopy > GEOTIFF_TILE_SIZE)
+            ncopy = GEOTIFF_TILE_SIZE;
+
+        memset (tiff->tile, 0, tile_bytes);
+        for (line = 0; line < level->lines_buffered; line++)
+        {
+            memcpy (&tiff->tile[line * GEOTIFF_TILE_SIZE],
+                &level->tile_row[(size_t) line * level->nsamps + samp0],
+                ncopy * sizeof (uint16_t));
+        }
+
+        if ((uint64_t) tiff->offset + tile_bytes > UINT32_MAX)
+        {
+            sprintf (errmsg, "GeoTIFF exceeds the 4 GB limit of a classic "
+                "TIFF: %s", tiff->tiff_file);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (fwrite (tiff->tile, tile_bytes, 1, tiff->fp) != 1)
+        {
+            sprintf (errmsg, "Writing GeoTIFF tiles: %s", tiff->tiff_file);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        index = level->tile_rows_written * level->tiles_across + tile;
+        level->tile_offsets[index] = tiff->offset;
+        level->tile_bytes[index] = tile_bytes;
+        tiff->offset += tile_bytes;
+    }
+
+    level->tile_rows_written++;
+    level->lines_buffered = 0;
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  reduce_lines
+
+PURPOSE: Reduces a pair of lines to a single line at half the resolution,
+with each output pixel the bitwise OR of the 2x2 block of input pixels.
+
+RETURN VALUE: None
+
+NOTES:
+1. line2 is NULL for the last line of a level with an odd number of lines.
+   The last output sample covers a single input sample when the level has an
+   odd number of samples.
+******************************************************************************/
+static void reduce_lines
+(
+    uint16_t *line1,        /* I: first line of the pair */
+    uint16_t *line2,        /* I: second line of the pair; may be NULL */
+    int nsamps,             /* I: number of samples in the input lines */
+    uint16_t *reduced       /* O: reduced line of (nsamps + 1) / 2 samples */
+)
+{
+    int samp;                 /* current input sample */
+
+    for (samp = 0; samp + 1 < nsamps; samp += 2)
+        reduced[samp / 2] = line1[samp] | line1[samp + 1];
+    if (samp < nsamps)
+        reduced[samp / 2] = line1[samp];
+
+    if (line2 != NULL)
+    {
+        for (samp = 0; samp + 1 < nsamps; samp += 2)
+            reduced[samp / 2] |= line2[samp] | line2[samp + 1];
+        if (samp < nsamps)
+            reduced[samp / 2] |= line2[samp];
+    }
+}
+
+
+/******************************************************************************
+MODULE:  add_line
+
+PURPOSE: Adds the next line to a resolution level, writing the row of tiles
+when it is complete and passing every pair of lines on to the next overview
+level.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the tiles
+SUCCESS         Successfully added
+
+NOTES:
+******************************************************************************/
+static int add_line
+(
+    Pixel_qa_geotiff_t *tiff, /* I/O: GeoTIFF being written */
+    int lvl,                  /* I: resolution level */
+    uint16_t *line            /* I: next line of the level */
+)
+{
+    Geotiff_level_t *level = &tiff->level[lvl];  /* resolution level */
+
+    memcpy (&level->tile_row[(size_t) level->lines_buffered * level->nsamps],
+        line, level->nsamps * sizeof (uint16_t));
+    level->lines_buffered++;
+    level->lines_received++;
+    if (level->lines_buffered == GEOTIFF_TILE_SIZE &&
+        write_tile_row (tiff, level) != SUCCESS)
+        return (ERROR);
+
+    /* Nothing more to do for the coarsest level */
+    if (lvl + 1 >= tiff->nlevels)
+        return (SUCCESS);
+
+    if (!level->have_pair_line)
+    {
+        memcpy (level->pair_line, line, level->nsamps * sizeof (uint16_t));
+        level->have_pair_line = true;
+        return (SUCCESS);
+    }
+
+    reduce_lines (level->pair_line, line, level->nsamps, level->reduced_line);
+    level->have_pair_line = false;
+    return (add_line (tiff, lvl + 1, level->reduced_line));
+}
+
+
+/******************************************************************************
+MODULE:  free_pixel_qa_geotiff
+
+PURPOSE: Frees the buffers of the GeoTIFF writer.
+
+RETURN VALUE: None
+
+NOTES:
+1. The file is not closed.
+******************************************************************************/
+void free_pixel_qa_geotiff
+(
+    Pixel_qa_geotiff_t *tiff  /* I/O: GeoTIFF whose buffers are to be freed */
+)
+{
+    int lvl;                  /* looping variable for the levels */
+    Geotiff_level_t *level = NULL;  /* resolution level */
+
+    for (lvl = 0; lvl <= GEOTIFF_MAX_OVERVIEWS; lvl++)
+    {
+        level = &tiff->level[lvl];
+        free (level->tile_offsets);
+        free (level->tile_bytes);
+        free (level->tile_row);
+        free (level->pair_line);
+        free (level->reduced_line);
+        level->tile_offsets = NULL;
+        level->tile_bytes = NULL;
+        level->tile_row = NULL;
+        level->pair_line = NULL;
+        level->reduced_line = NULL;
+    }
+    free (tiff->tile);
+    free (tiff->tiff_file);
+    tiff->tile = NULL;
+    tiff->tiff_file = NULL;
+}
+
+
+/******************************************************************************
+MODULE:  discard_pixel_qa_geotiff
+
+PURPOSE: Closes and removes a GeoTIFF which can't be finished, and frees the
+buffers of the writer.
+
+RETURN VALUE: None
+
+NOTES:
+******************************************************************************/
+static void discard_pixel_qa_geotiff
+(
+    Pixel_qa_geotiff_t *tiff  /* I/O: GeoTIFF being written */
+)
+{
+    if (tiff->fp != NULL)
+    {
+        fclose (tiff->fp);
+        tiff->fp = NULL;
+        if (tiff->tiff_file != NULL)
+            unlink (tiff->tiff_file);
+    }
+    free_pixel_qa_geotiff (tiff);
+}
+
+
+/******************************************************************************
+MODULE:  create_pixel_qa_geotiff
+
+PURPOSE: Creates the pixel QA GeoTIFF and sets up the resolution levels for
+writing.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error creating the GeoTIFF, or the projection can't be
+                written to a GeoTIFF
+SUCCESS         Successfully created
+
+NOTES:
+1. The number of overview levels is limited to GEOTIFF_MAX_OVERVIEWS, and
+   overviews stop once the level fits in a single tile.
+2. The pixel QA lines are expected to be written with write_pixel_qa_geotiff
+   and the file finished with close_pixel_qa_geotiff.
+3. The projection is checked before the file is created, so no file is left
+   behind for an unsupported projection.
+******************************************************************************/
+int create_pixel_qa_geotiff
+(
+    char *tiff_file,        /* I: GeoTIFF filename to be created */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    int noverviews,         /* I: number of overview levels to be built; 0
+                                  for none */
+    Espa_global_meta_t *gmeta, /* I: global metadata with the projection
+                                  information */
+    double pixel_size[2],   /* I: pixel size (x, y) of the QA band */
+    Pixel_qa_geotiff_t *tiff /* O: GeoTIFF being written */
+)
+{
+    char FUNC_NAME[] = "create_pixel_qa_geotiff";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    char header[8];           /* TIFF header */
+    int lvl;                  /* looping variable for the levels */
+    int ntiles;               /* number of tiles in a level */
+    uint16_t byte_order = 1;  /* used to determine the host byte order */
+    uint16_t magic = 42;      /* TIFF version number */
+    uint32_t first_ifd = 0;   /* offset of the first IFD, set when closing */
+    Geotiff_level_t *level = NULL;  /* resolution level */
+
+    memset (tiff, 0, sizeof (Pixel_qa_geotiff_t));
+    if (noverviews < 0)
+        noverviews = 0;
+    if (noverviews > GEOTIFF_MAX_OVERVIEWS)
+        noverviews = GEOTIFF_MAX_OVERVIEWS;
+
+    if (build_georeferencing (&gmeta->proj_info, pixel_size, &tiff->georef)
+        != SUCCESS)
+    {
+        sprintf (errmsg, "Unable to georeference the GeoTIFF: %s", tiff_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    tiff->tiff_file = strdup (tiff_file);
+    tiff->tile = malloc (GEOTIFF_TILE_SIZE * GEOTIFF_TILE_SIZE *
+        sizeof (uint16_t));
+    if (tiff->tiff_file == NULL || tiff->tile == NULL)
+    {
+        sprintf (errmsg, "Allocating memory for the GeoTIFF writer");
+        error_handler (true, FUNC_NAME, errmsg);
+        free_pixel_qa_geotiff (tiff);
+        return (ERROR);
+    }
+
+    /* Set up the full resolution level and each overview level */
+    tiff->nlevels = 0;
+    for (lvl = 0; lvl <= noverviews; lvl++)
+    {
+        if (lvl > 0 && tiff->level[lvl-1].nlines <= GEOTIFF_TILE_SIZE &&
+            tiff->level[lvl-1].nsamps <= GEOTIFF_TILE_SIZE)
+            break;
+
+        level = &tiff->level[lvl];
+        level->nlines = (lvl == 0) ? nlines : (tiff->level[lvl-1].nlines + 1)/2;
+        level->nsamps = (lvl == 0) ? nsamps : (tiff->level[lvl-1].nsamps + 1)/2;
+        level->tiles_across = (level->nsamps + GEOTIFF_TILE_SIZE - 1) /
+            GEOTIFF_TILE_SIZE;
+        level->tiles_down = (level->nlines + GEOTIFF_TILE_SIZE - 1) /
+            GEOTIFF_TILE_SIZE;
+        ntiles = level->tiles_across * level->tiles_down;
+        level->tile_offsets = calloc (ntiles, sizeof (uint32_t));
+        level->tile_bytes = calloc (ntiles, sizeof (uint32_t));
+        level->tile_row = calloc ((size_t) GEOTIFF_TILE_SIZE * level->nsamps,
+            sizeof (uint16_t));
+        level->pair_line = calloc (level->nsamps, sizeof (uint16_t));
+        level->reduced_line = calloc ((level->nsamps + 1) / 2,
+            sizeof (uint16_t));
+        if (level->tile_offsets == NULL || level->tile_bytes == NULL ||
+            level->tile_row == NULL || level->pair_line == NULL ||
+            level->reduced_line == NULL)
+        {
+            sprintf (errmsg, "Allocating memory for GeoTIFF level %d", lvl);
+            error_handler (true, FUNC_NAME, errmsg);
+            free_pixel_qa_geotiff (tiff);
+            return (ERROR);
+        }
+        tiff->nlevels++;
+    }
+
+    tiff->fp = fopen (tiff_file, "wb");
+    if (tiff->fp == NULL)
+    {
+        sprintf (errmsg, "Creating the GeoTIFF file: %s", tiff_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        free_pixel_qa_geotiff (tiff);
+        return (ERROR);
+    }
+
+    /* Write the header in the host byte order; the offset of the first IFD
+       is filled in once the tiles have been written */
+    if (*(uint8_t *) &byte_order == 1)
+        memcpy (header, "II", 2);
+    else
+        memcpy (header, "MM", 2);
+    memcpy (&header[2], &magic, sizeof (magic));
+    memcpy (&header[4], &first_ifd, sizeof (first_ifd));
+    if (fwrite (header, sizeof (header), 1, tiff->fp) != 1)
+    {
+        sprintf (errmsg, "Writing the GeoTIFF header: %s", tiff_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        discard_pixel_qa_geotiff (tiff);
+        return (ERROR);
+    }
+    tiff->offset = sizeof (header);
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  write_pixel_qa_geotiff
+
+PURPOSE: Writes the next lines of the pixel QA band to the GeoTIFF and to
+its overviews.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the lines
+SUCCESS         Successfully written
+
+NOTES:
+1. Lines must be written in order, top to bottom.
+2. On an error the partial GeoTIFF is removed and the buffers of the writer
+   are freed, so it must not be closed afterwards.
+******************************************************************************/
+int write_pixel_qa_geotiff
+(
+    Pixel_qa_geotiff_t *tiff, /* I/O: GeoTIFF being written */
+    int nlines,             /* I: number of lines to write */
+    uint16_t *pixel_qa      /* I: pixel QA values for the next nlines lines
+                                  of the band */
+)
+{
+    char FUNC_NAME[] = "write_pixel_qa_geotiff";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int line;                 /* current line */
+    int nsamps = tiff->level[0].nsamps;  /* number of samples in the band */
+
+    if (tiff->level[0].lines_received + nlines > tiff->level[0].nlines)
+    {
+        sprintf (errmsg, "Writing past the last line of the GeoTIFF: %s",
+            tiff->tiff_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        discard_pixel_qa_geotiff (tiff);
+        return (ERROR);
+    }
+
+    for (line = 0; line < nlines; line++)
+    {
+        if (add_line (tiff, 0, &pixel_qa[(size_t) line * nsamps]) != SUCCESS)
+        {
+            sprintf (errmsg, "Writing the GeoTIFF: %s", tiff->tiff_file);
+            error_handler (true, FUNC_NAME, errmsg);
+            discard_pixel_qa_geotiff (tiff);
+            return (ERROR);
+        }
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  close_pixel_qa_geotiff
+
+PURPOSE: Flushes the remaining tiles of each resolution level, writes the
+image file directories, and closes the GeoTIFF.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error finishing the GeoTIFF
+SUCCESS         Successfully closed
+
+NOTES:
+1. The buffers of the writer are freed whether or not an error occurs, and
+   on an error the partial GeoTIFF is removed.
+******************************************************************************/
+int close_pixel_qa_geotiff
+(
+    Pixel_qa_geotiff_t *tiff  /* I/O: GeoTIFF being written; the directories
+                                      are written and the file is closed */
+)
+{
+    char FUNC_NAME[] = "close_pixel_qa_geotiff";  /* function name */
+    char errmsg[STR_SIZE];    /* error message */
+    int lvl;                  /* looping variable for the levels */
+    int status = SUCCESS;     /* return status */
+    uint16_t short_value;     /* SHORT tag value */
+    uint32_t long_value;      /* LONG tag value */
+    uint32_t ifd_offset;      /* offset of the current IFD */
+    uint32_t next_offset;     /* offset of the next IFD */
+    uint32_t ntiles;          /* number of tiles in the level */
+    Geotiff_level_t *level = NULL;  /* resolution level */
+    Tiff_ifd_t ifd;           /* image file directory */
+
+    if (tiff->level[0].lines_received != tiff->level[0].nlines)
+    {
+        sprintf (errmsg, "Only %d of %d lines were written to the GeoTIFF: %s",
+            tiff->level[0].lines_received, tiff->level[0].nlines,
+            tiff->tiff_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        discard_pixel_qa_geotiff (tiff);
+        return (ERROR);
+    }
+
+    /* Flush the levels from the finest to the coarsest, so a leftover odd
+       line reaches the next level before that level is flushed */
+    for (lvl = 0; lvl < tiff->nlevels && status == SUCCESS; lvl++)
+    {
+        level = &tiff->level[lvl];
+        if (level->have_pair_line)
+        {
+            reduce_lines (level->pair_line, NULL, level->nsamps,
+                level->reduced_line);
+            level->have_pair_line = false;
+            status = add_line (tiff, lvl + 1, level->reduced_line);
+        }
+        if (status == SUCCESS && level->lines_buffered > 0)
+            status = write_tile_row (tiff, level);
+    }
+
+    /* Write the directories after the tiles, each followed by its extra
+       data, starting on a word boundary */
+    ifd_offset = tiff->offset;
+    for (lvl = 0; lvl < tiff->nlevels && status == SUCCESS; lvl++)
+    {
+        level = &tiff->level[lvl];
+        ntiles = level->tiles_across * level->tiles_down;
+        memset (&ifd, 0, sizeof (ifd));
+
+        long_value = (lvl == 0) ? 0 : 1;
+        status |= add_ifd_entry (&ifd, TAG_NEW_SUBFILE_TYPE, TIFF_LONG, 1,
+            &long_value);
+        long_value = level->nsamps;
+        status |= add_ifd_entry (&ifd, TAG_IMAGE_WIDTH, TIFF_LONG, 1,
+            &long_value);
+        long_value = level->nlines;
+        status |= add_ifd_entry (&ifd, TAG_IMAGE_LENGTH, TIFF_LONG, 1,
+            &long_value);
+        short_value = 16;
+        status |= add_ifd_entry (&ifd, TAG_BITS_PER_SAMPLE, TIFF_SHORT, 1,
+            &short_value);
+        short_value = 1;          /* no compression */
+        status |= add_ifd_entry (&ifd, TAG_COMPRESSION, TIFF_SHORT, 1,
+            &short_value);
+        short_value = 1;          /* black is zero */
+        status |= add_ifd_entry (&ifd, TAG_PHOTOMETRIC, TIFF_SHORT, 1,
+            &short_value);
+        short_value = 1;
+        status |= add_ifd_entry (&ifd, TAG_SAMPLES_PER_PIXEL, TIFF_SHORT, 1,
+            &short_value);
+        short_value = 1;          /* chunky */
+        status |= add_ifd_entry (&ifd, TAG_PLANAR_CONFIG, TIFF_SHORT, 1,
+            &short_value);
+        short_value = GEOTIFF_TILE_SIZE;
+        status |= add_ifd_entry (&ifd, TAG_TILE_WIDTH, TIFF_SHORT, 1,
+            &short_value);
+        status |= add_ifd_entry (&ifd, TAG_TILE_LENGTH, TIFF_SHORT, 1,
+            &short_value);
+        status |= add_ifd_entry (&ifd, TAG_TILE_OFFSETS, TIFF_LONG, ntiles,
+            level->tile_offsets);
+        status |= add_ifd_entry (&ifd, TAG_TILE_BYTE_COUNTS, TIFF_LONG,
+            ntiles, level->tile_bytes);
+        short_value = 1;          /* unsigned integer */
+        status |= add_ifd_entry (&ifd, TAG_SAMPLE_FORMAT, TIFF_SHORT, 1,
+            &short_value);
+        if (lvl == 0)
+            status |= add_georeferencing (&tiff->georef, &ifd);
+        status |= add_ifd_entry (&ifd, TAG_GDAL_NODATA, TIFF_ASCII, 2, "1");
+        if (status != SUCCESS)
+        {
+            status = ERROR;
+            free (ifd.extra);
+            break;
+        }
+
+        next_offset = 0;
+        if (lvl + 1 < tiff->nlevels)
+            next_offset = ifd_offset + 2 + 12 * ifd.nentries + 4 +
+                ifd.extra_size;
+        status = write_ifd (tiff->fp, &ifd, ifd_offset, next_offset);
+        free (ifd.extra);
+        ifd_offset = next_offset;
+    }
+
+    /* Point the header at the first directory */
+    long_value = tiff->offset;
+    if (status == SUCCESS &&
+        (fseek (tiff->fp, 4, SEEK_SET) != 0 ||
+         fwrite (&long_value, sizeof (long_value), 1, tiff->fp) != 1))
+        status = ERROR;
+
+    if (fclose (tiff->fp) != 0)
+        status = ERROR;
+    tiff->fp = NULL;
+    if (status != SUCCESS)
+    {
+        sprintf (errmsg, "Finishing the GeoTIFF: %s", tiff->tiff_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        unlink (tiff->tiff_file);
+    }
+
+    free_pixel_qa_geotiff (tiff);
+    return (status);
+}
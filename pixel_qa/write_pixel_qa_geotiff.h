@@ -0,0 +1,109 @@
+/*****************************************************************************
+FILE: write_pixel_qa_geotiff.h
+  
+PURPOSE: Contains defines and function prototypes for writing the Level-2
+pixel QA band as a tiled GeoTIFF, with optional internal overviews.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+1. The GeoTIFF is written without any external libraries.  It is a classic
+   (32-bit offset) TIFF with uncompressed 16-bit tiles, so the output is
+   limited to 4 GB, which is far more than a Landsat scene needs.
+*****************************************************************************/
+
+#ifndef WRITE_PIXEL_QA_GEOTIFF_H
+#define WRITE_PIXEL_QA_GEOTIFF_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "error_handler.h"
+#include "espa_metadata.h"
+
+/* Defines */
+#define GEOTIFF_TILE_SIZE 256         /* tile width and height in pixels */
+#define GEOTIFF_MAX_OVERVIEWS 8       /* maximum number of overview levels */
+#define GEOTIFF_MAX_GEO_KEYS 20       /* maximum number of GeoKeys */
+
+/* Data types */
+typedef struct
+{
+    int nlines;             /* number of lines at this resolution */
+    int nsamps;             /* number of samples at this resolution */
+    int tiles_across;       /* number of tiles across a tile row */
+    int tiles_down;         /* number of tile rows */
+    int lines_received;     /* number of lines received so far */
+    int lines_buffered;     /* number of lines held in tile_row */
+    int tile_rows_written;  /* number of tile rows written so far */
+    uint32_t *tile_offsets; /* file offset of each tile */
+    uint32_t *tile_bytes;   /* size of each tile in bytes */
+    uint16_t *tile_row;     /* GEOTIFF_TILE_SIZE lines of this level */
+    uint16_t *pair_line;    /* first line of a pair waiting to be reduced
+                               into the next overview level */
+    bool have_pair_line;    /* is pair_line holding a line? */
+    uint16_t *reduced_line; /* line reduced for the next overview level */
+} Geotiff_level_t;
+
+typedef struct
+{
+    int nkeys;              /* number of GeoKeys */
+    uint16_t key_directory[4 * (GEOTIFF_MAX_GEO_KEYS + 1)]; /* GeoKeyDirectory
+                               values, with the keys sorted by ID */
+    int ndoubles;           /* number of GeoDoubleParams values */
+    double doubles[GEOTIFF_MAX_GEO_KEYS]; /* GeoDoubleParams values */
+    double scale[3];        /* ModelPixelScale values */
+    double tiepoint[6];     /* ModelTiepoint values */
+} Geotiff_georef_t;
+
+typedef struct
+{
+    FILE *fp;               /* GeoTIFF file open for writing */
+    char *tiff_file;        /* GeoTIFF filename */
+    uint32_t offset;        /* current end of the file */
+    int nlevels;            /* number of resolution levels, the full
+                               resolution band plus the overviews */
+    Geotiff_level_t level[GEOTIFF_MAX_OVERVIEWS + 1]; /* resolution levels */
+    uint16_t *tile;         /* buffer for a single tile */
+    Geotiff_georef_t georef; /* georeferencing tags of the full resolution
+                               band */
+} Pixel_qa_geotiff_t;
+
+/* Function prototypes */
+int create_pixel_qa_geotiff
+(
+    char *tiff_file,        /* I: GeoTIFF filename to be created */
+    int nlines,             /* I: number of lines in the QA band */
+    int nsamps,             /* I: number of samples in the QA band */
+    int noverviews,         /* I: number of overview levels to be built; 0
+                                  for none */
+    Espa_global_meta_t *gmeta, /* I: global metadata with the projection
+                                  information */
+    double pixel_size[2],   /* I: pixel size (x, y) of the QA band */
+    Pixel_qa_geotiff_t *tiff /* O: GeoTIFF being written */
+);
+
+int write_pixel_qa_geotiff
+(
+    Pixel_qa_geotiff_t *tiff, /* I/O: GeoTIFF being written */
+    int nlines,             /* I: number of lines to write */
+    uint16_t *pixel_qa      /* I: pixel QA values for the next nlines lines
+                                  of the band */
+);
+
+int close_pixel_qa_geotiff
+(
+    Pixel_qa_geotiff_t *tiff  /* I/O: GeoTIFF being written; the directories
+                                      are written and the file is closed */
+);
+
+void free_pixel_qa_geotiff
+(
+    Pixel_qa_geotiff_t *tiff  /* I/O: GeoTIFF whose buffers are to be freed */
+);
+
+#endif
@@ -0,0 +1,973 @@
+/*****************************************************************************
+FILE: benchmark_qa.c
+
+PURPOSE: Contains a program which times the QA tools on a scene: reading the
+Level-1 QA band, generating the pixel QA band, reading and writing the pixel
+QA band, and the Level-1 translation and cloud dilation kernels over a range
+of dilation distances and thread counts.  It can also count the hardware
+events of each phase.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The timings are made in-process around the library calls, so they don't
+     include the start up of the tools.  Each phase is run --repeat times and
+     the fastest run is reported, to limit the noise from the file cache and
+     other processes.
+  2. generate_pixel_qa appends the pixel QA band to its XML file, so each run
+     works on a scratch copy of the XML file (scene_bench.xml), which is
+     removed at the end.
+  3. The tools themselves are single threaded.  The translation and dilation
+     kernels are timed by splitting the scene into strips of
+     QA_STREAM_STRIP_LINES lines (as the tools do) and, when built with
+     OpenMP, processing the strips in parallel with the specified number of
+     threads.  Without OpenMP only one thread is timed.
+  4. Like the other tools, it must be run in the directory of the scene since
+     the band file names in the XML file are relative.
+  5. The results are printed as a table with one row per phase, size,
+     distance, and thread count, with the time in seconds and the throughput
+     in millions of pixels per second.
+  6. With --counters, the cycles, instructions, branches, and last-level
+     cache accesses of the fastest run of each phase are counted with
+     perf_event_open (see l2qa_perf.h), and the table adds the millions of
+     cycles, the instructions per cycle, the bytes of QA data the phase reads
+     and writes per cycle, the cache and branch miss rates, and the memory
+     bandwidth estimated from the cache misses.  A low IPC with a high miss
+     rate and bandwidth points to a memory-bound phase, a high branch miss
+     rate to a branch-bound one, and a high IPC to a compute-bound one.  If
+     the counters are unavailable (e.g. in a virtual machine) a warning is
+     printed and the columns are "-".
+*****************************************************************************/
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "read_level1_qa.h"
+#include "generate_pixel_qa.h"
+#include "read_pixel_qa.h"
+#include "pixel_qa_dilation.h"
+#include "pixel_qa_stream.h"
+#include "l2qa_perf.h"
+
+/* Defines */
+#define MAX_VALUES 32              /* maximum values in a distance or thread
+                                      list */
+#define L1_QA_BYTES 2              /* bytes per pixel of the Level-1 QA */
+#define PIXEL_QA_BYTES 2           /* bytes per pixel of the pixel QA */
+
+/******************************************************************************
+MODULE:  elapsed_seconds
+
+PURPOSE: Returns the seconds since the specified start time.
+
+RETURN VALUE:
+Type = double
+Value           Description
+-----           -----------
+n               Elapsed seconds
+
+NOTES:
+******************************************************************************/
+static double elapsed_seconds
+(
+    struct timespec *start /* I: start time */
+)
+{
+    struct timespec now;   /* current time */
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return ((now.tv_sec - start->tv_sec) +
+        (now.tv_nsec - start->tv_nsec) * 1e-9);
+}
+
+
+/******************************************************************************
+MODULE:  print_ratio
+
+PURPOSE: Prints a column with the ratio of a hardware event count to a
+divisor, or "-" if the event wasn't counted.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Negative counts are L2QA_PERF_NOT_COUNTED, possibly scaled by the
+   caller, so any negative count or non-positive divisor is printed as "-".
+******************************************************************************/
+static void print_ratio
+(
+    long long count,       /* I: count of the event */
+    double divisor,        /* I: divisor of the count */
+    int width,             /* I: width of the column */
+    int precision          /* I: number of decimal places */
+)
+{
+    if (count < 0 || divisor <= 0.0)
+        printf (" %*s", width, "-");
+    else
+        printf (" %*.*f", width, precision, count / divisor);
+}
+
+
+/******************************************************************************
+MODULE:  start_run
+
+PURPOSE: Starts the hardware event counters and the timer of a run.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void start_run
+(
+    struct timespec *start /* O: start time of the run */
+)
+{
+    l2qa_perf_start ();
+    clock_gettime (CLOCK_MONOTONIC, start);
+}
+
+
+/******************************************************************************
+MODULE:  finish_run
+
+PURPOSE: Stops the timer and the hardware event counters of a run, and keeps
+the time and events of the run if it's the fastest so far.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void finish_run
+(
+    struct timespec *start, /* I: start time of the run */
+    double *best,          /* I/O: fastest time of the runs (negative before
+                                   the first run) */
+    L2qa_perf_counts_t *best_counts /* I/O: hardware events of the fastest
+                                            run */
+)
+{
+    double seconds;            /* time of the run */
+    L2qa_perf_counts_t counts; /* hardware events of the run */
+
+    seconds = elapsed_seconds (start);
+    l2qa_perf_stop (&counts);
+    if (*best < 0.0 || seconds < *best)
+    {
+        *best = seconds;
+        *best_counts = counts;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  print_result
+
+PURPOSE: Prints a row of the benchmark results.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. A distance of -1 is printed as "-" for the phases without dilation.
+2. The hardware event columns are only printed when the events are counted,
+   and a ratio whose events weren't counted is printed as "-".
+******************************************************************************/
+static void print_result
+(
+    char *phase,           /* I: name of the phase */
+    int nlines,            /* I: number of lines in the scene */
+    int nsamps,            /* I: number of samples in the scene */
+    int distance,          /* I: dilation distance (-1 if none) */
+    int nthreads,          /* I: number of threads */
+    double seconds,        /* I: fastest time of the phase */
+    int bytes_per_pixel,   /* I: bytes of QA data read and written per
+                                 pixel by the phase */
+    L2qa_perf_counts_t *counts /* I: hardware events of the fastest run */
+)
+{
+    char distance_str[STR_SIZE];  /* dilation distance for printing */
+    double bytes = (double) nlines * nsamps * bytes_per_pixel; /* bytes of
+                                     QA data of the phase */
+    long long *count = counts->count;  /* count of each event */
+
+    if (distance < 0)
+        strcpy (distance_str, "-");
+    else
+        sprintf (distance_str, "%d", distance);
+
+    printf ("%-20s %7d %7d %8s %7d %10.4f %10.1f", phase, nlines, nsamps,
+        distance_str, nthreads, seconds,
+        (seconds > 0.0) ? (double) nlines * nsamps / seconds * 1e-6 : 0.0);
+
+    if (l2qa_perf_is_enabled ())
+    {
+        print_ratio (count[L2QA_PERF_CYCLES], 1e6, 10, 1);
+        print_ratio (count[L2QA_PERF_INSTRUCTIONS],
+            count[L2QA_PERF_CYCLES], 6, 2);
+        print_ratio ((long long) bytes, count[L2QA_PERF_CYCLES], 8, 3);
+        print_ratio (count[L2QA_PERF_CACHE_MISSES] * 100,
+            count[L2QA_PERF_CACHE_REFERENCES], 8, 1);
+        print_ratio (count[L2QA_PERF_BRANCH_MISSES] * 100,
+            count[L2QA_PERF_BRANCHES], 8, 2);
+        print_ratio (count[L2QA_PERF_CACHE_MISSES] * L2QA_PERF_CACHE_LINE,
+            seconds * 1e9, 8, 2);
+    }
+
+    printf ("\n");
+    fflush (stdout);
+}
+
+
+/******************************************************************************
+MODULE:  print_header
+
+PURPOSE: Prints the header of the benchmark results.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void print_header (void)
+{
+    printf ("%-20s %7s %7s %8s %7s %10s %10s", "phase", "lines", "samps",
+        "distance", "threads", "seconds", "Mpixels/s");
+    if (l2qa_perf_is_enabled ())
+        printf (" %10s %6s %8s %8s %8s %8s", "Mcycles", "IPC", "B/cycle",
+            "LLCmiss%", "brmiss%", "memGB/s");
+    printf ("\n");
+}
+
+
+/******************************************************************************
+MODULE:  parse_int_list
+
+PURPOSE: Parses a comma-separated list of positive integers.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           The list is empty, too long, or has an invalid value
+SUCCESS         Successful
+
+NOTES:
+******************************************************************************/
+static int parse_int_list
+(
+    char *list,            /* I: comma-separated list */
+    int min_value,         /* I: smallest allowed value */
+    int *values,           /* O: values of the list */
+    int *nvalues           /* O: number of values in the list */
+)
+{
+    char *next = list;     /* next value in the list */
+    char *end = NULL;      /* end of the current value */
+    long value;            /* current value */
+
+    *nvalues = 0;
+    while (*next != '\0')
+    {
+        value = strtol (next, &end, 10);
+        if (end == next || value < min_value || value > 100000 ||
+            *nvalues >= MAX_VALUES || (*end != ',' && *end != '\0'))
+            return (ERROR);
+        values[(*nvalues)++] = (int) value;
+        next = (*end == ',') ? end + 1 : end;
+    }
+
+    return ((*nvalues > 0) ? SUCCESS : ERROR);
+}
+
+
+/******************************************************************************
+MODULE:  copy_file
+
+PURPOSE: Copies a file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error copying the file
+SUCCESS         Successful
+
+NOTES:
+******************************************************************************/
+static int copy_file
+(
+    char *source,          /* I: file to be copied */
+    char *destination      /* I: copy of the file */
+)
+{
+    char FUNC_NAME[] = "copy_file";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    char buffer[65536];        /* data being copied */
+    size_t nbytes;             /* number of bytes read */
+    FILE *fp_in = NULL;        /* file to be copied */
+    FILE *fp_out = NULL;       /* copy of the file */
+
+    fp_in = fopen (source, "rb");
+    fp_out = fopen (destination, "wb");
+    if (fp_in == NULL || fp_out == NULL)
+    {
+        sprintf (errmsg, "Unable to copy %.200s to %.200s", source,
+            destination);
+        error_handler (true, FUNC_NAME, errmsg);
+        if (fp_in != NULL)
+            fclose (fp_in);
+        if (fp_out != NULL)
+            fclose (fp_out);
+        return (ERROR);
+    }
+
+    while ((nbytes = fread (buffer, 1, sizeof (buffer), fp_in)) > 0)
+    {
+        if (fwrite (buffer, 1, nbytes, fp_out) != nbytes)
+        {
+            sprintf (errmsg, "Unable to write %.200s", destination);
+            error_handler (true, FUNC_NAME, errmsg);
+            fclose (fp_in);
+            fclose (fp_out);
+            return (ERROR);
+        }
+    }
+
+    fclose (fp_in);
+    if (fclose (fp_out) != 0)
+    {
+        sprintf (errmsg, "Unable to close %.200s", destination);
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE: usage
+
+PURPOSE: Prints the usage information for this application.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void usage ()
+{
+    printf ("benchmark_qa times reading the Level-1 QA band, generating, "
+            "reading, and writing the pixel QA band, and the Level-1 "
+            "translation and cloud dilation kernels over a range of dilation "
+            "distances and thread counts.\n\n");
+    printf ("usage: benchmark_qa --xml=input_xml_filename "
+            "[--distances=d1,d2,...] [--threads=n1,n2,...] [--repeat=n] "
+            "[--counters]\n");
+
+    printf ("\nwhere the following parameters are required:\n");
+    printf ("    -xml: name of the input XML file of a Collection 1 scene\n");
+    printf ("\nwhere the following parameters are optional:\n");
+    printf ("    -distances: dilation distances (default is 3)\n");
+    printf ("    -threads: thread counts for the kernels (default is 1)\n");
+    printf ("    -repeat: runs of each phase; the fastest is reported "
+            "(default is 3)\n");
+    printf ("    -counters: count the cycles, instructions, branch misses, "
+            "and cache misses of each phase with perf_event_open (default "
+            "is off)\n");
+    printf ("\nExample: benchmark_qa --xml=synthetic_oli.xml "
+            "--distances=1,3,5 --threads=1,2,4 --repeat=3\n");
+}
+
+
+/******************************************************************************
+MODULE:  get_args
+
+PURPOSE:  Gets the command-line arguments and validates that the required
+arguments were specified.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error getting the command-line arguments or a command-line
+                argument and associated value were not specified
+SUCCESS         No errors encountered
+
+NOTES:
+  1. Memory is allocated for the input XML file.  The caller is responsible
+     for freeing the allocated memory upon successful return.
+******************************************************************************/
+short get_args
+(
+    int argc,             /* I: number of cmd-line args */
+    char *argv[],         /* I: string of cmd-line args */
+    char **xml_infile,    /* O: address of input XML file */
+    int *distances,       /* O: dilation distances */
+    int *ndistances,      /* O: number of dilation distances */
+    int *threads,         /* O: thread counts */
+    int *nthreads,        /* O: number of thread counts */
+    int *repeat,          /* O: runs of each phase */
+    bool *counters        /* O: count the hardware events? */
+)
+{
+    int c;                           /* current argument index */
+    int option_index;                /* index for the command-line option */
+    char errmsg[STR_SIZE];           /* error message */
+    char FUNC_NAME[] = "get_args";   /* function name */
+    static struct option long_options[] =
+    {
+        {"xml", required_argument, 0, 'i'},
+        {"distances", required_argument, 0, 'd'},
+        {"threads", required_argument, 0, 't'},
+        {"repeat", required_argument, 0, 'r'},
+        {"counters", no_argument, 0, 'c'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    distances[0] = 3;
+    *ndistances = 1;
+    threads[0] = 1;
+    *nthreads = 1;
+    *repeat = 3;
+    *counters = false;
+
+    /* Loop through all the cmd-line options */
+    opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
+    while (1)
+    {
+        /* optstring in call to getopt_long is empty since we will only
+           support the long options */
+        c = getopt_long (argc, argv, "", long_options, &option_index);
+        if (c == -1)
+        {   /* Out of cmd-line options */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* If this option set a flag, do nothing else now. */
+                if (long_options[option_index].flag != 0)
+                    break;
+
+            case 'h':  /* help */
+                usage ();
+                return (ERROR);
+                break;
+
+            case 'i':  /* XML infile */
+                *xml_infile = strdup (optarg);
+                break;
+
+            case 'd':  /* dilation distances */
+                if (parse_int_list (optarg, 0, distances, ndistances)
+                    != SUCCESS)
+                {
+                    sprintf (errmsg, "Invalid list of distances %.80s",
+                        optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+
+            case 't':  /* thread counts */
+                if (parse_int_list (optarg, 1, threads, nthreads) != SUCCESS)
+                {
+                    sprintf (errmsg, "Invalid list of thread counts %.80s",
+                        optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+
+            case 'r':  /* runs of each phase */
+                *repeat = atoi (optarg);
+                break;
+
+            case 'c':  /* count the hardware events */
+                *counters = true;
+                break;
+
+            case '?':
+            default:
+                sprintf (errmsg, "Unknown option %s", argv[optind-1]);
+                error_handler (true, FUNC_NAME, errmsg);
+                usage ();
+                return (ERROR);
+                break;
+        }
+    }
+
+    /* Make sure the infile was specified */
+    if (*xml_infile == NULL)
+    {
+        sprintf (errmsg, "Input XML file is a required argument");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    if (*repeat < 1)
+    {
+        sprintf (errmsg, "Repeat must be at least 1");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  time_read_level1_qa
+
+PURPOSE: Times opening and reading the whole Level-1 QA band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error reading the Level-1 QA band
+SUCCESS         Successful
+
+NOTES:
+1. The Level-1 QA values of the last run are returned for the kernels.
+******************************************************************************/
+static int time_read_level1_qa
+(
+    char *xml_infile,      /* I: input XML file */
+    int repeat,            /* I: runs of the phase */
+    uint16_t **l1_qa,      /* O: Level-1 QA values (allocated here) */
+    int *nlines,           /* O: number of lines in the scene */
+    int *nsamps,           /* O: number of samples in the scene */
+    Espa_level1_qa_type *qa_category /* O: type of Level-1 QA data */
+)
+{
+    char FUNC_NAME[] = "time_read_level1_qa";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    char l1_qa_file[STR_SIZE]; /* Level-1 QA filename */
+    int run;                   /* looping variable for the runs */
+    double best = -1.0;        /* fastest time of the runs */
+    struct timespec start;     /* start time of the run */
+    L2qa_perf_counts_t counts; /* hardware events of the fastest run */
+    FILE *fp_bqa = NULL;       /* Level-1 QA band */
+
+    *l1_qa = NULL;
+    for (run = 0; run < repeat; run++)
+    {
+        start_run (&start);
+        fp_bqa = open_level1_qa (xml_infile, l1_qa_file, nlines, nsamps,
+            qa_category);
+        if (fp_bqa == NULL)
+        {
+            sprintf (errmsg, "Opening the Level-1 QA band of %s", xml_infile);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+
+        if (*l1_qa == NULL)
+        {
+            *l1_qa = malloc ((size_t) *nlines * *nsamps * sizeof (uint16_t));
+            if (*l1_qa == NULL)
+            {
+                sprintf (errmsg, "Allocating the Level-1 QA band");
+                error_handler (true, FUNC_NAME, errmsg);
+                return (ERROR);
+            }
+        }
+
+        if (read_level1_qa (fp_bqa, *nlines, *nsamps, *l1_qa) != SUCCESS)
+        {
+            sprintf (errmsg, "Reading the Level-1 QA band %.200s", l1_qa_file);
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        close_level1_qa (fp_bqa);
+        finish_run (&start, &best, &counts);
+    }
+
+    print_result ("read_level1_qa", *nlines, *nsamps, -1, 1, best,
+        L1_QA_BYTES, &counts);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  time_generate_pixel_qa
+
+PURPOSE: Times generating the pixel QA band from the scene, opening and
+reading the whole pixel QA band, and writing it to a new pixel QA file.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error generating, reading, or writing the pixel QA band
+SUCCESS         Successful
+
+NOTES:
+1. The scratch XML file is copied from the input XML file before each run,
+   which isn't timed.
+2. The write includes closing the file, but not syncing it to the disk.
+******************************************************************************/
+static int time_generate_pixel_qa
+(
+    char *xml_infile,      /* I: input XML file */
+    char *scratch_xml,     /* I: scratch copy of the XML file */
+    char *scratch_img,     /* I: scratch pixel QA file for the writes */
+    int repeat,            /* I: runs of the phase */
+    int nlines,            /* I: number of lines in the scene */
+    int nsamps             /* I: number of samples in the scene */
+)
+{
+    char FUNC_NAME[] = "time_generate_pixel_qa";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    char l2_qa_file[STR_SIZE]; /* pixel QA filename */
+    int run;                   /* looping variable for the runs */
+    int qa_nlines, qa_nsamps;  /* size of the pixel QA band */
+    double best_generate = -1.0;  /* fastest time of generate_pixel_qa */
+    double best_read = -1.0;   /* fastest time of reading the pixel QA */
+    double best_write = -1.0;  /* fastest time of writing the pixel QA */
+    struct timespec start;     /* start time of the run */
+    L2qa_perf_counts_t generate_counts; /* hardware events of the fastest
+                                           generate_pixel_qa */
+    L2qa_perf_counts_t read_counts;  /* hardware events of the fastest
+                                        read */
+    L2qa_perf_counts_t write_counts; /* hardware events of the fastest
+                                        write */
+    uint16_t *l2_qa = NULL;    /* pixel QA values */
+    FILE *fp_pqa = NULL;       /* pixel QA band */
+    Pixel_qa_options_t options;  /* generation options */
+
+    l2_qa = malloc ((size_t) nlines * nsamps * sizeof (uint16_t));
+    if (l2_qa == NULL)
+    {
+        sprintf (errmsg, "Allocating the pixel QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    init_pixel_qa_options (&options);
+    for (run = 0; run < repeat; run++)
+    {
+        if (copy_file (xml_infile, scratch_xml) != SUCCESS)
+        {   /* Error message already written */
+            free (l2_qa);
+            return (ERROR);
+        }
+
+        start_run (&start);
+        if (generate_pixel_qa_with_options (scratch_xml, &options)
+            != SUCCESS)
+        {
+            sprintf (errmsg, "Generating the pixel QA band of %s",
+                scratch_xml);
+            error_handler (true, FUNC_NAME, errmsg);
+            free (l2_qa);
+            return (ERROR);
+        }
+        finish_run (&start, &best_generate, &generate_counts);
+
+        start_run (&start);
+        fp_pqa = open_pixel_qa (scratch_xml, l2_qa_file, &qa_nlines,
+            &qa_nsamps);
+        if (fp_pqa == NULL || qa_nlines != nlines || qa_nsamps != nsamps)
+        {
+            sprintf (errmsg, "Opening the pixel QA band of %s", scratch_xml);
+            error_handler (true, FUNC_NAME, errmsg);
+            free (l2_qa);
+            return (ERROR);
+        }
+        if (read_pixel_qa (fp_pqa, nlines, nsamps, l2_qa) != SUCCESS)
+        {
+            sprintf (errmsg, "Reading the pixel QA band %.200s", l2_qa_file);
+            error_handler (true, FUNC_NAME, errmsg);
+            free (l2_qa);
+            return (ERROR);
+        }
+        close_pixel_qa (fp_pqa);
+        finish_run (&start, &best_read, &read_counts);
+
+        start_run (&start);
+        fp_pqa = create_pixel_qa (scratch_img);
+        if (fp_pqa == NULL ||
+            write_pixel_qa (fp_pqa, nlines, nsamps, l2_qa) != SUCCESS)
+        {
+            sprintf (errmsg, "Writing the pixel QA band %.200s", scratch_img);
+            error_handler (true, FUNC_NAME, errmsg);
+            if (fp_pqa != NULL)
+                close_pixel_qa (fp_pqa);
+            free (l2_qa);
+            return (ERROR);
+        }
+        close_pixel_qa (fp_pqa);
+        finish_run (&start, &best_write, &write_counts);
+    }
+
+    /* generate_pixel_qa reads the Level-1 QA and writes the pixel QA */
+    print_result ("generate_pixel_qa", nlines, nsamps, -1, 1, best_generate,
+        L1_QA_BYTES + PIXEL_QA_BYTES, &generate_counts);
+    print_result ("read_pixel_qa", nlines, nsamps, -1, 1, best_read,
+        PIXEL_QA_BYTES, &read_counts);
+    print_result ("write_pixel_qa", nlines, nsamps, -1, 1, best_write,
+        PIXEL_QA_BYTES, &write_counts);
+    free (l2_qa);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  set_num_threads
+
+PURPOSE: Sets the number of threads for the parallel kernels.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The number of threads is available
+false           The number of threads isn't available (more than one without
+                OpenMP)
+
+NOTES:
+******************************************************************************/
+static bool set_num_threads
+(
+    int nthreads           /* I: number of threads */
+)
+{
+#ifdef _OPENMP
+    omp_set_num_threads (nthreads);
+    return (true);
+#else
+    return (nthreads == 1);
+#endif
+}
+
+
+/******************************************************************************
+MODULE:  time_kernels
+
+PURPOSE: Times the Level-1 translation kernel and the cloud dilation kernel
+for each thread count and dilation distance.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error allocating memory
+SUCCESS         Successful
+
+NOTES:
+1. The strips are processed in parallel, each thread writing its own strips
+   of the output, as the tools process them in sequence.
+******************************************************************************/
+static int time_kernels
+(
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    int nlines,            /* I: number of lines in the scene */
+    int nsamps,            /* I: number of samples in the scene */
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data */
+    int *distances,        /* I: dilation distances */
+    int ndistances,        /* I: number of dilation distances */
+    int *threads,          /* I: thread counts */
+    int nthreads,          /* I: number of thread counts */
+    int repeat             /* I: runs of each kernel */
+)
+{
+    char FUNC_NAME[] = "time_kernels";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    int t, d;                  /* looping variables for threads, distances */
+    int run;                   /* looping variable for the runs */
+    int strip;                 /* looping variable for the strips */
+    int nstrips;               /* number of strips in the scene */
+    double best;               /* fastest time of the runs */
+    struct timespec start;     /* start time of the run */
+    L2qa_perf_counts_t counts; /* hardware events of the fastest run */
+    uint16_t *l2_qa = NULL;    /* pixel QA values */
+    uint16_t *dilated = NULL;  /* dilated pixel QA values */
+    Level1_qa_translator_t translator;  /* translation kernel */
+
+    translator = get_level1_qa_translator (qa_category);
+    l2_qa = malloc ((size_t) nlines * nsamps * sizeof (uint16_t));
+    dilated = malloc ((size_t) nlines * nsamps * sizeof (uint16_t));
+    if (translator == NULL || l2_qa == NULL || dilated == NULL)
+    {
+        sprintf (errmsg, "Setting up the kernels");
+        error_handler (true, FUNC_NAME, errmsg);
+        free (l2_qa);
+        free (dilated);
+        return (ERROR);
+    }
+    nstrips = (nlines + QA_STREAM_STRIP_LINES - 1) / QA_STREAM_STRIP_LINES;
+
+    for (t = 0; t < nthreads; t++)
+    {
+        if (!set_num_threads (threads[t]))
+        {
+            sprintf (errmsg, "Built without OpenMP; skipping %d threads",
+                threads[t]);
+            error_handler (false, FUNC_NAME, errmsg);
+            continue;
+        }
+
+        /* Level-1 translation */
+        best = -1.0;
+        for (run = 0; run < repeat; run++)
+        {
+            start_run (&start);
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic)
+#endif
+            for (strip = 0; strip < nstrips; strip++)
+            {
+                long offset = (long) strip * QA_STREAM_STRIP_LINES * nsamps;
+                int strip_lines = nlines - strip * QA_STREAM_STRIP_LINES;
+                if (strip_lines > QA_STREAM_STRIP_LINES)
+                    strip_lines = QA_STREAM_STRIP_LINES;
+                translator (&l1_qa[offset], strip_lines * nsamps,
+                    &l2_qa[offset], NULL);
+            }
+            finish_run (&start, &best, &counts);
+        }
+        print_result ("translate_level1_qa", nlines, nsamps, -1, threads[t],
+            best, L1_QA_BYTES + PIXEL_QA_BYTES, &counts);
+
+        /* Cloud dilation */
+        for (d = 0; d < ndistances; d++)
+        {
+            best = -1.0;
+            for (run = 0; run < repeat; run++)
+            {
+                start_run (&start);
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic)
+#endif
+                for (strip = 0; strip < nstrips; strip++)
+                {
+                    int first_line = strip * QA_STREAM_STRIP_LINES;
+                    int strip_lines = nlines - first_line;
+                    if (strip_lines > QA_STREAM_STRIP_LINES)
+                        strip_lines = QA_STREAM_STRIP_LINES;
+                    dilate_pixel_qa_rows (l2_qa, L2QA_CLOUD, distances[d],
+                        nlines, nsamps, first_line, strip_lines,
+                        &dilated[(long) first_line * nsamps]);
+                }
+                finish_run (&start, &best, &counts);
+            }
+            print_result ("dilate_pixel_qa", nlines, nsamps, distances[d],
+                threads[t], best, 2 * PIXEL_QA_BYTES, &counts);
+        }
+    }
+
+    free (l2_qa);
+    free (dilated);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  main
+
+PURPOSE:  Runs the benchmarks on the scene.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error running the benchmarks
+SUCCESS         No errors encountered
+
+NOTES:
+******************************************************************************/
+int main (int argc, char** argv)
+{
+    char FUNC_NAME[] = "benchmark_qa";  /* function name */
+    char errmsg[STR_SIZE];       /* error message */
+    char *xml_infile = NULL;     /* input XML filename */
+    char *cptr = NULL;           /* pointer to the file extension */
+    char scratch_xml[STR_SIZE];  /* scratch copy of the XML file */
+    char scratch_img[STR_SIZE];  /* scratch pixel QA file for the writes */
+    int distances[MAX_VALUES];   /* dilation distances */
+    int ndistances;              /* number of dilation distances */
+    int threads[MAX_VALUES];     /* thread counts */
+    int nthreads;                /* number of thread counts */
+    int repeat;                  /* runs of each phase */
+    int nlines, nsamps;          /* size of the scene */
+    int status;                  /* status of the benchmarks */
+    bool counters;               /* count the hardware events? */
+    uint16_t *l1_qa = NULL;      /* Level-1 QA values */
+    Espa_level1_qa_type qa_category;  /* type of Level-1 QA data */
+
+    /* Read the command-line arguments */
+    if (get_args (argc, argv, &xml_infile, distances, &ndistances, threads,
+        &nthreads, &repeat, &counters) != SUCCESS)
+    {   /* get_args already printed the error message */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Name the scratch XML file after the input XML file */
+    snprintf (scratch_xml, sizeof (scratch_xml), "%s", xml_infile);
+    cptr = strrchr (scratch_xml, '.');
+    if (cptr == NULL || strcmp (cptr, ".xml"))
+    {
+        sprintf (errmsg, "Input XML file %.200s doesn't end in .xml",
+            xml_infile);
+        error_handler (true, FUNC_NAME, errmsg);
+        exit (EXIT_FAILURE);
+    }
+    if (strlen (scratch_xml) + strlen ("_bench_write") >= sizeof (scratch_xml))
+    {
+        sprintf (errmsg, "Input XML filename is too long");
+        error_handler (true, FUNC_NAME, errmsg);
+        exit (EXIT_FAILURE);
+    }
+    strcpy (cptr, "_bench_write.img");
+    strcpy (scratch_img, scratch_xml);
+    strcpy (cptr, "_bench.xml");
+
+    /* Open the counters before any thread is created, so the threads of the
+       kernels are counted too */
+    if (counters && l2qa_perf_enable () == 0)
+    {
+        sprintf (errmsg, "Hardware performance counters are unavailable "
+            "(%.200s); reporting the times only", l2qa_perf_error ());
+        error_handler (false, FUNC_NAME, errmsg);
+    }
+
+    print_header ();
+
+    status = time_read_level1_qa (xml_infile, repeat, &l1_qa, &nlines,
+        &nsamps, &qa_category);
+    if (status == SUCCESS)
+        status = time_generate_pixel_qa (xml_infile, scratch_xml,
+            scratch_img, repeat, nlines, nsamps);
+    if (status == SUCCESS)
+        status = time_kernels (l1_qa, nlines, nsamps, qa_category, distances,
+            ndistances, threads, nthreads, repeat);
+
+    l2qa_perf_disable ();
+    unlink (scratch_xml);
+    unlink (scratch_img);
+    free (l1_qa);
+    free (xml_infile);
+    if (status != SUCCESS)
+    {   /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+
+    exit (SUCCESS);
+}
@@ -0,0 +1,232 @@
+/*****************************************************************************
+FILE: combine_qa_mask.c
+  
+PURPOSE: Contains the tool for combining the pixel QA band and the
+LEDAPS/LaSRC Level-2 QA bands into a single 8-bit mask band.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The XML metadata format parsed or written via this library follows the
+     ESPA internal metadata format found in ESPA Raw Binary Format v1.0.doc.
+     The schema for the ESPA internal metadata format is available at
+     http://espa.cr.usgs.gov/schema/espa_internal_metadata_v1_0.xsd.
+*****************************************************************************/
+#include <getopt.h>
+#include "combine_qa_mask.h"
+
+/******************************************************************************
+MODULE: usage
+
+PURPOSE: Prints the usage information for this application.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void usage ()
+{
+    printf ("combine_qa_mask is a program that reads the pixel QA band and "
+            "the LEDAPS/LaSRC Level-2 QA bands in one pass and writes a "
+            "single 8-bit mask band.  Each rule sets its own bit of the "
+            "mask (the first rule is bit 0) where all of its terms hold.\n\n");
+    printf ("usage: combine_qa_mask --xml=input_xml_filename "
+            "--rules=\"rule[;rule...]\" [--strip_lines=lines]\n");
+
+    printf ("\nwhere the following parameters are required:\n");
+    printf ("    -xml: name of the input XML metadata file which follows "
+            "the ESPA internal raw binary schema\n");
+    printf ("    -rules: up to %d rules separated by ';', each the AND of "
+            "terms separated by '&'.  A term starting with '!' is negated.\n",
+            QA_MASK_MAX_RULES);
+    printf ("        pixel QA: fill, clear, water, cloud_shadow, snow, "
+            "cloud, terrain_occlusion, cloud_conf<op><level>, "
+            "cirrus_conf<op><level>\n");
+    printf ("        radsat QA: radsat_fill, sat:<band>, "
+            "sat:<first band>-<last band>\n");
+    printf ("        LEDAPS cloud QA: ledaps_ddv, ledaps_cloud, "
+            "ledaps_cloud_shadow, ledaps_adj_cloud, ledaps_snow, "
+            "ledaps_land\n");
+    printf ("        LaSRC aerosol QA: aerosol_fill, aerosol_valid, "
+            "aerosol_interp, aerosol_water, aerosol_level<op><level>\n");
+    printf ("        <op> is one of <, <=, =, !=, >=, > and <level> is 0-3 "
+            "or none, low, moderate, high\n");
+    printf ("\nwhere the following parameters are optional:\n");
+    printf ("    -strip_lines: number of lines read and written at a time "
+            "(default is %d)\n", QA_MASK_STRIP_LINES);
+    printf ("\nExample: combine_qa_mask "
+            "--xml=LC08_L1TP_022033_20140228_20160905_01_T1.xml "
+            "--rules=\"clear & !sat:2-5 & aerosol_level<high; water\"\n");
+}
+
+
+/******************************************************************************
+MODULE:  get_args
+
+PURPOSE:  Gets the command-line arguments and validates that the required
+arguments were specified.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error getting the command-line arguments or a command-line
+                argument and associated value were not specified
+SUCCESS         No errors encountered
+
+NOTES:
+  1. Memory is allocated for the input file and the rules.  These should be
+     character pointers set to NULL on input.  The caller is responsible for
+     freeing the allocated memory upon successful return.
+******************************************************************************/
+short get_args
+(
+    int argc,             /* I: number of cmd-line args */
+    char *argv[],         /* I: string of cmd-line args */
+    char **xml_infile,    /* O: address of input XML filename */
+    char **rule_text,     /* O: address of the rules */
+    int *strip_lines      /* O: number of lines per strip */
+)
+{
+    int c;                           /* current argument index */
+    int option_index;                /* index for the command-line option */
+    char errmsg[STR_SIZE];           /* error message */
+    char FUNC_NAME[] = "get_args";   /* function name */
+    static struct option long_options[] =
+    {
+        {"xml", required_argument, 0, 'i'},
+        {"rules", required_argument, 0, 'r'},
+        {"strip_lines", required_argument, 0, 's'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    /* Loop through all the cmd-line options */
+    *strip_lines = QA_MASK_STRIP_LINES;
+    opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
+    while (1)
+    {
+        /* optstring in call to getopt_long is empty since we will only
+           support the long options */
+        c = getopt_long (argc, argv, "", long_options, &option_index);
+        if (c == -1)
+        {   /* Out of cmd-line options */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* If this option set a flag, do nothing else now. */
+                if (long_options[option_index].flag != 0)
+                    break;
+     
+            case 'h':  /* help */
+                usage ();
+                return (ERROR);
+                break;
+
+            case 'i':  /* XML infile */
+                *xml_infile = strdup (optarg);
+                break;
+
+            case 'r':  /* rules */
+                *rule_text = strdup (optarg);
+                break;
+
+            case 's':  /* lines per strip */
+                *strip_lines = atoi (optarg);
+                break;
+     
+            case '?':
+            default:
+                sprintf (errmsg, "Unknown option %s", argv[optind-1]);
+                error_handler (true, FUNC_NAME, errmsg);
+                usage ();
+                return (ERROR);
+                break;
+        }
+    }
+
+    /* Make sure the infiles and rules were specified */
+    if (*xml_infile == NULL)
+    {
+        sprintf (errmsg, "XML input file is a required argument");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    if (*rule_text == NULL)
+    {
+        sprintf (errmsg, "Rules are a required argument");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    if (*strip_lines < 1)
+    {
+        sprintf (errmsg, "Lines per strip must be a positive number");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  main
+
+PURPOSE:  Parses the rules and writes the combined QA mask band.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error combining the QA bands
+SUCCESS         No errors combining the QA bands
+
+NOTES:
+******************************************************************************/
+int main (int argc, char** argv)
+{
+    char *xml_infile = NULL;     /* input XML filename */
+    char *rule_text = NULL;      /* rules of the mask bits */
+    int strip_lines;             /* number of lines per strip */
+    Qa_mask_rules_t rules;       /* parsed rules */
+
+    /* Read the command-line arguments */
+    if (get_args (argc, argv, &xml_infile, &rule_text, &strip_lines)
+        != SUCCESS)
+    {   /* get_args already printed the error message */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Parse the rules */
+    if (parse_qa_mask_rules (rule_text, &rules) != SUCCESS)
+    {  /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Combine the QA bands */
+    printf ("Starting combination of the QA bands ...\n");
+    if (combine_qa_mask (xml_infile, &rules, strip_lines) != SUCCESS)
+    {  /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Free the pointers */
+    free (xml_infile);
+    free (rule_text);
+
+    /* Successful completion */
+    printf ("Successful combination of the QA bands!\n");
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,173 @@
+/*****************************************************************************
+FILE: convert_pixel_qa_bitplanes.c
+  
+PURPOSE: Contains the tool for converting the Level-2 pixel QA band to packed
+1-bit planes.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The XML metadata format parsed or written via this library follows the
+     ESPA internal metadata format found in ESPA Raw Binary Format v1.0.doc.
+     The schema for the ESPA internal metadata format is available at
+     http://espa.cr.usgs.gov/schema/espa_internal_metadata_v1_0.xsd.
+*****************************************************************************/
+#include <getopt.h>
+#include "pixel_qa_bitplanes.h"
+
+/******************************************************************************
+MODULE: usage
+
+PURPOSE: Prints the usage information for this application.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void usage ()
+{
+    printf ("convert_pixel_qa_bitplanes is a program that converts the "
+            "Level-2 pixel QA band into a file of packed 1-bit planes, one "
+            "for each defined pixel QA bit (fill through terrain occlusion). "
+            "A query on a single bit then reads 1/16th of the data of the "
+            "pixel QA band.\n\n");
+    printf ("usage: convert_pixel_qa_bitplanes --xml=input_xml_filename\n");
+
+    printf ("\nwhere the following parameters are required:\n");
+    printf ("    -xml: name of the input XML metadata file which follows "
+            "the ESPA internal raw binary schema\n");
+    printf ("\nExample: convert_pixel_qa_bitplanes "
+            "--xml=LE07_L1TP_022033_20140228_20160905_01_T1.xml\n");
+}
+
+
+/******************************************************************************
+MODULE:  get_args
+
+PURPOSE:  Gets the command-line arguments and validates that the required
+arguments were specified.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error getting the command-line arguments or a command-line
+                argument and associated value were not specified
+SUCCESS         No errors encountered
+
+NOTES:
+  1. Memory is allocated for the input and output files.  All of these should
+     be character pointers set to NULL on input.  The caller is responsible
+     for freeing the allocated memory upon successful return.
+******************************************************************************/
+short get_args
+(
+    int argc,             /* I: number of cmd-line args */
+    char *argv[],         /* I: string of cmd-line args */
+    char **xml_infile     /* O: address of input XML filename */
+)
+{
+    int c;                           /* current argument index */
+    int option_index;                /* index for the command-line option */
+    char errmsg[STR_SIZE];           /* error message */
+    char FUNC_NAME[] = "get_args";   /* function name */
+    static struct option long_options[] =
+    {
+        {"xml", required_argument, 0, 'i'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    /* Loop through all the cmd-line options */
+    opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
+    while (1)
+    {
+        /* optstring in call to getopt_long is empty since we will only
+           support the long options */
+        c = getopt_long (argc, argv, "", long_options, &option_index);
+        if (c == -1)
+        {   /* Out of cmd-line options */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* If this option set a flag, do nothing else now. */
+                if (long_options[option_index].flag != 0)
+                    break;
+     
+            case 'h':  /* help */
+                usage ();
+                return (ERROR);
+                break;
+
+            case 'i':  /* XML infile */
+                *xml_infile = strdup (optarg);
+                break;
+     
+            case '?':
+            default:
+                sprintf (errmsg, "Unknown option %s", argv[optind-1]);
+                error_handler (true, FUNC_NAME, errmsg);
+                usage ();
+                return (ERROR);
+                break;
+        }
+    }
+
+    /* Make sure the infiles were specified */
+    if (*xml_infile == NULL)
+    {
+        sprintf (errmsg, "XML input file is a required argument");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  main
+
+PURPOSE:  Reads the pixel QA band and writes its packed bitplanes.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error with the bitplane conversion
+SUCCESS         No errors with the bitplane conversion
+
+NOTES:
+******************************************************************************/
+int main (int argc, char** argv)
+{
+    char *xml_infile = NULL;     /* input XML filename */
+
+    /* Read the command-line arguments */
+    if (get_args (argc, argv, &xml_infile) != SUCCESS)
+    {   /* get_args already printed the error message */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Convert the pixel QA band to bitplanes */
+    printf ("Starting conversion of the pixel QA band to bitplanes ...\n");
+    if (convert_pixel_qa_to_bitplanes (xml_infile) != SUCCESS)
+    {  /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Free the pointers */
+    free (xml_infile);
+
+    /* Successful completion */
+    printf ("Successful conversion of the pixel QA bitplanes!\n");
+    exit (EXIT_SUCCESS);
+}
@@ -17,10 +17,16 @@ License Type:  NASA Open Source Agreement Version 1.3
 #include "read_pixel_qa.h"
 #include "write_pixel_qa.h"
 #include "pixel_qa_dilation.h"
+#include "pixel_qa_stream.h"
+#include "l2qa_timing.h"
 
 
 #define PROG_NAME "dilate_pixel_qa"
 
+/* Number of lines per strip when checking for and rewriting the lines
+   modified by the dilation */
+#define DILATE_STRIP_LINES 64
+
 
 /*****************************************************************************
 Method: usage
@@ -35,7 +41,9 @@ void usage()
            " QA band with the specified distance.\n\n", PROG_NAME);
 
     printf("usage: %s --xml=<xml_filename>"
-           " --bit=<bit> --distance=<distance>\n\n", PROG_NAME);
+           " --bit=<bit> --distance=<distance> [--stdin] [--stdout]"
+           " [--timing]\n\n",
+           PROG_NAME);
 
     printf("where the following parameters are required:\n");
     printf("    -xml: name of the input XML metadata file which follows"
@@ -45,6 +53,18 @@ void usage()
            " confidence 2, 8=cirrus confidence 1, 9=cirrus confidence 2),"
            " 10=terrain occlusion\n");
     printf("    -distance: search distance from current pixel\n");
+    printf("\nwhere the following parameters are optional:\n");
+    printf("    -stdin: read the pixel QA band as a QA stream from standard"
+           " input.  Unless --stdout is also specified, the dilated band is"
+           " written to the pixel QA file in the XML.\n");
+    printf("    -stdout: write the dilated pixel QA band as a QA stream to"
+           " standard output.  --xml isn't required if --stdin is also"
+           " specified.\n");
+    printf("    -timing: print the wall time, bytes, and pixels per second of"
+           " each phase as JSON to standard output when done, and move the"
+           " progress messages to standard error.  With --stdout the JSON"
+           " goes to standard error instead and the progress messages"
+           " aren't printed\n");
     printf("\nExample: %s --xml=LE07_L1TP_022033_20140228_20160905_01_T1.xml "
            "--bit=5 --distance=3\n", PROG_NAME);
 }
@@ -87,7 +107,10 @@ short get_args
     char *argv[],          /* I: string of cmd-line args */
     char **xml_infile,     /* O: address of input XML filename */
     uint8_t *bit_value,    /* O: address of bit value variable */
-    uint8_t *distance      /* O: address of distance value variable */
+    uint8_t *distance,     /* O: address of distance value variable */
+    bool *use_stdin,       /* O: read the pixel QA stream from stdin? */
+    bool *use_stdout,      /* O: write the pixel QA stream to stdout? */
+    bool *timing           /* O: report the time of each phase? */
 )
 {
     char FUNC_NAME[] = "get_args";
@@ -100,6 +123,9 @@ short get_args
         {"xml", required_argument, 0, 'i'},
         {"bit", required_argument, 0, 'b'},
         {"distance", required_argument, 0, 'd'},
+        {"stdin", no_argument, 0, 's'},
+        {"stdout", no_argument, 0, 'o'},
+        {"timing", no_argument, 0, 't'},
         {"version", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
@@ -108,6 +134,9 @@ short get_args
     /* Initialize variables so we can verify the tool's caller set them */
     *bit_value = 255;
     *distance = 255;
+    *use_stdin = false;
+    *use_stdout = false;
+    *timing = false;
 
     /* Loop through all the cmd-line options */
     opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
@@ -145,6 +174,18 @@ short get_args
                 *distance = (uint8_t) atoi(optarg);
                 break;
 
+            case 's':  /* read the pixel QA stream from stdin */
+                *use_stdin = true;
+                break;
+
+            case 'o':  /* write the pixel QA stream to stdout */
+                *use_stdout = true;
+                break;
+
+            case 't':  /* report the time of each phase */
+                *timing = true;
+                break;
+
             case 'v':  /* version */
                 version();
                 break;
@@ -160,8 +201,9 @@ short get_args
         }
     }
 
-    /* Make sure the infiles were specified */
-    if (*xml_infile == NULL)
+    /* Make sure the infiles were specified; the XML isn't needed when both
+       the input and output are streams */
+    if (*xml_infile == NULL && !(*use_stdin && *use_stdout))
     {
         snprintf(msg, sizeof(msg), "--xml is a required argument");
         error_handler(true, FUNC_NAME, msg);
@@ -189,6 +231,266 @@ short get_args
 }
 
 
+/*****************************************************************************
+Method:  dilate_dirty_strips
+
+Description:  Dilates the band one strip at a time and rewrites only the
+              strips the dilation actually changed in the band open for
+              update.  On mostly-clear scenes this is a small part of the
+              band.
+
+Return Value: Type = int
+Value    Description
+-----    -----------
+ERROR    Error allocating memory or writing the band
+SUCCESS  No errors encountered
+*****************************************************************************/
+int dilate_dirty_strips
+(
+    FILE *qa_fd,           /* I: pixel QA band open for update */
+    uint16_t *idata,       /* I: bit-packed input data */
+    uint8_t bit_value,     /* I: bit to dilate */
+    uint8_t distance,      /* I: search distance from the current pixel */
+    int nlines,            /* I: number of lines in the data */
+    int nsamps,            /* I: number of samples in the data */
+    FILE *fp_log           /* I: where to write the progress message, or
+                                 NULL */
+)
+{
+    char FUNC_NAME[] = "dilate_dirty_strips";
+
+    char msg[STR_SIZE];        /* error message */
+    int strip_lines;           /* number of lines in a full strip */
+    int strip_start;           /* first line of the current strip */
+    int curr_lines;            /* number of lines in the current strip */
+    int nstrips = 0;           /* number of strips processed */
+    int ndirty = 0;            /* number of strips changed by the dilation */
+    long long npixels;         /* number of pixels in the current strip */
+    uint16_t *ddata = NULL;    /* Holds a strip of dilated bit-packed data */
+    L2qa_timer_t timer;        /* start time of the timed phase */
+
+    /* Allocate memory for one strip of dilated output */
+    strip_lines = (nlines < DILATE_STRIP_LINES) ? nlines : DILATE_STRIP_LINES;
+    ddata = calloc(strip_lines * nsamps, sizeof(uint16_t));
+    if (ddata == NULL)
+    {
+        snprintf(msg, sizeof(msg), "allocating memory for output strip data");
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+
+    for (strip_start = 0; strip_start < nlines; strip_start += strip_lines)
+    {
+        curr_lines = nlines - strip_start;
+        if (curr_lines > strip_lines)
+            curr_lines = strip_lines;
+
+        npixels = (long long)curr_lines * nsamps;
+        l2qa_timer_start(&timer);
+        dilate_pixel_qa_rows(idata, bit_value, distance, nlines, nsamps,
+                             strip_start, curr_lines, ddata);
+        l2qa_timer_stop(&timer, L2QA_PHASE_DILATE,
+                        npixels * 2 * sizeof(uint16_t), npixels);
+
+        nstrips++;
+        if (memcmp(ddata, &idata[strip_start * nsamps],
+                   curr_lines * nsamps * sizeof(uint16_t)) == 0)
+            continue;
+
+        l2qa_timer_start(&timer);
+        if (write_pixel_qa_lines(qa_fd, strip_start, curr_lines, nsamps,
+                                 ddata) != SUCCESS)
+        {
+            free(ddata);
+            snprintf(msg, sizeof(msg),
+                     "unable to write the dilated bit-packed QA strip");
+            error_handler(true, FUNC_NAME, msg);
+            return ERROR;
+        }
+        l2qa_timer_stop(&timer, L2QA_PHASE_WRITE,
+                        npixels * sizeof(uint16_t), npixels);
+        ndirty++;
+    }
+
+    if (fp_log != NULL)
+        fprintf(fp_log, "%d of %d strips of %d lines rewritten\n", ndirty,
+                nstrips, strip_lines);
+
+    free(ddata);
+    return SUCCESS;
+}
+
+
+/*****************************************************************************
+Method:  dilate_to_stream
+
+Description:  Dilates the band one strip at a time and writes it as a QA
+              stream.
+
+Return Value: Type = int
+Value    Description
+-----    -----------
+ERROR    Error allocating memory or writing the stream
+SUCCESS  No errors encountered
+*****************************************************************************/
+int dilate_to_stream
+(
+    FILE *stream_fd,       /* I: stream open for writing */
+    uint16_t *idata,       /* I: bit-packed input data */
+    uint8_t bit_value,     /* I: bit to dilate */
+    uint8_t distance,      /* I: search distance from the current pixel */
+    int nlines,            /* I: number of lines in the data */
+    int nsamps             /* I: number of samples in the data */
+)
+{
+    char FUNC_NAME[] = "dilate_to_stream";
+
+    char msg[STR_SIZE];        /* error message */
+    int strip_start;           /* first line of the current strip */
+    int curr_lines;            /* number of lines in the current strip */
+    long long npixels;         /* number of pixels in the current strip */
+    uint16_t *ddata = NULL;    /* Holds a strip of dilated bit-packed data */
+    Qa_stream_header_t stream_hdr; /* header for the output stream */
+    L2qa_timer_t timer;        /* start time of the timed phase */
+
+    stream_hdr.nlines = nlines;
+    stream_hdr.nsamps = nsamps;
+    stream_hdr.data_type = ESPA_UINT16;
+    stream_hdr.strip_lines = QA_STREAM_STRIP_LINES;
+    if (write_qa_stream_header(stream_fd, &stream_hdr) != SUCCESS)
+    {
+        snprintf(msg, sizeof(msg), "writing the output stream header");
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+
+    ddata = calloc(QA_STREAM_STRIP_LINES * nsamps, sizeof(uint16_t));
+    if (ddata == NULL)
+    {
+        snprintf(msg, sizeof(msg), "allocating memory for output strip data");
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+
+    for (strip_start = 0; strip_start < nlines;
+         strip_start += QA_STREAM_STRIP_LINES)
+    {
+        curr_lines = nlines - strip_start;
+        if (curr_lines > QA_STREAM_STRIP_LINES)
+            curr_lines = QA_STREAM_STRIP_LINES;
+
+        npixels = (long long)curr_lines * nsamps;
+        l2qa_timer_start(&timer);
+        dilate_pixel_qa_rows(idata, bit_value, distance, nlines, nsamps,
+                             strip_start, curr_lines, ddata);
+        l2qa_timer_stop(&timer, L2QA_PHASE_DILATE,
+                        npixels * 2 * sizeof(uint16_t), npixels);
+
+        l2qa_timer_start(&timer);
+        if (write_raw_binary(stream_fd, curr_lines, nsamps, sizeof(uint16_t),
+                             ddata) != SUCCESS)
+        {
+            free(ddata);
+            snprintf(msg, sizeof(msg), "writing the dilated output stream");
+            error_handler(true, FUNC_NAME, msg);
+            return ERROR;
+        }
+        l2qa_timer_stop(&timer, L2QA_PHASE_WRITE,
+                        npixels * sizeof(uint16_t), npixels);
+    }
+    free(ddata);
+
+    if (fflush(stream_fd) != 0)
+    {
+        snprintf(msg, sizeof(msg), "writing the dilated output stream");
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+
+/*****************************************************************************
+Method:  dilate_to_file
+
+Description:  Creates the pixel QA band identified in the XML file and
+              dilates the input directly into the file mapping.  This is
+              used when the input came from a stream, so there's no
+              existing band to update.
+
+Return Value: Type = int
+Value    Description
+-----    -----------
+ERROR    Error finding, creating, or writing the pixel QA band
+SUCCESS  No errors encountered
+*****************************************************************************/
+int dilate_to_file
+(
+    char *xml_infile,      /* I: XML input filename */
+    uint16_t *idata,       /* I: bit-packed input data */
+    uint8_t bit_value,     /* I: bit to dilate */
+    uint8_t distance,      /* I: search distance from the current pixel */
+    int nlines,            /* I: number of lines in the data */
+    int nsamps             /* I: number of samples in the data */
+)
+{
+    char FUNC_NAME[] = "dilate_to_file";
+
+    char msg[STR_SIZE];        /* error message */
+    char output_qa_filename[PATH_MAX];
+    int xml_nlines;            /* number of lines in the XML pixel QA band */
+    int xml_nsamps;            /* number of samples in the XML pixel QA band */
+    long long npixels = (long long)nlines * nsamps; /* pixels in the band */
+    Pixel_qa_map_t output_qa_map; /* Mapping of the dilated output band */
+    L2qa_timer_t timer;        /* start time of the timed phase */
+
+    if (find_pixel_qa(xml_infile, output_qa_filename, &xml_nlines,
+                      &xml_nsamps) != SUCCESS)
+    {
+        snprintf(msg, sizeof(msg), "finding the output band in the XML");
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+
+    if (xml_nlines != nlines || xml_nsamps != nsamps)
+    {
+        snprintf(msg, sizeof(msg), "input stream size (%d, %d) does not"
+                 " match the pixel QA band in the XML (%d, %d)", nlines,
+                 nsamps, xml_nlines, xml_nsamps);
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+
+    if (create_mapped_pixel_qa(output_qa_filename, nlines, nsamps,
+                               &output_qa_map) != SUCCESS)
+    {
+        snprintf(msg, sizeof(msg), "opening output band data for writing");
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+
+    l2qa_timer_start(&timer);
+    dilate_pixel_qa(idata, bit_value, distance, nlines, nsamps,
+                    output_qa_map.pixel_qa);
+    l2qa_timer_stop(&timer, L2QA_PHASE_DILATE,
+                    npixels * 2 * sizeof(uint16_t), npixels);
+
+    l2qa_timer_start(&timer);
+    if (close_mapped_pixel_qa(&output_qa_map) != SUCCESS)
+    {
+        snprintf(msg, sizeof(msg),
+                 "unable to write the entire bit-packed QA band");
+        error_handler(true, FUNC_NAME, msg);
+        return ERROR;
+    }
+    l2qa_timer_stop(&timer, L2QA_PHASE_WRITE, npixels * sizeof(uint16_t),
+                    npixels);
+
+    return SUCCESS;
+}
+
+
 /*****************************************************************************
 Method:  main
 
@@ -209,105 +511,138 @@ int main(int argc, char *argv[])
     uint8_t distance;          /* search distance from the current pixel */
     int nlines = -1;           /* number of lines in the data */
     int nsamps = -1;           /* number of samples in the data */
+    int status;                /* status returned from the dilation */
+    bool use_stdin;            /* read the pixel QA stream from stdin? */
+    bool use_stdout;           /* write the pixel QA stream to stdout? */
+    bool timing;               /* report the time of each phase? */
 
     char *xml_infile = NULL; /* XML input filename */
     char msg[STR_SIZE];      /* error message */
     char input_qa_filename[PATH_MAX];
 
     FILE *input_qa_fd = NULL;
+    FILE *fp_log = stdout;   /* where to write the progress messages; NULL
+                                if they aren't written */
+    FILE *fp_report = stdout; /* where to write the timing report */
+    Qa_stream_header_t stream_hdr; /* header for the input stream */
 
     uint16_t *idata = NULL; /* Holds the bit-packed input data */
-    uint16_t *ddata = NULL; /* Holds the dilated bit-packed output data */
 
     /* Read the command line arguments */
-    if (get_args(argc, argv, &xml_infile, &bit_value, &distance)
-        != SUCCESS)
+    if (get_args(argc, argv, &xml_infile, &bit_value, &distance,
+                 &use_stdin, &use_stdout, &timing) != SUCCESS)
     {
         return EXIT_FAILURE;
     }
 
-    /* Open the input band */
-    input_qa_fd = open_pixel_qa(xml_infile, input_qa_filename, &nlines,
-         &nsamps);
-                                         
-    if (input_qa_fd == NULL)
+    /* Time the phases of the dilation */
+    if (timing)
+        l2qa_timing_enable();
+
+    /* Keep the progress messages out of the pixel QA stream and out of the
+       timing report, so each stream can be parsed on its own.  The report
+       takes standard error when the stream is on standard output. */
+    if (use_stdout)
     {
-        snprintf(msg, sizeof(msg), "opening input band data for reading");
-        error_handler(true, FUNC_NAME, msg);
-        return EXIT_FAILURE;
+        fp_log = stderr;
+        fp_report = stderr;
+    }
+    if (timing)
+        fp_log = use_stdout ? NULL : stderr;
+
+    if (use_stdin)
+    {
+        /* Read the header of the input stream */
+        if (read_qa_stream_header(stdin, &stream_hdr) != SUCCESS)
+        {
+            snprintf(msg, sizeof(msg), "reading the input stream header");
+            error_handler(true, FUNC_NAME, msg);
+            return EXIT_FAILURE;
+        }
+
+        if (stream_hdr.data_type != ESPA_UINT16)
+        {
+            snprintf(msg, sizeof(msg), "expecting a UINT16 input stream");
+            error_handler(true, FUNC_NAME, msg);
+            return EXIT_FAILURE;
+        }
+        nlines = stream_hdr.nlines;
+        nsamps = stream_hdr.nsamps;
+        input_qa_fd = stdin;
+        snprintf(input_qa_filename, sizeof(input_qa_filename), "stdin");
     }
+    else
+    {
+        /* Open the input band */
+        input_qa_fd = open_pixel_qa(xml_infile, input_qa_filename, &nlines,
+             &nsamps);
 
-    printf("%s, %d, %d\n", xml_infile, bit_value, distance);
-    printf("%s, %d, %d\n", input_qa_filename, nlines, nsamps);
+        if (input_qa_fd == NULL)
+        {
+            snprintf(msg, sizeof(msg), "opening input band data for reading");
+            error_handler(true, FUNC_NAME, msg);
+            return EXIT_FAILURE;
+        }
+    }
 
-    /* Allocate memory for the input and output */
+    if (fp_log != NULL)
+    {
+        fprintf(fp_log, "%s, %d, %d\n", xml_infile ? xml_infile : "(no XML)",
+                bit_value, distance);
+        fprintf(fp_log, "%s, %d, %d\n", input_qa_filename, nlines, nsamps);
+    }
+
+    /* Allocate memory for the input */
     idata = calloc(nlines * nsamps, sizeof(uint16_t));
     if (idata == NULL)
     {
-        fclose(input_qa_fd);
+        if (!use_stdin)
+            fclose(input_qa_fd);
         snprintf(msg, sizeof(msg), "allocating memory for input band data");
         error_handler(true, FUNC_NAME, msg);
         return EXIT_FAILURE;
     }
 
-    ddata = calloc(nlines * nsamps, sizeof(uint16_t));
-    if (ddata == NULL)
+    /* Read the band into memory here.  The dilation window spans lines, so
+       the whole band is held even when it arrives as a stream. */
+    if (read_pixel_qa(input_qa_fd, nlines, nsamps, idata) != SUCCESS)
     {
         free(idata);
-        fclose(input_qa_fd);
-        snprintf(msg, sizeof(msg), "allocating memory for output band data");
+        if (!use_stdin)
+            fclose(input_qa_fd);
+        snprintf(msg, sizeof(msg), "reading input band data");
         error_handler(true, FUNC_NAME, msg);
         return EXIT_FAILURE;
     }
 
-    /* Read the band into memory here */
-    if (read_pixel_qa(input_qa_fd, nlines, nsamps, idata)
-        != SUCCESS)
+    /* Process dilation here, writing the stream, a new band, or just the
+       strips of the existing band that were changed */
+    if (use_stdout)
+        status = dilate_to_stream(stdout, idata, bit_value, distance, nlines,
+                                  nsamps);
+    else if (use_stdin)
+        status = dilate_to_file(xml_infile, idata, bit_value, distance,
+                                nlines, nsamps);
+    else
+        status = dilate_dirty_strips(input_qa_fd, idata, bit_value, distance,
+                                     nlines, nsamps, fp_log);
+
+    /* Close the input band file descriptor */
+    if (!use_stdin && fclose(input_qa_fd) != 0)
     {
-        free(idata);
-        free(ddata);
-        fclose(input_qa_fd);
-        snprintf(msg, sizeof(msg), "reading input band data");
+        snprintf(msg, sizeof(msg), "closing the bit-packed QA band");
         error_handler(true, FUNC_NAME, msg);
-        return EXIT_FAILURE;
+        status = ERROR;
     }
-    /* Close the READ input band file descriptor */
-    fclose(input_qa_fd);
     input_qa_fd = NULL;
 
-    /* Process dilation here */
-    dilate_pixel_qa(idata, bit_value, distance, nlines, nsamps, ddata);
-
     /* Free the input memory */
     free(idata);
     idata = NULL;
 
-    /* Open the WRITE output band file descriptor */
-    input_qa_fd = create_pixel_qa(input_qa_filename);
-    if (input_qa_fd == NULL)
-    {
-        free(ddata);
-        snprintf(msg, sizeof(msg), "opening output band data for reading");
-        error_handler(true, FUNC_NAME, msg);
+    if (status != SUCCESS)
         return EXIT_FAILURE;
-    }
-
-    /* Write the dilated memory out to the file */
-    if (write_pixel_qa(input_qa_fd, nlines, nsamps, ddata)
-        != SUCCESS)
-    {
-        free(ddata);
-        sprintf (msg, "unable to write the entire bit-packed QA band");
-        error_handler (true, FUNC_NAME, msg);
-        return EXIT_FAILURE;
-    }
-    /* Close the WRITE output band file descriptor */
-    fclose(input_qa_fd);
-    input_qa_fd = NULL;
-
-    /* Free the output memory */
-    free(ddata);
-    ddata = NULL;
 
+    l2qa_timing_report(fp_report, PROG_NAME);
     return EXIT_SUCCESS;
 }
@@ -16,6 +16,7 @@ NOTES:
 *****************************************************************************/
 #include <getopt.h>
 #include "generate_pixel_qa.h"
+#include "l2qa_timing.h"
 
 /******************************************************************************
 MODULE: usage
@@ -32,16 +33,53 @@ void usage ()
     printf ("generate_pixel_qa is a program that opens the Level-1 QA band and "
             "generates the cfmask-like pixel QA band. This is a bit-packed "
             "band which uses the input Level-1 quality band. Water values are "
-            "not yet populated, but are handled in a downstream application. "
-            "The cloud values are populated, but they will also be dilated in "
-            "a downstream application.\n\n");
-    printf ("usage: generate_pixel_qa --xml=input_xml_filename\n");
+            "populated from the LaSRC sr_aerosol or LEDAPS sr_cloud_qa band "
+            "if the XML file has one, otherwise they are handled in a "
+            "downstream application. The cloud values are populated, but they "
+            "will also be dilated in a downstream application.\n\n");
+    printf ("usage: generate_pixel_qa --xml=input_xml_filename "
+            "[--stdin] [--stdout] [--geotiff] [--overviews=levels] "
+            "[--bitplanes] [--saturation] [--timing]\n");
 
     printf ("\nwhere the following parameters are required:\n");
     printf ("    -xml: name of the input XML metadata file which follows "
             "the ESPA internal raw binary schema\n");
+    printf ("\nwhere the following parameters are optional:\n");
+    printf ("    -stdin: read the Level-1 QA band as a QA stream from "
+            "standard input, rather than from the Level-1 QA band in the "
+            "XML file\n");
+    printf ("    -stdout: write the pixel QA band as a QA stream to standard "
+            "output, rather than to the pixel QA image file.  The ENVI header "
+            "and XML band entry are still written, so the downstream "
+            "application is expected to write the pixel QA image file.\n");
+    printf ("    -geotiff: also write the pixel QA band as a tiled GeoTIFF "
+            "(_pixel_qa.tif)\n");
+    printf ("    -overviews: number of internal overview levels to build in "
+            "the GeoTIFF, each the bitwise OR of 2x2 pixels of the level "
+            "above (default is 0, max is %d); implies --geotiff\n",
+            GEOTIFF_MAX_OVERVIEWS);
+    printf ("    -bitplanes: also write each pixel QA bit as its own packed "
+            "1-bit plane (_pixel_qa_bitplanes.img), for fast single-bit "
+            "queries\n");
+    printf ("    -saturation: also write the Level-1 radiometric saturation "
+            "and dropped pixel fields as an 8-bit band "
+            "(_level1_sat_qa.img) and add it to the XML file; Collection 1 "
+            "only\n");
+    printf ("    -timing: print the wall time, bytes, and pixels per second "
+            "of each phase as JSON to standard output when done, and move "
+            "the progress messages to standard error.  With --stdout the "
+            "JSON goes to standard error instead and the progress messages "
+            "aren't printed\n");
     printf ("\nExample: generate_pixel_qa "
             "--xml=LE07_L1TP_022033_20140228_20160905_01_T1.xml\n");
+    printf ("\nExample: generate_pixel_qa "
+            "--xml=LE07_L1TP_022033_20140228_20160905_01_T1.xml --stdout | "
+            "dilate_pixel_qa --stdin "
+            "--xml=LE07_L1TP_022033_20140228_20160905_01_T1.xml --bit=5 "
+            "--distance=3\n");
+    printf ("\nExample: generate_pixel_qa "
+            "--xml=LE07_L1TP_022033_20140228_20160905_01_T1.xml --geotiff "
+            "--overviews=4\n");
 }
 
 
@@ -68,7 +106,9 @@ short get_args
 (
     int argc,             /* I: number of cmd-line args */
     char *argv[],         /* I: string of cmd-line args */
-    char **xml_infile     /* O: address of input XML filename */
+    char **xml_infile,    /* O: address of input XML filename */
+    Pixel_qa_options_t *options, /* O: generation options */
+    bool *timing          /* O: report the time of each phase? */
 )
 {
     int c;                           /* current argument index */
@@ -78,10 +118,20 @@ short get_args
     static struct option long_options[] =
     {
         {"xml", required_argument, 0, 'i'},
+        {"stdin", no_argument, 0, 's'},
+        {"stdout", no_argument, 0, 'o'},
+        {"geotiff", no_argument, 0, 'g'},
+        {"overviews", required_argument, 0, 'v'},
+        {"bitplanes", no_argument, 0, 'b'},
+        {"saturation", no_argument, 0, 'a'},
+        {"timing", no_argument, 0, 't'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
+    init_pixel_qa_options (options);
+    *timing = false;
+
     /* Loop through all the cmd-line options */
     opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
     while (1)
@@ -109,6 +159,44 @@ short get_args
             case 'i':  /* XML infile */
                 *xml_infile = strdup (optarg);
                 break;
+
+            case 's':  /* read the Level-1 QA stream from stdin */
+                options->l1_stream = stdin;
+                break;
+
+            case 'o':  /* write the pixel QA stream to stdout */
+                options->l2_stream = stdout;
+                break;
+
+            case 'g':  /* also write the GeoTIFF */
+                options->write_geotiff = true;
+                break;
+
+            case 'v':  /* number of GeoTIFF overview levels */
+                options->write_geotiff = true;
+                options->geotiff_overviews = atoi (optarg);
+                if (options->geotiff_overviews < 0 ||
+                    options->geotiff_overviews > GEOTIFF_MAX_OVERVIEWS)
+                {
+                    sprintf (errmsg, "Number of overviews must be between 0 "
+                        "and %d", GEOTIFF_MAX_OVERVIEWS);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+
+            case 'b':  /* also write the bitplanes */
+                options->write_bitplanes = true;
+                break;
+
+            case 'a':  /* also write the Level-1 saturation QA band */
+                options->write_saturation = true;
+                break;
+
+            case 't':  /* report the time of each phase */
+                *timing = true;
+                break;
      
             case '?':
             default:
@@ -152,16 +240,37 @@ int main (int argc, char** argv)
 {
     char *xml_infile = NULL;     /* input XML filename */
     int status;                  /* status returned from function calls */
+    bool timing;                 /* report the time of each phase? */
+    Pixel_qa_options_t options;  /* generation options */
+    FILE *fp_log = stdout;       /* where to write the progress messages;
+                                    NULL if they aren't written */
+    FILE *fp_report = stdout;    /* where to write the timing report */
 
     /* Read the command-line arguments */
-    if (get_args (argc, argv, &xml_infile) != SUCCESS)
+    if (get_args (argc, argv, &xml_infile, &options, &timing) != SUCCESS)
     {   /* get_args already printed the error message */
         exit (EXIT_FAILURE);
     }
 
+    /* Time the phases of the generation */
+    if (timing)
+        l2qa_timing_enable ();
+
+    /* Keep the progress messages out of the pixel QA stream and out of the
+       timing report, so each stream can be parsed on its own.  The report
+       takes standard error when the stream is on standard output. */
+    if (options.l2_stream != NULL)
+    {
+        fp_log = stderr;
+        fp_report = stderr;
+    }
+    if (timing)
+        fp_log = (options.l2_stream != NULL) ? NULL : stderr;
+
     /* Read the Level-1 quality band and generate the pixel QA band */
-    printf ("Starting generation of Level-2 QA pixel band ...\n");
-    status = generate_pixel_qa (xml_infile);
+    if (fp_log != NULL)
+        fprintf (fp_log, "Starting generation of Level-2 QA pixel band ...\n");
+    status = generate_pixel_qa_with_options (xml_infile, &options);
     if (status != SUCCESS)
     {  /* Error messages already written */
         exit (EXIT_FAILURE);
@@ -171,6 +280,8 @@ int main (int argc, char** argv)
     free (xml_infile);
 
     /* Successful completion */
-    printf ("Successful generation of pixel QA!\n");
+    if (fp_log != NULL)
+        fprintf (fp_log, "Successful generation of pixel QA!\n");
+    l2qa_timing_report (fp_report, "generate_pixel_qa");
     exit (EXIT_SUCCESS);
 }
@@ -0,0 +1,932 @@
+/*****************************************************************************
+FILE: generate_synthetic_scene.c
+
+PURPOSE: Contains a program which writes a synthetic Collection 1 ESPA scene
+(XML file, Level-1 QA band, and band 1) for testing and benchmarking the QA
+tools without real scene data.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The Level-1 QA band has a rotated scene footprint inside a fill collar,
+     clustered clouds with confidence falling off at their edges, cloud
+     shadows offset from the clouds, patches of snow, cirrus (OLI only), and
+     sparse radiometric saturation and terrain occlusion/dropped pixels.
+  2. The clouds, snow, and cirrus come from value noise: random values on
+     coarse grids, smoothly interpolated and summed over a few scales.  The
+     noise is evaluated a pixel at a time, so only one line of each band is
+     in memory and any scene size can be written.
+  3. The scene depends only on the size, instrument, cloud cover, and seed, so
+     benchmarks are repeatable.
+*****************************************************************************/
+#include <getopt.h>
+#include <math.h>
+#include <time.h>
+#include "read_level1_qa.h"
+#include "l2qa_common.h"
+#include "write_metadata.h"
+
+/* Defines */
+#define NOISE_OCTAVES 3            /* number of scales of the value noise */
+#define NOISE_CELL 512             /* largest noise grid cell (pixels) */
+#define NSAMPLES 4096              /* samples used for the noise quantiles */
+#define FOOTPRINT_ANGLE 12.0       /* rotation of the scene footprint
+                                      (degrees) */
+#define SHADOW_OFFSET_LINES 60     /* offset of the shadows from the clouds */
+#define SHADOW_OFFSET_SAMPS 90
+#define SNOW_COVER 0.05            /* fraction of the scene with snow */
+#define CIRRUS_COVER 0.15          /* fraction of the scene with cirrus */
+#define B1_FILL -9999              /* fill value of band 1 */
+#define MAX_DATE_LEN 28            /* same as in generate_pixel_qa.h */
+
+/* Level-1 QA confidence values (two bits) */
+#define L1QA_LOW_CONF 1            /* low confidence (01) */
+#define L1QA_MODERATE_CONF 2       /* moderate confidence (10) */
+#define L1QA_HIGH_CONF 3           /* high confidence (11) */
+
+/* Value noise field */
+typedef struct
+{
+    int nrows[NOISE_OCTAVES];      /* rows of the grid of each octave */
+    int ncols[NOISE_OCTAVES];      /* columns of the grid of each octave */
+    float *grid[NOISE_OCTAVES];    /* random values of the grid points */
+} Noise_field_t;
+
+/******************************************************************************
+MODULE:  next_random
+
+PURPOSE: Returns the next value of a xorshift64* random number generator.
+
+RETURN VALUE:
+Type = uint64_t
+Value           Description
+-----           -----------
+n               Random number
+
+NOTES:
+1. The generator is used rather than rand so the scenes are the same on
+   every system.
+******************************************************************************/
+static uint64_t next_random
+(
+    uint64_t *state        /* I/O: state of the generator (not zero) */
+)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+
+/******************************************************************************
+MODULE:  pixel_random
+
+PURPOSE: Returns a random number (0-65535) for a pixel, which depends only on
+the pixel location and the seed.
+
+RETURN VALUE:
+Type = unsigned
+Value           Description
+-----           -----------
+n               Random number of the pixel
+
+NOTES:
+******************************************************************************/
+static unsigned pixel_random
+(
+    uint64_t seed,         /* I: seed of the scene */
+    int line,              /* I: line of the pixel */
+    int samp               /* I: sample of the pixel */
+)
+{
+    uint64_t state;        /* state of the generator */
+
+    state = (seed * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t) line << 32) ^
+        (uint64_t) samp;
+    if (state == 0)
+        state = 1;
+    next_random (&state);
+    return (unsigned) (next_random (&state) >> 48);
+}
+
+
+/******************************************************************************
+MODULE:  init_noise_field
+
+PURPOSE: Fills the grids of a value noise field covering the scene with
+random values.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error allocating the grids
+SUCCESS         Successful
+
+NOTES:
+******************************************************************************/
+static int init_noise_field
+(
+    int nlines,            /* I: number of lines in the scene */
+    int nsamps,            /* I: number of samples in the scene */
+    uint64_t seed,         /* I: seed of the field */
+    Noise_field_t *noise   /* O: noise field */
+)
+{
+    char FUNC_NAME[] = "init_noise_field";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    int octave;                /* looping variable for the octaves */
+    int cell = NOISE_CELL;     /* grid cell size of the octave */
+    long i;                    /* looping variable for the grid points */
+    uint64_t state;            /* state of the random number generator */
+
+    state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (octave = 0; octave < NOISE_OCTAVES; octave++, cell /= 4)
+    {
+        noise->nrows[octave] = nlines / cell + 2;
+        noise->ncols[octave] = nsamps / cell + 2;
+        noise->grid[octave] = malloc ((size_t) noise->nrows[octave] *
+            noise->ncols[octave] * sizeof (float));
+        if (noise->grid[octave] == NULL)
+        {
+            sprintf (errmsg, "Allocating the noise grid");
+            error_handler (true, FUNC_NAME, errmsg);
+            return (ERROR);
+        }
+        for (i = 0; i < (long) noise->nrows[octave] * noise->ncols[octave];
+            i++)
+            noise->grid[octave][i] = (next_random (&state) >> 40) /
+                (float) (1 << 24);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  free_noise_field
+
+PURPOSE: Frees the grids of a value noise field.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void free_noise_field
+(
+    Noise_field_t *noise   /* I/O: noise field */
+)
+{
+    int octave;            /* looping variable for the octaves */
+
+    for (octave = 0; octave < NOISE_OCTAVES; octave++)
+        free (noise->grid[octave]);
+}
+
+
+/******************************************************************************
+MODULE:  noise_value
+
+PURPOSE: Returns the value (0-1) of a value noise field at a pixel.
+
+RETURN VALUE:
+Type = float
+Value           Description
+-----           -----------
+n               Value of the field at the pixel
+
+NOTES:
+1. Each octave is interpolated between its grid points with a smoothstep, so
+   the features have soft, rounded edges.  Pixels outside the scene (i.e. the
+   shadow offsets) are clamped to the edge.
+******************************************************************************/
+static float noise_value
+(
+    Noise_field_t *noise,  /* I: noise field */
+    int line,              /* I: line of the pixel */
+    int samp               /* I: sample of the pixel */
+)
+{
+    int octave;            /* looping variable for the octaves */
+    int cell = NOISE_CELL; /* grid cell size of the octave */
+    int row, col;          /* grid point above and left of the pixel */
+    int ncols;             /* columns of the grid of the octave */
+    float y, x;            /* position of the pixel in the grid cell */
+    float top, bottom;     /* values interpolated across the cell */
+    float *grid;           /* grid of the octave */
+    float value = 0.0;     /* value of the field */
+    float weight = 1.0;    /* weight of the octave */
+    float total = 0.0;     /* total weight of the octaves */
+
+    if (line < 0)
+        line = 0;
+    if (samp < 0)
+        samp = 0;
+
+    for (octave = 0; octave < NOISE_OCTAVES; octave++, cell /= 4)
+    {
+        grid = noise->grid[octave];
+        ncols = noise->ncols[octave];
+        row = line / cell;
+        col = samp / cell;
+        if (row > noise->nrows[octave] - 2)
+            row = noise->nrows[octave] - 2;
+        if (col > ncols - 2)
+            col = ncols - 2;
+        y = (float) (line - row * cell) / cell;
+        x = (float) (samp - col * cell) / cell;
+        y = y * y * (3.0 - 2.0 * y);
+        x = x * x * (3.0 - 2.0 * x);
+
+        top = grid[row*ncols + col] +
+            x * (grid[row*ncols + col + 1] - grid[row*ncols + col]);
+        bottom = grid[(row+1)*ncols + col] +
+            x * (grid[(row+1)*ncols + col + 1] - grid[(row+1)*ncols + col]);
+        value += weight * (top + y * (bottom - top));
+        total += weight;
+        weight *= 0.5;
+    }
+
+    return (value / total);
+}
+
+
+/******************************************************************************
+MODULE:  compare_floats
+
+PURPOSE: Compares two floats for qsort.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+-1, 0, 1        First float is less than, equal to, or greater than the
+                second
+
+NOTES:
+******************************************************************************/
+static int compare_floats
+(
+    const void *a,         /* I: first float */
+    const void *b          /* I: second float */
+)
+{
+    float fa = *(const float *) a;
+    float fb = *(const float *) b;
+
+    return (fa > fb) - (fa < fb);
+}
+
+
+/******************************************************************************
+MODULE:  noise_threshold
+
+PURPOSE: Returns the value of a noise field which the specified fraction of
+the scene is above, estimated from a sample of the pixels.
+
+RETURN VALUE:
+Type = float
+Value           Description
+-----           -----------
+n               Threshold of the field
+
+NOTES:
+******************************************************************************/
+static float noise_threshold
+(
+    Noise_field_t *noise,  /* I: noise field */
+    int nlines,            /* I: number of lines in the scene */
+    int nsamps,            /* I: number of samples in the scene */
+    double fraction        /* I: fraction of the scene above the threshold */
+)
+{
+    static float samples[NSAMPLES];  /* sampled values of the field */
+    int i;                 /* looping variable */
+    int index;             /* index of the threshold in the samples */
+    uint64_t state = 12345;  /* state of the random number generator */
+
+    if (fraction <= 0.0)
+        return (2.0);      /* above any value of the field */
+
+    for (i = 0; i < NSAMPLES; i++)
+        samples[i] = noise_value (noise, next_random (&state) % nlines,
+            next_random (&state) % nsamps);
+    qsort (samples, NSAMPLES, sizeof (float), compare_floats);
+
+    index = (int) ((1.0 - fraction) * NSAMPLES);
+    if (index < 0)
+        index = 0;
+    if (index >= NSAMPLES)
+        index = NSAMPLES - 1;
+    return (samples[index]);
+}
+
+
+/******************************************************************************
+MODULE: usage
+
+PURPOSE: Prints the usage information for this application.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void usage ()
+{
+    printf ("generate_synthetic_scene writes a synthetic Collection 1 ESPA "
+            "scene (XML file, Level-1 QA band, and band 1) with a fill "
+            "collar, clustered clouds, cloud shadows, snow, and cirrus, for "
+            "testing and benchmarking the QA tools.\n\n");
+    printf ("usage: generate_synthetic_scene --output=scene_name "
+            "[--lines=n] [--samps=n] [--instrument=tm|etm|oli] "
+            "[--cloud_cover=percent] [--seed=n]\n");
+
+    printf ("\nwhere the following parameters are required:\n");
+    printf ("    -output: name of the scene; the files are "
+            "scene_name.xml, scene_name_bqa.img, and scene_name_b1.img\n");
+    printf ("\nwhere the following parameters are optional:\n");
+    printf ("    -lines: number of lines (default is 7001)\n");
+    printf ("    -samps: number of samples (default is 7971)\n");
+    printf ("    -instrument: instrument of the Level-1 QA layout (default is "
+            "oli)\n");
+    printf ("    -cloud_cover: percentage of the scene which is cloud "
+            "(default is 30)\n");
+    printf ("    -seed: seed of the random scene (default is 1)\n");
+    printf ("\nExample: generate_synthetic_scene --output=synthetic_oli "
+            "--lines=2000 --samps=2000 --cloud_cover=50\n");
+}
+
+
+/******************************************************************************
+MODULE:  get_args
+
+PURPOSE:  Gets the command-line arguments and validates that the required
+arguments were specified.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error getting the command-line arguments or a command-line
+                argument and associated value were not specified
+SUCCESS         No errors encountered
+
+NOTES:
+  1. Memory is allocated for the output scene name.  The caller is
+     responsible for freeing the allocated memory upon successful return.
+******************************************************************************/
+short get_args
+(
+    int argc,             /* I: number of cmd-line args */
+    char *argv[],         /* I: string of cmd-line args */
+    char **scene_name,    /* O: address of output scene name */
+    int *nlines,          /* O: number of lines */
+    int *nsamps,          /* O: number of samples */
+    Espa_level1_qa_type *qa_category, /* O: Level-1 QA layout */
+    char *instrument,     /* O: instrument name for the XML file */
+    double *cloud_cover,  /* O: fraction of the scene which is cloud */
+    uint64_t *seed        /* O: seed of the random scene */
+)
+{
+    int c;                           /* current argument index */
+    int option_index;                /* index for the command-line option */
+    char errmsg[STR_SIZE];           /* error message */
+    char FUNC_NAME[] = "get_args";   /* function name */
+    static struct option long_options[] =
+    {
+        {"output", required_argument, 0, 'o'},
+        {"lines", required_argument, 0, 'l'},
+        {"samps", required_argument, 0, 's'},
+        {"instrument", required_argument, 0, 'i'},
+        {"cloud_cover", required_argument, 0, 'c'},
+        {"seed", required_argument, 0, 'r'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    *nlines = 7001;
+    *nsamps = 7971;
+    *qa_category = LEVEL1_L8;
+    strcpy (instrument, "OLI_TIRS");
+    *cloud_cover = 0.3;
+    *seed = 1;
+
+    /* Loop through all the cmd-line options */
+    opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
+    while (1)
+    {
+        /* optstring in call to getopt_long is empty since we will only
+           support the long options */
+        c = getopt_long (argc, argv, "", long_options, &option_index);
+        if (c == -1)
+        {   /* Out of cmd-line options */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* If this option set a flag, do nothing else now. */
+                if (long_options[option_index].flag != 0)
+                    break;
+
+            case 'h':  /* help */
+                usage ();
+                return (ERROR);
+                break;
+
+            case 'o':  /* scene name */
+                *scene_name = strdup (optarg);
+                break;
+
+            case 'l':  /* number of lines */
+                *nlines = atoi (optarg);
+                break;
+
+            case 's':  /* number of samples */
+                *nsamps = atoi (optarg);
+                break;
+
+            case 'i':  /* instrument */
+                if (!strcmp (optarg, "tm"))
+                {
+                    *qa_category = LEVEL1_L457;
+                    strcpy (instrument, "TM");
+                }
+                else if (!strcmp (optarg, "etm"))
+                {
+                    *qa_category = LEVEL1_L457;
+                    strcpy (instrument, "ETM");
+                }
+                else if (!strcmp (optarg, "oli"))
+                {
+                    *qa_category = LEVEL1_L8;
+                    strcpy (instrument, "OLI_TIRS");
+                }
+                else
+                {
+                    sprintf (errmsg, "Unknown instrument %.80s", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+
+            case 'c':  /* cloud cover */
+                *cloud_cover = atof (optarg) / 100.0;
+                break;
+
+            case 'r':  /* seed */
+                *seed = strtoull (optarg, NULL, 10);
+                break;
+
+            case '?':
+            default:
+                sprintf (errmsg, "Unknown option %s", argv[optind-1]);
+                error_handler (true, FUNC_NAME, errmsg);
+                usage ();
+                return (ERROR);
+                break;
+        }
+    }
+
+    /* Make sure the scene name was specified */
+    if (*scene_name == NULL)
+    {
+        sprintf (errmsg, "Output scene name is a required argument");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    if (*nlines < 2 || *nsamps < 2 || *cloud_cover < 0.0 ||
+        *cloud_cover > 1.0)
+    {
+        sprintf (errmsg, "The scene must be at least 2 x 2 and the cloud "
+            "cover must be 0-100");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  set_band_metadata
+
+PURPOSE: Sets the metadata of one of the bands of the synthetic scene.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void set_band_metadata
+(
+    Espa_band_meta_t *bmeta, /* O: band metadata */
+    char *scene_name,      /* I: name of the scene */
+    char *band_name,       /* I: name of the band (b1, bqa) */
+    char *category,        /* I: category of the band (image, qa) */
+    Espa_data_type data_type, /* I: data type of the band */
+    int nlines,            /* I: number of lines */
+    int nsamps,            /* I: number of samples */
+    char *production_date  /* I: production date of the scene */
+)
+{
+    char *base_name;       /* scene name without its directory */
+
+    base_name = strrchr (scene_name, '/');
+    base_name = (base_name == NULL) ? scene_name : base_name + 1;
+
+    strcpy (bmeta->product, "L1TP");
+    strcpy (bmeta->source, "level1");
+    strcpy (bmeta->name, band_name);
+    strcpy (bmeta->category, category);
+    bmeta->data_type = data_type;
+    bmeta->nlines = nlines;
+    bmeta->nsamps = nsamps;
+    sprintf (bmeta->short_name, "SYN%.8s", band_name);
+    sprintf (bmeta->long_name, "synthetic %.80s band", band_name);
+    sprintf (bmeta->file_name, "%.200s_%.20s.img", base_name, band_name);
+    bmeta->pixel_size[0] = 30.0;
+    bmeta->pixel_size[1] = 30.0;
+    strcpy (bmeta->pixel_units, "meters");
+    sprintf (bmeta->app_version, "generate_synthetic_scene_%s",
+        L2QA_COMMON_VERSION);
+    strcpy (bmeta->production_date, production_date);
+}
+
+
+/******************************************************************************
+MODULE:  write_scene_metadata
+
+PURPOSE: Writes the XML file of the synthetic scene.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the XML file
+SUCCESS         Successful
+
+NOTES:
+1. The scene is given a UTM projection and a nominal location; only the band
+   sizes, file names, and instrument matter to the QA tools.
+******************************************************************************/
+static int write_scene_metadata
+(
+    char *scene_name,      /* I: name of the scene */
+    char *instrument,      /* I: instrument name */
+    int nlines,            /* I: number of lines */
+    int nsamps             /* I: number of samples */
+)
+{
+    char FUNC_NAME[] = "write_scene_metadata";  /* function name */
+    char errmsg[STR_SIZE];     /* error message */
+    char xml_file[STR_SIZE];   /* output XML filename */
+    char production_date[MAX_DATE_LEN+1]; /* current date/time */
+    time_t tp;                 /* time structure */
+    struct tm *tm = NULL;      /* time structure for UTC time */
+    Espa_internal_meta_t xml_metadata;  /* metadata of the scene */
+    Espa_global_meta_t *gmeta = &xml_metadata.global; /* global metadata */
+    Espa_band_meta_t *bmeta = NULL;  /* band metadata */
+    int i;                     /* looping variable */
+
+    /* Get the current date/time (UTC) for the production date */
+    if (time (&tp) == -1 || (tm = gmtime (&tp)) == NULL ||
+        strftime (production_date, MAX_DATE_LEN, "%Y-%m-%dT%H:%M:%SZ",
+        tm) == 0)
+    {
+        sprintf (errmsg, "Unable to get the production date/time");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    init_metadata_struct (&xml_metadata);
+    strcpy (gmeta->data_provider, "USGS/EROS");
+    strcpy (gmeta->satellite, strcmp (instrument, "OLI_TIRS") ?
+        (strcmp (instrument, "TM") ? "LANDSAT_7" : "LANDSAT_5") :
+        "LANDSAT_8");
+    strcpy (gmeta->instrument, instrument);
+    strcpy (gmeta->acquisition_date, "2017-06-15");
+    strcpy (gmeta->scene_center_time, "17:00:00.000000Z");
+    strcpy (gmeta->level1_production_date, production_date);
+    gmeta->solar_zenith = 30.0;
+    gmeta->solar_azimuth = 130.0;
+    strcpy (gmeta->solar_units, "degrees");
+    gmeta->wrs_system = 2;
+    gmeta->wrs_path = 22;
+    gmeta->wrs_row = 33;
+    sprintf (gmeta->product_id, "%.200s", scene_name);
+
+    /* Nominal UTM zone 16 location */
+    gmeta->proj_info.proj_type = GCTP_UTM_PROJ;
+    gmeta->proj_info.datum_type = ESPA_WGS84;
+    gmeta->proj_info.utm_zone = 16;
+    strcpy (gmeta->proj_info.grid_origin, "CENTER");
+    strcpy (gmeta->proj_info.units, "meters");
+    gmeta->proj_info.ul_corner[0] = 500000.0;
+    gmeta->proj_info.ul_corner[1] = 4300000.0;
+    gmeta->proj_info.lr_corner[0] = 500000.0 + 30.0 * (nsamps - 1);
+    gmeta->proj_info.lr_corner[1] = 4300000.0 - 30.0 * (nlines - 1);
+    gmeta->ul_corner[0] = 38.85;
+    gmeta->ul_corner[1] = -87.0;
+    gmeta->lr_corner[0] = 38.85 - 30.0 * nlines / 111000.0;
+    gmeta->lr_corner[1] = -87.0 + 30.0 * nsamps / 87000.0;
+    gmeta->bounding_coords[ESPA_WEST] = gmeta->ul_corner[1];
+    gmeta->bounding_coords[ESPA_EAST] = gmeta->lr_corner[1];
+    gmeta->bounding_coords[ESPA_NORTH] = gmeta->ul_corner[0];
+    gmeta->bounding_coords[ESPA_SOUTH] = gmeta->lr_corner[0];
+
+    /* Band 1 and the Level-1 QA band */
+    if (allocate_band_metadata (&xml_metadata, 2) != SUCCESS)
+    {
+        sprintf (errmsg, "Allocating the band metadata");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    bmeta = &xml_metadata.band[0];
+    set_band_metadata (bmeta, scene_name, "b1", "image", ESPA_INT16, nlines,
+        nsamps, production_date);
+    bmeta->fill_value = B1_FILL;
+    strcpy (bmeta->data_units, "digital numbers");
+
+    bmeta = &xml_metadata.band[1];
+    set_band_metadata (bmeta, scene_name, "bqa", "qa", ESPA_UINT16, nlines,
+        nsamps, production_date);
+    bmeta->fill_value = 1;
+    strcpy (bmeta->data_units, "quality/feature classification");
+    if (allocate_bitmap_metadata (bmeta, 16) != SUCCESS)
+    {
+        sprintf (errmsg, "Allocating the Level-1 QA bitmap metadata");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+    for (i = 0; i < 16; i++)
+        strcpy (bmeta->bitmap_description[i], "unused");
+    strcpy (bmeta->bitmap_description[ESPA_L1_DESIGNATED_FILL_BIT],
+        "designated fill");
+    strcpy (bmeta->bitmap_description[ESPA_L1_TERRAIN_OCCLUSION_BIT],
+        strcmp (instrument, "OLI_TIRS") ? "dropped pixel" :
+        "terrain occlusion");
+    strcpy (bmeta->bitmap_description[ESPA_L1_RAD_SATURATION_BIT],
+        "radiometric saturation");
+    strcpy (bmeta->bitmap_description[ESPA_L1_RAD_SATURATION_BIT+1],
+        "radiometric saturation");
+    strcpy (bmeta->bitmap_description[ESPA_L1_CLOUD_BIT], "cloud");
+    strcpy (bmeta->bitmap_description[ESPA_L1_CLOUD_CONF_BIT],
+        "cloud confidence");
+    strcpy (bmeta->bitmap_description[ESPA_L1_CLOUD_CONF_BIT+1],
+        "cloud confidence");
+    strcpy (bmeta->bitmap_description[ESPA_L1_CLOUD_SHADOW_CONF_BIT],
+        "cloud shadow confidence");
+    strcpy (bmeta->bitmap_description[ESPA_L1_CLOUD_SHADOW_CONF_BIT+1],
+        "cloud shadow confidence");
+    strcpy (bmeta->bitmap_description[ESPA_L1_SNOW_ICE_CONF_BIT],
+        "snow/ice confidence");
+    strcpy (bmeta->bitmap_description[ESPA_L1_SNOW_ICE_CONF_BIT+1],
+        "snow/ice confidence");
+    if (!strcmp (instrument, "OLI_TIRS"))
+    {
+        strcpy (bmeta->bitmap_description[ESPA_L1_CIRRUS_CONF_BIT],
+            "cirrus confidence");
+        strcpy (bmeta->bitmap_description[ESPA_L1_CIRRUS_CONF_BIT+1],
+            "cirrus confidence");
+    }
+
+    sprintf (xml_file, "%.200s.xml", scene_name);
+    if (write_metadata (&xml_metadata, xml_file) != SUCCESS)
+    {
+        sprintf (errmsg, "Writing the XML file %.200s", xml_file);
+        error_handler (true, FUNC_NAME, errmsg);
+        free_metadata (&xml_metadata);
+        return (ERROR);
+    }
+
+    free_metadata (&xml_metadata);
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  main
+
+PURPOSE:  Writes the synthetic scene.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the scene
+SUCCESS         No errors encountered
+
+NOTES:
+******************************************************************************/
+int main (int argc, char** argv)
+{
+    char FUNC_NAME[] = "generate_synthetic_scene";   /* function name */
+    char errmsg[STR_SIZE];       /* error message */
+    char *scene_name = NULL;     /* output scene name */
+    char instrument[STR_SIZE];   /* instrument name for the XML file */
+    char band_file[STR_SIZE];    /* output band filename */
+    int nlines, nsamps;          /* size of the scene */
+    int line, samp;              /* looping variables */
+    double cloud_cover;          /* fraction of the scene which is cloud */
+    double angle;                /* rotation of the footprint (radians) */
+    double center_line, center_samp;  /* center of the scene */
+    double half_height, half_width;   /* half size of the footprint */
+    double u, v;                 /* pixel location in the footprint */
+    double denom;                /* denominator of the footprint size */
+    float cloud_high;            /* cloud noise level of high confidence */
+    float cloud_moderate;        /* cloud noise level of moderate
+                                    confidence */
+    float snow_high;             /* snow noise level of high confidence */
+    float cirrus_high;           /* cirrus noise level of high confidence */
+    float cirrus_moderate;       /* cirrus noise level of moderate
+                                    confidence */
+    float value;                 /* noise value of the pixel */
+    unsigned rnd;                /* random number of the pixel */
+    uint16_t qa;                 /* Level-1 QA value of the pixel */
+    uint8_t conf;                /* confidence of the pixel */
+    uint16_t *bqa_line = NULL;   /* line of the Level-1 QA band */
+    int16_t *b1_line = NULL;     /* line of band 1 */
+    uint64_t seed;               /* seed of the scene */
+    Espa_level1_qa_type qa_category;  /* Level-1 QA layout */
+    Noise_field_t cloud;         /* cloud noise field */
+    Noise_field_t snow;          /* snow noise field */
+    Noise_field_t cirrus;        /* cirrus noise field */
+    FILE *fp_bqa = NULL;         /* Level-1 QA band */
+    FILE *fp_b1 = NULL;          /* band 1 */
+
+    /* Read the command-line arguments */
+    if (get_args (argc, argv, &scene_name, &nlines, &nsamps, &qa_category,
+        instrument, &cloud_cover, &seed) != SUCCESS)
+    {   /* get_args already printed the error message */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Set up the noise fields and their thresholds */
+    if (init_noise_field (nlines, nsamps, seed, &cloud) != SUCCESS ||
+        init_noise_field (nlines, nsamps, seed + 1, &snow) != SUCCESS ||
+        init_noise_field (nlines, nsamps, seed + 2, &cirrus) != SUCCESS)
+    {   /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+    cloud_high = noise_threshold (&cloud, nlines, nsamps, cloud_cover);
+    cloud_moderate = noise_threshold (&cloud, nlines, nsamps,
+        cloud_cover * 1.2);
+    snow_high = noise_threshold (&snow, nlines, nsamps, SNOW_COVER);
+    cirrus_high = noise_threshold (&cirrus, nlines, nsamps,
+        CIRRUS_COVER * 0.5);
+    cirrus_moderate = noise_threshold (&cirrus, nlines, nsamps,
+        CIRRUS_COVER);
+
+    /* Size the rotated footprint to fit inside the scene */
+    angle = FOOTPRINT_ANGLE * M_PI / 180.0;
+    center_line = (nlines - 1) / 2.0;
+    center_samp = (nsamps - 1) / 2.0;
+    denom = cos (angle) * cos (angle) - sin (angle) * sin (angle);
+    half_width = 0.49 * (nsamps * cos (angle) - nlines * sin (angle)) / denom;
+    half_height = 0.49 * (nlines * cos (angle) - nsamps * sin (angle)) /
+        denom;
+    if (half_width < nsamps * 0.1)
+        half_width = nsamps * 0.1;
+    if (half_height < nlines * 0.1)
+        half_height = nlines * 0.1;
+
+    /* Open the bands */
+    sprintf (band_file, "%.200s_bqa.img", scene_name);
+    fp_bqa = open_raw_binary (band_file, "w");
+    sprintf (band_file, "%.200s_b1.img", scene_name);
+    fp_b1 = open_raw_binary (band_file, "w");
+    bqa_line = calloc (nsamps, sizeof (uint16_t));
+    b1_line = calloc (nsamps, sizeof (int16_t));
+    if (fp_bqa == NULL || fp_b1 == NULL || bqa_line == NULL ||
+        b1_line == NULL)
+    {
+        sprintf (errmsg, "Unable to create the bands of %s", scene_name);
+        error_handler (true, FUNC_NAME, errmsg);
+        exit (EXIT_FAILURE);
+    }
+
+    for (line = 0; line < nlines; line++)
+    {
+        for (samp = 0; samp < nsamps; samp++)
+        {
+            /* Fill collar outside the rotated footprint */
+            u = (samp - center_samp) * cos (angle) +
+                (line - center_line) * sin (angle);
+            v = (line - center_line) * cos (angle) -
+                (samp - center_samp) * sin (angle);
+            if (fabs (u) > half_width || fabs (v) > half_height)
+            {
+                bqa_line[samp] = 1 << ESPA_L1_DESIGNATED_FILL_BIT;
+                b1_line[samp] = B1_FILL;
+                continue;
+            }
+
+            rnd = pixel_random (seed, line, samp);
+            qa = 0;
+
+            /* Clouds, with the confidence falling off at their edges */
+            value = noise_value (&cloud, line, samp);
+            if (value >= cloud_high)
+            {
+                qa |= 1 << ESPA_L1_CLOUD_BIT;
+                conf = L1QA_HIGH_CONF;
+                b1_line[samp] = 5000 + (rnd & 1023);
+            }
+            else if (value >= cloud_moderate)
+            {
+                conf = L1QA_MODERATE_CONF;
+                b1_line[samp] = 2500 + (rnd & 1023);
+            }
+            else
+            {
+                conf = L1QA_LOW_CONF;
+                b1_line[samp] = 300 + (rnd & 511);
+            }
+            qa |= conf << ESPA_L1_CLOUD_CONF_BIT;
+
+            /* Shadows of the clouds, offset away from the sun */
+            if (conf != L1QA_HIGH_CONF &&
+                noise_value (&cloud, line - SHADOW_OFFSET_LINES,
+                samp - SHADOW_OFFSET_SAMPS) >= cloud_high)
+            {
+                qa |= L1QA_HIGH_CONF << ESPA_L1_CLOUD_SHADOW_CONF_BIT;
+                b1_line[samp] = 100 + (rnd & 127);
+            }
+            else
+                qa |= L1QA_LOW_CONF << ESPA_L1_CLOUD_SHADOW_CONF_BIT;
+
+            /* Snow where it isn't cloud */
+            if (conf != L1QA_HIGH_CONF &&
+                noise_value (&snow, line, samp) >= snow_high)
+            {
+                qa |= L1QA_HIGH_CONF << ESPA_L1_SNOW_ICE_CONF_BIT;
+                b1_line[samp] = 7000 + (rnd & 1023);
+            }
+            else
+                qa |= L1QA_LOW_CONF << ESPA_L1_SNOW_ICE_CONF_BIT;
+
+            /* Cirrus and terrain occlusion (OLI), or dropped pixels
+               (TM/ETM+) */
+            if (qa_category == LEVEL1_L8)
+            {
+                value = noise_value (&cirrus, line, samp);
+                if (value >= cirrus_high)
+                    conf = L1QA_HIGH_CONF;
+                else if (value >= cirrus_moderate)
+                    conf = L1QA_MODERATE_CONF;
+                else
+                    conf = L1QA_LOW_CONF;
+                qa |= conf << ESPA_L1_CIRRUS_CONF_BIT;
+            }
+            if (rnd % 20000 == 0)
+                qa |= 1 << ESPA_L1_TERRAIN_OCCLUSION_BIT;
+
+            /* Sparse radiometric saturation */
+            if (rnd % 1000 == 1)
+                qa |= ((rnd >> 10) % 3 + 1) << ESPA_L1_RAD_SATURATION_BIT;
+
+            bqa_line[samp] = qa;
+        }
+
+        if (write_raw_binary (fp_bqa, 1, nsamps, sizeof (uint16_t),
+            bqa_line) != SUCCESS ||
+            write_raw_binary (fp_b1, 1, nsamps, sizeof (int16_t),
+            b1_line) != SUCCESS)
+        {
+            sprintf (errmsg, "Unable to write line %d of %s", line,
+                scene_name);
+            error_handler (true, FUNC_NAME, errmsg);
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    close_raw_binary (fp_bqa);
+    close_raw_binary (fp_b1);
+    free (bqa_line);
+    free (b1_line);
+    free_noise_field (&cloud);
+    free_noise_field (&snow);
+    free_noise_field (&cirrus);
+
+    /* Write the XML file */
+    if (write_scene_metadata (scene_name, instrument, nlines, nsamps)
+        != SUCCESS)
+    {   /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+
+    free (scene_name);
+    exit (SUCCESS);
+}
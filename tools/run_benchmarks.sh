@@ -0,0 +1,67 @@
+#! /bin/sh
+#-----------------------------------------------------------------------------
+# run_benchmarks.sh
+#
+# Generates synthetic scenes with generate_synthetic_scene and times the QA
+# tools on each of them with benchmark_qa, so the benchmarks need no external
+# data.  Run by 'make bench'; the settings can be overridden from the
+# environment:
+#     BENCH_SIZES       scene sizes as LINESxSAMPS (default "2000x2000
+#                       7001x7971", the second the size of a full scene)
+#     BENCH_INSTRUMENTS instruments of the scenes (default "oli etm")
+#     BENCH_DISTANCES   dilation distances (default "1,3,5")
+#     BENCH_THREADS     thread counts for the kernels (default "1,2,4")
+#     BENCH_REPEAT      runs of each phase (default 3)
+#     BENCH_COUNTERS    "yes" to count the hardware events of each phase
+#                       with perf_event_open (default "no")
+#     BENCH_DIR         directory for the scenes (default is a temporary
+#                       directory, removed at the end)
+#-----------------------------------------------------------------------------
+BENCH_SIZES=${BENCH_SIZES:-"2000x2000 7001x7971"}
+BENCH_INSTRUMENTS=${BENCH_INSTRUMENTS:-"oli etm"}
+BENCH_DISTANCES=${BENCH_DISTANCES:-"1,3,5"}
+BENCH_THREADS=${BENCH_THREADS:-"1,2,4"}
+BENCH_REPEAT=${BENCH_REPEAT:-3}
+BENCH_COUNTERS=${BENCH_COUNTERS:-no}
+
+counters_option=
+if [ "$BENCH_COUNTERS" = yes ]; then
+    counters_option=--counters
+fi
+
+TOOLS_DIR=$(cd "$(dirname "$0")" && pwd)
+if [ -n "$BENCH_DIR" ]; then
+    mkdir -p "$BENCH_DIR" || exit 1
+    remove_dir=no
+else
+    BENCH_DIR=$(mktemp -d "${TMPDIR:-/tmp}/qa_bench.XXXXXX") || exit 1
+    remove_dir=yes
+fi
+
+status=0
+cd "$BENCH_DIR" || exit 1
+for size in $BENCH_SIZES; do
+    lines=${size%x*}
+    samps=${size#*x}
+    for instrument in $BENCH_INSTRUMENTS; do
+        scene=synthetic_${instrument}_${lines}x${samps}
+        echo "== $scene"
+        if ! "$TOOLS_DIR/generate_synthetic_scene" --output=$scene \
+            --lines=$lines --samps=$samps --instrument=$instrument; then
+            status=1
+            continue
+        fi
+        if ! "$TOOLS_DIR/benchmark_qa" --xml=$scene.xml \
+            --distances=$BENCH_DISTANCES --threads=$BENCH_THREADS \
+            --repeat=$BENCH_REPEAT $counters_option; then
+            status=1
+        fi
+        rm -f ${scene}*
+    done
+done
+
+cd "$TOOLS_DIR"
+if [ $remove_dir = yes ]; then
+    rm -rf "$BENCH_DIR"
+fi
+exit $status
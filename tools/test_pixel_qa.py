@@ -0,0 +1,307 @@
+#! /usr/bin/env python
+'''Checks the NumPy array methods of pixel_qa.py against its scalar methods
+   and the PixelQAMask lookup tables against the same expressions written with
+   the array methods, over every possible pixel QA value, pixel_qa_scene_stats
+   against single-process counts of small scenes, and the argument checks of
+   the _pixel_qa dilation if the extension module has been built (make
+   python).
+
+   usage: test_pixel_qa.py
+'''
+import sys
+import os
+import shutil
+import tempfile
+import numpy
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(TOOLS_DIR, '..', 'pixel_qa'))
+import pixel_qa
+from pixel_qa import PixelQA, PixelQAMask
+
+# Scalar methods of PixelQA with a <name>_array counterpart, and the dtype the
+# array method returns
+ARRAY_METHODS = [
+    ('pixel_qa_is_fill', numpy.bool_),
+    ('pixel_qa_is_clear', numpy.bool_),
+    ('pixel_qa_is_water', numpy.bool_),
+    ('pixel_qa_is_cloud_shadow', numpy.bool_),
+    ('pixel_qa_is_snow', numpy.bool_),
+    ('pixel_qa_is_cloud', numpy.bool_),
+    ('pixel_qa_cloud_confidence', numpy.uint8),
+    ('pixel_qa_cirrus_confidence', numpy.uint8),
+    ('pixel_qa_is_terrain_occluded', numpy.bool_),
+]
+
+
+# Mask expressions and the same expressions written with the array methods,
+# covering the precedence of not, and, and or, the parentheses, both
+# spellings of each operator, and every comparison
+_clear = PixelQA.pixel_qa_is_clear_array
+_water = PixelQA.pixel_qa_is_water_array
+_snow = PixelQA.pixel_qa_is_snow_array
+_cloud = PixelQA.pixel_qa_is_cloud_array
+_cloud_conf = PixelQA.pixel_qa_cloud_confidence_array
+_cirrus_conf = PixelQA.pixel_qa_cirrus_confidence_array
+
+MASK_EXPRESSIONS = [
+    ('fill', PixelQA.pixel_qa_is_fill_array),
+    ('cloud_shadow', PixelQA.pixel_qa_is_cloud_shadow_array),
+    ('terrain_occlusion', PixelQA.pixel_qa_is_terrain_occluded_array),
+    ('not snow', lambda v: ~_snow(v)),
+    ('!!snow', _snow),
+    ('clear and not snow or water',
+     lambda v: (_clear(v) & ~_snow(v)) | _water(v)),
+    ('water | clear & snow', lambda v: _water(v) | (_clear(v) & _snow(v))),
+    ('not clear and snow', lambda v: ~_clear(v) & _snow(v)),
+    ('not (clear and snow)', lambda v: ~(_clear(v) & _snow(v))),
+    ('(water or clear) and snow', lambda v: (_water(v) | _clear(v)) & _snow(v)),
+    ('!(water | (clear & !cloud))',
+     lambda v: ~(_water(v) | (_clear(v) & ~_cloud(v)))),
+    ('clear and not snow or (water and cloud_conf < high)',
+     lambda v: ((_clear(v) & ~_snow(v)) |
+                (_water(v) & (_cloud_conf(v) < 3)))),
+    ('cloud_conf = high', lambda v: _cloud_conf(v) == 3),
+    ('cloud_conf == high', lambda v: _cloud_conf(v) == 3),
+    ('cloud_conf != none', lambda v: _cloud_conf(v) != 0),
+    ('cloud_conf < moderate', lambda v: _cloud_conf(v) < 2),
+    ('cloud_conf <= low', lambda v: _cloud_conf(v) <= 1),
+    ('cirrus_conf > 1', lambda v: _cirrus_conf(v) > 1),
+    ('cirrus_conf >= 3 or cloud_conf = 0',
+     lambda v: (_cirrus_conf(v) >= 3) | (_cloud_conf(v) == 0)),
+    ('  CLEAR And Cirrus_Conf<=Moderate  ',
+     lambda v: _clear(v) & (_cirrus_conf(v) <= 2)),
+]
+
+# Expressions PixelQAMask must reject with a ValueError
+INVALID_MASK_EXPRESSIONS = [
+    '', 'clear and', 'not', '(clear', '(clear snow)', 'clear)', 'clear snow',
+    'rain', 'clear $ snow', 'cloud_conf', 'cloud_conf <', 'cloud_conf < 4',
+    'cloud_conf < extreme', 'cloud_conf clear high', 'cloud_conf = = high',
+    'clear < high',
+]
+
+
+# Scenes for pixel_qa_scene_stats: (lines, samples, fraction of fill pixels),
+# and the (chunk_lines, nprocs) each is counted with.  The chunk sizes of 10,
+# 7, and 1 don't divide the 103 lines, and 256 makes a single chunk.
+STATS_SCENES = [(103, 71, 0.2), (5, 3, 1.0)]
+STATS_SETTINGS = [(256, 1), (10, 1), (10, 3), (7, 4), (1, 2), (256, 4)]
+
+# ESPA XML file with just the pixel QA band, as find_espa_band reads it
+STATS_XML = '''<?xml version="1.0" encoding="UTF-8"?>
+<espa_metadata version="2.0"
+    xmlns="http://espa.cr.usgs.gov/v2">
+    <bands>
+        <band product="level2_qa" source="level1" name="pixel_qa"
+            category="qa" data_type="UINT16" nlines="{}" nsamps="{}">
+            <file_name>{}</file_name>
+        </band>
+    </bands>
+</espa_metadata>
+'''
+
+
+'''Compares the actual and expected arrays, printing the result
+
+Returns:
+    0 if they match, 1 otherwise
+'''
+def compare(label, actual, expected):
+    actual = numpy.asarray(actual)
+    expected = numpy.asarray(expected)
+    if actual.shape != expected.shape:
+        print('FAILED {}: shape {} instead of {}'
+              .format(label, actual.shape, expected.shape))
+        return 1
+    mismatches = numpy.flatnonzero(actual != expected)
+    if len(mismatches) > 0:
+        print('FAILED {}: {} of {} values differ, first at {}'
+              .format(label, len(mismatches), expected.size, mismatches[:1]))
+        return 1
+    print('ok {}'.format(label))
+    return 0
+
+
+'''Compares each PixelQA array method with its scalar method, on a 1-D and a
+   2-D array of all the pixel QA values
+
+Returns:
+    Number of the comparisons which failed
+'''
+def test_array_methods():
+    values = numpy.arange(65536, dtype=numpy.uint16)
+    nfailed = 0
+    for (name, dtype) in ARRAY_METHODS:
+        scalar = getattr(PixelQA, name)
+        array = getattr(PixelQA, name + '_array')
+        expected = numpy.array([scalar(value) for value in range(65536)],
+                               dtype=dtype)
+
+        actual = array(values)
+        if actual.dtype != dtype:
+            print('FAILED {}_array: dtype {} instead of {}'
+                  .format(name, actual.dtype, numpy.dtype(dtype)))
+            nfailed += 1
+            continue
+        nfailed += compare(name + '_array', actual, expected)
+        nfailed += compare(name + '_array(2-D)',
+                           array(values.reshape(256, 256)),
+                           expected.reshape(256, 256))
+    return nfailed
+
+
+'''Compares the lookup table of each mask expression with the expression
+   written with the array methods, checks that apply() takes from the table,
+   and checks that the invalid expressions are rejected
+
+Returns:
+    Number of the checks which failed
+'''
+def test_mask_expressions():
+    values = numpy.arange(65536, dtype=numpy.uint16)
+    nfailed = 0
+    for (expression, function) in MASK_EXPRESSIONS:
+        try:
+            mask = PixelQAMask(expression)
+        except ValueError as error:
+            print('FAILED PixelQAMask({!r}): {}'.format(expression, error))
+            nfailed += 1
+            continue
+        nfailed += compare('PixelQAMask({!r}).lut'.format(expression),
+                           mask.lut, function(values))
+
+    mask = PixelQAMask(MASK_EXPRESSIONS[-1][0])
+    scene = numpy.random.RandomState(2).randint(0, 65536, size=(300, 257))
+    nfailed += compare('PixelQAMask.apply',
+                       mask.apply(scene.astype(numpy.uint16)),
+                       MASK_EXPRESSIONS[-1][1](scene))
+
+    for expression in INVALID_MASK_EXPRESSIONS:
+        try:
+            PixelQAMask(expression)
+            print('FAILED PixelQAMask({!r}) was accepted'.format(expression))
+            nfailed += 1
+        except ValueError:
+            print('ok PixelQAMask({!r}) is rejected'.format(expression))
+    return nfailed
+
+
+'''Counts the statistics of pixel_qa_scene_stats from the whole band with
+   numpy.bincount of each bit and confidence field
+
+Returns:
+    Dictionary of the statistics
+'''
+def reference_scene_stats(band):
+    band = band.ravel()
+    not_fill = ((band >> pixel_qa.PQA_FILL) & 1) == 0
+    stats = {'npixels': band.size, 'bits': {}, 'fractions': {}}
+    for (name, bit) in pixel_qa.PQA_STATS_BITS.items():
+        stats['bits'][name] = int(numpy.bincount((band >> bit) & 1,
+                                                 minlength=2)[1])
+    for (name, bit) in (('cloud_conf', pixel_qa.PQA_CLOUD_CONF1),
+                        ('cirrus_conf', pixel_qa.PQA_CIRRUS_CONF1)):
+        stats[name] = [int(count) for count in
+                       numpy.bincount((band >> bit) & 3, minlength=4)]
+
+    nvalid = int(numpy.count_nonzero(not_fill))
+    for name in ('clear', 'cloud', 'snow', 'water'):
+        bit = pixel_qa.PQA_STATS_BITS[name]
+        set_bits = (band[not_fill] >> bit) & 1
+        if nvalid > 0:
+            stats['fractions'][name] = (
+                int(numpy.bincount(set_bits, minlength=2)[1]) / float(nvalid))
+        else:
+            stats['fractions'][name] = 0.0
+    return stats
+
+
+'''Compares pixel_qa_scene_stats with reference_scene_stats on generated
+   scenes, in one and several processes and with chunks which don't divide
+   the scene
+
+Returns:
+    Number of the checks which failed
+'''
+def test_scene_stats():
+    nfailed = 0
+    rng = numpy.random.RandomState(3)
+    tmp_dir = tempfile.mkdtemp(prefix='test_pixel_qa_')
+    try:
+        for (nlines, nsamps, fill_fraction) in STATS_SCENES:
+            band = rng.randint(0, 65536, size=(nlines, nsamps))
+            band = band.astype(numpy.uint16) & ~numpy.uint16(1)
+            band[rng.random_sample((nlines, nsamps)) < fill_fraction] = 1
+            xml_file = os.path.join(tmp_dir, 'scene_{}.xml'.format(nlines))
+            img_file = 'scene_{}_pixel_qa.img'.format(nlines)
+            band.astype('<u2').tofile(os.path.join(tmp_dir, img_file))
+            with open(xml_file, 'w') as xml:
+                xml.write(STATS_XML.format(nlines, nsamps, img_file))
+
+            expected = reference_scene_stats(band)
+            for (chunk_lines, nprocs) in STATS_SETTINGS:
+                label = ('pixel_qa_scene_stats({}x{}, chunk_lines={}, '
+                         'nprocs={})'.format(nlines, nsamps, chunk_lines,
+                                             nprocs))
+                actual = pixel_qa.pixel_qa_scene_stats(
+                    xml_file, chunk_lines=chunk_lines, nprocs=nprocs)
+                if actual != expected:
+                    print('FAILED {}: {} instead of {}'
+                          .format(label, actual, expected))
+                    nfailed += 1
+                else:
+                    print('ok {}'.format(label))
+    finally:
+        shutil.rmtree(tmp_dir)
+    return nfailed
+
+
+'''Checks that the _pixel_qa dilation clamps distances larger than the scene
+   and rejects outputs overlapping the input
+
+Returns:
+    Number of the checks which failed
+'''
+def test_native_dilation():
+    if pixel_qa._pixel_qa is None:
+        print('skipped _pixel_qa dilation: the extension module is not '
+              'built')
+        return 0
+
+    nfailed = 0
+    rng = numpy.random.RandomState(1)
+    l2_qa = numpy.where(rng.random_sample((40, 57)) < 0.01,
+                        numpy.uint16(1 << 5), numpy.uint16(0))
+    nfailed += compare('dilate_pixel_qa_array(distance=2^31-1)',
+                       pixel_qa.dilate_pixel_qa_array(l2_qa, 5, 2**31 - 1),
+                       pixel_qa.dilate_pixel_qa_array(l2_qa, 5, 57))
+
+    band = numpy.zeros((80, 57), dtype=numpy.uint16)
+    for (first, last) in ((0, 40), (20, 60), (39, 79)):
+        try:
+            pixel_qa._pixel_qa.dilate_pixel_qa(band[:40], 5, 1,
+                                               band[first:last])
+            print('FAILED dilate_pixel_qa: output lines {}-{} overlapping '
+                  'the input were accepted'.format(first, last))
+            nfailed += 1
+        except ValueError:
+            print('ok dilate_pixel_qa rejects output lines {}-{}'
+                  .format(first, last))
+    return nfailed
+
+
+def main():
+    nfailed = test_array_methods()
+    nfailed += test_mask_expressions()
+    nfailed += test_scene_stats()
+    nfailed += test_native_dilation()
+    if nfailed > 0:
+        print('{} pixel QA checks failed'.format(nfailed))
+        return 1
+    print('All pixel QA checks passed')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
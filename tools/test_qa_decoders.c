@@ -0,0 +1,290 @@
+/*****************************************************************************
+FILE: test_qa_decoders.c
+
+PURPOSE: Contains a test program which writes the results of one of the
+Level-1 or Level-2 QA interrogation functions for every possible QA value,
+so other implementations of the decoders (i.e. level1_qa.py and level2_qa.py)
+can be compared with them.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The results are written to standard output as one byte per QA value, in
+     order of the QA values: 65536 bytes for the 16-bit bands (Level-1 QA,
+     LaSRC radsat) and 256 bytes for the 8-bit bands.
+  2. test_qa_decoders.py runs this program for each decoder and compares the
+     results with the Python decoders.
+*****************************************************************************/
+#include <getopt.h>
+#include "read_level1_qa.h"
+#include "read_level2_qa.h"
+
+/* Decoder of a single QA value; bit is used only by the saturation tests */
+typedef uint8_t (*Qa_decoder_t) (uint32_t qa, int bit);
+
+/* Wrap the inline functions as decoders */
+#define DECODER(FUNC, TYPE) \
+static uint8_t decode_##FUNC (uint32_t qa, int bit) \
+{ \
+    return (uint8_t) FUNC ((TYPE) qa); \
+}
+#define BIT_DECODER(FUNC, TYPE) \
+static uint8_t decode_##FUNC (uint32_t qa, int bit) \
+{ \
+    return (uint8_t) FUNC ((TYPE) qa, (uint8_t) bit); \
+}
+
+DECODER (level1_qa_is_fill, uint16_t)
+DECODER (level1_qa_is_terrain_occluded, uint16_t)
+DECODER (level1_qa_is_dropped_pixel, uint16_t)
+DECODER (level1_qa_radiometric_saturation, uint16_t)
+DECODER (level1_qa_is_cloud, uint16_t)
+DECODER (level1_qa_cloud_confidence, uint16_t)
+DECODER (level1_qa_cloud_shadow_confidence, uint16_t)
+DECODER (level1_qa_snow_ice_confidence, uint16_t)
+DECODER (level1_qa_cirrus_confidence, uint16_t)
+DECODER (ledaps_qa_is_fill, uint8_t)
+BIT_DECODER (ledaps_qa_is_saturated, uint8_t)
+DECODER (ledaps_qa_is_ddv, uint8_t)
+DECODER (ledaps_qa_is_cloud, uint8_t)
+DECODER (ledaps_qa_is_cloud_shadow, uint8_t)
+DECODER (ledaps_qa_is_adj_cloud, uint8_t)
+DECODER (ledaps_qa_is_snow, uint8_t)
+DECODER (ledaps_qa_is_land_water, uint8_t)
+DECODER (lasrc_radsat_qa_is_fill, uint16_t)
+BIT_DECODER (lasrc_radsat_qa_is_saturated, uint16_t)
+DECODER (lasrc_qa_is_fill, uint8_t)
+DECODER (lasrc_qa_is_valid_aerosol_retrieval, uint8_t)
+DECODER (lasrc_qa_is_aerosol_interp, uint8_t)
+DECODER (lasrc_qa_is_water, uint8_t)
+DECODER (lasrc_qa_aerosol_level, uint8_t)
+
+/* Table of the decoders by name, with the number of QA bits they take */
+#define DECODER_ENTRY(FUNC, NBITS) {#FUNC, NBITS, decode_##FUNC}
+static const struct
+{
+    const char *name;      /* name of the inline function */
+    int nbits;             /* number of bits in the QA value (8 or 16) */
+    Qa_decoder_t decode;   /* wrapper of the inline function */
+} decoders[] =
+{
+    DECODER_ENTRY (level1_qa_is_fill, 16),
+    DECODER_ENTRY (level1_qa_is_terrain_occluded, 16),
+    DECODER_ENTRY (level1_qa_is_dropped_pixel, 16),
+    DECODER_ENTRY (level1_qa_radiometric_saturation, 16),
+    DECODER_ENTRY (level1_qa_is_cloud, 16),
+    DECODER_ENTRY (level1_qa_cloud_confidence, 16),
+    DECODER_ENTRY (level1_qa_cloud_shadow_confidence, 16),
+    DECODER_ENTRY (level1_qa_snow_ice_confidence, 16),
+    DECODER_ENTRY (level1_qa_cirrus_confidence, 16),
+    DECODER_ENTRY (ledaps_qa_is_fill, 8),
+    DECODER_ENTRY (ledaps_qa_is_saturated, 8),
+    DECODER_ENTRY (ledaps_qa_is_ddv, 8),
+    DECODER_ENTRY (ledaps_qa_is_cloud, 8),
+    DECODER_ENTRY (ledaps_qa_is_cloud_shadow, 8),
+    DECODER_ENTRY (ledaps_qa_is_adj_cloud, 8),
+    DECODER_ENTRY (ledaps_qa_is_snow, 8),
+    DECODER_ENTRY (ledaps_qa_is_land_water, 8),
+    DECODER_ENTRY (lasrc_radsat_qa_is_fill, 16),
+    DECODER_ENTRY (lasrc_radsat_qa_is_saturated, 16),
+    DECODER_ENTRY (lasrc_qa_is_fill, 8),
+    DECODER_ENTRY (lasrc_qa_is_valid_aerosol_retrieval, 8),
+    DECODER_ENTRY (lasrc_qa_is_aerosol_interp, 8),
+    DECODER_ENTRY (lasrc_qa_is_water, 8),
+    DECODER_ENTRY (lasrc_qa_aerosol_level, 8)
+};
+#define NDECODERS ((int) (sizeof (decoders) / sizeof (decoders[0])))
+
+/******************************************************************************
+MODULE: usage
+
+PURPOSE: Prints the usage information for this application.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void usage ()
+{
+    int i;                 /* looping variable */
+
+    printf ("test_qa_decoders writes the result of a Level-1 or Level-2 QA "
+            "interrogation function for every possible QA value to standard "
+            "output, one byte per value.\n\n");
+    printf ("usage: test_qa_decoders --decoder=function_name [--bit=n]\n");
+
+    printf ("\nwhere the following parameters are required:\n");
+    printf ("    -decoder: name of the inline function, one of\n");
+    for (i = 0; i < NDECODERS; i++)
+        printf ("        %s\n", decoders[i].name);
+    printf ("\nwhere the following parameters are optional:\n");
+    printf ("    -bit: band saturation bit for ledaps_qa_is_saturated and "
+            "lasrc_radsat_qa_is_saturated (default is 1)\n");
+    printf ("\nExample: test_qa_decoders --decoder=ledaps_qa_is_saturated "
+            "--bit=3 > ledaps_b3_sat.bin\n");
+}
+
+
+/******************************************************************************
+MODULE:  get_args
+
+PURPOSE:  Gets the command-line arguments and validates that the required
+arguments were specified.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error getting the command-line arguments or a command-line
+                argument and associated value were not specified
+SUCCESS         No errors encountered
+
+NOTES:
+******************************************************************************/
+short get_args
+(
+    int argc,             /* I: number of cmd-line args */
+    char *argv[],         /* I: string of cmd-line args */
+    int *decoder,         /* O: index of the decoder in the table */
+    int *bit              /* O: band saturation bit */
+)
+{
+    int c;                           /* current argument index */
+    int i;                           /* looping variable */
+    int option_index;                /* index for the command-line option */
+    char errmsg[STR_SIZE];           /* error message */
+    char FUNC_NAME[] = "get_args";   /* function name */
+    static struct option long_options[] =
+    {
+        {"decoder", required_argument, 0, 'd'},
+        {"bit", required_argument, 0, 'b'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    *decoder = -1;
+    *bit = 1;
+
+    /* Loop through all the cmd-line options */
+    opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
+    while (1)
+    {
+        /* optstring in call to getopt_long is empty since we will only
+           support the long options */
+        c = getopt_long (argc, argv, "", long_options, &option_index);
+        if (c == -1)
+        {   /* Out of cmd-line options */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* If this option set a flag, do nothing else now. */
+                if (long_options[option_index].flag != 0)
+                    break;
+
+            case 'h':  /* help */
+                usage ();
+                return (ERROR);
+                break;
+
+            case 'd':  /* name of the decoder */
+                for (i = 0; i < NDECODERS; i++)
+                {
+                    if (!strcmp (optarg, decoders[i].name))
+                        *decoder = i;
+                }
+                if (*decoder == -1)
+                {
+                    sprintf (errmsg, "Unknown decoder %.80s", optarg);
+                    error_handler (true, FUNC_NAME, errmsg);
+                    usage ();
+                    return (ERROR);
+                }
+                break;
+
+            case 'b':  /* band saturation bit */
+                *bit = atoi (optarg);
+                break;
+
+            case '?':
+            default:
+                sprintf (errmsg, "Unknown option %s", argv[optind-1]);
+                error_handler (true, FUNC_NAME, errmsg);
+                usage ();
+                return (ERROR);
+                break;
+        }
+    }
+
+    /* Make sure the decoder was specified */
+    if (*decoder == -1)
+    {
+        sprintf (errmsg, "Decoder is a required argument");
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    /* Make sure the bit is in the QA value */
+    if (*bit < 0 || *bit >= decoders[*decoder].nbits)
+    {
+        sprintf (errmsg, "Bit must be between 0 and %d",
+            decoders[*decoder].nbits - 1);
+        error_handler (true, FUNC_NAME, errmsg);
+        usage ();
+        return (ERROR);
+    }
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  main
+
+PURPOSE:  Writes the results of the decoder for every possible QA value.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error writing the results
+SUCCESS         No errors encountered
+
+NOTES:
+******************************************************************************/
+int main (int argc, char** argv)
+{
+    char FUNC_NAME[] = "main";  /* function name */
+    char errmsg[STR_SIZE];      /* error message */
+    int decoder;                /* index of the decoder in the table */
+    int bit;                    /* band saturation bit */
+    uint32_t qa;                /* QA value */
+    uint32_t nvalues;           /* number of possible QA values */
+    static uint8_t results[65536];  /* result for each QA value */
+
+    /* Read the command-line arguments */
+    if (get_args (argc, argv, &decoder, &bit) != SUCCESS)
+        exit (ERROR);
+
+    /* Decode every possible QA value */
+    nvalues = 1u << decoders[decoder].nbits;
+    for (qa = 0; qa < nvalues; qa++)
+        results[qa] = decoders[decoder].decode (qa, bit);
+
+    if (fwrite (results, 1, nvalues, stdout) != nvalues)
+    {
+        sprintf (errmsg, "Unable to write the results of %s",
+            decoders[decoder].name);
+        error_handler (true, FUNC_NAME, errmsg);
+        exit (ERROR);
+    }
+
+    exit (SUCCESS);
+}
@@ -0,0 +1,101 @@
+#! /usr/bin/env python
+'''Compares the vectorized Python decoders of level1_qa.py and level2_qa.py
+   with the inline functions of read_level1_qa.h and read_level2_qa.h over
+   every possible QA value, using the results written by test_qa_decoders.
+
+   usage: test_qa_decoders.py [path_to_test_qa_decoders]
+'''
+import sys
+import os
+import subprocess
+import numpy
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(TOOLS_DIR, '..', 'level1_lib'))
+sys.path.insert(0, os.path.join(TOOLS_DIR, '..', 'level2_lib'))
+import level1_qa
+import level2_qa
+
+# Decoders to be compared: (module, function name, QA bits, saturation bits)
+DECODERS = [
+    (level1_qa, 'level1_qa_is_fill', 16, None),
+    (level1_qa, 'level1_qa_is_terrain_occluded', 16, None),
+    (level1_qa, 'level1_qa_is_dropped_pixel', 16, None),
+    (level1_qa, 'level1_qa_radiometric_saturation', 16, None),
+    (level1_qa, 'level1_qa_is_cloud', 16, None),
+    (level1_qa, 'level1_qa_cloud_confidence', 16, None),
+    (level1_qa, 'level1_qa_cloud_shadow_confidence', 16, None),
+    (level1_qa, 'level1_qa_snow_ice_confidence', 16, None),
+    (level1_qa, 'level1_qa_cirrus_confidence', 16, None),
+    (level2_qa, 'ledaps_qa_is_fill', 8, None),
+    (level2_qa, 'ledaps_qa_is_saturated', 8,
+     range(level2_qa.LEDAPS_B1_SAT_BIT, level2_qa.LEDAPS_B7_SAT_BIT + 1)),
+    (level2_qa, 'ledaps_qa_is_ddv', 8, None),
+    (level2_qa, 'ledaps_qa_is_cloud', 8, None),
+    (level2_qa, 'ledaps_qa_is_cloud_shadow', 8, None),
+    (level2_qa, 'ledaps_qa_is_adj_cloud', 8, None),
+    (level2_qa, 'ledaps_qa_is_snow', 8, None),
+    (level2_qa, 'ledaps_qa_is_land_water', 8, None),
+    (level2_qa, 'lasrc_radsat_qa_is_fill', 16, None),
+    (level2_qa, 'lasrc_radsat_qa_is_saturated', 16,
+     range(level2_qa.LASRC_B1_SAT_BIT, level2_qa.LASRC_B11_SAT_BIT + 1)),
+    (level2_qa, 'lasrc_qa_is_fill', 8, None),
+    (level2_qa, 'lasrc_qa_is_valid_aerosol_retrieval', 8, None),
+    (level2_qa, 'lasrc_qa_is_aerosol_interp', 8, None),
+    (level2_qa, 'lasrc_qa_is_water', 8, None),
+    (level2_qa, 'lasrc_qa_aerosol_level', 8, None),
+]
+
+
+'''Runs test_qa_decoders for the decoder
+
+Returns:
+    uint8 array of the C results for every QA value
+'''
+def c_results(exe, name, bit):
+    cmd = [exe, '--decoder=' + name]
+    if bit is not None:
+        cmd.append('--bit={}'.format(bit))
+    return numpy.frombuffer(subprocess.check_output(cmd), dtype=numpy.uint8)
+
+
+def main():
+    if len(sys.argv) > 1:
+        exe = sys.argv[1]
+    else:
+        exe = os.path.join(TOOLS_DIR, 'test_qa_decoders')
+
+    nfailed = 0
+    for (module, name, nbits, bits) in DECODERS:
+        if nbits == 16:
+            values = numpy.arange(65536, dtype=numpy.uint16)
+        else:
+            values = numpy.arange(256, dtype=numpy.uint8)
+        function = getattr(module, name)
+        for bit in (bits if bits is not None else [None]):
+            expected = c_results(exe, name, bit)
+            if bit is None:
+                actual = function(values)
+            else:
+                actual = function(values, bit)
+            actual = numpy.asarray(actual).astype(numpy.uint8)
+
+            label = name if bit is None else '{}(bit={})'.format(name, bit)
+            mismatches = numpy.flatnonzero(actual != expected)
+            if actual.shape != expected.shape or len(mismatches) > 0:
+                nfailed += 1
+                print('FAILED {}: {} of {} values differ, first at {}'
+                      .format(label, len(mismatches), len(expected),
+                              mismatches[:1]))
+            else:
+                print('ok {}'.format(label))
+
+    if nfailed > 0:
+        print('{} decoders differ from the C functions'.format(nfailed))
+        return 1
+    print('All decoders match the C functions')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
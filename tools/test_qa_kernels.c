@@ -0,0 +1,2688 @@
+/*****************************************************************************
+FILE: test_qa_kernels.c
+
+PURPOSE: Contains a test program which checks every optimized QA kernel bit
+for bit against its reference kernel: the specialized Level-1 translation
+kernels against translate_level1_qa, the SSE2 Level-1 and LaSRC aerosol bulk
+decoders against the inline functions, the SSE2 LEDAPS and LaSRC radsat
+statistics against per-pixel counts, the QA mask rules against per-pixel
+calls to the inline decoders, the threaded Level-1 QA histogram
+against a single-threaded count, the bitplane packing against a plain
+per-bit packing, the GeoTIFF tiles and overviews against the scene and its
+2x2 OR reductions, and the strip, tiled, and threaded dilations against
+dilate_pixel_qa_reference.
+
+PROJECT:  Land Satellites Data System Science Research and Development (LSRD)
+at the USGS EROS
+
+LICENSE TYPE:  NASA Open Source Agreement Version 1.3
+
+NOTES:
+  1. The kernels are run on generated scenes for every Level-1 QA layout:
+     random QA values, random values without fill, a synthetic scene with a
+     fill collar and clustered clouds, shadows, and snow, scenes with all-fill
+     rows, an all-fill scene, and a scene with a single cloud pixel.  The
+     scene sizes include a single pixel, a single line and column, and sizes
+     which aren't multiples of the SIMD width or the strip size.
+  2. The dilations are checked for distance 0, small distances, and distances
+     as large as and larger than the scene.
+  3. translate_level1_qa only knows the Collection 1 layouts.  The
+     Collection 2 kernel is checked against a translation written with the
+     QA_PIXEL bit positions of the Collection 2 DFCB as literal defines, so
+     it doesn't share the layout table with the kernel.  A new layout needs
+     its own reference translation.
+  4. Every difference is reported with the kernel, the scene, and the first
+     differing value, and the program exits with ERROR if any kernel differs.
+     A new kernel only needs to be added to the matching test function.
+  5. The scenes are generated from --seed, so a failure can be reproduced.
+  6. The GeoTIFF cases write a scratch GeoTIFF in the current directory and
+     remove it.
+*****************************************************************************/
+#include <getopt.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "read_level1_qa.h"
+#include "level1_qa_layout.h"
+#include "level1_qa_bulk.h"
+#include "level1_qa_histogram.h"
+#include "read_level2_qa.h"
+#include "level2_qa_aerosol_bulk.h"
+#include "level2_qa_radsat_stats.h"
+#include "generate_pixel_qa.h"
+#include "pixel_qa_bitplanes.h"
+#include "pixel_qa_dilation.h"
+#include "pixel_qa_stream.h"
+#include "combine_qa_mask.h"
+
+/* Defines */
+#define KERNEL_THREADS 4           /* threads of the threaded kernels */
+#define TILE_LINES 7               /* lines in the odd-sized strips */
+#define MAX_HISTOGRAM_THREADS 64   /* most threads for the histogram case
+                                      with more threads than pixels */
+#define MAX_SCENE_NAME 64          /* maximum length of a scene name */
+
+/* TIFF field type, tags, and GeoKey read back from the pixel QA GeoTIFF */
+#define TIFF_TYPE_SHORT 3
+#define TIFF_NEW_SUBFILE_TYPE 254
+#define TIFF_IMAGE_WIDTH 256
+#define TIFF_IMAGE_LENGTH 257
+#define TIFF_TILE_WIDTH 322
+#define TIFF_TILE_LENGTH 323
+#define TIFF_TILE_OFFSETS 324
+#define TIFF_TILE_BYTE_COUNTS 325
+#define TIFF_GEO_KEY_DIRECTORY 34735
+#define GEO_PROJECTED_CS_TYPE_KEY 3072
+
+/* Types of generated scenes */
+typedef enum
+{
+    SCENE_RANDOM,           /* random QA values */
+    SCENE_NO_FILL,          /* random QA values without fill */
+    SCENE_SYNTHETIC,        /* fill collar with clustered classes */
+    SCENE_FILL_ROWS,        /* random QA values with every third row fill */
+    SCENE_ALL_FILL,         /* every pixel is fill */
+    SCENE_SINGLE_CLOUD,     /* clear scene with one cloud pixel */
+    NUM_SCENES
+} Scene_type_t;
+
+static const char *scene_names[NUM_SCENES] =
+{
+    "random", "no_fill", "synthetic", "fill_rows", "all_fill", "single_cloud"
+};
+
+/* Scene sizes (lines, samples) */
+static const int scene_sizes[][2] =
+{
+    {1, 1}, {1, 37}, {37, 1}, {3, 5}, {67, 45}, {70, 19}
+};
+#define NUM_SIZES ((int) (sizeof (scene_sizes) / sizeof (scene_sizes[0])))
+
+/* GeoTIFF sizes (lines, samples) and requested overview levels, covering a
+   single tile, partial tiles, and overviews of odd sizes */
+static const int geotiff_cases[][3] =
+{
+    {1, 1, 0}, {67, 45, 2}, {257, 256, 8}, {600, 517, 3}, {1100, 1000, 8}
+};
+#define NUM_GEOTIFF_CASES \
+    ((int) (sizeof (geotiff_cases) / sizeof (geotiff_cases[0])))
+
+/* Types of Level-1 QA data in the layout table */
+#define LAYOUT_CATEGORY(NAME, CATEGORY, ...) CATEGORY,
+static const Espa_level1_qa_type layout_categories[] =
+{
+    LEVEL1_QA_LAYOUT_TABLE (LAYOUT_CATEGORY)
+};
+#define NUM_LAYOUTS \
+    ((int) (sizeof (layout_categories) / sizeof (layout_categories[0])))
+
+/* Collection 2 QA_PIXEL bits, written out from the Collection 2 Level-1 DFCB
+   rather than taken from LEVEL1_QA_LAYOUT_TABLE */
+#define C2_QA_FILL_BIT 0               /* one bit */
+#define C2_QA_DILATED_CLOUD_BIT 1      /* one bit */
+#define C2_QA_CIRRUS_BIT 2             /* one bit */
+#define C2_QA_CLOUD_BIT 3              /* one bit */
+#define C2_QA_CLOUD_SHADOW_BIT 4       /* one bit */
+#define C2_QA_SNOW_BIT 5               /* one bit */
+#define C2_QA_CLEAR_BIT 6              /* one bit */
+#define C2_QA_WATER_BIT 7              /* one bit */
+#define C2_QA_CLOUD_CONF_BIT 8         /* two bits */
+#define C2_QA_CLOUD_SHADOW_CONF_BIT 10 /* two bits */
+#define C2_QA_SNOW_ICE_CONF_BIT 12     /* two bits */
+#define C2_QA_CIRRUS_CONF_BIT 14       /* two bits */
+
+/* Pixel QA bits which are dilated */
+static const uint8_t dilation_bits[] = {L2QA_CLOUD, L2QA_CLD_SHADOW, L2QA_SNOW};
+#define NUM_DILATION_BITS \
+    ((int) (sizeof (dilation_bits) / sizeof (dilation_bits[0])))
+
+/* Number of cases checked and number which differed */
+static int ncases = 0;
+static int nfailed = 0;
+
+/* State of the random number generator */
+static uint32_t random_state = 1;
+
+
+/******************************************************************************
+MODULE:  usage
+
+PURPOSE: Prints the usage information for this application.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+void usage ()
+{
+    printf ("test_qa_kernels runs each optimized QA kernel (translation, bulk "
+            "decoders, bitplanes, dilation) on generated scenes and reports "
+            "any bit which differs from the reference kernel.\n\n");
+    printf ("usage: test_qa_kernels [--seed=n]\n");
+
+    printf ("\nwhere the following parameters are optional:\n");
+    printf ("    -seed: seed of the generated scenes (default is 1)\n");
+    printf ("\nExample: test_qa_kernels --seed=7\n");
+}
+
+
+/******************************************************************************
+MODULE:  get_args
+
+PURPOSE:  Gets the command-line arguments.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error getting the command-line arguments
+SUCCESS         No errors encountered
+
+NOTES:
+******************************************************************************/
+short get_args
+(
+    int argc,             /* I: number of cmd-line args */
+    char *argv[],         /* I: string of cmd-line args */
+    uint32_t *seed        /* O: seed of the generated scenes */
+)
+{
+    int c;                           /* current argument index */
+    int option_index;                /* index for the command-line option */
+    char errmsg[STR_SIZE];           /* error message */
+    char FUNC_NAME[] = "get_args";   /* function name */
+    static struct option long_options[] =
+    {
+        {"seed", required_argument, 0, 's'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    *seed = 1;
+
+    /* Loop through all the cmd-line options */
+    opterr = 0;   /* turn off getopt_long error msgs as we'll print our own */
+    while (1)
+    {
+        /* optstring in call to getopt_long is empty since we will only
+           support the long options */
+        c = getopt_long (argc, argv, "", long_options, &option_index);
+        if (c == -1)
+        {   /* Out of cmd-line options */
+            break;
+        }
+
+        switch (c)
+        {
+            case 0:
+                /* If this option set a flag, do nothing else now. */
+                if (long_options[option_index].flag != 0)
+                    break;
+
+            case 'h':  /* help */
+                usage ();
+                return (ERROR);
+                break;
+
+            case 's':  /* seed of the generated scenes */
+                *seed = (uint32_t) strtoul (optarg, NULL, 10);
+                break;
+
+            case '?':
+            default:
+                sprintf (errmsg, "Unknown option %s", argv[optind-1]);
+                error_handler (true, FUNC_NAME, errmsg);
+                usage ();
+                return (ERROR);
+                break;
+        }
+    }
+
+    /* The generator needs a non-zero state */
+    if (*seed == 0)
+        *seed = 1;
+
+    return (SUCCESS);
+}
+
+
+/******************************************************************************
+MODULE:  next_random
+
+PURPOSE: Returns the next value of the xorshift random number generator.
+
+RETURN VALUE:
+Type = uint32_t
+Value           Description
+-----           -----------
+n               Random value
+
+NOTES:
+******************************************************************************/
+static uint32_t next_random ()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (random_state);
+}
+
+
+/******************************************************************************
+MODULE:  set_field
+
+PURPOSE: Sets a field of a Level-1 QA value, if the layout has the field.
+
+RETURN VALUE:
+Type = uint16_t
+Value           Description
+-----           -----------
+n               Level-1 QA value with the field set
+
+NOTES:
+******************************************************************************/
+static uint16_t set_field
+(
+    uint16_t qa,           /* I: Level-1 QA value */
+    int bit,               /* I: first bit of the field, or
+                                 LEVEL1_QA_NO_BIT */
+    int nbits,             /* I: number of bits in the field */
+    int value              /* I: value of the field */
+)
+{
+    uint16_t mask;         /* mask of the field */
+
+    if (bit == LEVEL1_QA_NO_BIT)
+        return (qa);
+
+    mask = ((1 << nbits) - 1) << bit;
+    return ((qa & ~mask) | ((value << bit) & mask));
+}
+
+
+/******************************************************************************
+MODULE:  make_level1_scene
+
+PURPOSE: Generates a Level-1 QA scene of the specified type for the layout.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The synthetic scene has a fill collar which changes width from line to
+   line, and discs of high confidence cloud with their shadows offset from
+   them, discs of snow, and random cirrus, terrain occlusion, and water.  The
+   classification flags, where the layout has them, agree with the
+   confidences.
+******************************************************************************/
+static void make_level1_scene
+(
+    Scene_type_t scene,    /* I: type of scene */
+    const Level1_qa_layout_t *layout, /* I: layout of the Level-1 QA */
+    int nlines,            /* I: number of lines */
+    int nsamps,            /* I: number of samples */
+    uint16_t *l1_qa        /* O: Level-1 QA values */
+)
+{
+    int line, samp;        /* looping variables */
+    int i;                 /* looping variable for the discs */
+    int ndiscs;            /* number of discs of each class */
+    int collar;            /* width of the fill collar of the line */
+    int dl, ds;            /* offset from the center of the disc */
+    int cloud[64][3];      /* line, sample, and radius of the cloud discs */
+    int snow[64][3];       /* line, sample, and radius of the snow discs */
+    long npixels = (long) nlines * nsamps;  /* number of pixels */
+    long pix;              /* looping variable for the pixels */
+    uint16_t qa;           /* Level-1 QA value of the current pixel */
+
+    switch (scene)
+    {
+        case SCENE_RANDOM:
+        case SCENE_NO_FILL:
+        case SCENE_FILL_ROWS:
+            for (pix = 0; pix < npixels; pix++)
+            {
+                qa = next_random () & 0xffff;
+                if (scene == SCENE_NO_FILL ||
+                    (scene == SCENE_FILL_ROWS && (pix / nsamps) % 3 != 0))
+                    qa = set_field (qa, layout->fill_bit, 1, 0);
+                else if (scene == SCENE_FILL_ROWS)
+                    qa = set_field (0, layout->fill_bit, 1, 1);
+                l1_qa[pix] = qa;
+            }
+            break;
+
+        case SCENE_ALL_FILL:
+            for (pix = 0; pix < npixels; pix++)
+                l1_qa[pix] = set_field (0, layout->fill_bit, 1, 1);
+            break;
+
+        case SCENE_SINGLE_CLOUD:
+            for (pix = 0; pix < npixels; pix++)
+            {
+                qa = set_field (0, layout->cloud_conf_bit, 2, L2QA_LOW_CONF);
+                l1_qa[pix] = set_field (qa, layout->clear_bit, 1, 1);
+            }
+            pix = next_random () % npixels;
+            l1_qa[pix] = set_field (l1_qa[pix], layout->clear_bit, 1, 0);
+            l1_qa[pix] = set_field (l1_qa[pix], layout->cloud_bit, 1, 1);
+            l1_qa[pix] = set_field (l1_qa[pix], layout->cloud_conf_bit, 2,
+                L2QA_HIGH_CONF);
+            break;
+
+        case SCENE_SYNTHETIC:
+        default:
+            ndiscs = 1 + npixels / 500;
+            if (ndiscs > 64)
+                ndiscs = 64;
+            for (i = 0; i < ndiscs; i++)
+            {
+                cloud[i][0] = next_random () % nlines;
+                cloud[i][1] = next_random () % nsamps;
+                cloud[i][2] = 1 + next_random () % 6;
+                snow[i][0] = next_random () % nlines;
+                snow[i][1] = next_random () % nsamps;
+                snow[i][2] = next_random () % 4;
+            }
+
+            for (line = 0; line < nlines; line++)
+            {
+                collar = nsamps / 8 + next_random () % 3;
+                for (samp = 0; samp < nsamps; samp++)
+                {
+                    if (samp < collar || samp >= nsamps - collar)
+                    {
+                        l1_qa[line * nsamps + samp] =
+                            set_field (0, layout->fill_bit, 1, 1);
+                        continue;
+                    }
+
+                    qa = set_field (0, layout->cloud_conf_bit, 2,
+                        L2QA_LOW_CONF);
+                    qa = set_field (qa, layout->cloud_shadow_conf_bit, 2,
+                        L2QA_LOW_CONF);
+                    qa = set_field (qa, layout->snow_ice_conf_bit, 2,
+                        L2QA_LOW_CONF);
+                    qa = set_field (qa, layout->cirrus_conf_bit, 2,
+                        next_random () % 4);
+                    qa = set_field (qa, layout->terrain_occlusion_bit, 1,
+                        next_random () % 50 == 0);
+                    qa = set_field (qa, layout->radiometric_saturation_bit, 2,
+                        next_random () % 20 == 0 ? 3 : 0);
+                    qa = set_field (qa, layout->dropped_pixel_bit, 1,
+                        next_random () % 100 == 0);
+
+                    for (i = 0; i < ndiscs; i++)
+                    {
+                        dl = line - cloud[i][0];
+                        ds = samp - cloud[i][1];
+                        if (dl * dl + ds * ds <= cloud[i][2] * cloud[i][2])
+                        {
+                            qa = set_field (qa, layout->cloud_bit, 1, 1);
+                            qa = set_field (qa, layout->cloud_conf_bit, 2,
+                                L2QA_HIGH_CONF);
+                        }
+                        else if (dl * dl + ds * ds <=
+                            (cloud[i][2] + 1) * (cloud[i][2] + 1))
+                            qa = set_field (qa, layout->cloud_conf_bit, 2,
+                                L2QA_MODERATE_CONF);
+
+                        dl -= 3;
+                        ds -= 2;
+                        if (dl * dl + ds * ds <= cloud[i][2] * cloud[i][2])
+                            qa = set_field (qa, layout->cloud_shadow_conf_bit,
+                                2, L2QA_HIGH_CONF);
+
+                        dl = line - snow[i][0];
+                        ds = samp - snow[i][1];
+                        if (dl * dl + ds * ds <= snow[i][2] * snow[i][2])
+                            qa = set_field (qa, layout->snow_ice_conf_bit, 2,
+                                L2QA_HIGH_CONF);
+                    }
+
+                    /* Classification flags of the layouts which have them */
+                    qa = set_field (qa, layout->cloud_shadow_bit, 1,
+                        level1_qa_layout_field (layout->cloud_shadow_conf_bit,
+                        2, qa) == L2QA_HIGH_CONF);
+                    qa = set_field (qa, layout->snow_bit, 1,
+                        level1_qa_layout_field (layout->snow_ice_conf_bit, 2,
+                        qa) == L2QA_HIGH_CONF);
+                    qa = set_field (qa, layout->clear_bit, 1,
+                        !level1_qa_layout_field (layout->cloud_bit, 1, qa));
+                    qa = set_field (qa, layout->water_bit, 1,
+                        next_random () % 10 == 0);
+                    l1_qa[line * nsamps + samp] = qa;
+                }
+            }
+            break;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  check_values
+
+PURPOSE: Compares the values of a kernel with the values of its reference
+kernel, and reports the first difference.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The values are identical
+false           At least one value differs
+
+NOTES:
+1. value_size is 1 for uint8 values and 2 for uint16 values.  For images
+   (nsamps > 0) the first difference is reported by line and sample, and
+   otherwise by index.
+******************************************************************************/
+static bool check_values
+(
+    const char *kernel,    /* I: name of the kernel */
+    const char *scene,     /* I: name of the scene and settings */
+    const void *expected,  /* I: values of the reference kernel */
+    const void *actual,    /* I: values of the kernel */
+    size_t nvalues,        /* I: number of values */
+    int value_size,        /* I: size of each value in bytes */
+    int nsamps             /* I: samples per line, or 0 if not an image */
+)
+{
+    size_t i;              /* looping variable */
+    size_t first = 0;      /* index of the first difference */
+    size_t ndiffer = 0;    /* number of values which differ */
+    unsigned exp_val = 0;  /* first differing reference value */
+    unsigned act_val = 0;  /* first differing kernel value */
+    unsigned e, a;         /* current values */
+
+    ncases++;
+    for (i = 0; i < nvalues; i++)
+    {
+        if (value_size == 1)
+        {
+            e = ((const uint8_t *) expected)[i];
+            a = ((const uint8_t *) actual)[i];
+        }
+        else
+        {
+            e = ((const uint16_t *) expected)[i];
+            a = ((const uint16_t *) actual)[i];
+        }
+
+        if (e != a)
+        {
+            if (ndiffer == 0)
+            {
+                first = i;
+                exp_val = e;
+                act_val = a;
+            }
+            ndiffer++;
+        }
+    }
+
+    if (ndiffer == 0)
+        return (true);
+
+    nfailed++;
+    if (nsamps > 0)
+        printf ("FAILED %s on %s: %zu of %zu values differ, first at line %zu "
+            "sample %zu: expected 0x%04x, got 0x%04x\n", kernel, scene,
+            ndiffer, nvalues, first / nsamps, first % nsamps, exp_val,
+            act_val);
+    else
+        printf ("FAILED %s on %s: %zu of %zu values differ, first at %zu: "
+            "expected 0x%02x, got 0x%02x\n", kernel, scene, ndiffer, nvalues,
+            first, exp_val, act_val);
+    return (false);
+}
+
+
+/******************************************************************************
+MODULE:  reference_translate_layout
+
+PURPOSE: Translates the Level-1 QA values into the pixel QA values with the
+rules of translate_level1_qa and the bit positions of the layout descriptor,
+and copies the saturation fields as described in pixel_qa.h.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The fields the layout doesn't have are 0, so cirrus and terrain occlusion
+   only apply to the layouts which have them, as translate_level1_qa only
+   applies them to L8.
+2. Only the Collection 1 rules are applied, so this is only a reference for
+   the Collection 1 layouts, where it's checked against translate_level1_qa
+   and provides the saturation values.
+******************************************************************************/
+static void reference_translate_layout
+(
+    const Level1_qa_layout_t *layout, /* I: layout of the Level-1 QA */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    int npixels,           /* I: number of pixels to be translated */
+    uint16_t *l2_qa,       /* O: pixel QA values */
+    uint8_t *l1_sat        /* O: Level-1 saturation QA values */
+)
+{
+    int i;                 /* looping variable */
+    uint16_t qa;           /* Level-1 QA value of the current pixel */
+    uint16_t pqa;          /* pixel QA value of the current pixel */
+    uint8_t conf;          /* confidence of the current pixel */
+
+    for (i = 0; i < npixels; i++)
+    {
+        qa = l1_qa[i];
+        l1_sat[i] = (level1_qa_layout_field (
+            layout->radiometric_saturation_bit, 2, qa) << L1SAT_RADSAT) |
+            (level1_qa_layout_field (layout->dropped_pixel_bit, 1, qa) <<
+            L1SAT_DROPPED);
+
+        if (level1_qa_layout_field (layout->fill_bit, 1, qa))
+        {
+            l2_qa[i] = (1 << L2QA_FILL);
+            continue;
+        }
+
+        pqa = (1 << L2QA_CLEAR);
+        if (level1_qa_layout_field (layout->cloud_shadow_conf_bit, 2, qa) ==
+            L2QA_HIGH_CONF)
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_CLD_SHADOW);
+        }
+
+        if (level1_qa_layout_field (layout->snow_ice_conf_bit, 2, qa) ==
+            L2QA_HIGH_CONF)
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_SNOW);
+        }
+
+        if (level1_qa_layout_field (layout->cloud_bit, 1, qa))
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_CLOUD);
+        }
+
+        conf = level1_qa_layout_field (layout->cloud_conf_bit, 2, qa);
+        if (conf == L2QA_LOW_CONF)
+            pqa |= (1 << L2QA_CLOUD_CONF1);
+        else if (conf == L2QA_MODERATE_CONF)
+            pqa |= (1 << L2QA_CLOUD_CONF2);
+        else if (conf == L2QA_HIGH_CONF)
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_CLOUD_CONF1) | (1 << L2QA_CLOUD_CONF2);
+        }
+
+        conf = level1_qa_layout_field (layout->cirrus_conf_bit, 2, qa);
+        if (conf == L2QA_LOW_CONF)
+            pqa |= (1 << L2QA_CIRRUS_CONF1);
+        else if (conf == L2QA_MODERATE_CONF)
+            pqa |= (1 << L2QA_CIRRUS_CONF2);
+        else if (conf == L2QA_HIGH_CONF)
+            pqa |= (1 << L2QA_CIRRUS_CONF1) | (1 << L2QA_CIRRUS_CONF2);
+
+        if (level1_qa_layout_field (layout->terrain_occlusion_bit, 1, qa))
+            pqa |= (1 << L2QA_TERRAIN_OCCL);
+
+        l2_qa[i] = pqa;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  reference_translate_c2
+
+PURPOSE: Translates the Collection 2 QA_PIXEL values into the pixel QA values
+with the C2_QA_* bit positions, as described for the Collection 2 layout in
+generate_pixel_qa.c.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. QA_PIXEL has no radiometric saturation or dropped pixel fields, so the
+   saturation values are all 0.
+2. The cloud shadow and snow flags replace the high confidences of the
+   Collection 1 rules, a pixel which isn't flagged clear or is flagged
+   dilated cloud isn't clear, the cirrus flag is high cirrus confidence, and
+   the water flag marks the pixels which are still clear as water.
+******************************************************************************/
+static void reference_translate_c2
+(
+    uint16_t *l1_qa,       /* I: QA_PIXEL values */
+    int npixels,           /* I: number of pixels to be translated */
+    uint16_t *l2_qa,       /* O: pixel QA values */
+    uint8_t *l1_sat        /* O: Level-1 saturation QA values */
+)
+{
+    int i;                 /* looping variable */
+    uint16_t qa;           /* QA_PIXEL value of the current pixel */
+    uint16_t pqa;          /* pixel QA value of the current pixel */
+    uint8_t conf;          /* confidence of the current pixel */
+
+    for (i = 0; i < npixels; i++)
+    {
+        qa = l1_qa[i];
+        l1_sat[i] = 0;
+
+        if ((qa >> C2_QA_FILL_BIT) & 1)
+        {
+            l2_qa[i] = (1 << L2QA_FILL);
+            continue;
+        }
+
+        pqa = 0;
+        if (((qa >> C2_QA_CLEAR_BIT) & 1) &&
+            !((qa >> C2_QA_DILATED_CLOUD_BIT) & 1))
+            pqa = (1 << L2QA_CLEAR);
+
+        if ((qa >> C2_QA_CLOUD_SHADOW_BIT) & 1)
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_CLD_SHADOW);
+        }
+
+        if ((qa >> C2_QA_SNOW_BIT) & 1)
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_SNOW);
+        }
+
+        if ((qa >> C2_QA_CLOUD_BIT) & 1)
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_CLOUD);
+        }
+
+        conf = (qa >> C2_QA_CLOUD_CONF_BIT) & 3;
+        if (conf == L2QA_LOW_CONF)
+            pqa |= (1 << L2QA_CLOUD_CONF1);
+        else if (conf == L2QA_MODERATE_CONF)
+            pqa |= (1 << L2QA_CLOUD_CONF2);
+        else if (conf == L2QA_HIGH_CONF)
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_CLOUD_CONF1) | (1 << L2QA_CLOUD_CONF2);
+        }
+
+        conf = (qa >> C2_QA_CIRRUS_CONF_BIT) & 3;
+        if (conf == L2QA_LOW_CONF)
+            pqa |= (1 << L2QA_CIRRUS_CONF1);
+        else if (conf == L2QA_MODERATE_CONF)
+            pqa |= (1 << L2QA_CIRRUS_CONF2);
+        if (conf == L2QA_HIGH_CONF || ((qa >> C2_QA_CIRRUS_BIT) & 1))
+            pqa |= (1 << L2QA_CIRRUS_CONF1) | (1 << L2QA_CIRRUS_CONF2);
+
+        if (((qa >> C2_QA_WATER_BIT) & 1) && (pqa & (1 << L2QA_CLEAR)))
+        {
+            pqa &= ~(1 << L2QA_CLEAR);
+            pqa |= (1 << L2QA_WATER);
+        }
+
+        l2_qa[i] = pqa;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  test_translation
+
+PURPOSE: Checks the translation kernels of a layout on a scene: the
+specialized kernel with and without the saturation output, run on the whole
+scene, in strips of TILE_LINES and QA_STREAM_STRIP_LINES lines, and in
+parallel strips.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void test_translation
+(
+    const Level1_qa_layout_t *layout, /* I: layout of the Level-1 QA */
+    const char *scene,     /* I: name of the scene */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    int nlines,            /* I: number of lines */
+    int nsamps,            /* I: number of samples */
+    uint16_t *expected,    /* O: reference pixel QA values */
+    uint8_t *expected_sat, /* O: reference saturation values */
+    uint16_t *l2_qa,       /* O: scratch pixel QA values */
+    uint8_t *l1_sat        /* O: scratch saturation values */
+)
+{
+    char kernel[STR_SIZE];         /* name of the kernel */
+    int npixels = nlines * nsamps; /* number of pixels */
+    int strip_sizes[2] = {TILE_LINES, QA_STREAM_STRIP_LINES}; /* strip lines */
+    int s;                 /* looping variable for the strip sizes */
+    int strip;             /* looping variable for the strips */
+    int nstrips;           /* number of strips */
+    Level1_qa_translator_t translate; /* specialized translation kernel */
+
+    /* Reference translation */
+    if (layout->qa_category == LEVEL1_L457 || layout->qa_category == LEVEL1_L8)
+    {
+        translate_level1_qa (l1_qa, npixels, layout->qa_category, expected);
+        reference_translate_layout (layout, l1_qa, npixels, l2_qa,
+            expected_sat);
+        sprintf (kernel, "%s layout reference translation",
+            layout->description);
+        check_values (kernel, scene, expected, l2_qa, npixels, 2, nsamps);
+    }
+    else if (layout->qa_category == LEVEL1_C2)
+        reference_translate_c2 (l1_qa, npixels, expected, expected_sat);
+    else
+    {
+        ncases++;
+        nfailed++;
+        printf ("FAILED %s: no reference translation\n",
+            layout->description);
+        return;
+    }
+
+    translate = get_level1_qa_translator (layout->qa_category);
+    if (translate == NULL)
+    {
+        ncases++;
+        nfailed++;
+        printf ("FAILED %s: no translation kernel\n", layout->description);
+        return;
+    }
+
+    /* Whole scene, without and with the saturation output */
+    memset (l2_qa, 0xaa, npixels * sizeof (uint16_t));
+    translate (l1_qa, npixels, l2_qa, NULL);
+    sprintf (kernel, "%s translation", layout->description);
+    check_values (kernel, scene, expected, l2_qa, npixels, 2, nsamps);
+
+    memset (l2_qa, 0xaa, npixels * sizeof (uint16_t));
+    memset (l1_sat, 0xaa, npixels);
+    translate (l1_qa, npixels, l2_qa, l1_sat);
+    sprintf (kernel, "%s translation with saturation", layout->description);
+    check_values (kernel, scene, expected, l2_qa, npixels, 2, nsamps);
+    strcat (kernel, " (saturation)");
+    check_values (kernel, scene, expected_sat, l1_sat, npixels, 1, nsamps);
+
+    /* Strips, in sequence and in parallel */
+    for (s = 0; s < 2; s++)
+    {
+        nstrips = (nlines + strip_sizes[s] - 1) / strip_sizes[s];
+
+        memset (l2_qa, 0xaa, npixels * sizeof (uint16_t));
+        for (strip = 0; strip < nstrips; strip++)
+        {
+            int offset = strip * strip_sizes[s] * nsamps;
+            int strip_lines = nlines - strip * strip_sizes[s];
+            if (strip_lines > strip_sizes[s])
+                strip_lines = strip_sizes[s];
+            translate (&l1_qa[offset], strip_lines * nsamps, &l2_qa[offset],
+                &l1_sat[offset]);
+        }
+        sprintf (kernel, "%s translation in %d-line strips",
+            layout->description, strip_sizes[s]);
+        check_values (kernel, scene, expected, l2_qa, npixels, 2, nsamps);
+
+        memset (l2_qa, 0xaa, npixels * sizeof (uint16_t));
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic) num_threads(KERNEL_THREADS)
+#endif
+        for (strip = 0; strip < nstrips; strip++)
+        {
+            int offset = strip * strip_sizes[s] * nsamps;
+            int strip_lines = nlines - strip * strip_sizes[s];
+            if (strip_lines > strip_sizes[s])
+                strip_lines = strip_sizes[s];
+            translate (&l1_qa[offset], strip_lines * nsamps, &l2_qa[offset],
+                NULL);
+        }
+        sprintf (kernel, "%s translation in threaded %d-line strips",
+            layout->description, strip_sizes[s]);
+        check_values (kernel, scene, expected, l2_qa, npixels, 2, nsamps);
+    }
+}
+
+
+/******************************************************************************
+MODULE:  pack_reference_mask
+
+PURPOSE: Packs a flag for each value into a mask, as described in
+level1_qa_bulk.h.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void pack_reference_mask
+(
+    uint8_t *flags,        /* I: flag (0 or 1) of each value */
+    size_t nvalues,        /* I: number of values */
+    uint8_t *mask          /* O: packed mask */
+)
+{
+    size_t i;              /* looping variable */
+
+    memset (mask, 0, (nvalues + 7) / 8);
+    for (i = 0; i < nvalues; i++)
+        mask[i / 8] |= (flags[i] & 1) << (i % 8);
+}
+
+
+/******************************************************************************
+MODULE:  test_level1_bulk
+
+PURPOSE: Checks the Level-1 QA bulk decoders, which use SSE2 when available,
+against the inline functions of read_level1_qa.h, starting at unaligned
+offsets into the scene.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void test_level1_bulk
+(
+    const char *scene,     /* I: name of the scene */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    size_t npixels,        /* I: number of pixels */
+    uint8_t *flags,        /* O: scratch reference values */
+    uint8_t *expected,     /* O: scratch reference mask */
+    uint8_t *actual        /* O: scratch kernel values */
+)
+{
+    char kernel[STR_SIZE];         /* name of the kernel */
+    int offsets[3] = {0, 1, 3};    /* first pixel of the checked pixels */
+    int o;                 /* looping variable for the offsets */
+    int bit;               /* looping variable for the bits */
+    size_t i;              /* looping variable for the pixels */
+    size_t n;              /* number of pixels checked */
+    uint16_t *qa;          /* first checked Level-1 QA value */
+
+    for (o = 0; o < 3; o++)
+    {
+        if ((size_t) offsets[o] >= npixels)
+            continue;
+        qa = &l1_qa[offsets[o]];
+        n = npixels - offsets[o];
+
+        /* Generic single-bit masks and two-bit fields */
+        for (bit = 0; bit < 16; bit++)
+        {
+            for (i = 0; i < n; i++)
+                flags[i] = (qa[i] >> bit) & ESPA_L1_SINGLE_BIT;
+            pack_reference_mask (flags, n, expected);
+            memset (actual, 0xaa, level1_qa_mask_bytes (n));
+            level1_qa_bit_mask (qa, n, bit, actual);
+            sprintf (kernel, "level1_qa_bit_mask(bit=%d) at offset %d", bit,
+                offsets[o]);
+            check_values (kernel, scene, expected, actual,
+                level1_qa_mask_bytes (n), 1, 0);
+
+            if (bit > 14)
+                continue;
+            for (i = 0; i < n; i++)
+                flags[i] = (qa[i] >> bit) & ESPA_L1_DOUBLE_BIT;
+            memset (actual, 0xaa, n);
+            level1_qa_field_values (qa, n, bit, actual);
+            sprintf (kernel, "level1_qa_field_values(bit=%d) at offset %d",
+                bit, offsets[o]);
+            check_values (kernel, scene, flags, actual, n, 1, 0);
+        }
+
+        /* Named masks */
+#define CHECK_MASK(FUNC, PREDICATE) \
+        for (i = 0; i < n; i++) \
+            flags[i] = PREDICATE (qa[i]); \
+        pack_reference_mask (flags, n, expected); \
+        memset (actual, 0xaa, level1_qa_mask_bytes (n)); \
+        FUNC (qa, n, LEVEL1_L457, actual); \
+        sprintf (kernel, "%s at offset %d", #FUNC, offsets[o]); \
+        check_values (kernel, scene, expected, actual, \
+            level1_qa_mask_bytes (n), 1, 0);
+
+        CHECK_MASK (level1_qa_fill_mask, level1_qa_is_fill)
+        CHECK_MASK (level1_qa_terrain_occluded_mask,
+            level1_qa_is_terrain_occluded)
+        CHECK_MASK (level1_qa_dropped_pixel_mask, level1_qa_is_dropped_pixel)
+        CHECK_MASK (level1_qa_cloud_mask, level1_qa_is_cloud)
+#undef CHECK_MASK
+
+        /* Named two-bit fields */
+#define CHECK_FIELD(FUNC, DECODER) \
+        for (i = 0; i < n; i++) \
+            flags[i] = DECODER (qa[i]); \
+        memset (actual, 0xaa, n); \
+        FUNC (qa, n, LEVEL1_L457, actual); \
+        sprintf (kernel, "%s at offset %d", #FUNC, offsets[o]); \
+        check_values (kernel, scene, flags, actual, n, 1, 0);
+
+        CHECK_FIELD (level1_qa_radiometric_saturation_values,
+            level1_qa_radiometric_saturation)
+        CHECK_FIELD (level1_qa_cloud_confidence_values,
+            level1_qa_cloud_confidence)
+        CHECK_FIELD (level1_qa_cloud_shadow_confidence_values,
+            level1_qa_cloud_shadow_confidence)
+        CHECK_FIELD (level1_qa_snow_ice_confidence_values,
+            level1_qa_snow_ice_confidence)
+        CHECK_FIELD (level1_qa_cirrus_confidence_values,
+            level1_qa_cirrus_confidence)
+#undef CHECK_FIELD
+    }
+}
+
+
+/******************************************************************************
+MODULE:  test_level1_bulk_c2
+
+PURPOSE: Checks that the named Level-1 QA bulk decoders, which decode the
+Collection 1 bits, reject Collection 2 QA data.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Each rejection writes an error message, so the expected errors are
+   announced first.
+******************************************************************************/
+static void test_level1_bulk_c2 ()
+{
+    uint16_t qa[1] = {0};  /* Level-1 QA value */
+    uint8_t out[1];        /* scratch kernel value */
+    int status[9];         /* status of each decoder */
+    int i;                 /* looping variable for the decoders */
+
+    printf ("Checking that the 9 Collection 1 bulk decoders reject "
+        "Collection 2 QA; 9 errors are expected\n");
+    fflush (stdout);
+    status[0] = level1_qa_fill_mask (qa, 1, LEVEL1_C2, out);
+    status[1] = level1_qa_terrain_occluded_mask (qa, 1, LEVEL1_C2, out);
+    status[2] = level1_qa_dropped_pixel_mask (qa, 1, LEVEL1_C2, out);
+    status[3] = level1_qa_cloud_mask (qa, 1, LEVEL1_C2, out);
+    status[4] = level1_qa_radiometric_saturation_values (qa, 1, LEVEL1_C2,
+        out);
+    status[5] = level1_qa_cloud_confidence_values (qa, 1, LEVEL1_C2, out);
+    status[6] = level1_qa_cloud_shadow_confidence_values (qa, 1, LEVEL1_C2,
+        out);
+    status[7] = level1_qa_snow_ice_confidence_values (qa, 1, LEVEL1_C2, out);
+    status[8] = level1_qa_cirrus_confidence_values (qa, 1, LEVEL1_C2, out);
+
+    for (i = 0; i < 9; i++)
+    {
+        ncases++;
+        if (status[i] != ERROR)
+        {
+            nfailed++;
+            printf ("FAILED Collection 1 bulk decoder %d accepted Collection "
+                "2 QA\n", i);
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  reference_summary
+
+PURPOSE: Derives the Level-1 QA class counts of the pixels one pixel at a
+time with the inline predicates generated for the layout.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void reference_summary
+(
+    Espa_level1_qa_type qa_category, /* I: type of Level-1 QA data */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    size_t npixels,        /* I: number of pixels */
+    Level1_qa_summary_t *summary /* O: class counts of the pixels */
+)
+{
+    size_t i;              /* looping variable for the pixels */
+    uint16_t qa;           /* Level-1 QA value of the current pixel */
+
+    memset (summary, 0, sizeof (Level1_qa_summary_t));
+    summary->npixels = npixels;
+    for (i = 0; i < npixels; i++)
+    {
+        qa = l1_qa[i];
+        switch (qa_category)
+        {
+#define SUMMARIZE_PIXEL(NAME, CATEGORY, ...) \
+            case CATEGORY: \
+                if (level1_qa_##NAME##_is_fill (qa)) \
+                { \
+                    summary->fill++; \
+                    break; \
+                } \
+                summary->terrain_occluded += \
+                    level1_qa_##NAME##_is_terrain_occluded (qa); \
+                summary->dropped_pixel += \
+                    level1_qa_##NAME##_is_dropped_pixel (qa); \
+                summary->cloud += level1_qa_##NAME##_is_cloud (qa); \
+                summary->radiometric_saturation[ \
+                    level1_qa_##NAME##_radiometric_saturation (qa)]++; \
+                summary->cloud_conf[ \
+                    level1_qa_##NAME##_cloud_confidence (qa)]++; \
+                summary->cloud_shadow_conf[ \
+                    level1_qa_##NAME##_cloud_shadow_confidence (qa)]++; \
+                summary->snow_ice_conf[ \
+                    level1_qa_##NAME##_snow_ice_confidence (qa)]++; \
+                summary->cirrus_conf[ \
+                    level1_qa_##NAME##_cirrus_confidence (qa)]++; \
+                break;
+
+            LEVEL1_QA_LAYOUT_TABLE (SUMMARIZE_PIXEL)
+#undef SUMMARIZE_PIXEL
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  test_histogram
+
+PURPOSE: Checks histogram_level1_qa_values, which counts into a histogram per
+thread and merges them, against a single-threaded count of the values, and
+checks summarize_level1_qa_histogram against the class counts of the pixels.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The histogram is built in two calls, over the first half and then the
+   second half of the pixels, so the counts of the second call have to be
+   added to those of the first.
+2. It is built with one thread, with KERNEL_THREADS threads, and, for the
+   small scenes, with more threads than pixels, where some threads count
+   nothing.
+******************************************************************************/
+static void test_histogram
+(
+    const Level1_qa_layout_t *layout, /* I: layout of the Level-1 QA */
+    const char *scene,     /* I: name of the scene */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    size_t npixels         /* I: number of pixels */
+)
+{
+    char kernel[STR_SIZE];         /* name of the kernel */
+    int nthreads[3];       /* threads of the histograms */
+    int max_threads = 1;   /* threads of the parallel regions on entry */
+    int t;                 /* looping variable for the thread counts */
+    size_t i;              /* looping variable for the pixels */
+    size_t half = npixels / 2; /* pixels counted by the first call */
+    uint64_t *expected = NULL; /* single-threaded histogram */
+    uint64_t *histogram = NULL; /* histogram of the kernel */
+    Level1_qa_summary_t exp_summary; /* reference class counts */
+    Level1_qa_summary_t summary;     /* class counts of the kernel */
+
+    expected = calloc (LEVEL1_QA_NBINS, sizeof (uint64_t));
+    histogram = malloc (LEVEL1_QA_NBINS * sizeof (uint64_t));
+    if (expected == NULL || histogram == NULL)
+    {
+        error_handler (true, "test_histogram", "Allocating the histograms");
+        ncases++;
+        nfailed++;
+        free (expected);
+        free (histogram);
+        return;
+    }
+
+    for (i = 0; i < npixels; i++)
+        expected[l1_qa[i]]++;
+    reference_summary (layout->qa_category, l1_qa, npixels, &exp_summary);
+
+    nthreads[0] = 1;
+    nthreads[1] = KERNEL_THREADS;
+    nthreads[2] = (int) npixels + 3;
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads ();
+#endif
+
+    for (t = 0; t < 3; t++)
+    {
+        if (nthreads[t] > MAX_HISTOGRAM_THREADS)
+            continue;
+#ifdef _OPENMP
+        omp_set_num_threads (nthreads[t]);
+#endif
+
+        memset (histogram, 0, LEVEL1_QA_NBINS * sizeof (uint64_t));
+        sprintf (kernel, "%s histogram_level1_qa_values with %d threads",
+            layout->description, nthreads[t]);
+        if (histogram_level1_qa_values (l1_qa, half, histogram) != SUCCESS ||
+            histogram_level1_qa_values (&l1_qa[half], npixels - half,
+                histogram) != SUCCESS)
+        {
+            ncases++;
+            nfailed++;
+            printf ("FAILED %s on %s: error building the histogram\n",
+                kernel, scene);
+            continue;
+        }
+        check_values (kernel, scene, expected, histogram,
+            LEVEL1_QA_NBINS * sizeof (uint64_t), 1, 0);
+
+        summarize_level1_qa_histogram (histogram, layout->qa_category,
+            &summary);
+        sprintf (kernel, "%s summarize_level1_qa_histogram with %d threads",
+            layout->description, nthreads[t]);
+        check_values (kernel, scene, &exp_summary, &summary,
+            sizeof (summary), 1, 0);
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads (max_threads);
+#endif
+    free (expected);
+    free (histogram);
+}
+
+
+/******************************************************************************
+MODULE:  test_aerosol_bulk
+
+PURPOSE: Checks the LaSRC aerosol QA bulk decoder, which uses SSE2 when
+available, against the inline functions of read_level2_qa.h, starting at
+unaligned offsets into the values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The aerosol QA values are the low bytes of the Level-1 QA values, so they
+   cover every combination of the aerosol bits on the random scenes.
+******************************************************************************/
+static void test_aerosol_bulk
+(
+    const char *scene,     /* I: name of the scene */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    size_t npixels,        /* I: number of pixels */
+    uint8_t *flags,        /* O: scratch reference values */
+    uint8_t *expected,     /* O: scratch reference values */
+    uint8_t *actual        /* O: scratch kernel values */
+)
+{
+    char kernel[STR_SIZE];         /* name of the kernel */
+    int offsets[3] = {0, 1, 3};    /* first value of the checked values */
+    int o;                 /* looping variable for the offsets */
+    int k;                 /* looping variable for the outputs */
+    size_t i;              /* looping variable for the pixels */
+    size_t n;              /* number of values checked */
+    size_t mask_bytes;     /* bytes in each mask */
+    uint8_t *aerosol = NULL; /* aerosol QA values */
+    uint8_t *level = NULL;   /* aerosol levels */
+    uint8_t *masks[3];       /* water, valid, and interpolated masks */
+    Lasrc_aerosol_counts_t exp_counts; /* reference counts */
+    Lasrc_aerosol_counts_t counts;     /* counts of the kernel */
+
+    aerosol = malloc (npixels);
+    level = malloc (npixels);
+    masks[0] = malloc (3 * level2_qa_mask_bytes (npixels));
+    if (aerosol == NULL || level == NULL || masks[0] == NULL)
+    {
+        error_handler (true, "test_aerosol_bulk", "Allocating the aerosol QA "
+            "values");
+        ncases++;
+        nfailed++;
+        free (aerosol);
+        free (level);
+        free (masks[0]);
+        return;
+    }
+
+    for (i = 0; i < npixels; i++)
+        aerosol[i] = l1_qa[i] & 0xff;
+
+    for (o = 0; o < 3; o++)
+    {
+        if ((size_t) offsets[o] >= npixels)
+            continue;
+        n = npixels - offsets[o];
+        mask_bytes = level2_qa_mask_bytes (n);
+        masks[1] = masks[0] + mask_bytes;
+        masks[2] = masks[1] + mask_bytes;
+
+        memset (level, 0xaa, n);
+        memset (masks[0], 0xaa, 3 * mask_bytes);
+        memset (&counts, 0, sizeof (counts));
+        decode_lasrc_aerosol_values (&aerosol[offsets[o]], n, level, masks[0],
+            masks[1], masks[2], &counts);
+
+        /* Aerosol level */
+        for (i = 0; i < n; i++)
+            flags[i] = lasrc_qa_aerosol_level (aerosol[offsets[o] + i]);
+        sprintf (kernel, "decode_lasrc_aerosol_values level at offset %d",
+            offsets[o]);
+        check_values (kernel, scene, flags, level, n, 1, 0);
+
+        /* Water, valid retrieval, and interpolated masks */
+        for (k = 0; k < 3; k++)
+        {
+            for (i = 0; i < n; i++)
+            {
+                uint8_t pix = aerosol[offsets[o] + i];
+                if (k == 0)
+                    flags[i] = lasrc_qa_is_water (pix);
+                else if (k == 1)
+                    flags[i] = lasrc_qa_is_valid_aerosol_retrieval (pix);
+                else
+                    flags[i] = lasrc_qa_is_aerosol_interp (pix);
+            }
+            pack_reference_mask (flags, n, expected);
+            sprintf (kernel, "decode_lasrc_aerosol_values %s mask at offset "
+                "%d", k == 0 ? "water" : k == 1 ? "valid" : "interp",
+                offsets[o]);
+            check_values (kernel, scene, expected, masks[k], mask_bytes, 1,
+                0);
+        }
+
+        /* Counts */
+        memset (&exp_counts, 0, sizeof (exp_counts));
+        exp_counts.npixels = n;
+        for (i = 0; i < n; i++)
+        {
+            uint8_t pix = aerosol[offsets[o] + i];
+            exp_counts.fill += lasrc_qa_is_fill (pix);
+            exp_counts.valid += lasrc_qa_is_valid_aerosol_retrieval (pix);
+            exp_counts.interp += lasrc_qa_is_aerosol_interp (pix);
+            exp_counts.water += lasrc_qa_is_water (pix);
+            exp_counts.level[lasrc_qa_aerosol_level (pix)]++;
+        }
+        sprintf (kernel, "decode_lasrc_aerosol_values counts at offset %d",
+            offsets[o]);
+        check_values (kernel, scene, &exp_counts, &counts, sizeof (counts),
+            1, 0);
+    }
+
+    free (aerosol);
+    free (level);
+    free (masks[0]);
+}
+
+
+/******************************************************************************
+MODULE:  reference_radsat_stats
+
+PURPOSE: Counts the fill and per band saturated pixels of the LEDAPS or LaSRC
+radsat QA values one pixel at a time with the inline functions of
+read_level2_qa.h.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void reference_radsat_stats
+(
+    Espa_level2_qa_type qa_category, /* I: LEDAPS_RADSAT or LASRC_RADSAT */
+    uint8_t *ledaps_qa,    /* I: LEDAPS radsat QA values */
+    uint16_t *lasrc_qa,    /* I: LaSRC radsat QA values */
+    size_t npixels,        /* I: number of pixels */
+    Level2_radsat_stats_t *stats /* O: counts of the pixels */
+)
+{
+    size_t i;              /* looping variable for the pixels */
+    int band;              /* looping variable for the spectral bands */
+    bool fill;             /* is the current pixel fill? */
+    bool saturated;        /* is the current pixel saturated in the band? */
+    bool any;              /* is the current pixel saturated in any band? */
+
+    init_level2_radsat_stats (qa_category, stats);
+    stats->npixels = npixels;
+    for (i = 0; i < npixels; i++)
+    {
+        if (qa_category == LEDAPS_RADSAT)
+            fill = ledaps_qa_is_fill (ledaps_qa[i]);
+        else
+            fill = lasrc_radsat_qa_is_fill (lasrc_qa[i]);
+        stats->fill += fill;
+
+        any = false;
+        for (band = 1; band <= stats->nbands; band++)
+        {
+            if (qa_category == LEDAPS_RADSAT)
+                saturated = ledaps_qa_is_saturated (ledaps_qa[i], band);
+            else
+                saturated = lasrc_radsat_qa_is_saturated (lasrc_qa[i], band);
+            stats->saturated[band-1] += saturated;
+            any = any || saturated;
+        }
+        stats->saturated_any += any;
+    }
+}
+
+
+/******************************************************************************
+MODULE:  test_radsat_stats
+
+PURPOSE: Checks the LEDAPS and LaSRC radsat statistics kernels, which use
+SSE2 when available, against reference_radsat_stats, starting at unaligned
+offsets into the values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The LEDAPS values are the low bytes and the LaSRC values are the whole
+   Level-1 QA values, so the random scenes cover every combination of the
+   radsat bits, and the bits above the LaSRC band 11 bit are set too.
+2. The kernels work on 64 pixels at a time.  The scene sizes and offsets
+   give lengths of 1 and lengths which aren't multiples of 16 or 64, and
+   each offset is also counted in two calls split at an odd length, which
+   checks that the counts are added.  A length of 0 is checked as well.
+******************************************************************************/
+static void test_radsat_stats
+(
+    const char *scene,     /* I: name of the scene */
+    uint16_t *l1_qa,       /* I: Level-1 QA values */
+    size_t npixels         /* I: number of pixels */
+)
+{
+    char kernel[STR_SIZE];         /* name of the kernel */
+    int offsets[3] = {0, 1, 3};    /* first value of the checked values */
+    int o;                 /* looping variable for the offsets */
+    int c;                 /* looping variable for the QA categories */
+    size_t i;              /* looping variable for the pixels */
+    size_t n;              /* number of values checked */
+    size_t split;          /* values counted by the first of two calls */
+    uint8_t *ledaps_qa = NULL;   /* LEDAPS radsat QA values */
+    uint16_t *lasrc_qa = NULL;   /* LaSRC radsat QA values */
+    Espa_level2_qa_type categories[2] = {LEDAPS_RADSAT, LASRC_RADSAT};
+                                 /* radsat QA categories */
+    Level2_radsat_stats_t exp_stats; /* reference counts */
+    Level2_radsat_stats_t stats;     /* counts of the kernel */
+
+    ledaps_qa = malloc (npixels);
+    if (ledaps_qa == NULL)
+    {
+        error_handler (true, "test_radsat_stats", "Allocating the radsat QA "
+            "values");
+        ncases++;
+        nfailed++;
+        return;
+    }
+    for (i = 0; i < npixels; i++)
+        ledaps_qa[i] = l1_qa[i] & 0xff;
+
+    for (c = 0; c < 2; c++)
+    {
+        /* No pixels */
+        reference_radsat_stats (categories[c], ledaps_qa, l1_qa, 0,
+            &exp_stats);
+        init_level2_radsat_stats (categories[c], &stats);
+        if (categories[c] == LEDAPS_RADSAT)
+            ledaps_radsat_stats_values (ledaps_qa, 0, &stats);
+        else
+            lasrc_radsat_stats_values (l1_qa, 0, &stats);
+        sprintf (kernel, "%s_radsat_stats_values of 0 pixels",
+            categories[c] == LEDAPS_RADSAT ? "ledaps" : "lasrc");
+        check_values (kernel, scene, &exp_stats, &stats, sizeof (stats), 1,
+            0);
+
+        for (o = 0; o < 3; o++)
+        {
+            if ((size_t) offsets[o] >= npixels)
+                continue;
+            n = npixels - offsets[o];
+            lasrc_qa = &l1_qa[offsets[o]];
+            reference_radsat_stats (categories[c], &ledaps_qa[offsets[o]],
+                lasrc_qa, n, &exp_stats);
+
+            /* In one call */
+            init_level2_radsat_stats (categories[c], &stats);
+            if (categories[c] == LEDAPS_RADSAT)
+                ledaps_radsat_stats_values (&ledaps_qa[offsets[o]], n,
+                    &stats);
+            else
+                lasrc_radsat_stats_values (lasrc_qa, n, &stats);
+            sprintf (kernel, "%s_radsat_stats_values at offset %d",
+                categories[c] == LEDAPS_RADSAT ? "ledaps" : "lasrc",
+                offsets[o]);
+            check_values (kernel, scene, &exp_stats, &stats, sizeof (stats),
+                1, 0);
+
+            /* In two calls */
+            split = (n / 2) | 1;
+            if (split > n)
+                split = n;
+            init_level2_radsat_stats (categories[c], &stats);
+            if (categories[c] == LEDAPS_RADSAT)
+            {
+                ledaps_radsat_stats_values (&ledaps_qa[offsets[o]], split,
+                    &stats);
+                ledaps_radsat_stats_values (&ledaps_qa[offsets[o] + split],
+                    n - split, &stats);
+            }
+            else
+            {
+                lasrc_radsat_stats_values (lasrc_qa, split, &stats);
+                lasrc_radsat_stats_values (&lasrc_qa[split], n - split,
+                    &stats);
+            }
+            sprintf (kernel, "%s_radsat_stats_values in two calls at offset "
+                "%d", categories[c] == LEDAPS_RADSAT ? "ledaps" : "lasrc",
+                offsets[o]);
+            check_values (kernel, scene, &exp_stats, &stats, sizeof (stats),
+                1, 0);
+        }
+    }
+
+    free (ledaps_qa);
+}
+
+
+/******************************************************************************
+MODULE:  test_qa_mask_parse
+
+PURPOSE: Checks parse_qa_mask_rules on single terms of every form, on rules
+with several terms, and on the rules it must reject.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The rejected rules write their error messages to stderr.
+******************************************************************************/
+static void test_qa_mask_parse ()
+{
+    char text[STR_SIZE];   /* rules being parsed */
+    int i;                 /* looping variable for the cases */
+    int n;                 /* looping variable for the rules and terms */
+    bool ok;               /* did the case parse as expected? */
+    Qa_mask_rules_t rules; /* parsed rules */
+    Qa_mask_term_t *term;  /* first term of the first rule */
+
+    /* Single terms: text, type, negation, comparison, level, first band,
+       last band */
+    static const struct
+    {
+        const char *text;
+        Qa_mask_term_type_t type;
+        bool negate;
+        Qa_mask_cmp_t cmp;
+        int level;
+        int first_band;
+        int last_band;
+    } terms[] =
+    {
+        {"fill", QA_TERM_FILL, false, 0, 0, 0, 0},
+        {"!clear", QA_TERM_CLEAR, true, 0, 0, 0, 0},
+        {" water ", QA_TERM_WATER, false, 0, 0, 0, 0},
+        {"cloud_shadow", QA_TERM_CLOUD_SHADOW, false, 0, 0, 0, 0},
+        {"snow", QA_TERM_SNOW, false, 0, 0, 0, 0},
+        {"! cloud", QA_TERM_CLOUD, true, 0, 0, 0, 0},
+        {"terrain_occlusion", QA_TERM_TERRAIN_OCCL, false, 0, 0, 0, 0},
+        {"cloud_conf<2", QA_TERM_CLOUD_CONF, false, QA_CMP_LT, 2, 0, 0},
+        {"cloud_conf <= low", QA_TERM_CLOUD_CONF, false, QA_CMP_LE, 1, 0, 0},
+        {"cloud_conf=none", QA_TERM_CLOUD_CONF, false, QA_CMP_EQ, 0, 0, 0},
+        {"cloud_conf!=high", QA_TERM_CLOUD_CONF, false, QA_CMP_NE, 3, 0, 0},
+        {"cirrus_conf>=moderate", QA_TERM_CIRRUS_CONF, false, QA_CMP_GE, 2, 0,
+            0},
+        {"!cirrus_conf>0", QA_TERM_CIRRUS_CONF, true, QA_CMP_GT, 0, 0, 0},
+        {"radsat_fill", QA_TERM_RADSAT_FILL, false, 0, 0, 0, 0},
+        {"sat:4", QA_TERM_SATURATED, false, 0, 0, 4, 4},
+        {"!sat : 2 - 5", QA_TERM_SATURATED, true, 0, 0, 2, 5},
+        {"sat:11-11", QA_TERM_SATURATED, false, 0, 0, 11, 11},
+        {"ledaps_ddv", QA_TERM_LEDAPS_DDV, false, 0, 0, 0, 0},
+        {"ledaps_cloud", QA_TERM_LEDAPS_CLOUD, false, 0, 0, 0, 0},
+        {"ledaps_cloud_shadow", QA_TERM_LEDAPS_CLOUD_SHADOW, false, 0, 0, 0,
+            0},
+        {"ledaps_adj_cloud", QA_TERM_LEDAPS_ADJ_CLOUD, false, 0, 0, 0, 0},
+        {"ledaps_snow", QA_TERM_LEDAPS_SNOW, false, 0, 0, 0, 0},
+        {"ledaps_land", QA_TERM_LEDAPS_LAND, false, 0, 0, 0, 0},
+        {"aerosol_fill", QA_TERM_AEROSOL_FILL, false, 0, 0, 0, 0},
+        {"aerosol_valid", QA_TERM_AEROSOL_VALID, false, 0, 0, 0, 0},
+        {"aerosol_interp", QA_TERM_AEROSOL_INTERP, false, 0, 0, 0, 0},
+        {"aerosol_water", QA_TERM_AEROSOL_WATER, false, 0, 0, 0, 0},
+        {"aerosol_level>3", QA_TERM_AEROSOL_LEVEL, false, QA_CMP_GT, 3, 0, 0}
+    };
+
+    /* Rules which must be rejected */
+    static const char *bad_rules[] =
+    {
+        "", " ; ; ", "fog", "clear & fog", "cloudy", "sat", "sat:", "sat:0",
+        "sat:5-2", "sat:2-", "sat:x", "cloud_conf", "cloud_conf<", "cloud_conf4",
+        "cloud_conf<4", "cloud_conf<-1", "cloud_conf=extreme",
+        "aerosol_level>=lowish", "cloud_conf<1x", "clear=1", "water:2",
+        "!!fill"
+    };
+
+    for (i = 0; i < (int) (sizeof (terms) / sizeof (terms[0])); i++)
+    {
+        ncases++;
+        strcpy (text, terms[i].text);
+        ok = parse_qa_mask_rules (text, &rules) == SUCCESS &&
+            rules.nrules == 1 && rules.rules[0].nterms == 1;
+        term = &rules.rules[0].terms[0];
+        if (ok && (term->type != terms[i].type ||
+            term->negate != terms[i].negate ||
+            term->first_band != terms[i].first_band ||
+            term->last_band != terms[i].last_band))
+            ok = false;
+        if (ok && (terms[i].type == QA_TERM_CLOUD_CONF ||
+            terms[i].type == QA_TERM_CIRRUS_CONF ||
+            terms[i].type == QA_TERM_AEROSOL_LEVEL) &&
+            (term->cmp != terms[i].cmp || term->level != terms[i].level))
+            ok = false;
+        if (!ok)
+        {
+            nfailed++;
+            printf ("FAILED parse_qa_mask_rules on \"%s\"\n", terms[i].text);
+        }
+    }
+
+    /* Several rules and terms, with empty rules skipped, and the LaSRC
+       radsat category implied by an aerosol term */
+    ncases++;
+    strcpy (text, " clear & !sat:2-5 & aerosol_level<high ;; water ; ");
+    ok = parse_qa_mask_rules (text, &rules) == SUCCESS &&
+        rules.nrules == 2 && rules.rules[0].nterms == 3 &&
+        rules.rules[1].nterms == 1 &&
+        rules.rules[0].terms[0].type == QA_TERM_CLEAR &&
+        rules.rules[0].terms[1].type == QA_TERM_SATURATED &&
+        rules.rules[0].terms[1].negate &&
+        rules.rules[0].terms[2].type == QA_TERM_AEROSOL_LEVEL &&
+        rules.rules[0].terms[2].cmp == QA_CMP_LT &&
+        rules.rules[0].terms[2].level == 3 &&
+        rules.rules[1].terms[0].type == QA_TERM_WATER &&
+        !strcmp (rules.rules[0].text, "clear&!sat:2-5&aerosol_level<high") &&
+        !strcmp (rules.rules[1].text, "water") &&
+        rules.radsat_category == LASRC_RADSAT;
+    strcpy (text, "sat:1 ; ledaps_cloud");
+    ok = ok && parse_qa_mask_rules (text, &rules) == SUCCESS &&
+        rules.radsat_category == LEDAPS_RADSAT;
+    if (!ok)
+    {
+        nfailed++;
+        printf ("FAILED parse_qa_mask_rules on several rules\n");
+    }
+
+    /* QA_MASK_MAX_RULES rules and QA_MASK_MAX_TERMS terms are allowed, one
+       more of either isn't */
+    for (i = 0; i < 4; i++)
+    {
+        text[0] = '\0';
+        for (n = 0; n < ((i < 2) ? QA_MASK_MAX_RULES : QA_MASK_MAX_TERMS) +
+            i % 2; n++)
+            strcat (text, (n == 0) ? "fill" : (i < 2) ? ";snow" : "&snow");
+        ncases++;
+        if ((parse_qa_mask_rules (text, &rules) == SUCCESS) != (i % 2 == 0) ||
+            (i == 0 && rules.nrules != QA_MASK_MAX_RULES) ||
+            (i == 2 && rules.rules[0].nterms != QA_MASK_MAX_TERMS))
+        {
+            nfailed++;
+            printf ("FAILED parse_qa_mask_rules on %d %s\n", n,
+                (i < 2) ? "rules" : "terms");
+        }
+    }
+
+    for (i = 0; i < (int) (sizeof (bad_rules) / sizeof (bad_rules[0])); i++)
+    {
+        ncases++;
+        strcpy (text, bad_rules[i]);
+        if (parse_qa_mask_rules (text, &rules) == SUCCESS)
+        {
+            nfailed++;
+            printf ("FAILED parse_qa_mask_rules accepted \"%s\"\n",
+                bad_rules[i]);
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  reference_qa_mask_level
+
+PURPOSE: Compares a confidence or aerosol level against the level of a mask
+term.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The comparison holds
+false           The comparison doesn't hold
+
+NOTES:
+******************************************************************************/
+static bool reference_qa_mask_level
+(
+    int value,             /* I: level of the pixel */
+    const Qa_mask_term_t *term /* I: term with the comparison and level */
+)
+{
+    switch (term->cmp)
+    {
+        case QA_CMP_LT: return (value < term->level);
+        case QA_CMP_LE: return (value <= term->level);
+        case QA_CMP_EQ: return (value == term->level);
+        case QA_CMP_NE: return (value != term->level);
+        case QA_CMP_GE: return (value >= term->level);
+        case QA_CMP_GT: return (value > term->level);
+    }
+    return (false);
+}
+
+
+/******************************************************************************
+MODULE:  reference_qa_mask_term
+
+PURPOSE: Evaluates a mask term on a single pixel with the inline decoders.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The term holds for the pixel
+false           The term doesn't hold for the pixel
+
+NOTES:
+******************************************************************************/
+static bool reference_qa_mask_term
+(
+    const Qa_mask_term_t *term, /* I: term to evaluate */
+    Espa_level2_qa_type radsat_category, /* I: LEDAPS or LaSRC radsat */
+    uint16_t pqa,          /* I: pixel QA value */
+    uint16_t radsat,       /* I: radsat QA value */
+    uint8_t cloud,         /* I: LEDAPS cloud QA value */
+    uint8_t aerosol        /* I: LaSRC aerosol QA value */
+)
+{
+    int band;              /* looping variable for the bands */
+    bool holds = false;    /* does the test of the term hold? */
+    bool lasrc = (radsat_category == LASRC_RADSAT); /* LaSRC radsat? */
+
+    switch (term->type)
+    {
+        case QA_TERM_FILL: holds = pixel_qa_is_fill (pqa); break;
+        case QA_TERM_CLEAR: holds = pixel_qa_is_clear (pqa); break;
+        case QA_TERM_WATER: holds = pixel_qa_is_water (pqa); break;
+        case QA_TERM_CLOUD_SHADOW:
+            holds = pixel_qa_is_cloud_shadow (pqa); break;
+        case QA_TERM_SNOW: holds = pixel_qa_is_snow (pqa); break;
+        case QA_TERM_CLOUD: holds = pixel_qa_is_cloud (pqa); break;
+        case QA_TERM_TERRAIN_OCCL:
+            holds = pixel_qa_is_terrain_occluded (pqa); break;
+        case QA_TERM_CLOUD_CONF:
+            holds = reference_qa_mask_level (pixel_qa_cloud_confidence (pqa),
+                term);
+            break;
+        case QA_TERM_CIRRUS_CONF:
+            holds = reference_qa_mask_level (pixel_qa_cirrus_confidence (pqa),
+                term);
+            break;
+        case QA_TERM_RADSAT_FILL:
+            holds = lasrc ? lasrc_radsat_qa_is_fill (radsat) :
+                ledaps_qa_is_fill (radsat);
+            break;
+        case QA_TERM_SATURATED:
+            for (band = term->first_band; band <= term->last_band; band++)
+                holds |= lasrc ? lasrc_radsat_qa_is_saturated (radsat, band) :
+                    ledaps_qa_is_saturated (radsat, band);
+            break;
+        case QA_TERM_LEDAPS_DDV: holds = ledaps_qa_is_ddv (cloud); break;
+        case QA_TERM_LEDAPS_CLOUD: holds = ledaps_qa_is_cloud (cloud); break;
+        case QA_TERM_LEDAPS_CLOUD_SHADOW:
+            holds = ledaps_qa_is_cloud_shadow (cloud); break;
+        case QA_TERM_LEDAPS_ADJ_CLOUD:
+            holds = ledaps_qa_is_adj_cloud (cloud); break;
+        case QA_TERM_LEDAPS_SNOW: holds = ledaps_qa_is_snow (cloud); break;
+        case QA_TERM_LEDAPS_LAND:
+            holds = ledaps_qa_is_land_water (cloud); break;
+        case QA_TERM_AEROSOL_FILL: holds = lasrc_qa_is_fill (aerosol); break;
+        case QA_TERM_AEROSOL_VALID:
+            holds = lasrc_qa_is_valid_aerosol_retrieval (aerosol); break;
+        case QA_TERM_AEROSOL_INTERP:
+            holds = lasrc_qa_is_aerosol_interp (aerosol); break;
+        case QA_TERM_AEROSOL_WATER: holds = lasrc_qa_is_water (aerosol); break;
+        case QA_TERM_AEROSOL_LEVEL:
+            holds = reference_qa_mask_level (lasrc_qa_aerosol_level (aerosol),
+                term);
+            break;
+    }
+
+    return (holds != term->negate);
+}
+
+
+/******************************************************************************
+MODULE:  test_qa_mask_evaluate
+
+PURPOSE: Checks evaluate_qa_mask_rules against per-pixel evaluation of the
+parsed terms with the inline decoders, for the LEDAPS and LaSRC radsat
+bands, on random QA values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. Every term type is used by at least one of the rule sets, negated and
+   not, and every comparison of the levels is used.
+******************************************************************************/
+static void test_qa_mask_evaluate
+(
+    const char *scene,     /* I: name of the scene */
+    uint16_t *l1_qa,       /* I: QA values, used as the pixel QA values and
+                                 as the source of the Level-2 QA values */
+    size_t npixels,        /* I: number of pixels */
+    uint16_t *radsat_qa,   /* O: scratch radsat QA values */
+    uint8_t *cloud_qa,     /* O: scratch LEDAPS cloud QA values */
+    uint8_t *aerosol_qa,   /* O: scratch LaSRC aerosol QA values */
+    uint8_t *actual        /* O: scratch mask values */
+)
+{
+    char kernel[STR_SIZE]; /* name of the kernel */
+    char text[STR_SIZE];   /* rules being parsed */
+    int s;                 /* looping variable for the rule sets */
+    int c;                 /* looping variable for the radsat categories */
+    int r, t;              /* looping variables for the rules and terms */
+    size_t i;              /* looping variable for the pixels */
+    uint8_t *expected = NULL; /* reference mask values */
+    bool holds;            /* does the current rule hold? */
+    Qa_mask_rules_t rules; /* parsed rules */
+    Espa_level2_qa_type categories[2] = {LEDAPS_RADSAT, LASRC_RADSAT};
+
+    /* Rule sets; the last one uses LaSRC bands only */
+    static const char *rule_sets[] =
+    {
+        "fill; clear & !water; cloud_shadow & snow; !cloud; "
+            "terrain_occlusion; cloud_conf>=moderate & cirrus_conf<2; "
+            "cloud_conf=1 & cirrus_conf!=high; cloud_conf<=low & "
+            "!cirrus_conf>0",
+        "radsat_fill; !radsat_fill; sat:1; !sat:2-5; sat:7 & !radsat_fill; "
+            "sat:1-7 & !fill",
+        "ledaps_ddv; ledaps_cloud & !ledaps_cloud_shadow; ledaps_adj_cloud; "
+            "ledaps_snow & clear; !ledaps_land",
+        "aerosol_fill; aerosol_valid & !aerosol_interp; !aerosol_water; "
+            "aerosol_level>none; aerosol_level<=moderate & "
+            "aerosol_level!=low; aerosol_level=high & !sat:3",
+        "sat:8-11; sat:11 & !sat:1; !radsat_fill & sat:1-11"
+    };
+    int nsets = (int) (sizeof (rule_sets) / sizeof (rule_sets[0]));
+
+    expected = malloc (npixels);
+    if (expected == NULL)
+    {
+        error_handler (true, "test_qa_mask_evaluate",
+            "Allocating the masks");
+        ncases++;
+        nfailed++;
+        return;
+    }
+
+    /* Shift the QA values so the bands aren't the same bits of one value */
+    for (i = 0; i < npixels; i++)
+    {
+        cloud_qa[i] = (uint8_t) (l1_qa[i] >> 3);
+        aerosol_qa[i] = (uint8_t) (l1_qa[(i + 1) % npixels] >> 5);
+    }
+
+    for (c = 0; c < 2; c++)
+    {
+        /* The LEDAPS radsat band is 8-bit, widened to uint16 */
+        for (i = 0; i < npixels; i++)
+            radsat_qa[i] = (categories[c] == LASRC_RADSAT) ?
+                (l1_qa[(i + 2) % npixels] & 0x0fff) :
+                (l1_qa[(i + 2) % npixels] & 0x00ff);
+
+        for (s = 0; s < nsets; s++)
+        {
+            if (s == nsets - 1 && categories[c] != LASRC_RADSAT)
+                continue;
+            strcpy (text, rule_sets[s]);
+            if (parse_qa_mask_rules (text, &rules) != SUCCESS)
+            {
+                ncases++;
+                nfailed++;
+                printf ("FAILED parse_qa_mask_rules on rule set %d\n", s);
+                continue;
+            }
+            rules.radsat_category = categories[c];
+
+            for (i = 0; i < npixels; i++)
+            {
+                expected[i] = 0;
+                for (r = 0; r < rules.nrules; r++)
+                {
+                    holds = true;
+                    for (t = 0; t < rules.rules[r].nterms; t++)
+                        holds &= reference_qa_mask_term (
+                            &rules.rules[r].terms[t], categories[c],
+                            l1_qa[i], radsat_qa[i], cloud_qa[i],
+                            aerosol_qa[i]);
+                    expected[i] |= holds << r;
+                }
+            }
+
+            evaluate_qa_mask_rules (&rules, npixels, l1_qa, radsat_qa,
+                cloud_qa, aerosol_qa, actual);
+            sprintf (kernel, "evaluate_qa_mask_rules rule set %d (%s radsat)",
+                s, (categories[c] == LASRC_RADSAT) ? "LaSRC" : "LEDAPS");
+            check_values (kernel, scene, expected, actual, npixels, 1, 0);
+        }
+    }
+
+    free (expected);
+}
+
+
+/******************************************************************************
+MODULE:  test_bitplanes
+
+PURPOSE: Checks pack_pixel_qa_bitplanes against a plain per-bit packing, and
+checks that unpack_pixel_qa_bitplanes restores the pixel QA values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void test_bitplanes
+(
+    const char *scene,     /* I: name of the scene */
+    uint16_t *pixel_qa,    /* I: pixel QA values */
+    int nlines,            /* I: number of lines */
+    int nsamps,            /* I: number of samples */
+    uint16_t *unpacked     /* O: scratch pixel QA values */
+)
+{
+    char kernel[STR_SIZE];         /* name of the kernel */
+    int line, samp;        /* looping variables */
+    int plane;             /* looping variable for the planes */
+    size_t row_bytes = pixel_qa_bitplane_row_bytes (nsamps); /* bytes in a
+                              row of a plane */
+    size_t plane_bytes = row_bytes * nlines; /* bytes in a plane */
+    size_t npixels = (size_t) nlines * nsamps; /* number of pixels */
+    size_t i;              /* looping variable for the pixels */
+    uint8_t *expected = NULL;  /* reference planes */
+    uint8_t *actual = NULL;    /* planes of the kernel */
+    uint8_t *planes[PIXEL_QA_NPLANES]; /* planes of the kernel */
+    uint16_t *masked = NULL;   /* pixel QA values of the defined bits */
+
+    expected = calloc (PIXEL_QA_NPLANES, plane_bytes);
+    actual = malloc (PIXEL_QA_NPLANES * plane_bytes);
+    masked = malloc (npixels * sizeof (uint16_t));
+    if (expected == NULL || actual == NULL || masked == NULL)
+    {
+        error_handler (true, "test_bitplanes", "Allocating the bitplanes");
+        ncases++;
+        nfailed++;
+        free (expected);
+        free (actual);
+        free (masked);
+        return;
+    }
+
+    for (plane = 0; plane < PIXEL_QA_NPLANES; plane++)
+    {
+        planes[plane] = &actual[plane * plane_bytes];
+        for (line = 0; line < nlines; line++)
+        {
+            for (samp = 0; samp < nsamps; samp++)
+                expected[plane * plane_bytes + line * row_bytes + samp / 8] |=
+                    ((pixel_qa[line * nsamps + samp] >> plane) & 1) <<
+                    (samp % 8);
+        }
+    }
+
+    memset (actual, 0xaa, PIXEL_QA_NPLANES * plane_bytes);
+    pack_pixel_qa_bitplanes (pixel_qa, nlines, nsamps, planes);
+    sprintf (kernel, "pack_pixel_qa_bitplanes");
+    check_values (kernel, scene, expected, actual,
+        PIXEL_QA_NPLANES * plane_bytes, 1, 0);
+
+    unpack_pixel_qa_bitplanes (planes, PIXEL_QA_ALL_PLANES, nlines, nsamps,
+        unpacked);
+    for (i = 0; i < npixels; i++)
+        masked[i] = pixel_qa[i] & PIXEL_QA_ALL_PLANES;
+    sprintf (kernel, "unpack_pixel_qa_bitplanes");
+    check_values (kernel, scene, masked, unpacked, npixels, 2, nsamps);
+
+    free (expected);
+    free (actual);
+    free (masked);
+}
+
+
+/******************************************************************************
+MODULE:  tiff_tag_value
+
+PURPOSE: Reads a value of a SHORT or LONG tag from a directory of a TIFF held
+in memory.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The value was read
+false           The tag is missing, or the value is outside the tag or the
+                file
+
+NOTES:
+1. The TIFF is expected to be in the host byte order, as the GeoTIFF writer
+   writes it.
+******************************************************************************/
+static bool tiff_tag_value
+(
+    const uint8_t *file,   /* I: contents of the TIFF */
+    size_t file_size,      /* I: size of the TIFF in bytes */
+    uint32_t ifd_offset,   /* I: file offset of the directory */
+    uint16_t tag,          /* I: TIFF tag */
+    uint32_t index,        /* I: index of the value */
+    uint32_t *count,       /* O: number of values of the tag */
+    uint32_t *value        /* O: value */
+)
+{
+    int i;                 /* looping variable for the entries */
+    uint16_t nentries;     /* number of directory entries */
+    uint16_t entry_tag;    /* tag of the current entry */
+    uint16_t type;         /* field type of the tag */
+    uint16_t short_value;  /* SHORT value */
+    uint32_t size;         /* size of a value in bytes */
+    uint32_t pos;          /* file offset of the current entry or value */
+
+    if ((size_t) ifd_offset + 2 > file_size)
+        return (false);
+    memcpy (&nentries, &file[ifd_offset], 2);
+    if ((size_t) ifd_offset + 2 + 12 * nentries > file_size)
+        return (false);
+
+    for (i = 0; i < nentries; i++)
+    {
+        pos = ifd_offset + 2 + 12 * i;
+        memcpy (&entry_tag, &file[pos], 2);
+        if (entry_tag != tag)
+            continue;
+
+        memcpy (&type, &file[pos + 2], 2);
+        memcpy (count, &file[pos + 4], 4);
+        size = (type == TIFF_TYPE_SHORT) ? 2 : 4;
+        if (index >= *count)
+            return (false);
+        pos += 8;
+        if ((uint64_t) *count * size > 4)
+            memcpy (&pos, &file[pos], 4);
+        if ((uint64_t) pos + (uint64_t) (index + 1) * size > file_size)
+            return (false);
+        pos += index * size;
+
+        if (size == 2)
+        {
+            memcpy (&short_value, &file[pos], 2);
+            *value = short_value;
+        }
+        else
+            memcpy (value, &file[pos], 4);
+        return (true);
+    }
+
+    return (false);
+}
+
+
+/******************************************************************************
+MODULE:  read_geotiff_level
+
+PURPOSE: Checks the directory of a resolution level of a pixel QA GeoTIFF
+held in memory, and reads the level from its tiles.
+
+RETURN VALUE:
+Type = bool
+Value           Description
+-----           -----------
+true            The directory and tiles are as expected
+false           A directory entry or tile is wrong; the problem is reported
+
+NOTES:
+1. The padding of the tiles past the edges of the level must be zero.
+******************************************************************************/
+static bool read_geotiff_level
+(
+    const char *scene,     /* I: name of the GeoTIFF case */
+    const uint8_t *file,   /* I: contents of the GeoTIFF */
+    size_t file_size,      /* I: size of the GeoTIFF in bytes */
+    uint32_t ifd_offset,   /* I: file offset of the level's directory */
+    int lvl,               /* I: resolution level */
+    int nlines,            /* I: expected number of lines of the level */
+    int nsamps,            /* I: expected number of samples of the level */
+    uint16_t *level_qa     /* O: pixel QA values of the level */
+)
+{
+    int tile;              /* looping variable for the tiles */
+    int line, samp;        /* looping variables within a tile */
+    int level_line;        /* line of the level */
+    int level_samp;        /* sample of the level */
+    int tiles_across = (nsamps + GEOTIFF_TILE_SIZE - 1) / GEOTIFF_TILE_SIZE;
+                           /* number of tiles across a tile row */
+    int ntiles = tiles_across * ((nlines + GEOTIFF_TILE_SIZE - 1) /
+        GEOTIFF_TILE_SIZE); /* number of tiles in the level */
+    uint32_t tile_bytes = GEOTIFF_TILE_SIZE * GEOTIFF_TILE_SIZE *
+        sizeof (uint16_t); /* size of a tile in bytes */
+    uint32_t count;        /* number of values of a tag */
+    uint32_t value;        /* value of a tag */
+    uint32_t offset = 0;   /* file offset of the current tile */
+    uint16_t pixel;        /* pixel value in the tile */
+    const char *problem = NULL;  /* first problem found */
+
+    if (!tiff_tag_value (file, file_size, ifd_offset, TIFF_NEW_SUBFILE_TYPE,
+        0, &count, &value) || value != (lvl == 0 ? 0 : 1))
+        problem = "NewSubfileType";
+    else if (!tiff_tag_value (file, file_size, ifd_offset, TIFF_IMAGE_WIDTH,
+        0, &count, &value) || value != (uint32_t) nsamps)
+        problem = "ImageWidth";
+    else if (!tiff_tag_value (file, file_size, ifd_offset, TIFF_IMAGE_LENGTH,
+        0, &count, &value) || value != (uint32_t) nlines)
+        problem = "ImageLength";
+    else if (!tiff_tag_value (file, file_size, ifd_offset, TIFF_TILE_WIDTH,
+        0, &count, &value) || value != GEOTIFF_TILE_SIZE)
+        problem = "TileWidth";
+    else if (!tiff_tag_value (file, file_size, ifd_offset, TIFF_TILE_LENGTH,
+        0, &count, &value) || value != GEOTIFF_TILE_SIZE)
+        problem = "TileLength";
+
+    for (tile = 0; tile < ntiles && problem == NULL; tile++)
+    {
+        if (!tiff_tag_value (file, file_size, ifd_offset, TIFF_TILE_OFFSETS,
+            tile, &count, &offset) || count != (uint32_t) ntiles)
+            problem = "TileOffsets";
+        else if (!tiff_tag_value (file, file_size, ifd_offset,
+            TIFF_TILE_BYTE_COUNTS, tile, &count, &value) ||
+            count != (uint32_t) ntiles || value != tile_bytes ||
+            (size_t) offset + tile_bytes > file_size)
+            problem = "TileByteCounts";
+
+        for (line = 0; line < GEOTIFF_TILE_SIZE && problem == NULL; line++)
+        {
+            level_line = (tile / tiles_across) * GEOTIFF_TILE_SIZE + line;
+            for (samp = 0; samp < GEOTIFF_TILE_SIZE; samp++)
+            {
+                level_samp = (tile % tiles_across) * GEOTIFF_TILE_SIZE + samp;
+                memcpy (&pixel, &file[offset + sizeof (uint16_t) *
+                    (line * GEOTIFF_TILE_SIZE + samp)], sizeof (uint16_t));
+                if (level_line < nlines && level_samp < nsamps)
+                    level_qa[(size_t) level_line * nsamps + level_samp] =
+                        pixel;
+                else if (pixel != 0)
+                    problem = "tile padding";
+            }
+        }
+    }
+
+    if (problem == NULL)
+        return (true);
+
+    printf ("FAILED GeoTIFF level %d on %s: wrong %s\n", lvl, scene, problem);
+    return (false);
+}
+
+
+/******************************************************************************
+MODULE:  set_geotiff_projection
+
+PURPOSE: Sets the global metadata of a GeoTIFF case to a UTM projection.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void set_geotiff_projection
+(
+    int datum_type,        /* I: ESPA datum */
+    int utm_zone,          /* I: UTM zone; negative in the south */
+    Espa_global_meta_t *gmeta /* O: global metadata */
+)
+{
+    memset (gmeta, 0, sizeof (Espa_global_meta_t));
+    gmeta->proj_info.proj_type = GCTP_UTM_PROJ;
+    gmeta->proj_info.datum_type = datum_type;
+    gmeta->proj_info.utm_zone = utm_zone;
+    strcpy (gmeta->proj_info.grid_origin, "CENTER");
+    gmeta->proj_info.ul_corner[0] = 500000.0;
+    gmeta->proj_info.ul_corner[1] = 4300000.0;
+}
+
+
+/******************************************************************************
+MODULE:  test_geotiff
+
+PURPOSE: Writes a pixel QA scene to a GeoTIFF in strips and reads it back:
+the header, the chain of directories, the UTM GeoKey, and the tiles of every
+level.  The full resolution level must match the scene, and each overview
+must be the bitwise OR of the 2x2 blocks of the level above it.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The expected overview sizes and pixels are computed here from the scene,
+   not from the levels of the writer.
+******************************************************************************/
+static void test_geotiff
+(
+    const char *tiff_file, /* I: scratch GeoTIFF filename */
+    int nlines,            /* I: number of lines */
+    int nsamps,            /* I: number of samples */
+    int noverviews         /* I: number of overview levels to request */
+)
+{
+    char scene[MAX_SCENE_NAME];    /* name of the GeoTIFF case */
+    char kernel[STR_SIZE];         /* name of the kernel */
+    int lvl;               /* looping variable for the levels */
+    int nlevels;           /* expected number of levels */
+    int line, samp;        /* looping variables */
+    int strip_lines;       /* number of lines in the current strip */
+    int dims[GEOTIFF_MAX_OVERVIEWS + 1][2]; /* expected level sizes */
+    size_t npixels = (size_t) nlines * nsamps; /* number of pixels */
+    size_t i;              /* looping variable for the pixels */
+    size_t file_size = 0;  /* size of the GeoTIFF in bytes */
+    uint16_t byte_order = 1; /* used to determine the host byte order */
+    uint16_t magic;        /* TIFF version number */
+    uint16_t nentries;     /* number of entries of the current directory */
+    uint32_t ifd_offset;   /* offset of the current directory */
+    uint32_t count;        /* number of values of a tag */
+    uint32_t key, value;   /* GeoKey ID and value */
+    uint32_t utm_code = 0; /* ProjectedCSTypeGeoKey value */
+    uint16_t *levels[GEOTIFF_MAX_OVERVIEWS + 1]; /* expected levels */
+    uint16_t *level_qa = NULL; /* level read from the GeoTIFF */
+    uint8_t *file = NULL;  /* contents of the GeoTIFF */
+    double pixel_size[2] = {30.0, 30.0}; /* pixel size (x, y) */
+    FILE *fp = NULL;       /* GeoTIFF read back */
+    Espa_global_meta_t gmeta; /* global metadata of the scene */
+    Pixel_qa_geotiff_t tiff;  /* GeoTIFF being written */
+
+    snprintf (scene, sizeof (scene), "%dx%d with %d overviews", nlines,
+        nsamps, noverviews);
+    memset (levels, 0, sizeof (levels));
+    ncases++;
+
+    /* Sparse bits, so the overviews don't have every bit set */
+    nlevels = 1;
+    dims[0][0] = nlines;
+    dims[0][1] = nsamps;
+    levels[0] = malloc (npixels * sizeof (uint16_t));
+    level_qa = malloc (npixels * sizeof (uint16_t));
+    if (levels[0] == NULL || level_qa == NULL)
+    {
+        error_handler (true, "test_geotiff", "Allocating the levels");
+        nfailed++;
+        goto cleanup;
+    }
+    for (i = 0; i < npixels; i++)
+        levels[0][i] = (next_random () % 3 == 0) ?
+            (uint16_t) (1 << (next_random () % 16)) : 0;
+
+    /* Reduce each level into the next until a level fits in a tile */
+    while (nlevels <= noverviews && (dims[nlevels-1][0] > GEOTIFF_TILE_SIZE ||
+        dims[nlevels-1][1] > GEOTIFF_TILE_SIZE))
+    {
+        dims[nlevels][0] = (dims[nlevels-1][0] + 1) / 2;
+        dims[nlevels][1] = (dims[nlevels-1][1] + 1) / 2;
+        levels[nlevels] = calloc ((size_t) dims[nlevels][0] *
+            dims[nlevels][1], sizeof (uint16_t));
+        if (levels[nlevels] == NULL)
+        {
+            error_handler (true, "test_geotiff", "Allocating the levels");
+            nfailed++;
+            goto cleanup;
+        }
+        for (line = 0; line < dims[nlevels-1][0]; line++)
+        {
+            for (samp = 0; samp < dims[nlevels-1][1]; samp++)
+                levels[nlevels][(line / 2) * dims[nlevels][1] + samp / 2] |=
+                    levels[nlevels-1][line * dims[nlevels-1][1] + samp];
+        }
+        nlevels++;
+    }
+
+    /* Write the scene in odd-sized strips */
+    set_geotiff_projection (ESPA_WGS84, 16, &gmeta);
+    if (create_pixel_qa_geotiff ((char *) tiff_file, nlines, nsamps,
+        noverviews, &gmeta, pixel_size, &tiff) != SUCCESS)
+    {
+        nfailed++;
+        printf ("FAILED create_pixel_qa_geotiff on %s\n", scene);
+        goto cleanup;
+    }
+    for (line = 0; line < nlines; line += strip_lines)
+    {
+        strip_lines = (nlines - line < TILE_LINES) ? nlines - line :
+            TILE_LINES;
+        if (write_pixel_qa_geotiff (&tiff, strip_lines,
+            &levels[0][(size_t) line * nsamps]) != SUCCESS)
+        {
+            nfailed++;
+            printf ("FAILED write_pixel_qa_geotiff on %s\n", scene);
+            goto cleanup;
+        }
+    }
+    if (close_pixel_qa_geotiff (&tiff) != SUCCESS)
+    {
+        nfailed++;
+        printf ("FAILED close_pixel_qa_geotiff on %s\n", scene);
+        goto cleanup;
+    }
+
+    /* Read the GeoTIFF back and check the header */
+    fp = fopen (tiff_file, "rb");
+    if (fp != NULL && fseek (fp, 0, SEEK_END) == 0)
+    {
+        file_size = ftell (fp);
+        file = malloc (file_size);
+        rewind (fp);
+        if (file == NULL || fread (file, 1, file_size, fp) != file_size)
+            file_size = 0;
+    }
+    if (fp != NULL)
+        fclose (fp);
+    if (file_size >= 8)
+        memcpy (&magic, &file[2], sizeof (magic));
+    if (file_size < 8 || magic != 42 ||
+        memcmp (file, (*(uint8_t *) &byte_order == 1) ? "II" : "MM", 2))
+    {
+        nfailed++;
+        printf ("FAILED reading the GeoTIFF header of %s\n", scene);
+        goto cleanup;
+    }
+
+    /* Follow the chain of directories through the levels */
+    memcpy (&ifd_offset, &file[4], sizeof (ifd_offset));
+    for (lvl = 0; lvl < nlevels; lvl++)
+    {
+        if (ifd_offset == 0)
+        {
+            nfailed++;
+            printf ("FAILED GeoTIFF %s: %d of %d levels\n", scene, lvl,
+                nlevels);
+            goto cleanup;
+        }
+        if (!read_geotiff_level (scene, file, file_size, ifd_offset, lvl,
+            dims[lvl][0], dims[lvl][1], level_qa))
+        {
+            nfailed++;
+            goto cleanup;
+        }
+
+        /* WGS84 UTM zone 16 north */
+        if (lvl == 0)
+        {
+            for (i = 1; tiff_tag_value (file, file_size, ifd_offset,
+                TIFF_GEO_KEY_DIRECTORY, 4 * i, &count, &key); i++)
+            {
+                if (key == GEO_PROJECTED_CS_TYPE_KEY &&
+                    tiff_tag_value (file, file_size, ifd_offset,
+                    TIFF_GEO_KEY_DIRECTORY, 4 * i + 3, &count, &value))
+                    utm_code = value;
+            }
+            if (utm_code != 32616)
+            {
+                nfailed++;
+                printf ("FAILED GeoTIFF %s: ProjectedCSTypeGeoKey %u, "
+                    "expected 32616\n", scene, utm_code);
+                goto cleanup;
+            }
+        }
+
+        sprintf (kernel, "GeoTIFF level %d", lvl);
+        check_values (kernel, scene, levels[lvl], level_qa,
+            (size_t) dims[lvl][0] * dims[lvl][1], 2, dims[lvl][1]);
+
+        /* read_geotiff_level checked that the entries are in the file */
+        memcpy (&nentries, &file[ifd_offset], sizeof (nentries));
+        ifd_offset += 2 + 12 * nentries;
+        if ((size_t) ifd_offset + 4 > file_size)
+        {
+            nfailed++;
+            printf ("FAILED GeoTIFF %s: level %d directory past the end of "
+                "the file\n", scene, lvl);
+            goto cleanup;
+        }
+        memcpy (&ifd_offset, &file[ifd_offset], sizeof (ifd_offset));
+    }
+    if (ifd_offset != 0)
+    {
+        nfailed++;
+        printf ("FAILED GeoTIFF %s: more than %d levels\n", scene, nlevels);
+    }
+
+cleanup:
+    unlink (tiff_file);
+    for (lvl = 0; lvl <= GEOTIFF_MAX_OVERVIEWS; lvl++)
+        free (levels[lvl]);
+    free (level_qa);
+    free (file);
+}
+
+
+/******************************************************************************
+MODULE:  test_geotiff_errors
+
+PURPOSE: Checks that the GeoTIFF writer rejects projections without an EPSG
+code before the file is created, and removes a GeoTIFF which can't be
+finished.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void test_geotiff_errors
+(
+    const char *tiff_file  /* I: scratch GeoTIFF filename */
+)
+{
+    int i;                 /* looping variable */
+    int nlines = 10;       /* number of lines of the GeoTIFF */
+    int nsamps = 10;       /* number of samples of the GeoTIFF */
+    uint16_t pixel_qa[11 * 10]; /* one line more than the GeoTIFF */
+    double pixel_size[2] = {30.0, 30.0}; /* pixel size (x, y) */
+    Espa_global_meta_t gmeta; /* global metadata of the GeoTIFF */
+    Pixel_qa_geotiff_t tiff;  /* GeoTIFF being written */
+    static const int bad_zones[][2] = /* datum and UTM zone without an EPSG
+                                         code */
+    {
+        {ESPA_NAD83, 30}, {ESPA_NAD83, -16}, {ESPA_NAD27, 23},
+        {ESPA_WGS84, 61}
+    };
+
+    memset (pixel_qa, 0, sizeof (pixel_qa));
+    for (i = 0; i < (int) (sizeof (bad_zones) / sizeof (bad_zones[0])); i++)
+    {
+        unlink (tiff_file);
+        set_geotiff_projection (bad_zones[i][0], bad_zones[i][1], &gmeta);
+        ncases++;
+        if (create_pixel_qa_geotiff ((char *) tiff_file, nlines, nsamps, 0,
+            &gmeta, pixel_size, &tiff) == SUCCESS)
+        {
+            nfailed++;
+            printf ("FAILED create_pixel_qa_geotiff accepted datum %d UTM "
+                "zone %d\n", bad_zones[i][0], bad_zones[i][1]);
+            close_pixel_qa_geotiff (&tiff);
+        }
+        else if (access (tiff_file, F_OK) == 0)
+        {
+            nfailed++;
+            printf ("FAILED create_pixel_qa_geotiff created %s for datum %d "
+                "UTM zone %d\n", tiff_file, bad_zones[i][0], bad_zones[i][1]);
+        }
+    }
+
+    /* Closing before the last line and writing past it */
+    set_geotiff_projection (ESPA_WGS84, 16, &gmeta);
+    for (i = 0; i < 2; i++)
+    {
+        ncases++;
+        if (create_pixel_qa_geotiff ((char *) tiff_file, nlines, nsamps, 0,
+            &gmeta, pixel_size, &tiff) != SUCCESS)
+        {
+            nfailed++;
+            printf ("FAILED create_pixel_qa_geotiff for the error cases\n");
+            continue;
+        }
+        if ((i == 0 && (write_pixel_qa_geotiff (&tiff, nlines - 1, pixel_qa)
+            != SUCCESS || close_pixel_qa_geotiff (&tiff) == SUCCESS)) ||
+            (i == 1 && write_pixel_qa_geotiff (&tiff, nlines + 1, pixel_qa)
+            == SUCCESS))
+        {
+            nfailed++;
+            printf ("FAILED GeoTIFF writer accepted %s the last line\n",
+                (i == 0) ? "closing before" : "writing past");
+        }
+        if (access (tiff_file, F_OK) == 0)
+        {
+            nfailed++;
+            printf ("FAILED GeoTIFF writer left %s behind after an error\n",
+                tiff_file);
+        }
+    }
+    unlink (tiff_file);
+}
+
+
+/******************************************************************************
+MODULE:  test_dilation
+
+PURPOSE: Checks the dilation kernels on a pixel QA scene against
+dilate_pixel_qa_reference: dilate_pixel_qa, dilate_pixel_qa_rows in strips of
+one line, TILE_LINES, and QA_STREAM_STRIP_LINES lines, and the strips in
+parallel.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+******************************************************************************/
+static void test_dilation
+(
+    const char *scene,     /* I: name of the scene */
+    uint16_t *pixel_qa,    /* I: pixel QA values */
+    int nlines,            /* I: number of lines */
+    int nsamps,            /* I: number of samples */
+    uint16_t *expected,    /* O: scratch reference values */
+    uint16_t *dilated      /* O: scratch kernel values */
+)
+{
+    char kernel[STR_SIZE];         /* name of the kernel */
+    char name[STR_SIZE];           /* name of the scene and settings */
+    int largest = (nlines > nsamps) ? nlines : nsamps; /* scene extent */
+    int distances[6];      /* dilation distances */
+    int strip_sizes[3] = {1, TILE_LINES, QA_STREAM_STRIP_LINES}; /* strip
+                              lines */
+    int d;                 /* looping variable for the distances */
+    int b;                 /* looping variable for the bits */
+    int s;                 /* looping variable for the strip sizes */
+    int strip;             /* looping variable for the strips */
+    int nstrips;           /* number of strips */
+    size_t npixels = (size_t) nlines * nsamps; /* number of pixels */
+
+    distances[0] = 0;
+    distances[1] = 1;
+    distances[2] = 2;
+    distances[3] = 5;
+    distances[4] = largest;
+    distances[5] = largest + 3;
+
+    for (b = 0; b < NUM_DILATION_BITS; b++)
+    {
+        for (d = 0; d < 6; d++)
+        {
+            snprintf (name, sizeof (name), "%s, bit %d, distance %d", scene,
+                dilation_bits[b], distances[d]);
+            dilate_pixel_qa_reference (pixel_qa, dilation_bits[b],
+                distances[d], nlines, nsamps, expected);
+
+            memset (dilated, 0xaa, npixels * sizeof (uint16_t));
+            dilate_pixel_qa (pixel_qa, dilation_bits[b], distances[d], nlines,
+                nsamps, dilated);
+            check_values ("dilate_pixel_qa", name, expected, dilated, npixels,
+                2, nsamps);
+
+            for (s = 0; s < 3; s++)
+            {
+                nstrips = (nlines + strip_sizes[s] - 1) / strip_sizes[s];
+
+                memset (dilated, 0xaa, npixels * sizeof (uint16_t));
+                for (strip = 0; strip < nstrips; strip++)
+                {
+                    int first_line = strip * strip_sizes[s];
+                    int strip_lines = nlines - first_line;
+                    if (strip_lines > strip_sizes[s])
+                        strip_lines = strip_sizes[s];
+                    dilate_pixel_qa_rows (pixel_qa, dilation_bits[b],
+                        distances[d], nlines, nsamps, first_line, strip_lines,
+                        &dilated[(size_t) first_line * nsamps]);
+                }
+                sprintf (kernel, "dilate_pixel_qa_rows in %d-line strips",
+                    strip_sizes[s]);
+                check_values (kernel, name, expected, dilated, npixels, 2,
+                    nsamps);
+
+                memset (dilated, 0xaa, npixels * sizeof (uint16_t));
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic) \
+                    num_threads(KERNEL_THREADS)
+#endif
+                for (strip = 0; strip < nstrips; strip++)
+                {
+                    int first_line = strip * strip_sizes[s];
+                    int strip_lines = nlines - first_line;
+                    if (strip_lines > strip_sizes[s])
+                        strip_lines = strip_sizes[s];
+                    dilate_pixel_qa_rows (pixel_qa, dilation_bits[b],
+                        distances[d], nlines, nsamps, first_line, strip_lines,
+                        &dilated[(size_t) first_line * nsamps]);
+                }
+                sprintf (kernel, "dilate_pixel_qa_rows in threaded %d-line "
+                    "strips", strip_sizes[s]);
+                check_values (kernel, name, expected, dilated, npixels, 2,
+                    nsamps);
+            }
+        }
+    }
+}
+
+
+/******************************************************************************
+MODULE:  main
+
+PURPOSE:  Runs every kernel on every generated scene and reports the kernels
+which differ from their reference kernels.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           A kernel differs from its reference kernel, or error
+                allocating memory
+SUCCESS         Every kernel matches its reference kernel
+
+NOTES:
+******************************************************************************/
+int main (int argc, char** argv)
+{
+    char FUNC_NAME[] = "main";  /* function name */
+    char scene[MAX_SCENE_NAME]; /* name of the scene */
+    char tiff_file[STR_SIZE];   /* scratch GeoTIFF filename */
+    int l;                      /* looping variable for the layouts */
+    int z;                      /* looping variable for the sizes */
+    int t;                      /* looping variable for the scene types */
+    int nlines, nsamps;         /* size of the scene */
+    size_t npixels;             /* number of pixels in the scene */
+    size_t max_pixels = 0;      /* number of pixels in the largest scene */
+    uint32_t seed;              /* seed of the generated scenes */
+    uint16_t *l1_qa = NULL;     /* Level-1 QA values */
+    uint16_t *pixel_qa = NULL;  /* reference pixel QA values */
+    uint16_t *scratch16[2];     /* scratch pixel QA values */
+    uint8_t *scratch8[3];       /* scratch 8-bit values */
+    uint8_t *expected_sat = NULL; /* reference saturation values */
+    const Level1_qa_layout_t *layout = NULL; /* layout of the Level-1 QA */
+
+    /* Read the command-line arguments */
+    if (get_args (argc, argv, &seed) != SUCCESS)
+        exit (ERROR);
+    random_state = seed;
+
+    /* Allocate the buffers for the largest scene */
+    for (z = 0; z < NUM_SIZES; z++)
+    {
+        npixels = (size_t) scene_sizes[z][0] * scene_sizes[z][1];
+        if (npixels > max_pixels)
+            max_pixels = npixels;
+    }
+    l1_qa = malloc (max_pixels * sizeof (uint16_t));
+    pixel_qa = malloc (max_pixels * sizeof (uint16_t));
+    scratch16[0] = malloc (max_pixels * sizeof (uint16_t));
+    scratch16[1] = malloc (max_pixels * sizeof (uint16_t));
+    scratch8[0] = malloc (max_pixels);
+    scratch8[1] = malloc (max_pixels);
+    scratch8[2] = malloc (max_pixels);
+    expected_sat = malloc (max_pixels);
+    if (l1_qa == NULL || pixel_qa == NULL || scratch16[0] == NULL ||
+        scratch16[1] == NULL || scratch8[0] == NULL || scratch8[1] == NULL ||
+        scratch8[2] == NULL || expected_sat == NULL)
+    {
+        error_handler (true, FUNC_NAME, "Allocating the scenes");
+        exit (ERROR);
+    }
+
+    test_level1_bulk_c2 ();
+
+    /* The GeoTIFF writer doesn't depend on the scene type */
+    snprintf (tiff_file, sizeof (tiff_file), "test_qa_kernels_%d.tif",
+        (int) getpid ());
+    for (z = 0; z < NUM_GEOTIFF_CASES; z++)
+        test_geotiff (tiff_file, geotiff_cases[z][0], geotiff_cases[z][1],
+            geotiff_cases[z][2]);
+    test_geotiff_errors (tiff_file);
+    test_qa_mask_parse ();
+    for (l = 0; l < NUM_LAYOUTS; l++)
+    {
+        layout = get_level1_qa_layout (layout_categories[l]);
+        for (z = 0; z < NUM_SIZES; z++)
+        {
+            nlines = scene_sizes[z][0];
+            nsamps = scene_sizes[z][1];
+            npixels = (size_t) nlines * nsamps;
+            for (t = 0; t < NUM_SCENES; t++)
+            {
+                snprintf (scene, sizeof (scene), "%s %dx%d (seed %u)",
+                    scene_names[t], nlines, nsamps, seed);
+                make_level1_scene (t, layout, nlines, nsamps, l1_qa);
+
+                test_translation (layout, scene, l1_qa, nlines, nsamps,
+                    pixel_qa, expected_sat, scratch16[0], scratch8[0]);
+                test_histogram (layout, scene, l1_qa, npixels);
+
+                /* The bulk decoders and pixel QA kernels don't depend on the
+                   Level-1 layout, so they only run on the first one */
+                if (l != 0)
+                    continue;
+                test_level1_bulk (scene, l1_qa, npixels, scratch8[0],
+                    scratch8[1], scratch8[2]);
+                test_aerosol_bulk (scene, l1_qa, npixels, scratch8[0],
+                    scratch8[1], scratch8[2]);
+                test_radsat_stats (scene, l1_qa, npixels);
+                test_qa_mask_evaluate (scene, l1_qa, npixels, scratch16[0],
+                    scratch8[0], scratch8[1], scratch8[2]);
+                test_bitplanes (scene, pixel_qa, nlines, nsamps,
+                    scratch16[0]);
+                test_dilation (scene, pixel_qa, nlines, nsamps, scratch16[0],
+                    scratch16[1]);
+
+                /* The raw Level-1 QA values as pixel QA values cover every
+                   combination of the pixel QA bits */
+                if (t == SCENE_RANDOM || t == SCENE_NO_FILL)
+                {
+                    strcat (scene, " as pixel QA");
+                    test_bitplanes (scene, l1_qa, nlines, nsamps,
+                        scratch16[0]);
+                    test_dilation (scene, l1_qa, nlines, nsamps,
+                        scratch16[0], scratch16[1]);
+                }
+            }
+        }
+    }
+
+    free (l1_qa);
+    free (pixel_qa);
+    free (scratch16[0]);
+    free (scratch16[1]);
+    free (scratch8[0]);
+    free (scratch8[1]);
+    free (scratch8[2]);
+    free (expected_sat);
+
+    if (nfailed > 0)
+    {
+        printf ("%d of %d kernel cases differ from the reference kernels\n",
+            nfailed, ncases);
+        exit (ERROR);
+    }
+    printf ("All %d kernel cases match the reference kernels\n", ncases);
+    exit (SUCCESS);
+}
@@ -17,6 +17,7 @@ NOTES:
 *****************************************************************************/
 #include <getopt.h>
 #include "read_level1_qa.h"
+#include "level1_qa_layout.h"
 
 /******************************************************************************
 MODULE: usage
@@ -134,82 +135,18 @@ short get_args
 
 
 /******************************************************************************
-MODULE:  main
+MODULE:  test_c1_interrogation
 
-PURPOSE:  Reads the Level-1 QA band and then spits out a few pixel values
-to make sure the read is working correctly.
+PURPOSE: Prints the results of the Collection 1 Level-1 QA interrogation
+functions of read_level1_qa.h for a few QA values.
 
 RETURN VALUE:
-Type = int
-Value           Description
------           -----------
-ERROR           Error with the Level-1 QA test
-SUCCESS         No errors with the Level-1 QA test
+Type = None
 
 NOTES:
 ******************************************************************************/
-int main (int argc, char** argv)
+void test_c1_interrogation ()
 {
-    char FUNC_NAME[] = "test_read_level1_qa";   /* function name */
-    char errmsg[STR_SIZE];       /* error message */
-    char *xml_infile = NULL;     /* input XML filename */
-    char l1_qa_file[STR_SIZE];   /* Level-1 QA filename from XML file */
-    int nlines;                  /* number of lines in the QA band */
-    int nsamps;                  /* number of samples in the QA band */
-    uint16_t *level1_qa = NULL;  /* Level-1 QA band */
-    Espa_level1_qa_type qa_cat;  /* type of Level-1 QA data (L4-7, L8) */
-    FILE *fp_bqa = NULL;         /* file pointer for the band quality band */
-
-    /* Read the command-line arguments */
-    if (get_args (argc, argv, &xml_infile) != SUCCESS)
-    {   /* get_args already printed the error message */
-        exit (EXIT_FAILURE);
-    }
-
-    /* Open the Level-1 QA band */
-    fp_bqa = open_level1_qa (xml_infile, l1_qa_file, &nlines, &nsamps, &qa_cat);
-    if (fp_bqa == NULL)
-    {  /* Error messages already written */
-        exit (EXIT_FAILURE);
-    }
-    printf ("Level-1 QA information:\n");
-    printf ("  Filename: %s\n", l1_qa_file);
-    printf ("  Filesize: %d lines x %d samples\n", nlines, nsamps);
-    printf ("  QA Category: ");
-    if (qa_cat == LEVEL1_L457)
-        printf ("Landsat 4-7\n");
-    else if (qa_cat == LEVEL1_L8)
-        printf ("Landsat 8\n");
-    else
-        printf ("UNKNOWN\n");
-
-    /* Allocate memory for the entire Level-1 QA band */
-    level1_qa = calloc (nlines*nsamps, sizeof (uint16_t));
-    if (level1_qa == NULL)
-    {
-        sprintf (errmsg, "Allocating memory for the Level-1 QA band");
-        error_handler (true, FUNC_NAME, errmsg);
-        return (ERROR);
-    }
-
-    /* Read the entire band of Level-1 QA data */
-    if (read_level1_qa (fp_bqa, nlines, nsamps, level1_qa) != SUCCESS)
-    {  /* Error messages already written */
-        exit (EXIT_FAILURE);
-    }
-
-    /* Close the Level-1 QA band */
-    close_level1_qa (fp_bqa);
-
-    /* Print out the desired pixel values for testing */
-    printf ("Pixel line 0, sample 0: %d\n", level1_qa[0]);
-    printf ("Pixel line 0, sample 1000: %d\n", level1_qa[1000]);
-    printf ("Pixel line 4557, sample 4432: %d\n", level1_qa[4557*nsamps+4432]);
-    printf ("Pixel line 1560, sample 6305: %d\n", level1_qa[1560*nsamps+6305]);
-    printf ("Pixel line 3589, sample 6898: %d\n", level1_qa[3589*nsamps+6898]);
-    printf ("Pixel line 775, sample 3468: %d\n", level1_qa[775*nsamps+3468]);
-
-    /* Test the pixel interrogation */
     printf ("Value 1: ");   /* Fill */
     if (level1_qa_is_fill (1))
         printf ("Fill\n");
@@ -288,7 +225,186 @@ int main (int argc, char** argv)
     printf ("Cirrus conf (4096): %d\n", level1_qa_cirrus_confidence (4096));
     printf ("Cirrus conf (2048+4096): %d\n", level1_qa_cirrus_confidence (2048+4096));
     printf ("Cirrus conf (8192+2048+4096): %d\n", level1_qa_cirrus_confidence (8192+2048+4096));
+}
+
+
+/******************************************************************************
+MODULE:  test_c2_interrogation
 
+PURPOSE: Prints the results of the Collection 2 QA_PIXEL interrogation
+functions of level1_qa_layout.h for a few QA values.
+
+RETURN VALUE:
+Type = None
+
+NOTES:
+1. The Collection 1 functions of read_level1_qa.h don't apply to the
+   QA_PIXEL bits, so the level1_qa_c2_* functions are used instead.
+******************************************************************************/
+void test_c2_interrogation ()
+{
+    printf ("Value 1: ");   /* Fill */
+    if (level1_qa_c2_is_fill (1))
+        printf ("Fill\n");
+    else
+        printf ("Not fill\n");
+
+    printf ("Value 0: ");   /* Not fill */
+    if (level1_qa_c2_is_fill (0))
+        printf ("Fill\n");
+    else
+        printf ("Not fill\n");
+
+    printf ("Value 2: ");   /* Dilated cloud */
+    if (level1_qa_c2_is_dilated_cloud (2))
+        printf ("Dilated cloud\n");
+    else
+        printf ("Not dilated cloud\n");
+
+    printf ("Value 4: ");   /* Cirrus */
+    if (level1_qa_c2_is_cirrus (4))
+        printf ("Cirrus\n");
+    else
+        printf ("Not cirrus\n");
+
+    printf ("Value 8: ");   /* Cloud */
+    if (level1_qa_c2_is_cloud (8))
+        printf ("Cloud\n");
+    else
+        printf ("Not cloud\n");
+
+    printf ("Value 16: ");   /* Not cloud */
+    if (level1_qa_c2_is_cloud (16))
+        printf ("Cloud\n");
+    else
+        printf ("Not cloud\n");
+
+    printf ("Value 16: ");   /* Cloud shadow */
+    if (level1_qa_c2_is_cloud_shadow (16))
+        printf ("Cloud shadow\n");
+    else
+        printf ("Not cloud shadow\n");
+
+    printf ("Value 32: ");   /* Snow */
+    if (level1_qa_c2_is_snow (32))
+        printf ("Snow\n");
+    else
+        printf ("Not snow\n");
+
+    printf ("Value 64: ");   /* Clear */
+    if (level1_qa_c2_is_clear (64))
+        printf ("Clear\n");
+    else
+        printf ("Not clear\n");
+
+    printf ("Value 128: ");   /* Water */
+    if (level1_qa_c2_is_water (128))
+        printf ("Water\n");
+    else
+        printf ("Not water\n");
+
+    printf ("Cloud confidence (64): %d\n", level1_qa_c2_cloud_confidence (64));
+    printf ("Cloud confidence (256): %d\n", level1_qa_c2_cloud_confidence (256));
+    printf ("Cloud confidence (512): %d\n", level1_qa_c2_cloud_confidence (512));
+    printf ("Cloud confidence (256+512): %d\n", level1_qa_c2_cloud_confidence (256+512));
+
+    printf ("Cloud shadow conf (1024): %d\n", level1_qa_c2_cloud_shadow_confidence (1024));
+    printf ("Cloud shadow conf (2048): %d\n", level1_qa_c2_cloud_shadow_confidence (2048));
+    printf ("Cloud shadow conf (1024+2048): %d\n", level1_qa_c2_cloud_shadow_confidence (1024+2048));
+
+    printf ("Snow/ice conf (4096): %d\n", level1_qa_c2_snow_ice_confidence (4096));
+    printf ("Snow/ice conf (8192): %d\n", level1_qa_c2_snow_ice_confidence (8192));
+    printf ("Snow/ice conf (4096+8192): %d\n", level1_qa_c2_snow_ice_confidence (4096+8192));
+
+    printf ("Cirrus conf (16384): %d\n", level1_qa_c2_cirrus_confidence (16384));
+    printf ("Cirrus conf (32768): %d\n", level1_qa_c2_cirrus_confidence (32768));
+    printf ("Cirrus conf (16384+32768): %d\n", level1_qa_c2_cirrus_confidence (16384+32768));
+}
+
+
+/******************************************************************************
+MODULE:  main
+
+PURPOSE:  Reads the Level-1 QA band and then spits out a few pixel values
+to make sure the read is working correctly.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error with the Level-1 QA test
+SUCCESS         No errors with the Level-1 QA test
+
+NOTES:
+******************************************************************************/
+int main (int argc, char** argv)
+{
+    char FUNC_NAME[] = "test_read_level1_qa";   /* function name */
+    char errmsg[STR_SIZE];       /* error message */
+    char *xml_infile = NULL;     /* input XML filename */
+    char l1_qa_file[STR_SIZE];   /* Level-1 QA filename from XML file */
+    int nlines;                  /* number of lines in the QA band */
+    int nsamps;                  /* number of samples in the QA band */
+    uint16_t *level1_qa = NULL;  /* Level-1 QA band */
+    Espa_level1_qa_type qa_cat;  /* type of Level-1 QA data (L4-7, L8, C2) */
+    FILE *fp_bqa = NULL;         /* file pointer for the band quality band */
+
+    /* Read the command-line arguments */
+    if (get_args (argc, argv, &xml_infile) != SUCCESS)
+    {   /* get_args already printed the error message */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Open the Level-1 QA band */
+    fp_bqa = open_level1_qa (xml_infile, l1_qa_file, &nlines, &nsamps, &qa_cat);
+    if (fp_bqa == NULL)
+    {  /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+    printf ("Level-1 QA information:\n");
+    printf ("  Filename: %s\n", l1_qa_file);
+    printf ("  Filesize: %d lines x %d samples\n", nlines, nsamps);
+    printf ("  QA Category: ");
+    if (qa_cat == LEVEL1_L457)
+        printf ("Landsat 4-7\n");
+    else if (qa_cat == LEVEL1_L8)
+        printf ("Landsat 8\n");
+    else if (qa_cat == LEVEL1_C2)
+        printf ("Collection 2 Landsat 4-9\n");
+    else
+        printf ("UNKNOWN\n");
+
+    /* Allocate memory for the entire Level-1 QA band */
+    level1_qa = calloc (nlines*nsamps, sizeof (uint16_t));
+    if (level1_qa == NULL)
+    {
+        sprintf (errmsg, "Allocating memory for the Level-1 QA band");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    /* Read the entire band of Level-1 QA data */
+    if (read_level1_qa (fp_bqa, nlines, nsamps, level1_qa) != SUCCESS)
+    {  /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+
+    /* Close the Level-1 QA band */
+    close_level1_qa (fp_bqa);
+
+    /* Print out the desired pixel values for testing */
+    printf ("Pixel line 0, sample 0: %d\n", level1_qa[0]);
+    printf ("Pixel line 0, sample 1000: %d\n", level1_qa[1000]);
+    printf ("Pixel line 4557, sample 4432: %d\n", level1_qa[4557*nsamps+4432]);
+    printf ("Pixel line 1560, sample 6305: %d\n", level1_qa[1560*nsamps+6305]);
+    printf ("Pixel line 3589, sample 6898: %d\n", level1_qa[3589*nsamps+6898]);
+    printf ("Pixel line 775, sample 3468: %d\n", level1_qa[775*nsamps+3468]);
+
+    /* Test the pixel interrogation with the decoders of the QA category */
+    if (qa_cat == LEVEL1_C2)
+        test_c2_interrogation ();
+    else
+        test_c1_interrogation ();
 
     /* Free the pointers */
     free (xml_infile);
@@ -157,6 +157,135 @@ short get_args
 }
 
 
+/******************************************************************************
+MODULE:  test_open_multi
+
+PURPOSE: Opens the Level-2 QA band being tested, the other band of the same
+processor, and a band of the other processor with open_level2_qa_multi, and
+checks the returned bands against those of open_level2_qa.
+
+RETURN VALUE:
+Type = int
+Value           Description
+-----           -----------
+ERROR           Error opening the bands, or the returned bands are wrong
+SUCCESS         The returned bands are correct
+
+NOTES:
+1. A product has either the LEDAPS or the LaSRC bands, so the band of the
+   other processor is missing, and open_level2_qa_multi should report it
+   without failing.  The other band of the same processor may or may not be
+   in the product.
+******************************************************************************/
+int test_open_multi
+(
+    char *xml_infile,      /* I: input XML filename */
+    Espa_level2_qa_type qa_type, /* I: type of Level-2 QA data being tested */
+    char *l2_qa_file,      /* I: Level-2 QA filename from open_level2_qa */
+    int nlines,            /* I: number of lines from open_level2_qa */
+    int nsamps             /* I: number of samples from open_level2_qa */
+)
+{
+    char FUNC_NAME[] = "test_open_multi";   /* function name */
+    char errmsg[STR_SIZE];       /* error message */
+    int i;                       /* looping variable for the bands */
+    int nfound;                  /* number of bands found and opened */
+    int nflagged = 0;            /* number of bands flagged as found */
+    int status = SUCCESS;        /* status of the checks */
+    Level2_qa_band_t bands[3];   /* requested bands */
+
+    /* The band being tested, the other band of its processor, and a band of
+       the other processor */
+    bands[0].qa_category = qa_type;
+    if (qa_type == LEDAPS_RADSAT || qa_type == LEDAPS_CLOUD)
+    {
+        bands[1].qa_category = (qa_type == LEDAPS_RADSAT) ? LEDAPS_CLOUD :
+            LEDAPS_RADSAT;
+        bands[2].qa_category = LASRC_AEROSOL;
+    }
+    else
+    {
+        bands[1].qa_category = (qa_type == LASRC_RADSAT) ? LASRC_AEROSOL :
+            LASRC_RADSAT;
+        bands[2].qa_category = LEDAPS_CLOUD;
+    }
+
+    printf ("Opening Level-2 QA categories %d, %d, and %d together; "
+        "category %d should be reported missing\n", bands[0].qa_category,
+        bands[1].qa_category, bands[2].qa_category, bands[2].qa_category);
+    if (open_level2_qa_multi (xml_infile, 3, bands, &nfound) != SUCCESS)
+    {
+        sprintf (errmsg, "Opening the Level-2 QA bands together");
+        error_handler (true, FUNC_NAME, errmsg);
+        return (ERROR);
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        if (bands[i].found)
+        {
+            nflagged++;
+            if (bands[i].fp_l2qa == NULL || bands[i].nlines <= 0 ||
+                bands[i].nsamps <= 0 || bands[i].l2_qa_file[0] == '\0')
+            {
+                sprintf (errmsg, "Found band %d (category %d) wasn't opened "
+                    "or has no size", i, bands[i].qa_category);
+                error_handler (true, FUNC_NAME, errmsg);
+                status = ERROR;
+            }
+        }
+        else if (bands[i].fp_l2qa != NULL || bands[i].nlines != 0 ||
+            bands[i].nsamps != 0 || bands[i].l2_qa_file[0] != '\0')
+        {
+            sprintf (errmsg, "Missing band %d (category %d) was returned with "
+                "a file or size", i, bands[i].qa_category);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+
+    /* The band being tested must match open_level2_qa, and the band of the
+       other processor must be missing */
+    if (!bands[0].found || strcmp (bands[0].l2_qa_file, l2_qa_file) ||
+        bands[0].nlines != nlines || bands[0].nsamps != nsamps)
+    {
+        sprintf (errmsg, "Band of category %d doesn't match the file and "
+            "size from open_level2_qa", qa_type);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+    if (bands[2].found)
+    {
+        sprintf (errmsg, "Band of category %d was expected to be missing",
+            bands[2].qa_category);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+    if (nfound != nflagged)
+    {
+        sprintf (errmsg, "%d bands were reported opened, but %d were flagged "
+            "as found", nfound, nflagged);
+        error_handler (true, FUNC_NAME, errmsg);
+        status = ERROR;
+    }
+
+    close_level2_qa_multi (3, bands);
+    for (i = 0; i < 3; i++)
+    {
+        if (bands[i].fp_l2qa != NULL)
+        {
+            sprintf (errmsg, "Band %d wasn't closed", i);
+            error_handler (true, FUNC_NAME, errmsg);
+            status = ERROR;
+        }
+    }
+
+    if (status == SUCCESS)
+        printf ("  %d of 3 Level-2 QA bands found and opened\n", nfound);
+    return (status);
+}
+
+
 /******************************************************************************
 MODULE:  main
 
@@ -213,6 +342,13 @@ int main (int argc, char** argv)
     else
         printf ("UNKNOWN\n");
 
+    /* Open the band together with other Level-2 QA bands */
+    if (test_open_multi (xml_infile, qa_type, l2_qa_file, nlines, nsamps)
+        != SUCCESS)
+    {  /* Error messages already written */
+        exit (EXIT_FAILURE);
+    }
+
     /* Handle the 8-bit QA values */
     if (qa_type == LEDAPS_RADSAT ||
         qa_type == LEDAPS_CLOUD ||